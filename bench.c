@@ -0,0 +1,451 @@
+/**
+ * Benchmark for my_printf.
+ *
+ * Every case formats the same format string and arguments with my_printf,
+ * glibc printf and glibc snprintf. stdout is redirected to /dev/null so that
+ * both printf implementations write to a null sink, and snprintf writes to a
+ * buffer on the stack.
+ *
+ * The outputs are not always the same, since my_printf leaves out some of
+ * the lengths, flags and widths, so the bytes per second of each
+ * implementation are computed from the length that it returned. A call
+ * that fails counts as no bytes.
+ *
+ * Results are written as CSV to the original stdout:
+ *   case,impl,ns_per_call,bytes_per_sec
+ *
+ * If a baseline file is given (a previous CSV run), the program exits with
+ * status 1 when my_printf is slower than the baseline by more than the
+ * threshold percentage in any case. Absolute times only mean something on
+ * the machine that measured them, so each case compares the time of
+ * my_printf divided by the time of glibc printf in this run with the same
+ * ratio in the baseline. This leaves out most of the speed of the machine,
+ * but not all of it: the two don't gain the same from a newer CPU or glibc,
+ * so a baseline is best regenerated on the host that checks against it.
+ *
+ * Build:
+ *   gcc -O2 -o bench bench.c my_printf.c
+ *
+ * Usage:
+ *   bench [-o results.csv] [-b baseline.csv] [-t threshold] [-f filter]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "my_printf.h"
+
+// minimum duration of one measurement in nanoseconds
+#define BENCH_MIN_NS 20000000ULL
+
+// number of measurements per case and implementation, the fastest one is
+// reported
+#define BENCH_REPS 5
+
+// default regression threshold in percent
+#define BENCH_THRESHOLD 10.0
+
+// maximum number of cases in a baseline file
+#define BENCH_MAX_BASE 256
+
+/**
+ * A single benchmark case.
+ * Each case formats one format string with three implementations.
+ */
+typedef struct bench_case {
+	const char* name;          // name of the case
+	int (*my)(void);           // formats with my_printf
+	int (*libc)(void);         // formats with printf
+	int (*snp)(char*, size_t); // formats with snprintf
+}bench_case;
+
+/**
+ * A result read from a baseline file.
+ */
+typedef struct bench_base {
+	char name[64];  // name of the case
+	char impl[16];  // implementation name
+	double ns;      // nanoseconds per call
+}bench_base;
+
+/**
+ * Defines the three formatting functions of a benchmark case.
+ */
+#define BENCH_CASE(name, ...)                                        \
+	static int my_##name(void) { return my_printf(__VA_ARGS__); }   \
+	static int libc_##name(void) { return printf(__VA_ARGS__); }    \
+	static int snp_##name(char* b, size_t n)                         \
+	{ return snprintf(b, n, __VA_ARGS__); }
+
+/**
+ * Creates a bench_case entry for a case defined with BENCH_CASE.
+ */
+#define BENCH_ENTRY(name) { #name, my_##name, libc_##name, snp_##name }
+
+static char bench_c = 'a';
+static int bench_n;
+
+// specifiers
+BENCH_CASE(spec_c, "%c %c %c\n", 'A', 'B', 'C')
+BENCH_CASE(spec_s, "%s %s\n", "Hello", "World!")
+BENCH_CASE(spec_s_long, "%s\n",
+	"The quick brown fox jumps over the lazy dog, again and again.")
+BENCH_CASE(spec_d, "%d %d %d\n", 4, -10, 2147483647)
+BENCH_CASE(spec_i, "%i %i %i\n", 4, -10, -2147483647)
+BENCH_CASE(spec_u, "%u %u %u\n", 4u, 4000000000u, 254u)
+BENCH_CASE(spec_x, "%x %x %x\n", 4, 0xDEADBEEF, 254)
+BENCH_CASE(spec_X, "%X %X %X\n", 4, 0xDEADBEEF, 254)
+BENCH_CASE(spec_o, "%o %o %o\n", 4, 0777, 254)
+BENCH_CASE(spec_p, "%p\n", (void*)&bench_c)
+BENCH_CASE(spec_f, "%f\n", 3.14159)
+BENCH_CASE(spec_e, "%e\n", 3.14159)
+BENCH_CASE(spec_E, "%E\n", 3.14159)
+BENCH_CASE(spec_g, "%g\n", 3.14159)
+BENCH_CASE(spec_G, "%G\n", 3.14159)
+BENCH_CASE(spec_n, "abc%n\n", &bench_n)
+BENCH_CASE(spec_per, "100%%\n")
+BENCH_CASE(literal, "a plain literal string without any format tags\n")
+
+// flags, width and precision
+BENCH_CASE(flag_left, "%-8d|\n", 42)
+BENCH_CASE(flag_sign, "%+d\n", 42)
+BENCH_CASE(flag_space, "% d\n", 42)
+BENCH_CASE(flag_point, "%#x\n", 42)
+BENCH_CASE(flag_zero, "%08d\n", 42)
+BENCH_CASE(width, "%12d\n", 42)
+BENCH_CASE(width_arg, "%*d\n", 12, 42)
+BENCH_CASE(prec, "%.3e\n", 33.147)
+BENCH_CASE(prec_arg, "%.*e\n", 3, 33.147)
+BENCH_CASE(prec_s, "%.3s\n", "abcdef")
+
+// length classes
+BENCH_CASE(len_hh, "%hhd %hhu\n", (signed char)-12, (unsigned char)200)
+BENCH_CASE(len_h, "%hd %hu\n", (short)-12, (unsigned short)12)
+BENCH_CASE(len_l, "%ld %lu\n", -12L, 12UL)
+BENCH_CASE(len_ll, "%lld %llu\n", -123456789012LL, 18446744073709551615ULL)
+BENCH_CASE(len_j, "%jd %ju\n", (intmax_t)-123456789012LL, (uintmax_t)12)
+BENCH_CASE(len_z, "%zd %zu\n", (ssize_t)-12, (size_t)123456789012ULL)
+BENCH_CASE(len_t, "%td\n", (ptrdiff_t)-123456789012LL)
+BENCH_CASE(len_L, "%Lf %Le\n", 3.25L, 1e300L)
+
+// float corner cases
+BENCH_CASE(float_tiny_f, "%f\n", 1e-300)
+BENCH_CASE(float_tiny_e, "%e\n", 1e-300)
+BENCH_CASE(float_huge_f, "%f\n", 1e300)
+BENCH_CASE(float_huge_e, "%e\n", 1e300)
+BENCH_CASE(float_sub_f, "%f\n", 5e-324)
+BENCH_CASE(float_sub_e, "%e\n", 5e-324)
+BENCH_CASE(float_int_f, "%f\n", 45.0)
+BENCH_CASE(float_int_e, "%e\n", 45.0)
+BENCH_CASE(float_zero_f, "%f\n", 0.0)
+BENCH_CASE(float_neg_f, "%f\n", -1.25)
+
+// a typical log line
+BENCH_CASE(log_line, "[%s] %s:%d user=%u took %e s\n",
+	"INFO", "server.c", 128, 1000u, 0.00625)
+
+static const bench_case bench_cases[] = {
+	BENCH_ENTRY(spec_c),
+	BENCH_ENTRY(spec_s),
+	BENCH_ENTRY(spec_s_long),
+	BENCH_ENTRY(spec_d),
+	BENCH_ENTRY(spec_i),
+	BENCH_ENTRY(spec_u),
+	BENCH_ENTRY(spec_x),
+	BENCH_ENTRY(spec_X),
+	BENCH_ENTRY(spec_o),
+	BENCH_ENTRY(spec_p),
+	BENCH_ENTRY(spec_f),
+	BENCH_ENTRY(spec_e),
+	BENCH_ENTRY(spec_E),
+	BENCH_ENTRY(spec_g),
+	BENCH_ENTRY(spec_G),
+	BENCH_ENTRY(spec_n),
+	BENCH_ENTRY(spec_per),
+	BENCH_ENTRY(literal),
+	BENCH_ENTRY(flag_left),
+	BENCH_ENTRY(flag_sign),
+	BENCH_ENTRY(flag_space),
+	BENCH_ENTRY(flag_point),
+	BENCH_ENTRY(flag_zero),
+	BENCH_ENTRY(width),
+	BENCH_ENTRY(width_arg),
+	BENCH_ENTRY(prec),
+	BENCH_ENTRY(prec_arg),
+	BENCH_ENTRY(prec_s),
+	BENCH_ENTRY(len_hh),
+	BENCH_ENTRY(len_h),
+	BENCH_ENTRY(len_l),
+	BENCH_ENTRY(len_ll),
+	BENCH_ENTRY(len_j),
+	BENCH_ENTRY(len_z),
+	BENCH_ENTRY(len_t),
+	BENCH_ENTRY(len_L),
+	BENCH_ENTRY(float_tiny_f),
+	BENCH_ENTRY(float_tiny_e),
+	BENCH_ENTRY(float_huge_f),
+	BENCH_ENTRY(float_huge_e),
+	BENCH_ENTRY(float_sub_f),
+	BENCH_ENTRY(float_sub_e),
+	BENCH_ENTRY(float_int_f),
+	BENCH_ENTRY(float_int_e),
+	BENCH_ENTRY(float_zero_f),
+	BENCH_ENTRY(float_neg_f),
+	BENCH_ENTRY(log_line),
+};
+
+#define BENCH_N_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+static char bench_buf[4096];
+
+static int (*bench_snp_fn)(char*, size_t);
+
+/**
+ * Calls the current snprintf case with a buffer that is large enough
+ * for any of the cases.
+ *
+ * Returns:
+ *   int - the return value of snprintf
+ */
+static int bench_snp(void)
+{
+	return bench_snp_fn(bench_buf, sizeof(bench_buf));
+}
+
+/**
+ * Gets the current value of a monotonic clock in nanoseconds.
+ *
+ * Returns:
+ *   uint64_t - the current time in nanoseconds
+ */
+static uint64_t bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Measures the average duration of a function call.
+ * The function is called in batches until at least BENCH_MIN_NS
+ * nanoseconds have passed.
+ *
+ * Params:
+ *   int (*)(void) - the function to measure
+ *   int* - receives the value returned by the last call
+ *
+ * Returns:
+ *   double - nanoseconds per call
+ */
+static double bench_measure(int (*fn)(void), int* res)
+{
+	uint64_t start, elapsed, calls, batch, i;
+
+	calls = 0;
+	batch = 1;
+	start = bench_now();
+
+	do
+	{
+		for (i = 0; i < batch; i++)
+			*res = fn();
+
+		calls += batch;
+		if (batch < 1024)
+			batch *= 2;
+
+		elapsed = bench_now() - start;
+	} while (elapsed < BENCH_MIN_NS);
+
+	// Keep the buffered output of each measurement out of the next one.
+	fflush(stdout);
+
+	return (double)elapsed / (double)calls;
+}
+
+/**
+ * Reads the results of a previous run.
+ *
+ * Params:
+ *   const char* - the path of the baseline file
+ *   bench_base* - an array to receive the results
+ *   size_t - the capacity of the array
+ *
+ * Returns:
+ *   size_t - the number of results read
+ */
+static size_t bench_read_base(const char* path, bench_base* base, size_t cap)
+{
+	FILE* f;
+	char line[256];
+	size_t n;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		return 0;
+
+	n = 0;
+	while (n < cap && fgets(line, sizeof(line), f) != NULL)
+	{
+		if (sscanf(line, "%63[^,],%15[^,],%lf",
+			base[n].name, base[n].impl, &base[n].ns) == 3)
+			n++;
+	}
+
+	fclose(f);
+
+	return n;
+}
+
+/**
+ * Finds the baseline duration of a case for an implementation.
+ *
+ * Returns:
+ *   double - nanoseconds per call, or 0 if the case is not in the baseline
+ */
+static double bench_find_base(const bench_base* base,
+	size_t n,
+	const char* name,
+	const char* impl)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+	{
+		if (!strcmp(base[i].name, name) && !strcmp(base[i].impl, impl))
+			return base[i].ns;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char* out_path = NULL;
+	const char* base_path = NULL;
+	const char* filter = NULL;
+	double threshold = BENCH_THRESHOLD;
+	bench_base* base = NULL;
+	size_t n_base = 0;
+	FILE* out;
+	size_t i, k;
+	int fd, failed, opt;
+
+	while ((opt = getopt(argc, argv, "o:b:t:f:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'o': out_path = optarg; break;
+		case 'b': base_path = optarg; break;
+		case 't': threshold = atof(optarg); break;
+		case 'f': filter = optarg; break;
+		default:
+			fprintf(stderr, "usage: %s [-o results.csv] [-b baseline.csv]"
+				" [-t threshold] [-f filter]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (base_path != NULL)
+	{
+		base = malloc(sizeof(bench_base) * BENCH_MAX_BASE);
+		if (base == NULL)
+			return 2;
+
+		n_base = bench_read_base(base_path, base, BENCH_MAX_BASE);
+		if (n_base == 0)
+		{
+			fprintf(stderr, "bench: could not read baseline %s\n", base_path);
+			free(base);
+			return 2;
+		}
+	}
+
+	// Keep the original stdout for the results, then send stdout
+	// to the null sink.
+	if (out_path != NULL)
+		out = fopen(out_path, "w");
+	else
+	{
+		fd = dup(STDOUT_FILENO);
+		out = fd < 0 ? NULL : fdopen(fd, "w");
+	}
+
+	if (out == NULL || freopen("/dev/null", "w", stdout) == NULL)
+	{
+		fprintf(stderr, "bench: could not set up output\n");
+		free(base);
+		return 2;
+	}
+
+	fprintf(out, "case,impl,ns_per_call,bytes_per_sec\n");
+
+	failed = 0;
+	for (i = 0; i < BENCH_N_CASES; i++)
+	{
+		const bench_case* c = &bench_cases[i];
+		const char* impls[3] = { "my_printf", "printf", "snprintf" };
+		int (*fns[3])(void) = { c->my, c->libc, bench_snp };
+		double ns[3], t, old, old_libc, ratio, limit;
+		int bytes[3], r;
+
+		if (filter != NULL && strstr(c->name, filter) == NULL)
+			continue;
+
+		// The implementations take turns, so that a change in the speed of
+		// the machine during the case slows them all down alike.
+		bench_snp_fn = c->snp;
+		for (r = 0; r < BENCH_REPS; r++)
+		{
+			for (k = 0; k < 3; k++)
+			{
+				t = bench_measure(fns[k], &bytes[k]);
+				if (r == 0 || t < ns[k])
+					ns[k] = t;
+			}
+		}
+
+		for (k = 0; k < 3; k++)
+		{
+			fprintf(out, "%s,%s,%.1f,%.0f\n", c->name, impls[k], ns[k],
+				ns[k] > 0 && bytes[k] > 0 ? bytes[k] * 1e9 / ns[k] : 0);
+		}
+		fflush(out);
+
+		if (base != NULL)
+		{
+			old = bench_find_base(base, n_base, c->name, impls[0]);
+			old_libc = bench_find_base(base, n_base, c->name, impls[1]);
+
+			// my_printf time in units of printf time, now and in the baseline
+			if (old > 0 && old_libc > 0 && ns[1] > 0)
+			{
+				ratio = ns[0] / ns[1];
+				old /= old_libc;
+				limit = old * (1.0 + threshold / 100.0);
+
+				if (ratio > limit)
+				{
+					fprintf(stderr, "bench: %s regressed: %.2fx printf,"
+						" baseline %.2fx printf (+%.1f%%)\n",
+						c->name, ratio, old, (ratio / old - 1.0) * 100.0);
+					failed = 1;
+				}
+			}
+		}
+	}
+
+	fclose(out);
+	free(base);
+
+	return failed;
+}
@@ -0,0 +1,172 @@
+/**
+ * Throughput benchmark for the asynchronous file sink.
+ *
+ * Records of several sizes are written to a file through three paths:
+ * my_fprintf on a stdio stream, my_aio_printf with io_uring, and
+ * my_aio_printf with plain writes (MY_AIO_SYNC). Each run writes the same
+ * number of bytes, and the file is synced before the clock stops so that
+ * the numbers include getting the data to the kernel and the disk.
+ *
+ * Results are written as CSV to stdout:
+ *   record_size,impl,mb_per_sec
+ *
+ * Build:
+ *   gcc -O2 -o bench_aio bench_aio.c my_printf.c
+ *
+ * Usage:
+ *   bench_aio [-o file] [-m megabytes] [-b buffer_size] [-F]
+ *
+ *   -F registers the buffers with io_uring (MY_AIO_FIXED).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "my_printf.h"
+
+// maximum size of a record
+#define AIO_BENCH_MAX_REC 4096
+
+static const size_t rec_sizes[] = { 16, 64, 256, 1024, 4096 };
+
+static char rec_payload[AIO_BENCH_MAX_REC];
+
+/**
+ * Gets the current time in seconds.
+ */
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Writes records with my_fprintf on a stdio stream.
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int bench_stdio(const char* path, size_t rec, size_t n)
+{
+	FILE* f;
+	size_t i;
+
+	f = fopen(path, "w");
+	if (f == NULL)
+		return 1;
+
+	for (i = 0; i < n; i++)
+		my_fprintf(f, "%u %s\n", (unsigned)i, rec_payload);
+
+	fflush(f);
+	fsync(fileno(f));
+	fclose(f);
+
+	(void)rec;
+
+	return 0;
+}
+
+/**
+ * Writes records with my_aio_printf.
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int bench_aio(const char* path, size_t rec, size_t n, size_t buf, int flags)
+{
+	my_aio aio;
+	size_t i;
+	int fd, err;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return 1;
+
+	if (my_aio_open(&aio, fd, buf, flags))
+	{
+		close(fd);
+		return 1;
+	}
+
+	for (i = 0; i < n; i++)
+		my_aio_printf(&aio, "%u %s\n", (unsigned)i, rec_payload);
+
+	err = my_aio_close(&aio) != 0;
+	fsync(fd);
+	close(fd);
+
+	(void)rec;
+
+	return err;
+}
+
+int main(int argc, char** argv)
+{
+	const char* path = "bench_aio.out";
+	size_t total = 64 << 20;
+	size_t buf = 0;
+	size_t r, n, rec, payload;
+	double start, mb;
+	int flags = 0;
+	int opt, err;
+
+	while ((opt = getopt(argc, argv, "o:m:b:F")) != -1)
+	{
+		switch (opt)
+		{
+		case 'o': path = optarg; break;
+		case 'm': total = strtoull(optarg, NULL, 0) << 20; break;
+		case 'b': buf = strtoull(optarg, NULL, 0); break;
+		case 'F': flags |= MY_AIO_FIXED; break;
+		default:
+			fprintf(stderr, "usage: %s [-o file] [-m megabytes]"
+				" [-b buffer_size] [-F]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("record_size,impl,mb_per_sec\n");
+
+	err = 0;
+	for (r = 0; r < sizeof(rec_sizes) / sizeof(rec_sizes[0]); r++)
+	{
+		rec = rec_sizes[r];
+
+		// A record is a counter of up to 10 digits, a space, the payload
+		// and a newline, so pad the payload to make up the record size.
+		payload = rec > 12 ? rec - 12 : 1;
+		memset(rec_payload, 'x', payload);
+		rec_payload[payload] = '\0';
+
+		n = total / rec;
+		mb = (double)(n * rec) / (1 << 20);
+
+		start = bench_now();
+		err |= bench_stdio(path, rec, n);
+		printf("%zu,stdio,%.1f\n", rec, mb / (bench_now() - start));
+
+		start = bench_now();
+		err |= bench_aio(path, rec, n, buf, flags);
+		printf("%zu,aio_uring,%.1f\n", rec, mb / (bench_now() - start));
+
+		start = bench_now();
+		err |= bench_aio(path, rec, n, buf, MY_AIO_SYNC);
+		printf("%zu,aio_sync,%.1f\n", rec, mb / (bench_now() - start));
+
+		fflush(stdout);
+	}
+
+	unlink(path);
+
+	return err ? 1 : 0;
+}
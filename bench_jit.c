@@ -0,0 +1,127 @@
+/**
+ * Benchmark of compiled format strings against the interpreter.
+ *
+ * Each format is written into a character array many times with
+ * my_snprintf, which parses the format on every call, and with
+ * my_jit_snprintf on a format compiled once by my_jit_compile. The
+ * outputs are checked to be the same.
+ *
+ * Results are written as CSV to stdout:
+ *   format,impl,ns_per_call
+ *
+ * Build:
+ *   gcc -O2 -pthread -o bench_jit bench_jit.c my_printf.c
+ *
+ * Usage:
+ *   bench_jit [-n iterations]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "my_printf.h"
+
+// size of the output buffers
+#define JIT_BENCH_BUF 512
+
+/**
+ * Gets the current time in seconds.
+ */
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char** argv)
+{
+	static const char* formats[] = {
+		"GET /index.html HTTP/1.1 %d %u\n",
+		"[%s] user=%s id=%d status=%x\n",
+		"%d,%d,%d,%d,%d,%d,%d,%d\n",
+		"temperature=%e pressure=%a\n",
+		"%s:%d: %s\n",
+	};
+	char mine[JIT_BENCH_BUF];
+	char ref[JIT_BENCH_BUF];
+	my_jit* jit;
+	size_t f, i, n = 1000000;
+	double start, t_interp, t_jit;
+	int opt, err = 0;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': n = strtoull(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("format,impl,ns_per_call\n");
+
+	for (f = 0; f < sizeof(formats) / sizeof(formats[0]); f++)
+	{
+		const char* fmt = formats[f];
+
+		jit = my_jit_compile(fmt);
+		if (jit == NULL)
+			return 2;
+
+		// Format 1 takes strings first, format 3 takes doubles, format 4
+		// takes a string, an int and a string, and the rest take integers.
+		// Extra arguments are never read.
+		start = bench_now();
+		for (i = 0; i < n; i++)
+		{
+			if (f == 3)
+				my_snprintf(mine, sizeof(mine), fmt, i * 0.001, i * 1.5);
+			else if (f == 1)
+				my_snprintf(mine, sizeof(mine), fmt, "worker-7", "main.c", (int)i, (unsigned)i);
+			else if (f == 4)
+				my_snprintf(mine, sizeof(mine), fmt, "main.c", (int)i, "unexpected token");
+			else
+				my_snprintf(mine, sizeof(mine), fmt, (int)i, (unsigned)i, 3, 4, 5, 6, 7, 8);
+		}
+		t_interp = bench_now() - start;
+
+		start = bench_now();
+		for (i = 0; i < n; i++)
+		{
+			if (f == 3)
+				my_jit_snprintf(ref, sizeof(ref), jit, i * 0.001, i * 1.5);
+			else if (f == 1)
+				my_jit_snprintf(ref, sizeof(ref), jit, "worker-7", "main.c", (int)i, (unsigned)i);
+			else if (f == 4)
+				my_jit_snprintf(ref, sizeof(ref), jit, "main.c", (int)i, "unexpected token");
+			else
+				my_jit_snprintf(ref, sizeof(ref), jit, (int)i, (unsigned)i, 3, 4, 5, 6, 7, 8);
+		}
+		t_jit = bench_now() - start;
+
+		if (strcmp(mine, ref) != 0)
+		{
+			fprintf(stderr, "bench_jit: output differs for format %zu\n", f);
+			err = 1;
+		}
+
+		printf("%zu,interpreter,%.1f\n", f, t_interp / n * 1e9);
+		printf("%zu,%s,%.1f\n", f, my_jit_native(jit) ? "jit" : "jit_fallback",
+			t_jit / n * 1e9);
+		fflush(stdout);
+
+		my_jit_free(jit);
+	}
+
+	return err ? 1 : 0;
+}
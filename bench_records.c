@@ -0,0 +1,176 @@
+/**
+ * Scaling benchmark for my_format_records.
+ *
+ * A table of rows is formatted into a sink that discards its output, with
+ * 1, 2, 4, ... threads up to the number given with -j. Three tables are
+ * used: rows of integers, rows that mix integers, strings and floats, and
+ * rows where every field is a float, so that the cost per row ranges from
+ * cheap to expensive.
+ *
+ * Results are written as CSV to stdout:
+ *   case,threads,mb_per_sec,speedup
+ *
+ * Build:
+ *   gcc -O2 -pthread -o bench_records bench_records.c my_printf.c
+ *
+ * Usage:
+ *   bench_records [-n rows] [-j max_threads]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "my_printf.h"
+
+// size of the buffer of the discarding sink
+#define RECORDS_BUF 4096
+
+/**
+ * A row of the table.
+ */
+typedef struct bench_row {
+	int id;            // row number
+	unsigned flags;    // bit flags
+	const char* name;  // short name
+	double price;      // a price
+	double ratio;      // a small ratio
+}bench_row;
+
+static const char* row_names[] = {
+	"apple", "banana", "cherry", "durian", "elderberry", "fig", "grape"
+};
+
+/**
+ * Gets the current time in seconds.
+ */
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Empties the buffer of a sink, throwing away what was written.
+ */
+static int null_flush(my_sink* sink)
+{
+	sink->pos = 0;
+
+	return 0;
+}
+
+static int row_ints(my_sink* sink, const char* fmt, const void* rec)
+{
+	const bench_row* r = rec;
+
+	return my_format(sink, fmt, r->id, r->flags, r->id * 7);
+}
+
+static int row_mixed(my_sink* sink, const char* fmt, const void* rec)
+{
+	const bench_row* r = rec;
+
+	return my_format(sink, fmt, r->id, r->name, r->price);
+}
+
+static int row_floats(my_sink* sink, const char* fmt, const void* rec)
+{
+	const bench_row* r = rec;
+
+	return my_format(sink, fmt, r->price, r->ratio, r->price * r->ratio);
+}
+
+int main(int argc, char** argv)
+{
+	static const struct {
+		const char* name;
+		const char* fmt;
+		my_record_fn fn;
+	} cases[] = {
+		{ "ints", "%d,%x,%u\n", row_ints },
+		{ "mixed", "%d,%s,%e\n", row_mixed },
+		{ "floats", "%e,%e,%e\n", row_floats },
+	};
+	bench_row* rows;
+	my_sink sink;
+	char buf[RECORDS_BUF];
+	size_t n = 1000000;
+	size_t i, c;
+	long max_threads;
+	double start, secs, base;
+	int threads, opt, err;
+
+	max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	while ((opt = getopt(argc, argv, "n:j:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': n = strtoull(optarg, NULL, 0); break;
+		case 'j': max_threads = strtol(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-n rows] [-j max_threads]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (max_threads < 1)
+		max_threads = 1;
+
+	rows = malloc(n * sizeof(bench_row));
+	if (rows == NULL)
+		return 2;
+
+	srand(1);
+	for (i = 0; i < n; i++)
+	{
+		rows[i].id = (int)i;
+		rows[i].flags = (unsigned)rand();
+		rows[i].name = row_names[i % (sizeof(row_names) / sizeof(row_names[0]))];
+		rows[i].price = (double)rand() / RAND_MAX * 10000.0;
+		rows[i].ratio = (double)rand() / RAND_MAX;
+	}
+
+	printf("case,threads,mb_per_sec,speedup\n");
+
+	err = 0;
+	for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+	{
+		base = 0;
+		for (threads = 1; threads <= max_threads; threads *= 2)
+		{
+			sink.buf = buf;
+			sink.size = sizeof(buf);
+			sink.pos = 0;
+			sink.count = 0;
+			sink.err = 0;
+			sink.flush = null_flush;
+			sink.span = NULL;
+			sink.data = NULL;
+
+			start = bench_now();
+			err |= my_format_records(&sink, cases[c].fmt, rows, n,
+				sizeof(bench_row), cases[c].fn, threads) != 0;
+			secs = bench_now() - start;
+
+			if (threads == 1)
+				base = secs;
+
+			printf("%s,%d,%.1f,%.2f\n", cases[c].name, threads,
+				(double)sink.count / (1 << 20) / secs, base / secs);
+			fflush(stdout);
+		}
+	}
+
+	free(rows);
+
+	return err ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+/**
+ * Benchmark of my_sscanf against the C library's sscanf on log lines.
+ *
+ * A set of log lines is generated once, with a fixed seed, and each
+ * format is used to parse every line with both implementations. The
+ * values read by both are compared, so the benchmark also checks that
+ * they agree, including the size of what is stored for the hh and ll
+ * lengths.
+ *
+ * Results are written as CSV to stdout:
+ *   case,impl,ns_per_line
+ *
+ * Build:
+ *   gcc -O2 -o bench_scan bench_scan.c my_printf.c
+ *
+ * Usage:
+ *   bench_scan [-n lines] [-r rounds]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "my_printf.h"
+
+// maximum length of a generated line
+#define SCAN_LINE 160
+
+/**
+ * The values read from one log line.
+ */
+typedef struct scan_rec {
+	int pid;
+	unsigned int tid;
+	long ts;
+	int status;
+	long bytes;
+	unsigned int addr;
+	char level[16];
+	char path[64];
+	int end;
+	signed char small;           // read with hh
+	char guard1;                 // must not be written by hh
+	unsigned char usmall;        // read with hh
+	char guard2;                 // must not be written by hh
+	long long big;               // read with ll
+	unsigned long long ubig;     // read with ll
+	long long count;             // stored with lln
+}scan_rec;
+
+typedef int (*scan_fn)(const char* str, const char* fmt, ...);
+
+/**
+ * A benchmark case, which is a format string and the way its values are
+ * passed.
+ */
+typedef struct scan_case {
+	const char* name;
+	const char* line_fmt; // format of the generated lines, for snprintf
+	const char* scan_fmt; // format for parsing the lines
+	int kind;             // which fields are passed
+}scan_case;
+
+static const scan_case cases[] = {
+	{
+		"access_log",
+		"%ld %s /api/v%d/items/%u %d %ld",
+		"%ld %15s %63s %d %ld%n",
+		0
+	},
+	{
+		"syslog",
+		"%ld [%d:%u] %s connection from %u.%u.%u.%u",
+		"%ld [%d:%u] %15s connection from %n",
+		1
+	},
+	{
+		"hex_trace",
+		"ts=%ld tid=%x addr=0x%08x len=%d",
+		"ts=%ld tid=%x addr=%x len=%d%n",
+		2
+	},
+	{
+		"lengths",
+		"seq=%lld id=%llx cpu=%d prio=%d",
+		"seq=%lld id=%llx cpu=%hhu prio=%hhd%lln",
+		3
+	},
+};
+
+static const char* levels[] = { "INFO", "WARN", "ERROR", "DEBUG" };
+
+/**
+ * Gets the current time in seconds.
+ */
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Generates a log line for a case.
+ */
+static void gen_line(const scan_case* c, char* line)
+{
+	long ts = 1700000000000L + rand() % 100000000;
+	int pid = rand() % 65536;
+	unsigned int tid = (unsigned int)rand();
+
+	switch (c->kind)
+	{
+	case 0:
+		snprintf(line, SCAN_LINE, c->line_fmt, ts, levels[rand() % 4],
+			rand() % 4, (unsigned int)rand(), 200 + rand() % 300,
+			(long)rand() * 1000);
+		break;
+
+	case 1:
+		snprintf(line, SCAN_LINE, c->line_fmt, ts, pid, tid,
+			levels[rand() % 4], rand() % 256, rand() % 256, rand() % 256,
+			rand() % 256);
+		break;
+
+	case 2:
+		snprintf(line, SCAN_LINE, c->line_fmt, ts, tid,
+			(unsigned int)rand(), rand() % 65536);
+		break;
+
+	default:
+		// Values that don't fit in a char are cut as scanf cuts them.
+		snprintf(line, SCAN_LINE, c->line_fmt, -ts * 1000,
+			(unsigned long long)ts << 20 | tid, rand() % 1000, rand() % 1000 - 500);
+		break;
+	}
+}
+
+/**
+ * Parses a line with a scanf function.
+ *
+ * Returns:
+ *   int - the result of the scanf function
+ */
+static int parse_line(scan_fn fn, const scan_case* c, const char* line, scan_rec* r)
+{
+	switch (c->kind)
+	{
+	case 0:
+		return fn(line, c->scan_fmt, &r->ts, r->level, r->path, &r->status,
+			&r->bytes, &r->end);
+
+	case 1:
+		return fn(line, c->scan_fmt, &r->ts, &r->pid, &r->tid, r->level,
+			&r->end);
+
+	case 2:
+		return fn(line, c->scan_fmt, &r->ts, &r->tid, &r->addr, &r->status,
+			&r->end);
+
+	default:
+		return fn(line, c->scan_fmt, &r->big, &r->ubig, &r->usmall, &r->small,
+			&r->count);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t n_lines = 10000;
+	long rounds = 50;
+	char* lines;
+	scan_rec mine, ref;
+	size_t c, i;
+	double start, t;
+	long r;
+	int opt, err = 0;
+
+	while ((opt = getopt(argc, argv, "n:r:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': n_lines = strtoull(optarg, NULL, 0); break;
+		case 'r': rounds = strtol(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-n lines] [-r rounds]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	lines = malloc(n_lines * SCAN_LINE);
+	if (lines == NULL || n_lines == 0 || rounds < 1)
+		return 2;
+
+	printf("case,impl,ns_per_line\n");
+
+	for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+	{
+		srand(1);
+		for (i = 0; i < n_lines; i++)
+			gen_line(&cases[c], lines + i * SCAN_LINE);
+
+		// Check that both implementations read the same values.
+		for (i = 0; i < n_lines; i++)
+		{
+			memset(&mine, 0, sizeof(mine));
+			memset(&ref, 0, sizeof(ref));
+
+			if (parse_line(my_sscanf, &cases[c], lines + i * SCAN_LINE, &mine)
+				!= parse_line(sscanf, &cases[c], lines + i * SCAN_LINE, &ref)
+				|| memcmp(&mine, &ref, sizeof(mine)) != 0)
+			{
+				fprintf(stderr, "bench_scan: %s: results differ for \"%s\"\n",
+					cases[c].name, lines + i * SCAN_LINE);
+				err = 1;
+				break;
+			}
+		}
+
+		start = bench_now();
+		for (r = 0; r < rounds; r++)
+			for (i = 0; i < n_lines; i++)
+				parse_line(my_sscanf, &cases[c], lines + i * SCAN_LINE, &mine);
+		t = bench_now() - start;
+		printf("%s,my_sscanf,%.1f\n", cases[c].name,
+			t * 1e9 / ((double)rounds * (double)n_lines));
+
+		start = bench_now();
+		for (r = 0; r < rounds; r++)
+			for (i = 0; i < n_lines; i++)
+				parse_line(sscanf, &cases[c], lines + i * SCAN_LINE, &ref);
+		t = bench_now() - start;
+		printf("%s,sscanf,%.1f\n", cases[c].name,
+			t * 1e9 / ((double)rounds * (double)n_lines));
+	}
+
+	free(lines);
+
+	return err;
+}
@@ -0,0 +1,411 @@
+/**
+ * Exhaustive float32 conformance and cost sweep for my_printf.
+ *
+ * Every 32-bit float bit pattern in the requested range is formatted with
+ * my_snprintf and with the C library's snprintf for each conversion, and the
+ * outputs are compared. The time taken by each my_snprintf call is recorded
+ * in a log2 histogram of cycles, so that the inputs where the conversion is
+ * slowest (large exponents, subnormals) stand out.
+ *
+ * A float passed to a variadic function is promoted to double, so only
+ * the double path of the engine is swept: the values are every double that
+ * is exactly a float. There is no separate float path to test.
+ *
+ * The range is split into blocks that the worker threads take from a shared
+ * counter, so all cores stay busy even though the cost per value varies a
+ * lot across the range.
+ *
+ * Results are written as key=value lines to stdout. The program exits with
+ * status 1 if any output differed from the reference.
+ *
+ * Build:
+ *   gcc -O2 -pthread -o float_sweep float_sweep.c my_printf.c
+ *
+ * Usage:
+ *   float_sweep [-s first] [-e last] [-x stride] [-j threads]
+ *     [-c conversions] [-m max_reports]
+ *
+ *   first and last are bit patterns (hexadecimal is accepted), both
+ *   inclusive. The default is the whole range 0 to 0xFFFFFFFF.
+ *   conversions is a comma separated list, by default "%e,%f,%g".
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "my_printf.h"
+
+// maximum number of conversions that can be compared
+#define SWEEP_MAX_CONV 8
+
+// number of log2 buckets in a cycle histogram
+#define SWEEP_BUCKETS 64
+
+// number of bit patterns taken by a worker at a time
+#define SWEEP_BLOCK 4096
+
+// number of the slowest values kept for each conversion
+#define SWEEP_SLOW 8
+
+// size of the output buffers
+#define SWEEP_BUF 2048
+
+// float classes
+#define CLASS_ZERO    0
+#define CLASS_SUB     1
+#define CLASS_NORMAL  2
+#define CLASS_SPECIAL 3
+#define CLASS_N       4
+
+static const char* class_names[CLASS_N] = {
+	"zero", "subnormal", "normal", "inf_nan"
+};
+
+/**
+ * A value and the number of cycles it took to format it.
+ */
+typedef struct sweep_slow {
+	uint32_t bits;   // bit pattern of the float
+	uint64_t cycles; // cycles taken by my_snprintf
+}sweep_slow;
+
+/**
+ * The results of one conversion, either for one worker or for the
+ * whole sweep.
+ */
+typedef struct sweep_stats {
+	uint64_t values[CLASS_N];          // values formatted per class
+	uint64_t mismatches[CLASS_N];      // outputs that differed per class
+	uint64_t cycles[CLASS_N];          // total cycles per class
+	uint64_t hist[SWEEP_BUCKETS];      // log2 histogram of cycles
+	sweep_slow slow[SWEEP_SLOW];       // slowest values
+}sweep_stats;
+
+/**
+ * The state of a worker thread.
+ */
+typedef struct sweep_worker {
+	pthread_t thread;                    // the thread
+	sweep_stats stats[SWEEP_MAX_CONV];   // results per conversion
+}sweep_worker;
+
+static const char* sweep_conv[SWEEP_MAX_CONV];
+static size_t sweep_n_conv;
+
+static uint64_t sweep_first;
+static uint64_t sweep_last;
+static uint64_t sweep_stride = 1;
+static long sweep_max_reports = 20;
+
+static atomic_uint_fast64_t sweep_next;
+static atomic_long sweep_reports;
+static pthread_mutex_t sweep_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Reads a cycle counter, or a nanosecond clock on architectures
+ * without a cycle counter.
+ *
+ * Returns:
+ *   uint64_t - the current cycle count
+ */
+static inline uint64_t sweep_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * Determines the class of a float from its bit pattern.
+ *
+ * Params:
+ *   uint32_t - the bit pattern of a float
+ *
+ * Returns:
+ *   int - one of the CLASS_ values
+ */
+static int sweep_class(uint32_t bits)
+{
+	uint32_t exp = (bits >> 23) & 0xFF;
+
+	if (exp == 0xFF)
+		return CLASS_SPECIAL;
+
+	if (exp == 0)
+		return (bits & 0x007FFFFF) ? CLASS_SUB : CLASS_ZERO;
+
+	return CLASS_NORMAL;
+}
+
+/**
+ * Gets the index of the log2 bucket of a cycle count.
+ */
+static int sweep_bucket(uint64_t cycles)
+{
+	int b = 0;
+
+	while (cycles > 1 && b < SWEEP_BUCKETS - 1)
+	{
+		cycles >>= 1;
+		b++;
+	}
+
+	return b;
+}
+
+/**
+ * Records a value in the list of the slowest values if it is slower
+ * than the fastest one in the list.
+ */
+static void sweep_record_slow(sweep_slow* slow, uint32_t bits, uint64_t cycles)
+{
+	size_t i, min;
+
+	min = 0;
+	for (i = 1; i < SWEEP_SLOW; i++)
+	{
+		if (slow[i].cycles < slow[min].cycles)
+			min = i;
+	}
+
+	if (cycles > slow[min].cycles)
+	{
+		slow[min].bits = bits;
+		slow[min].cycles = cycles;
+	}
+}
+
+/**
+ * Formats and compares every value in the range, one block at a time.
+ *
+ * Params:
+ *   void* - a sweep_worker
+ */
+static void* sweep_run(void* arg)
+{
+	sweep_worker* w = arg;
+	char mine[SWEEP_BUF];
+	char ref[SWEEP_BUF];
+	uint64_t block, i, start, cycles;
+	uint32_t bits;
+	size_t c;
+	float f;
+	int cls;
+
+	for (;;)
+	{
+		block = atomic_fetch_add(&sweep_next, SWEEP_BLOCK * sweep_stride);
+		if (block > sweep_last)
+			break;
+
+		for (i = block;
+			i <= sweep_last && i < block + SWEEP_BLOCK * sweep_stride;
+			i += sweep_stride)
+		{
+			bits = (uint32_t)i;
+			memcpy(&f, &bits, sizeof(f));
+			cls = sweep_class(bits);
+
+			for (c = 0; c < sweep_n_conv; c++)
+			{
+				sweep_stats* st = &w->stats[c];
+
+				// The promotion that a call with f itself would do.
+				start = sweep_cycles();
+				my_snprintf(mine, sizeof(mine), sweep_conv[c], (double)f);
+				cycles = sweep_cycles() - start;
+
+				snprintf(ref, sizeof(ref), sweep_conv[c], (double)f);
+
+				st->values[cls]++;
+				st->cycles[cls] += cycles;
+				st->hist[sweep_bucket(cycles)]++;
+				sweep_record_slow(st->slow, bits, cycles);
+
+				if (strcmp(mine, ref) != 0)
+				{
+					st->mismatches[cls]++;
+
+					if (atomic_fetch_add(&sweep_reports, 1) < sweep_max_reports)
+					{
+						pthread_mutex_lock(&sweep_lock);
+						printf("mismatch conv=%s bits=0x%08X my=\"%.64s\""
+							" ref=\"%.64s\"\n",
+							sweep_conv[c], (unsigned)bits, mine, ref);
+						pthread_mutex_unlock(&sweep_lock);
+					}
+				}
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Splits a comma separated list of conversions.
+ *
+ * Returns:
+ *   size_t - the number of conversions
+ */
+static size_t sweep_parse_conv(char* list)
+{
+	size_t n = 0;
+	char* tok;
+
+	for (tok = strtok(list, ","); tok != NULL && n < SWEEP_MAX_CONV;
+		tok = strtok(NULL, ","))
+	{
+		sweep_conv[n++] = tok;
+	}
+
+	return n;
+}
+
+int main(int argc, char** argv)
+{
+	char default_conv[] = "%e,%f,%g";
+	char* conv = default_conv;
+	sweep_worker* workers;
+	sweep_stats total;
+	long n_threads;
+	uint64_t mismatches, values;
+	size_t c, k, s;
+	long t;
+	int opt, cls;
+
+	sweep_first = 0;
+	sweep_last = 0xFFFFFFFFULL;
+	n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	while ((opt = getopt(argc, argv, "s:e:x:j:c:m:")) != -1)
+	{
+		switch (opt)
+		{
+		case 's': sweep_first = strtoull(optarg, NULL, 0); break;
+		case 'e': sweep_last = strtoull(optarg, NULL, 0); break;
+		case 'x': sweep_stride = strtoull(optarg, NULL, 0); break;
+		case 'j': n_threads = strtol(optarg, NULL, 0); break;
+		case 'c': conv = optarg; break;
+		case 'm': sweep_max_reports = strtol(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-s first] [-e last] [-x stride]"
+				" [-j threads] [-c conversions] [-m max_reports]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	sweep_n_conv = sweep_parse_conv(conv);
+
+	if (n_threads < 1)
+		n_threads = 1;
+	if (sweep_stride < 1)
+		sweep_stride = 1;
+	if (sweep_last > 0xFFFFFFFFULL)
+		sweep_last = 0xFFFFFFFFULL;
+
+	if (sweep_n_conv == 0 || sweep_first > sweep_last)
+	{
+		fprintf(stderr, "float_sweep: nothing to do\n");
+		return 2;
+	}
+
+	workers = calloc((size_t)n_threads, sizeof(sweep_worker));
+	if (workers == NULL)
+		return 2;
+
+	atomic_init(&sweep_next, sweep_first);
+	atomic_init(&sweep_reports, 0);
+
+	for (t = 0; t < n_threads; t++)
+		pthread_create(&workers[t].thread, NULL, sweep_run, &workers[t]);
+
+	for (t = 0; t < n_threads; t++)
+		pthread_join(workers[t].thread, NULL);
+
+	printf("range=0x%08llX-0x%08llX stride=%llu threads=%ld\n",
+		(unsigned long long)sweep_first, (unsigned long long)sweep_last,
+		(unsigned long long)sweep_stride, n_threads);
+
+	mismatches = 0;
+	for (c = 0; c < sweep_n_conv; c++)
+	{
+		memset(&total, 0, sizeof(total));
+
+		// Merge the results of the workers.
+		for (t = 0; t < n_threads; t++)
+		{
+			sweep_stats* st = &workers[t].stats[c];
+
+			for (cls = 0; cls < CLASS_N; cls++)
+			{
+				total.values[cls] += st->values[cls];
+				total.mismatches[cls] += st->mismatches[cls];
+				total.cycles[cls] += st->cycles[cls];
+			}
+
+			for (k = 0; k < SWEEP_BUCKETS; k++)
+				total.hist[k] += st->hist[k];
+
+			for (s = 0; s < SWEEP_SLOW; s++)
+				sweep_record_slow(total.slow, st->slow[s].bits, st->slow[s].cycles);
+		}
+
+		for (cls = 0; cls < CLASS_N; cls++)
+		{
+			values = total.values[cls];
+			mismatches += total.mismatches[cls];
+
+			printf("conv=%s class=%s values=%llu mismatches=%llu"
+				" mean_cycles=%.1f\n",
+				sweep_conv[c], class_names[cls], (unsigned long long)values,
+				(unsigned long long)total.mismatches[cls],
+				values ? (double)total.cycles[cls] / (double)values : 0.0);
+		}
+
+		for (k = 0; k < SWEEP_BUCKETS; k++)
+		{
+			if (total.hist[k] == 0)
+				continue;
+
+			printf("conv=%s hist_cycles_log2=%zu count=%llu\n",
+				sweep_conv[c], k, (unsigned long long)total.hist[k]);
+		}
+
+		for (s = 0; s < SWEEP_SLOW; s++)
+		{
+			float f;
+			uint32_t bits = total.slow[s].bits;
+
+			if (total.slow[s].cycles == 0)
+				continue;
+
+			memcpy(&f, &bits, sizeof(f));
+			printf("conv=%s slow bits=0x%08X value=%a cycles=%llu\n",
+				sweep_conv[c], (unsigned)bits, (double)f,
+				(unsigned long long)total.slow[s].cycles);
+		}
+	}
+
+	free(workers);
+
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,873 @@
+/**
+ * Generator of specialized format functions for my_printf.
+ *
+ * The C sources given on the command line are scanned for calls to
+ * my_printf, my_fprintf and my_snprintf whose format is a string literal
+ * (or several adjacent literals). For each distinct format, a function is
+ * generated that writes the literal text with fixed size copies and calls
+ * the conversion for each tag directly, so the format is never parsed at
+ * run time. The output is the same as that of the generic functions.
+ *
+ * Two files are written:
+ *   prefix.c - the generated functions, to be compiled with the program
+ *   prefix.h - declarations, and macros that redirect my_printf,
+ *              my_fprintf and my_snprintf to a generated function when
+ *              the format is one of the literals that was found
+ *
+ * Sources include prefix.h instead of my_printf.h. The macros compare the
+ * format with each literal using __builtin_strcmp, which GCC and Clang
+ * fold at compile time, so each call site compiles to a direct call to
+ * its generated function, or to the generic function if the format is not
+ * a literal or was not found when the files were generated. Other
+ * compilers, and builds with MY_PRINTF_NO_GEN defined, always use the
+ * generic functions.
+ *
+ * Formats that use '*' for the width or precision, wide characters or
+ * strings, or any conversion other than c, s, d, i, u, x, X, o, p, f, e,
+ * E, a, A and %, are left to the generic functions, as are custom
+ * specifiers.
+ *
+ * A summary is written as key=value lines to stdout.
+ *
+ * Build:
+ *   gcc -O2 -o fmtgen fmtgen.c
+ *
+ * Usage:
+ *   fmtgen [-o prefix] file...
+ *
+ *   The default prefix is "my_printf_gen".
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "my_printf.h"
+
+// longest literal run that is copied inline rather than with my_sink_write
+#define GEN_LIT_MAX 32
+
+// number of functions whose calls are redirected
+#define GEN_FUNCS    3
+
+/**
+ * A function whose calls are redirected.
+ */
+typedef struct gen_func {
+	const char* name;   // name of the function
+	int fmt_arg;        // index of the format argument
+	const char* params; // parameters before the format
+	const char* args;   // names of those parameters
+	const char* run;    // how the generated function formats
+}gen_func;
+
+static const gen_func gen_funcs[GEN_FUNCS] = {
+	{ "my_printf", 0, "", "", "my_fn_vfprintf(stdout, " },
+	{ "my_fprintf", 1, "FILE* stream, ", "stream, ", "my_fn_vfprintf(stream, " },
+	{ "my_snprintf", 2, "char* str, size_t size, ", "str, size, ",
+		"my_fn_vsnprintf(str, size, " },
+};
+
+/**
+ * A distinct literal format found in the sources.
+ */
+typedef struct gen_fmt {
+	char* str;        // the format, up to its first NUL
+	int ok;           // 1 if the format can be specialized
+	int used;         // bit i is set if called with gen_funcs[i]
+}gen_fmt;
+
+/**
+ * A format tag, as my_printf parses it.
+ */
+typedef struct gen_tag {
+	unsigned flags;   // FMT_ bit flags
+	size_t width;     // minimum number of characters
+	size_t prec;      // precision
+	unsigned len;     // LEN_ bit flags
+	char spec;        // specifier
+}gen_tag;
+
+static gen_fmt* gen_fmts;
+static size_t gen_n_fmts;
+static size_t gen_n_calls;
+
+/**
+ * Reads a whole file into memory.
+ *
+ * Returns:
+ *   char* - the NUL terminated contents, or NULL on failure
+ */
+static char* gen_read(const char* path)
+{
+	FILE* f;
+	char* buf = NULL;
+	size_t len = 0, cap = 0, n;
+
+	f = fopen(path, "rb");
+	if (f == NULL)
+		return NULL;
+
+	for (;;)
+	{
+		if (cap - len < 4096)
+		{
+			char* p;
+
+			cap = cap ? cap * 2 : 65536;
+			p = realloc(buf, cap);
+			if (p == NULL)
+			{
+				free(buf);
+				fclose(f);
+				return NULL;
+			}
+			buf = p;
+		}
+
+		n = fread(buf + len, 1, cap - len - 1, f);
+		len += n;
+		if (n == 0)
+			break;
+	}
+
+	if (ferror(f))
+	{
+		free(buf);
+		buf = NULL;
+	}
+	else
+		buf[len] = '\0';
+
+	fclose(f);
+
+	return buf;
+}
+
+static int gen_ident(char c)
+{
+	return isalnum((unsigned char)c) || c == '_';
+}
+
+/**
+ * Skips white space, comments and line continuations.
+ */
+static const char* gen_skip_space(const char* p)
+{
+	for (;;)
+	{
+		if (isspace((unsigned char)*p))
+			p++;
+		else if (p[0] == '\\' && p[1] == '\n')
+			p += 2;
+		else if (p[0] == '/' && p[1] == '/')
+		{
+			while (*p != '\0' && *p != '\n')
+				p++;
+		}
+		else if (p[0] == '/' && p[1] == '*')
+		{
+			p += 2;
+			while (*p != '\0' && !(p[0] == '*' && p[1] == '/'))
+				p++;
+			if (*p != '\0')
+				p += 2;
+		}
+		else
+			return p;
+	}
+}
+
+/**
+ * Skips a string or character literal.
+ *
+ * Params:
+ *   const char* - the opening quote
+ *
+ * Returns:
+ *   const char* - the character after the closing quote
+ */
+static const char* gen_skip_quoted(const char* p)
+{
+	char q = *p++;
+
+	while (*p != '\0' && *p != q && *p != '\n')
+	{
+		if (*p == '\\' && p[1] != '\0')
+			p++;
+		p++;
+	}
+
+	return *p == q ? p + 1 : p;
+}
+
+/**
+ * Skips one argument of a call, up to the comma or closing parenthesis
+ * that ends it.
+ */
+static const char* gen_skip_arg(const char* p)
+{
+	int depth = 0;
+
+	while (*p != '\0')
+	{
+		p = gen_skip_space(p);
+
+		if (*p == '"' || *p == '\'')
+			p = gen_skip_quoted(p);
+		else if (*p == '(' || *p == '[' || *p == '{')
+			depth++, p++;
+		else if (*p == ')' || *p == ']' || *p == '}')
+		{
+			if (depth == 0)
+				return p;
+			depth--, p++;
+		}
+		else if (*p == ',' && depth == 0)
+			return p;
+		else if (*p != '\0')
+			p++;
+	}
+
+	return p;
+}
+
+/**
+ * Decodes the characters of a string literal and appends them to a
+ * buffer. Characters after an embedded NUL are dropped, since my_printf
+ * stops there.
+ *
+ * Params:
+ *   const char* - the opening quote
+ *   char* - the buffer, with room for the whole literal
+ *   size_t* - the length of the buffer, which is updated
+ *   int* - set when a NUL has been seen
+ *
+ * Returns:
+ *   const char* - the character after the closing quote, or NULL if the
+ *                 literal cannot be decoded
+ */
+static const char* gen_decode(const char* p, char* out, size_t* len, int* nul)
+{
+	unsigned v;
+	int k;
+	char c;
+
+	for (p++; *p != '"'; p++)
+	{
+		if (*p == '\0' || *p == '\n')
+			return NULL;
+
+		c = *p;
+		if (c == '\\')
+		{
+			p++;
+			switch (*p)
+			{
+			case 'n': c = '\n'; break;
+			case 't': c = '\t'; break;
+			case 'r': c = '\r'; break;
+			case 'a': c = '\a'; break;
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'v': c = '\v'; break;
+			case '\\': case '\'': case '"': case '?': c = *p; break;
+			case 'x':
+				v = 0;
+				for (k = 0; isxdigit((unsigned char)p[1]); k++, p++)
+					v = v * 16 + (isdigit((unsigned char)p[1])
+						? p[1] - '0' : (tolower((unsigned char)p[1]) - 'a' + 10));
+				if (k == 0 || v > 0xFF)
+					return NULL;
+				c = (char)v;
+				break;
+			default:
+				if (*p < '0' || *p > '7')
+					return NULL;
+				v = 0;
+				for (k = 0; k < 3 && *p >= '0' && *p <= '7'; k++, p++)
+					v = v * 8 + (unsigned)(*p - '0');
+				p--;
+				if (v > 0xFF)
+					return NULL;
+				c = (char)v;
+				break;
+			}
+		}
+
+		if (c == '\0')
+			*nul = 1;
+		if (!*nul)
+			out[(*len)++] = c;
+	}
+
+	return p + 1;
+}
+
+/**
+ * Parses a format tag as my_printf does.
+ *
+ * Params:
+ *   const char* - the character after the '%'
+ *   gen_tag* - the tag
+ *
+ * Returns:
+ *   const char* - the specifier, or NULL if the format ended in the tag
+ */
+static const char* gen_parse_tag(const char* p, gen_tag* t)
+{
+	memset(t, 0, sizeof(*t));
+
+	for (;; p++)
+	{
+		if (*p == '-') t->flags |= FMT_LEFT;
+		else if (*p == '+') t->flags |= FMT_SIGN;
+		else if (*p == ' ') t->flags |= FMT_SPACE;
+		else if (*p == '#') t->flags |= FMT_POINT;
+		else if (*p == '0') t->flags |= FMT_ZERO;
+		else break;
+	}
+
+	if (*p == '*')
+	{
+		t->flags |= FMT_WIDTH;
+		p++;
+	}
+	else
+	{
+		while (*p >= '0' && *p <= '9')
+			t->width = t->width * 10 + (size_t)(*p++ - '0');
+	}
+
+	if (*p == '.')
+	{
+		p++;
+		if (*p == '*')
+		{
+			t->flags |= FMT_PREC;
+			p++;
+		}
+		else
+		{
+			while (*p >= '0' && *p <= '9')
+				t->prec = t->prec * 10 + (size_t)(*p++ - '0');
+			t->flags |= FMT_ZPREC;
+		}
+	}
+
+	for (;; p++)
+	{
+		if (*p == 'h') t->len |= LEN_h;
+		else if (*p == 'l') t->len |= LEN_l;
+		else if (*p == 'L') t->len |= LEN_L;
+		else if (*p == 'W') t->len |= LEN_W;
+		else if (*p == 'U') t->len |= LEN_U;
+		else if (*p == 'Q') t->len |= LEN_Q;
+		else break;
+	}
+
+	if (*p == '\0')
+		return NULL;
+
+	t->spec = *p;
+
+	return p;
+}
+
+/**
+ * Determines whether a format can be specialized.
+ *
+ * Returns:
+ *   int - 1 if every tag has a conversion function, or 0 otherwise
+ */
+static int gen_supported(const char* f)
+{
+	gen_tag t;
+
+	while ((f = strchr(f, '%')) != NULL)
+	{
+		f = gen_parse_tag(f + 1, &t);
+		if (f == NULL || (t.flags & (FMT_WIDTH | FMT_PREC)))
+			return 0;
+
+		if (t.spec == 'c' || t.spec == 's')
+		{
+			if (t.len & (LEN_l | LEN_W | LEN_U))
+				return 0;
+		}
+		else if (strchr("%diuxXopfeEaA", t.spec) == NULL)
+			return 0;
+		else if (strchr("feEaA", t.spec) != NULL && (t.len & (LEN_L | LEN_Q)))
+			return 0;
+
+		f++;
+	}
+
+	return 1;
+}
+
+/**
+ * Records a literal format found in a call.
+ */
+static int gen_add(const char* str, size_t len, int func)
+{
+	gen_fmt* p;
+	size_t i;
+
+	gen_n_calls++;
+
+	for (i = 0; i < gen_n_fmts; i++)
+	{
+		if (strlen(gen_fmts[i].str) == len && memcmp(gen_fmts[i].str, str, len) == 0)
+		{
+			gen_fmts[i].used |= 1 << func;
+			return 0;
+		}
+	}
+
+	p = realloc(gen_fmts, (gen_n_fmts + 1) * sizeof(gen_fmt));
+	if (p == NULL)
+		return 1;
+	gen_fmts = p;
+
+	p = &gen_fmts[gen_n_fmts];
+	p->str = malloc(len + 1);
+	if (p->str == NULL)
+		return 1;
+	memcpy(p->str, str, len);
+	p->str[len] = '\0';
+	p->ok = gen_supported(p->str);
+	p->used = 1 << func;
+	gen_n_fmts++;
+
+	return 0;
+}
+
+/**
+ * Looks at the arguments of a call, and records its format if it is made
+ * of string literals.
+ *
+ * Params:
+ *   const char* - the character after the name of the function
+ *   int - the index of the function in gen_funcs
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if no memory could be allocated
+ */
+static int gen_call(const char* p, int func)
+{
+	char* buf;
+	size_t len = 0;
+	int i, nul = 0, err;
+
+	p = gen_skip_space(p);
+	if (*p != '(')
+		return 0;
+	p++;
+
+	for (i = 0; i < gen_funcs[func].fmt_arg; i++)
+	{
+		p = gen_skip_arg(p);
+		if (*p != ',')
+			return 0;
+		p++;
+	}
+
+	p = gen_skip_space(p);
+	if (*p != '"')
+		return 0;
+
+	// The decoded format is no longer than the literals.
+	buf = malloc(strlen(p) + 1);
+	if (buf == NULL)
+		return 1;
+
+	while (*p == '"')
+	{
+		p = gen_decode(p, buf, &len, &nul);
+		if (p == NULL)
+		{
+			free(buf);
+			return 0;
+		}
+		p = gen_skip_space(p);
+	}
+
+	err = 0;
+	if (*p == ',' || *p == ')')
+		err = gen_add(buf, len, func);
+
+	free(buf);
+
+	return err;
+}
+
+/**
+ * Finds the calls in a source file.
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int gen_scan(const char* src)
+{
+	const char* p = src;
+	const char* id;
+	size_t n;
+	int f;
+
+	while (*p != '\0')
+	{
+		if ((p[0] == '/' && (p[1] == '/' || p[1] == '*')))
+			p = gen_skip_space(p);
+		else if (*p == '"' || *p == '\'')
+			p = gen_skip_quoted(p);
+		else if (gen_ident(*p))
+		{
+			for (id = p; gen_ident(*p); p++);
+			n = (size_t)(p - id);
+
+			for (f = 0; f < GEN_FUNCS; f++)
+			{
+				if (strlen(gen_funcs[f].name) == n
+					&& memcmp(gen_funcs[f].name, id, n) == 0
+					&& gen_call(p, f))
+					return 1;
+			}
+		}
+		else
+			p++;
+	}
+
+	return 0;
+}
+
+/**
+ * Writes characters as the inside of a C string literal.
+ */
+static void gen_quote(FILE* out, const char* s, size_t len)
+{
+	size_t i;
+	unsigned char c;
+
+	for (i = 0; i < len; i++)
+	{
+		c = (unsigned char)s[i];
+		if (c == '\\' || c == '"' || c == '?')
+			fprintf(out, "\\%c", c);
+		else if (c == '/' && i > 0 && s[i - 1] == '*')
+			fputs("\\057", out);  // keeps the text inside a comment
+		else if (c == '\n')
+			fputs("\\n", out);
+		else if (c == '\t')
+			fputs("\\t", out);
+		else if (c < ' ' || c >= 0x7F)
+			fprintf(out, "\\%03o", c);
+		else
+			fputc(c, out);
+	}
+}
+
+/**
+ * Writes the statement that copies a run of literal characters.
+ */
+static void gen_literal(FILE* out, const char* s, size_t len)
+{
+	if (len == 0)
+		return;
+
+	fprintf(out, "\t%s(sink, \"", len <= GEN_LIT_MAX ? "gen_lit" : "my_sink_write");
+	gen_quote(out, s, len);
+	fprintf(out, "\", %zu);\n", len);
+}
+
+/**
+ * Writes the format function of a format, and a function for each of the
+ * generic functions that it was called with.
+ */
+static void gen_emit_fmt(FILE* out, size_t k)
+{
+	const char* f = gen_fmts[k].str;
+	const char* conv;
+	char* lit;
+	size_t n_lit = 0, n_tags = 0, n_args = 0;
+	gen_tag t;
+	int i;
+
+	lit = malloc(strlen(f) + 1);
+	if (lit == NULL)
+		return;
+
+	fprintf(out, "/* \"");
+	gen_quote(out, f, strlen(f));
+	fprintf(out, "\" */\n");
+
+	// The tags that the conversions need.
+	for (conv = f; (conv = strchr(conv, '%')) != NULL; conv++)
+	{
+		conv = gen_parse_tag(conv + 1, &t);
+		if (t.spec != '%')
+			n_args++;
+		if (strchr("eEaA", t.spec) == NULL)
+			continue;
+
+		fprintf(out, "static const ftag gen_tag_%zu_%zu = { 0x%02X, %zu, %zu, 0x%02X, '%c' };\n",
+			k, n_tags++, t.flags, t.width, t.prec, t.len, t.spec);
+	}
+
+	fprintf(out, "%sstatic void gen_fmt_%zu(my_sink* sink, va_list argp)\n{\n",
+		n_tags ? "\n" : "", k);
+
+	// A format with only text takes no arguments.
+	if (n_args == 0)
+		fprintf(out, "\t(void)argp;\n");
+
+	n_tags = 0;
+	while (*f != '\0')
+	{
+		if (*f != '%')
+		{
+			lit[n_lit++] = *f++;
+			continue;
+		}
+
+		f = gen_parse_tag(f + 1, &t);
+		f++;
+		if (t.spec == '%')
+		{
+			lit[n_lit++] = '%';
+			continue;
+		}
+
+		gen_literal(out, lit, n_lit);
+		n_lit = 0;
+
+		switch (t.spec)
+		{
+		case 'c': fprintf(out, "\tmy_conv_c(sink, va_arg(argp, int));\n"); break;
+		case 's': fprintf(out, "\tmy_conv_s(sink, va_arg(argp, const char*));\n"); break;
+		case 'd':
+		case 'i': fprintf(out, "\tmy_conv_d(sink, va_arg(argp, int));\n"); break;
+		case 'u': fprintf(out, "\tmy_conv_u(sink, va_arg(argp, unsigned int));\n"); break;
+		case 'x': fprintf(out, "\tmy_conv_x(sink, va_arg(argp, int));\n"); break;
+		case 'X': fprintf(out, "\tmy_conv_X(sink, va_arg(argp, int));\n"); break;
+		case 'o': fprintf(out, "\tmy_conv_o(sink, va_arg(argp, int));\n"); break;
+		case 'p': fprintf(out, "\tmy_conv_p(sink, va_arg(argp, const void*));\n"); break;
+		case 'f': fprintf(out, "\tmy_conv_f(sink, va_arg(argp, double));\n"); break;
+		case 'e':
+		case 'E':
+			fprintf(out, "\tmy_conv_e(sink, va_arg(argp, double), &gen_tag_%zu_%zu);\n",
+				k, n_tags++);
+			break;
+		default:
+			fprintf(out, "\tmy_conv_a(sink, va_arg(argp, double), &gen_tag_%zu_%zu);\n",
+				k, n_tags++);
+			break;
+		}
+	}
+
+	gen_literal(out, lit, n_lit);
+	fprintf(out, "}\n");
+
+	for (i = 0; i < GEN_FUNCS; i++)
+	{
+		if (!(gen_fmts[k].used & (1 << i)))
+			continue;
+
+		fprintf(out, "\nint my_gen%s_%zu(%sconst char* fmt, ...)\n{\n",
+			gen_funcs[i].name + 2, k, gen_funcs[i].params);
+		fprintf(out, "\tva_list argp;\n\tint res;\n\n");
+		fprintf(out, "\t(void)fmt;\n\tva_start(argp, fmt);\n");
+		fprintf(out, "\tres = %sgen_fmt_%zu, argp);\n", gen_funcs[i].run, k);
+		fprintf(out, "\tva_end(argp);\n\n\treturn res;\n}\n");
+	}
+
+	fprintf(out, "\n");
+
+	free(lit);
+}
+
+/**
+ * Writes the source file of the generated functions.
+ */
+static int gen_write_source(const char* path, const char* header)
+{
+	FILE* out;
+	const char* base;
+	size_t k;
+
+	out = fopen(path, "w");
+	if (out == NULL)
+		return 1;
+
+	base = strrchr(header, '/');
+	base = base != NULL ? base + 1 : header;
+
+	fprintf(out, "/* Generated by fmtgen. Do not edit. */\n\n");
+	fprintf(out, "#include <stdio.h>\n#include <stdarg.h>\n#include <string.h>\n\n");
+	fprintf(out, "#define MY_PRINTF_NO_GEN\n#include \"%s\"\n\n", base);
+	fprintf(out,
+		"/**\n"
+		" * Copies a short run of literal characters into the buffer of a sink.\n"
+		" * The length is a constant, so the copy becomes a few stores.\n"
+		" */\n"
+		"static inline void gen_lit(my_sink* sink, const char* str, size_t len)\n"
+		"{\n"
+		"\tif (sink->size - sink->pos >= len)\n"
+		"\t{\n"
+		"\t\tmemcpy(sink->buf + sink->pos, str, len);\n"
+		"\t\tsink->pos += len;\n"
+		"\t\tsink->count += len;\n"
+		"\t}\n"
+		"\telse\n"
+		"\t\tmy_sink_write(sink, str, len);\n"
+		"}\n\n");
+
+	for (k = 0; k < gen_n_fmts; k++)
+	{
+		if (gen_fmts[k].ok)
+			gen_emit_fmt(out, k);
+	}
+
+	return fclose(out) != 0;
+}
+
+/**
+ * Writes the header with the declarations and the redirecting macros.
+ */
+static int gen_write_header(const char* path)
+{
+	FILE* out;
+	size_t k;
+	int i;
+
+	out = fopen(path, "w");
+	if (out == NULL)
+		return 1;
+
+	fprintf(out, "/* Generated by fmtgen. Do not edit. */\n\n");
+	fprintf(out, "#ifndef MY_PRINTF_GEN_H\n#define MY_PRINTF_GEN_H\n\n");
+	fprintf(out, "#include \"my_printf.h\"\n\n");
+
+	for (k = 0; k < gen_n_fmts; k++)
+	{
+		for (i = 0; i < GEN_FUNCS; i++)
+		{
+			if (gen_fmts[k].ok && (gen_fmts[k].used & (1 << i)))
+				fprintf(out, "int my_gen%s_%zu(%sconst char* fmt, ...);\n",
+					gen_funcs[i].name + 2, k, gen_funcs[i].params);
+		}
+	}
+
+	fprintf(out, "\n#if (defined(__GNUC__) || defined(__clang__)) && !defined(MY_PRINTF_NO_GEN)\n\n");
+	fprintf(out, "#define MY_GEN_FMT(fmt, ...) (fmt)\n");
+	fprintf(out, "#define MY_GEN_IS(fmt, lit) \\\n"
+		"\t(__builtin_constant_p(fmt) && __builtin_strcmp((fmt), (lit)) == 0)\n");
+
+	for (i = 0; i < GEN_FUNCS; i++)
+	{
+		fprintf(out, "\n#define %s(%s...) ( \\\n", gen_funcs[i].name, gen_funcs[i].args);
+
+		for (k = 0; k < gen_n_fmts; k++)
+		{
+			if (!gen_fmts[k].ok || !(gen_fmts[k].used & (1 << i)))
+				continue;
+
+			fprintf(out, "\tMY_GEN_IS(MY_GEN_FMT(__VA_ARGS__, 0), \"");
+			gen_quote(out, gen_fmts[k].str, strlen(gen_fmts[k].str));
+			fprintf(out, "\") ? my_gen%s_%zu(%s__VA_ARGS__) : \\\n",
+				gen_funcs[i].name + 2, k, gen_funcs[i].args);
+		}
+
+		fprintf(out, "\t(%s)(%s__VA_ARGS__))\n", gen_funcs[i].name, gen_funcs[i].args);
+	}
+
+	fprintf(out, "\n#endif\n\n#endif\n");
+
+	return fclose(out) != 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char* prefix = "my_printf_gen";
+	char* src;
+	char* c_path;
+	char* h_path;
+	size_t k, n_ok;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "o:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'o': prefix = optarg; break;
+		default:
+			fprintf(stderr, "usage: %s [-o prefix] file...\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (optind >= argc)
+	{
+		fprintf(stderr, "usage: %s [-o prefix] file...\n", argv[0]);
+		return 2;
+	}
+
+	for (i = optind; i < argc; i++)
+	{
+		src = gen_read(argv[i]);
+		if (src == NULL)
+		{
+			fprintf(stderr, "fmtgen: cannot read %s\n", argv[i]);
+			return 2;
+		}
+
+		if (gen_scan(src))
+		{
+			fprintf(stderr, "fmtgen: out of memory\n");
+			return 2;
+		}
+
+		free(src);
+	}
+
+	c_path = malloc(strlen(prefix) + 3);
+	h_path = malloc(strlen(prefix) + 3);
+	if (c_path == NULL || h_path == NULL)
+		return 2;
+	sprintf(c_path, "%s.c", prefix);
+	sprintf(h_path, "%s.h", prefix);
+
+	if (gen_write_header(h_path) || gen_write_source(c_path, h_path))
+	{
+		fprintf(stderr, "fmtgen: cannot write %s\n", prefix);
+		return 2;
+	}
+
+	n_ok = 0;
+	for (k = 0; k < gen_n_fmts; k++)
+		n_ok += gen_fmts[k].ok;
+
+	printf("calls=%zu formats=%zu specialized=%zu\n", gen_n_calls, gen_n_fmts, n_ok);
+
+	for (k = 0; k < gen_n_fmts; k++)
+	{
+		if (gen_fmts[k].ok)
+			continue;
+
+		printf("generic=\"");
+		gen_quote(stdout, gen_fmts[k].str, strlen(gen_fmts[k].str));
+		printf("\"\n");
+	}
+
+	for (k = 0; k < gen_n_fmts; k++)
+		free(gen_fmts[k].str);
+	free(gen_fmts);
+	free(c_path);
+	free(h_path);
+
+	return 0;
+}
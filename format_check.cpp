@@ -0,0 +1,319 @@
+/**
+ * Conformance check for my::format.
+ *
+ * A list of fixed cases is checked first: alignment, fill, signs, bases,
+ * the default of each argument type, nullptr, arguments taken for the
+ * width and precision, and the format strings that must be refused. Then
+ * random fields are formatted with my::format and with the matching %
+ * conversion of the C library's snprintf, and the outputs are compared.
+ *
+ * Each difference is written to stdout, followed by a count. The program
+ * exits with status 1 if there was any difference.
+ *
+ * Build:
+ *   gcc -O2 -c my_printf.c
+ *   g++ -std=c++17 -O2 -pthread -o format_check format_check.cpp my_format.cpp my_printf.o
+ *
+ * Usage:
+ *   format_check [-n random_cases] [-r seed]
+ */
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "my_format.hpp"
+
+// maximum number of differences written to stdout
+#define CHECK_MAX_REPORTS 20
+
+static long check_failed;
+
+/**
+ * Compares an output with the expected one, and reports it if they differ.
+ *
+ * Params:
+ *   int - the line of the check
+ *   const std::string& - the output
+ *   const std::string& - the expected output
+ */
+static void check(int line, const std::string& got, const std::string& want)
+{
+	if (got == want)
+		return;
+
+	if (check_failed++ < CHECK_MAX_REPORTS)
+		printf("line %d: got \"%s\" expected \"%s\"\n", line, got.c_str(), want.c_str());
+}
+
+#define CHECK(got, want) check(__LINE__, (got), (want))
+
+/**
+ * Formats with the C library, as the reference.
+ *
+ * Params:
+ *   const char* - a format string with % conversions
+ *   ... - the values to be converted
+ *
+ * Returns:
+ *   std::string - the formatted string
+ */
+static std::string ref(const char* fmt, ...)
+{
+	char buf[8192];
+	va_list argp;
+
+	va_start(argp, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, argp);
+	va_end(argp);
+
+	return buf;
+}
+
+/**
+ * Checks a format string that must throw my::format_error.
+ */
+static void check_error(int line, const char* fmt)
+{
+	try
+	{
+		my::format(fmt, 1, "s");
+	}
+	catch (const my::format_error&)
+	{
+		return;
+	}
+
+	if (check_failed++ < CHECK_MAX_REPORTS)
+		printf("line %d: no error for \"%s\"\n", line, fmt);
+}
+
+/**
+ * Checks the fixed cases.
+ */
+static void check_fixed(void)
+{
+	std::string big(1000, 'x');
+	std::string s;
+	std::vector<char> v;
+	char arr[32];
+	char* end;
+
+	CHECK(my::format("hello"), "hello");
+	CHECK(my::format("{} {} {}", 1, "two", 3u), "1 two 3");
+	CHECK(my::format("{1} {0} {1}", "a", "b"), "b a b");
+	CHECK(my::format("{{}} {{{}}}", 5), "{} {5}");
+
+	// alignment and fill
+	CHECK(my::format("[{:*^9}]", "mid"), "[***mid***]");
+	CHECK(my::format("[{:*^8}]", "mid"), "[**mid***]");
+	CHECK(my::format("[{:>6}]", "r"), "[     r]");
+	CHECK(my::format("[{:6}]", "l"), "[l     ]");
+	CHECK(my::format("[{:6}]", 42), "[    42]");
+	CHECK(my::format("[{:<6}]", 42), "[42    ]");
+	CHECK(my::format("{:\xc3\xa9^5}", 1), "\xc3\xa9\xc3\xa9" "1" "\xc3\xa9\xc3\xa9");
+	CHECK(my::format("{:>1005}", big), "     " + big);
+	CHECK(my::format("<{}>", big), "<" + big + ">");
+
+	// integers
+	CHECK(my::format("[{:06}]", -42), "[-00042]");
+	CHECK(my::format("[{:#010x}]", 255), "[0x000000ff]");
+	CHECK(my::format("[{:#X}]", 255), "[0XFF]");
+	CHECK(my::format("[{:#o}]", 8), "[010]");
+	CHECK(my::format("{:x}", -255), "-ff");
+	CHECK(my::format("{}", -9223372036854775807LL - 1), "-9223372036854775808");
+	CHECK(my::format("{}", 18446744073709551615ULL), "18446744073709551615");
+	CHECK(my::format("{:x}", 18446744073709551615ULL), "ffffffffffffffff");
+
+	// bool, char and strings
+	CHECK(my::format("{} {}", true, false), "true false");
+	CHECK(my::format("{:d}", true), "1");
+	CHECK(my::format("{}{:d}", 'A', 'A'), "A65");
+	CHECK(my::format("{:c}", 66), "B");
+	CHECK(my::format("{:.3}", "abcdef"), "abc");
+	CHECK(my::format("{:>{}.{}}", "abcdef", 5, 2), "   ab");
+
+	// floats
+	CHECK(my::format("{}", 3.14159), "3.141590");
+	CHECK(my::format("{}", 0.1), "0.100000");
+	CHECK(my::format("{}", 1e300), ref("%f", 1e300));
+	CHECK(my::format("{:.2}", 0.125), "0.12");
+	CHECK(my::format("{:.2f}", 3.14159), "3.14");
+	CHECK(my::format("{:f}", 0.1), "0.100000");
+	CHECK(my::format("{:+.1e}", 12345.0), "+1.2e+04");
+	CHECK(my::format("{:010.2f}", -3.14159), "-000003.14");
+	CHECK(my::format("{:010f}", INFINITY), "       inf");
+	CHECK(my::format("{:e}", -NAN), "-nan");
+	CHECK(my::format("{:.3f}", 1.0005L), "1.001");
+	CHECK(my::format("{:.2f}", 2.675), "2.67");
+	CHECK(my::format("{:.0f}", 0.5), "0");
+	CHECK(my::format("{:a}", 1.5), "0x1.8p+0");
+	CHECK(my::format("{:.400f}", 1e-300), ref("%.400f", 1e-300));
+
+	// pointers
+	CHECK(my::format("{:>20}", (void*)0x1234), "    0000000000001234");
+	CHECK(my::format("{}", nullptr), my::format("{}", (void*)0));
+	CHECK(my::format("{:>20}", nullptr), my::format("{:>20}", (void*)0));
+
+	// errors
+	check_error(__LINE__, "{");
+	check_error(__LINE__, "}");
+	check_error(__LINE__, "{:q}");
+	check_error(__LINE__, "{0}{}");
+	check_error(__LINE__, "{}{0}");
+	check_error(__LINE__, "{2}");
+	check_error(__LINE__, "{:.}");
+	check_error(__LINE__, "{:.2d}");
+	check_error(__LINE__, "{:+s}");
+	check_error(__LINE__, "{1:d}");
+	try
+	{
+		my::format("{}", (const char*)nullptr);
+		check(__LINE__, "no error", "format_error");
+	}
+	catch (const my::format_error&)
+	{
+	}
+
+	// output iterators
+	my::format_to(std::back_inserter(s), "{}-{}", 1, big);
+	CHECK(s, "1-" + big);
+	my::format_to(std::back_inserter(v), "{:>4}", 7);
+	CHECK(std::string(v.begin(), v.end()), "   7");
+	end = my::format_to(arr, "{}|{}", 12, "ab");
+	*end = 0;
+	CHECK(arr, "12|ab");
+}
+
+/**
+ * Compares random fields with the matching % conversions.
+ *
+ * Params:
+ *   long - the number of fields
+ *   unsigned long - the seed of the generator
+ */
+static void check_random(long n, unsigned long seed)
+{
+	std::mt19937_64 rng(seed);
+	const char* strs[] = { "", "a", "hello", "longer string here" };
+
+	for (long i = 0; i < n; i++)
+	{
+		int flags = rng() % 16;
+		int width = rng() % 3 ? 0 : rng() % 30;
+		int prec = rng() % 2 ? -1 : rng() % 25;
+		int kind = rng() % 5;
+		std::string field = "{:", conv = "%", p;
+		std::string got, want;
+
+		if (flags & 1)
+		{
+			field += "<";
+			conv += "-";
+		}
+		if (flags & 2)
+		{
+			field += "+";
+			conv += "+";
+		}
+		else if (flags & 4)
+		{
+			field += " ";
+			conv += " ";
+		}
+		if ((flags & 8) && !(flags & 1))
+		{
+			field += "0";
+			conv += "0";
+		}
+		if (width)
+		{
+			field += std::to_string(width);
+			conv += std::to_string(width);
+		}
+		if (prec >= 0)
+			p = "." + std::to_string(prec);
+
+		if (kind == 0)
+		{
+			long long x = (long long)rng() >> (rng() % 64);
+
+			got = my::format(field + "}", x);
+			want = ref((conv + "lld").c_str(), x);
+		}
+		else if (kind <= 2)
+		{
+			char type = kind == 1 ? 'f' : 'e';
+			uint64_t bits = rng();
+			double d;
+
+			memcpy(&d, &bits, sizeof(d));
+			if (rng() % 2)
+				d = (double)(int64_t)(rng() >> (rng() % 64)) / (double)(1ULL << (rng() % 40));
+
+			// NaN signs and huge %f values are left to the fixed cases.
+			if (std::isnan(d) || (type == 'f' && std::fabs(d) > 1e30))
+				continue;
+
+			got = my::format(field + p + type + "}", d);
+			want = ref((conv + p + type).c_str(), d);
+		}
+		else if (kind == 3)
+		{
+			long double d = (long double)(int64_t)rng() / (long double)(1ULL << (rng() % 60));
+
+			got = my::format(field + p + "e}", d);
+			want = ref((conv + p + "Le").c_str(), d);
+		}
+		else
+		{
+			const char* str = strs[rng() % 4];
+
+			// Strings take no sign or zeros, and are on the left by default.
+			if (flags & 14)
+				continue;
+			if (!(flags & 1))
+				field = "{:>" + field.substr(2);
+
+			got = my::format(field + p + "}", str);
+			want = ref((conv + p + "s").c_str(), str);
+		}
+
+		if (got != want && check_failed++ < CHECK_MAX_REPORTS)
+			printf("random: \"%s\" got \"%s\" expected \"%s\"\n",
+				(field + p + "}").c_str(), got.c_str(), want.c_str());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	long n = 300000;
+	unsigned long seed = 42;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:r:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'n': n = strtol(optarg, NULL, 0); break;
+		case 'r': seed = strtoul(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-n random_cases] [-r seed]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	check_fixed();
+	check_random(n, seed);
+
+	printf("failed=%ld\n", check_failed);
+
+	return check_failed != 0;
+}
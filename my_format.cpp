@@ -0,0 +1,668 @@
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "my_format.hpp"
+
+namespace my {
+namespace detail {
+
+// no alignment was given, so the kind of argument decides
+#define ALIGN_NONE 0
+
+/**
+ * A replacement field, parsed.
+ * The ftag holds the flags, the width, the precision and the type, as a
+ * tag of my_printf would, with FMT_LEFT for the '<' alignment. The fill
+ * and the other alignments have no place in a tag.
+ */
+typedef struct field {
+	ftag tag;          // flags, width, precision and type
+	char align;        // '<', '>', '^' or ALIGN_NONE
+	char fill[4];      // the UTF-8 sequence of the fill character
+	size_t fill_len;   // number of characters in the fill
+}field;
+
+/**
+ * Makes room in a sink that only counts characters by discarding the
+ * contents of its buffer.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *
+ * Returns:
+ *   int - always 0
+ */
+static int count_flush(my_sink* sink)
+{
+	sink->pos = 0;
+
+	return 0;
+}
+
+/**
+ * Grows the string of a string sink, so that the engine writes directly
+ * into it.
+ *
+ * Params:
+ *   my_sink* - a sink whose data is a std::string
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if the string can't grow
+ */
+static int string_flush(my_sink* sink)
+{
+	std::string* s = static_cast<std::string*>(sink->data);
+
+	try
+	{
+		s->resize(s->size() * 2);
+	}
+	catch (...)
+	{
+		return 1;
+	}
+
+	sink->buf = &(*s)[0];
+	sink->size = s->size();
+
+	return 0;
+}
+
+/**
+ * Reads a decimal number of a replacement field.
+ *
+ * Params:
+ *   const char*& - the first digit, which is moved past the number
+ *   const char* - the end of the format string
+ *
+ * Returns:
+ *   size_t - the number
+ */
+static size_t parse_num(const char*& p, const char* end)
+{
+	size_t n = 0;
+
+	for (; p < end && *p >= '0' && *p <= '9'; p++)
+	{
+		if (n > (SIZE_MAX - 9) / 10)
+			throw format_error("number too large in format string");
+
+		n = n * 10 + (size_t)(*p - '0');
+	}
+
+	return n;
+}
+
+/**
+ * Finds the argument of a field or of a width or precision in a field,
+ * by its index or as the next one.
+ *
+ * Params:
+ *   const char*& - the character after the opening brace, which is moved
+ *     past the index
+ *   const char* - the end of the format string
+ *   size_t& - the next argument, or SIZE_MAX once an index has been seen
+ *   size_t - the number of arguments
+ *
+ * Returns:
+ *   size_t - the index of the argument
+ */
+static size_t parse_index(const char*& p, const char* end, size_t& next, size_t n)
+{
+	size_t i;
+
+	if (p < end && *p >= '0' && *p <= '9')
+	{
+		if (next != 0 && next != SIZE_MAX)
+			throw format_error("cannot switch from automatic to manual argument indexing");
+
+		i = parse_num(p, end);
+		next = SIZE_MAX;
+	}
+	else
+	{
+		if (next == SIZE_MAX)
+			throw format_error("cannot switch from manual to automatic argument indexing");
+
+		i = next++;
+	}
+
+	if (i >= n)
+		throw format_error("argument index out of range");
+
+	return i;
+}
+
+/**
+ * Reads a width or precision from an argument.
+ *
+ * Params:
+ *   const format_arg& - the argument, which must be a non-negative integer
+ *
+ * Returns:
+ *   size_t - the width or precision
+ */
+static size_t arg_size(const format_arg& a)
+{
+	if (a.kind == ARG_INT && a.i >= 0)
+		return (size_t)a.i;
+	if (a.kind == ARG_UINT)
+		return (size_t)a.u;
+
+	throw format_error("width or precision is not a non-negative integer");
+}
+
+/**
+ * Parses the format spec of a field, after the colon, up to the closing
+ * brace.
+ *
+ * Params:
+ *   const char*& - the first character of the spec, which is moved to the
+ *     closing brace
+ *   const char* - the end of the format string
+ *   size_t& - the next argument, for widths and precisions in braces
+ *   const format_arg* - the arguments
+ *   size_t - the number of arguments
+ *
+ * Returns:
+ *   field - the parsed field
+ */
+static field parse_spec(const char*& p,
+	const char* end,
+	size_t& next,
+	const format_arg* args,
+	size_t n)
+{
+	field f;
+	size_t len;
+
+	f.tag.flags = 0;
+	f.tag.width = 0;
+	f.tag.prec = 0;
+	f.tag.len = 0;
+	f.tag.spec = 0;
+	f.align = ALIGN_NONE;
+	f.fill[0] = ' ';
+	f.fill_len = 1;
+
+	// A fill is a whole UTF-8 sequence, and only comes with an alignment.
+	len = (unsigned char)*p >= 0xF0 ? 4
+		: (unsigned char)*p >= 0xE0 ? 3
+		: (unsigned char)*p >= 0xC0 ? 2
+		: 1;
+	if (p + len < end && (p[len] == '<' || p[len] == '>' || p[len] == '^'))
+	{
+		if (*p == '{' || *p == '}')
+			throw format_error("invalid fill character");
+
+		memcpy(f.fill, p, len);
+		f.fill_len = len;
+		p += len;
+	}
+	if (p < end && (*p == '<' || *p == '>' || *p == '^'))
+	{
+		f.align = *p++;
+		if (f.align == '<')
+			f.tag.flags |= FMT_LEFT;
+	}
+
+	if (p < end && *p == '+')
+		f.tag.flags |= FMT_SIGN;
+	else if (p < end && *p == ' ')
+		f.tag.flags |= FMT_SPACE;
+	if (p < end && (*p == '+' || *p == ' ' || *p == '-'))
+		p++;
+
+	if (p < end && *p == '#')
+	{
+		f.tag.flags |= FMT_POINT;
+		p++;
+	}
+
+	if (p < end && *p == '0')
+	{
+		f.tag.flags |= FMT_ZERO;
+		p++;
+	}
+
+	if (p < end && *p == '{')
+	{
+		p++;
+		f.tag.width = arg_size(args[parse_index(p, end, next, n)]);
+		f.tag.flags |= FMT_WIDTH;
+		if (p == end || *p++ != '}')
+			throw format_error("invalid width in format string");
+	}
+	else
+		f.tag.width = parse_num(p, end);
+
+	if (p < end && *p == '.')
+	{
+		p++;
+		if (p < end && *p == '{')
+		{
+			p++;
+			f.tag.prec = arg_size(args[parse_index(p, end, next, n)]);
+			f.tag.flags |= FMT_PREC;
+			if (p == end || *p++ != '}')
+				throw format_error("invalid precision in format string");
+		}
+		else if (p < end && *p >= '0' && *p <= '9')
+			f.tag.prec = parse_num(p, end);
+		else
+			throw format_error("missing precision in format string");
+
+		f.tag.flags |= FMT_ZPREC;
+	}
+
+	if (p < end && *p != '}')
+		f.tag.spec = *p++;
+
+	if (p == end || *p != '}')
+		throw format_error("invalid format spec");
+
+	return f;
+}
+
+/**
+ * Writes the fill of a field a number of times.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const field& - the field
+ *   size_t - the number of fill characters
+ */
+static void write_fill(my_sink* sink, const field& f, size_t n)
+{
+	if (f.fill_len == 1)
+	{
+		for (; n > 0; n--)
+			my_sink_putc(sink, f.fill[0]);
+	}
+	else
+	{
+		for (; n > 0; n--)
+			my_sink_write(sink, f.fill, f.fill_len);
+	}
+}
+
+/**
+ * Writes the body of a field with the fill, sign and prefix around it.
+ * Without a width, the body goes straight to the sink. Otherwise its
+ * length is found first by writing it to a sink that only counts, unless
+ * the caller already knows it.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const field& - the field
+ *   const char* - the sign and prefix, which are not filled with zeros
+ *   size_t - the length of the body, or SIZE_MAX if it must be counted
+ *   int - non-zero to fill the width with zeros after the prefix
+ *   Body - writes the body to a sink
+ */
+template <class Body>
+static void write_padded(my_sink* sink,
+	const field& f,
+	const char* prefix,
+	size_t len,
+	int zero,
+	Body body)
+{
+	size_t plen = strlen(prefix);
+	size_t pad, left;
+
+	if (f.tag.width == 0)
+	{
+		my_sink_write(sink, prefix, plen);
+		body(sink);
+		return;
+	}
+
+	if (len == SIZE_MAX)
+	{
+		my_sink count;
+		char buf[256];
+
+		count.buf = buf;
+		count.size = sizeof(buf);
+		count.pos = 0;
+		count.count = 0;
+		count.err = 0;
+		count.flush = count_flush;
+		count.span = nullptr;
+		count.data = nullptr;
+
+		body(&count);
+		len = count.count;
+	}
+
+	pad = plen + len < f.tag.width ? f.tag.width - plen - len : 0;
+
+	if (zero)
+	{
+		my_sink_write(sink, prefix, plen);
+		for (; pad > 0; pad--)
+			my_sink_putc(sink, '0');
+		body(sink);
+		return;
+	}
+
+	left = f.align == '<' ? 0 : f.align == '^' ? pad / 2 : pad;
+	write_fill(sink, f, left);
+	my_sink_write(sink, prefix, plen);
+	body(sink);
+	write_fill(sink, f, pad - left);
+}
+
+/**
+ * Writes an integer in the base of the type of a field.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   field& - the field, whose alignment defaults to the right
+ *   unsigned long long - the absolute value
+ *   int - non-zero if the value is negative
+ */
+static void write_int(my_sink* sink, field& f, unsigned long long u, int neg)
+{
+	char prefix[4];
+	size_t n = 0;
+	int zero;
+	ftag t;
+
+	if (f.tag.flags & FMT_ZPREC)
+		throw format_error("precision not allowed for integers");
+
+	if (neg)
+		prefix[n++] = '-';
+	else if (f.tag.flags & FMT_SIGN)
+		prefix[n++] = '+';
+	else if (f.tag.flags & FMT_SPACE)
+		prefix[n++] = ' ';
+
+	if ((f.tag.flags & FMT_POINT) && f.tag.spec != 'd' && f.tag.spec != 0)
+	{
+		prefix[n++] = '0';
+		if (f.tag.spec != 'o')
+			prefix[n++] = f.tag.spec;
+	}
+	prefix[n] = '\0';
+
+	// Zeros only fill the width when there is no alignment.
+	zero = (f.tag.flags & FMT_ZERO) && f.align == ALIGN_NONE;
+	if (f.align == ALIGN_NONE)
+		f.align = '>';
+
+	t = f.tag;
+	write_padded(sink, f, prefix, SIZE_MAX, zero,
+		[&](my_sink* s) { my_conv_ull(s, u, &t); });
+}
+
+/**
+ * Writes a string, or a character as a string of one.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   field& - the field, whose alignment defaults to the left
+ *   const char* - the string
+ *   size_t - the number of characters in the string
+ */
+static void write_str(my_sink* sink, field& f, const char* s, size_t len)
+{
+	if (f.tag.flags & (FMT_SIGN | FMT_SPACE | FMT_POINT | FMT_ZERO))
+		throw format_error("sign, # and 0 are only allowed for numbers");
+
+	if (f.align == ALIGN_NONE)
+		f.align = '<';
+
+	write_padded(sink, f, "", len, 0,
+		[&](my_sink* k) { my_sink_write(k, s, len); });
+}
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
+/**
+ * Writes a float with the conversion of the type of a field.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   field& - the field, whose alignment defaults to the right
+ *   const format_arg& - the argument, a double or a long double
+ */
+static void write_float(my_sink* sink, field& f, const format_arg& a)
+{
+	long double v = a.kind == ARG_LDOUBLE ? a.ld : (long double)a.d;
+	int neg = std::signbit(v);
+	char prefix[2] = { 0, 0 };
+	int zero;
+	ftag t;
+
+	if (neg)
+		prefix[0] = '-';
+	else if (f.tag.flags & FMT_SIGN)
+		prefix[0] = '+';
+	else if (f.tag.flags & FMT_SPACE)
+		prefix[0] = ' ';
+
+	// The sign is written here, so that zeros can go after it.
+	t = f.tag;
+	t.flags &= ~(FMT_LEFT | FMT_SIGN | FMT_SPACE | FMT_ZERO | FMT_WIDTH | FMT_PREC);
+	t.width = 0;
+
+	// Without a type, a float is written as with f, so with 6 digits
+	// after the point unless there is a precision.
+	if (t.spec == 0)
+		t.spec = 'f';
+	if (t.spec != 'f' && t.spec != 'e' && t.spec != 'E'
+		&& t.spec != 'a' && t.spec != 'A')
+		throw format_error("invalid type for a float");
+	if ((t.spec == 'a' || t.spec == 'A') && a.kind == ARG_LDOUBLE)
+		throw format_error("a and A are not available for long double");
+
+	// Infinity and NaN are filled with spaces, as if there were no '0'.
+	zero = (f.tag.flags & FMT_ZERO) && f.align == ALIGN_NONE && std::isfinite(v);
+	if (f.align == ALIGN_NONE)
+		f.align = '>';
+
+	write_padded(sink, f, prefix, SIZE_MAX, zero,
+		[&](my_sink* s) {
+			// A double is exact as a long double, and the long double
+			// conversions round it correctly for any precision.
+			if (t.spec == 'f')
+				my_conv_Lf(s, std::fabs(v), &t);
+			else if (t.spec == 'e' || t.spec == 'E')
+				my_conv_Le(s, std::fabs(v), &t);
+			else
+				my_conv_a(s, std::fabs(a.d), &t);
+		});
+}
+
+#endif
+
+/**
+ * Writes one argument as its field describes.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   field& - the parsed field
+ *   const format_arg& - the argument
+ */
+static void write_arg(my_sink* sink, field& f, const format_arg& a)
+{
+	char spec = f.tag.spec;
+	int is_int = spec == 'd' || spec == 'x' || spec == 'X' || spec == 'o';
+	char c;
+
+	switch (a.kind)
+	{
+	case ARG_BOOL:
+		if (is_int)
+			write_int(sink, f, a.b, 0);
+		else if (spec == 0 || spec == 's')
+			write_str(sink, f, a.b ? "true" : "false", a.b ? 4 : 5);
+		else
+			throw format_error("invalid type for bool");
+		break;
+
+	case ARG_CHAR:
+		if (is_int)
+			write_int(sink, f, a.c < 0 ? 0 - (unsigned long long)a.c : (unsigned long long)a.c, a.c < 0);
+		else if (spec == 0 || spec == 'c')
+			write_str(sink, f, &a.c, 1);
+		else
+			throw format_error("invalid type for char");
+		break;
+
+	case ARG_INT:
+	case ARG_UINT:
+		if (spec == 'c')
+		{
+			if (a.kind == ARG_INT ? a.i < CHAR_MIN || a.i > UCHAR_MAX : a.u > UCHAR_MAX)
+				throw format_error("integer out of range for c");
+
+			c = (char)(a.kind == ARG_INT ? a.i : (long long)a.u);
+			write_str(sink, f, &c, 1);
+		}
+		else if (spec == 0 || is_int)
+		{
+			if (a.kind == ARG_UINT)
+				write_int(sink, f, a.u, 0);
+			else
+				write_int(sink, f, a.i < 0 ? 0 - (unsigned long long)a.i : (unsigned long long)a.i, a.i < 0);
+		}
+		else
+			throw format_error("invalid type for an integer");
+		break;
+
+	case ARG_DOUBLE:
+	case ARG_LDOUBLE:
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+		write_float(sink, f, a);
+		break;
+#else
+		throw format_error("floats are not in MY_PRINTF_TIER");
+#endif
+
+	case ARG_STR:
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_STR
+		if (spec != 0 && spec != 's')
+			throw format_error("invalid type for a string");
+		if (a.s.data == nullptr)
+			throw format_error("string pointer is null");
+
+		write_str(sink, f, a.s.data,
+			(f.tag.flags & FMT_ZPREC) && f.tag.prec < a.s.size ? f.tag.prec : a.s.size);
+		break;
+#else
+		throw format_error("strings are not in MY_PRINTF_TIER");
+#endif
+
+	case ARG_PTR:
+		if (spec != 0 && spec != 'p')
+			throw format_error("invalid type for a pointer");
+		if (f.tag.flags & (FMT_SIGN | FMT_SPACE | FMT_POINT | FMT_ZERO | FMT_ZPREC))
+			throw format_error("invalid format spec for a pointer");
+
+		if (f.align == ALIGN_NONE)
+			f.align = '>';
+		write_padded(sink, f, "", sizeof(uintptr_t) * 2, 0,
+			[&](my_sink* s) { my_conv_p(s, a.p); });
+		break;
+	}
+}
+
+void vformat_to(my_sink* sink, std::string_view fmt, const format_arg* args, size_t n)
+{
+	const char* p = fmt.data();
+	const char* end = p + fmt.size();
+	const char* lit;   // start of a run of literal characters
+	size_t next = 0;   // next automatic argument, or SIZE_MAX for manual
+	size_t i;
+	field f;
+
+	while (p < end)
+	{
+		// Write the literal characters up to the next brace.
+		for (lit = p; p < end && *p != '{' && *p != '}'; p++);
+		my_sink_write(sink, lit, (size_t)(p - lit));
+		if (p == end)
+			break;
+
+		if (*p == '}')
+		{
+			if (p + 1 == end || p[1] != '}')
+				throw format_error("unmatched '}' in format string");
+
+			my_sink_putc(sink, '}');
+			p += 2;
+			continue;
+		}
+
+		p++;
+		if (p < end && *p == '{')
+		{
+			my_sink_putc(sink, '{');
+			p++;
+			continue;
+		}
+
+		i = parse_index(p, end, next, n);
+
+		if (p < end && *p == ':')
+		{
+			p++;
+			f = parse_spec(p, end, next, args, n);
+		}
+		else if (p < end && *p == '}')
+		{
+			f.tag.flags = 0;
+			f.tag.width = 0;
+			f.tag.prec = 0;
+			f.tag.len = 0;
+			f.tag.spec = 0;
+			f.align = ALIGN_NONE;
+			f.fill[0] = ' ';
+			f.fill_len = 1;
+		}
+		else
+			throw format_error("invalid replacement field");
+
+		write_arg(sink, f, args[i]);
+
+		// Move past the closing brace.
+		p++;
+	}
+}
+
+std::string vformat(std::string_view fmt, const format_arg* args, size_t n)
+{
+	std::string s;
+	my_sink sink;
+
+	// Most strings fit in the format string and a few characters for each
+	// argument, and the rest grow the string.
+	s.resize(fmt.size() + 16 * n + 16);
+
+	sink.buf = &s[0];
+	sink.size = s.size();
+	sink.pos = 0;
+	sink.count = 0;
+	sink.err = 0;
+	sink.flush = string_flush;
+	sink.span = nullptr;
+	sink.data = &s;
+
+	vformat_to(&sink, fmt, args, n);
+	if (sink.err)
+		throw std::bad_alloc();
+
+	s.resize(sink.count);
+
+	return s;
+}
+
+}
+}
@@ -0,0 +1,380 @@
+#ifndef MY_FORMAT_HPP
+#define MY_FORMAT_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "my_printf.h"
+
+/**
+ * Formatting with the replacement fields of std::format, such as "{}",
+ * "{0:>8}" and "{:+.3e}", for C++17 and later.
+ * Each field is parsed into an ftag and written with the my_conv_
+ * conversions, so the output comes from the same engine as my_printf.
+ *
+ * Build:
+ *   gcc -O2 -c my_printf.c
+ *   g++ -std=c++17 -O2 -pthread -o program program.cpp my_format.cpp my_printf.o
+ *
+ * A replacement field is
+ *   {[index][:[[fill]align][sign][#][0][width][.precision][type]]}
+ *
+ * The index is the position of the argument. Fields without one take the
+ * arguments in order, and the two can't be mixed. "{{" and "}}" are written
+ * as "{" and "}".
+ *
+ * Potential alignments:
+ *   < on the left, the default for strings, characters and bool
+ *   > on the right, the default for numbers and pointers
+ *   ^ in the middle, with the extra fill on the right
+ * The fill is any one character other than '{' and '}', including a UTF-8
+ * sequence, and is a space by default.
+ *
+ * Potential signs, for numbers:
+ *   + a '+' before numbers that are not negative
+ *   [space] a space before numbers that are not negative
+ *   - only a '-' before negative numbers, the default
+ *
+ * The '#' flag writes 0x, 0X or 0 before integers written with x, X or o,
+ * and is passed on to the float conversions as for %#e. The '0' flag fills
+ * the width with zeros after the sign and prefix, unless there is an
+ * alignment or the number is infinite or NaN.
+ *
+ * The width is the minimum number of bytes, and the precision is the
+ * number of digits after the point for floats, or the maximum number of
+ * bytes of a string. Either can be taken from an argument with "{}" or
+ * "{index}" in its place, such as "{:>{}.{}f}".
+ *
+ * Potential types:
+ *   s strings and bool, the default for them
+ *   c a character, the default for char, or an integer as a character
+ *   d decimal integer, the default for integers
+ *   x hexadecimal integer (lower case letters)
+ *   X hexadecimal integer (capital letters)
+ *   o octal integer
+ *   f decimal floating point, exact to the precision, which defaults to 6
+ *   e scientific notation using 'e' character
+ *   E scientific notation using 'E' character
+ *   a hexadecimal floating point, such as 0x1.8p+3, for float and double
+ *   A hexadecimal floating point, such as 0X1.8P+3, for float and double
+ *   p pointer address, as %p writes it, the default for pointers
+ * Integers keep their sign in every base, so -255 with x is -ff. bool and
+ * char are written as integers with d, x, X or o. A float without a type
+ * is written as with f, so 3.14159 is 3.141590 and 0.1 is 0.100000.
+ *
+ * Fields that don't fit their argument, arguments that are missing and
+ * conversions left out of MY_PRINTF_TIER throw my::format_error.
+ */
+namespace my {
+
+/**
+ * The exception thrown for a format string that can't be used with its
+ * arguments.
+ */
+class format_error : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+
+// kinds of format arguments
+enum arg_kind : unsigned char {
+	ARG_BOOL,    // bool
+	ARG_CHAR,    // char
+	ARG_INT,     // signed integer
+	ARG_UINT,    // unsigned integer
+	ARG_DOUBLE,  // float or double
+	ARG_LDOUBLE, // long double
+	ARG_STR,     // string, which is not zero terminated
+	ARG_PTR      // pointer
+};
+
+/**
+ * A format argument, with its type erased.
+ */
+struct format_arg {
+	arg_kind kind;          // ARG_ kind of the value
+	union {
+		bool b;
+		char c;
+		long long i;
+		unsigned long long u;
+		double d;
+		long double ld;
+		const void* p;
+		struct {
+			const char* data;
+			size_t size;
+		}s;
+	};
+};
+
+/**
+ * Erases the type of a format argument.
+ * Types that can't be formatted are refused when the call is compiled.
+ *
+ * Params:
+ *   const T& - the argument
+ *
+ * Returns:
+ *   format_arg - the kind and the value of the argument
+ */
+template <class T>
+inline format_arg make_arg(const T& v)
+{
+	format_arg a;
+
+	if constexpr (std::is_same_v<T, bool>)
+	{
+		a.kind = ARG_BOOL;
+		a.b = v;
+	}
+	else if constexpr (std::is_same_v<T, char>)
+	{
+		a.kind = ARG_CHAR;
+		a.c = v;
+	}
+	else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+	{
+		a.kind = ARG_INT;
+		a.i = v;
+	}
+	else if constexpr (std::is_integral_v<T>)
+	{
+		a.kind = ARG_UINT;
+		a.u = v;
+	}
+	else if constexpr (std::is_same_v<T, long double>)
+	{
+		a.kind = ARG_LDOUBLE;
+		a.ld = v;
+	}
+	else if constexpr (std::is_floating_point_v<T>)
+	{
+		a.kind = ARG_DOUBLE;
+		a.d = v;
+	}
+	else if constexpr (std::is_same_v<T, char*> || std::is_same_v<T, const char*>)
+	{
+		// A NULL string is refused when it is formatted.
+		a.kind = ARG_STR;
+		a.s.data = v;
+		a.s.size = v != nullptr ? std::char_traits<char>::length(v) : 0;
+	}
+	else if constexpr (std::is_null_pointer_v<T>
+		|| (std::is_pointer_v<T> && !std::is_function_v<std::remove_pointer_t<T>>))
+	{
+		// Before the strings, since nullptr converts to std::string_view.
+		a.kind = ARG_PTR;
+		a.p = v;
+	}
+	else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+	{
+		std::string_view sv = v;
+
+		a.kind = ARG_STR;
+		a.s.data = sv.data();
+		a.s.size = sv.size();
+	}
+	else
+		static_assert(sizeof(T) == 0, "my::format can't format this type");
+
+	return a;
+}
+
+/**
+ * A sink that writes to an output iterator.
+ * Exceptions thrown by the iterator are kept until the engine returns,
+ * since they can't be thrown through it.
+ */
+template <class OutputIt>
+int iterator_flush(my_sink* sink);
+
+template <class OutputIt>
+struct iterator_sink {
+	my_sink sink;               // the sink given to the engine
+	OutputIt out;               // where the characters go
+	std::exception_ptr err;     // exception thrown by the iterator
+	char buf[256];              // output buffer
+
+	explicit iterator_sink(OutputIt it) : out(std::move(it))
+	{
+		sink.buf = buf;
+		sink.size = sizeof(buf);
+		sink.pos = 0;
+		sink.count = 0;
+		sink.err = 0;
+		sink.flush = iterator_flush<OutputIt>;
+		sink.span = nullptr;
+		sink.data = this;
+	}
+};
+
+/**
+ * Gets the container of a back_insert_iterator, so that a whole buffer
+ * can be inserted at once instead of one character at a time.
+ */
+template <class C>
+struct back_inserted : std::back_insert_iterator<C> {
+	static C& get(std::back_insert_iterator<C>& it)
+	{
+		return *(it.*(&back_inserted::container));
+	}
+};
+
+// determines if an output iterator is a back_insert_iterator
+template <class T>
+struct is_back_inserter : std::false_type {};
+template <class C>
+struct is_back_inserter<std::back_insert_iterator<C>> : std::true_type {};
+
+/**
+ * Empties the buffer of an iterator_sink into its iterator.
+ *
+ * Params:
+ *   my_sink* - the sink of an iterator_sink
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if the iterator threw
+ */
+template <class OutputIt>
+int iterator_flush(my_sink* sink)
+{
+	iterator_sink<OutputIt>* is = static_cast<iterator_sink<OutputIt>*>(sink->data);
+
+	try
+	{
+		if constexpr (is_back_inserter<OutputIt>::value)
+		{
+			auto& c = back_inserted<typename OutputIt::container_type>::get(is->out);
+			c.insert(c.end(), sink->buf, sink->buf + sink->pos);
+		}
+		else
+			is->out = std::copy(sink->buf, sink->buf + sink->pos, is->out);
+	}
+	catch (...)
+	{
+		is->err = std::current_exception();
+		return 1;
+	}
+
+	sink->pos = 0;
+
+	return 0;
+}
+
+/**
+ * Formats the arguments of a format string into a sink.
+ * Nothing is flushed at the end.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   std::string_view - a format string with replacement fields
+ *   const format_arg* - the arguments
+ *   size_t - the number of arguments
+ */
+void vformat_to(my_sink* sink, std::string_view fmt, const format_arg* args, size_t n);
+
+/**
+ * Formats the arguments of a format string into a new string.
+ *
+ * Params:
+ *   std::string_view - a format string with replacement fields
+ *   const format_arg* - the arguments
+ *   size_t - the number of arguments
+ *
+ * Returns:
+ *   std::string - the formatted string
+ */
+std::string vformat(std::string_view fmt, const format_arg* args, size_t n);
+
+}
+
+/**
+ * Formats the arguments of a format string into a sink, such as the
+ * sinks of my_vformat. The buffer of the sink is not flushed.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   std::string_view - a format string with replacement fields
+ *   const Args&... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters in the sink, or -1 if the sink failed
+ */
+template <class... Args>
+int format_to(my_sink* sink, std::string_view fmt, const Args&... args)
+{
+	const std::array<detail::format_arg, sizeof...(Args)> list = {
+		detail::make_arg(args)...
+	};
+
+	detail::vformat_to(sink, fmt, list.data(), list.size());
+
+	return sink->err ? -1 : (int)sink->count;
+}
+
+/**
+ * Formats the arguments of a format string into an output iterator of
+ * characters.
+ *
+ * Params:
+ *   OutputIt - where to write the characters
+ *   std::string_view - a format string with replacement fields
+ *   const Args&... - the values to be converted to strings
+ *
+ * Returns:
+ *   OutputIt - the iterator past the last character written
+ */
+template <class OutputIt, class... Args>
+OutputIt format_to(OutputIt out, std::string_view fmt, const Args&... args)
+{
+	const std::array<detail::format_arg, sizeof...(Args)> list = {
+		detail::make_arg(args)...
+	};
+	detail::iterator_sink<OutputIt> is(std::move(out));
+
+	detail::vformat_to(&is.sink, fmt, list.data(), list.size());
+	if (is.sink.pos > 0)
+		detail::iterator_flush<OutputIt>(&is.sink);
+
+	if (is.err)
+		std::rethrow_exception(is.err);
+
+	return std::move(is.out);
+}
+
+/**
+ * Formats the arguments of a format string into a string.
+ * The characters are written directly into the string, which is returned
+ * without being copied.
+ *
+ * Params:
+ *   std::string_view - a format string with replacement fields
+ *   const Args&... - the values to be converted to strings
+ *
+ * Returns:
+ *   std::string - the formatted string
+ */
+template <class... Args>
+std::string format(std::string_view fmt, const Args&... args)
+{
+	const std::array<detail::format_arg, sizeof...(Args)> list = {
+		detail::make_arg(args)...
+	};
+
+	return detail::vformat(fmt, list.data(), list.size());
+}
+
+}
+
+#endif
@@ -1,19 +1,51 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include "my_printf.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdarg.h>
 #include <string.h>
+#include <wchar.h>
+#include <errno.h>
+#include <float.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(MY_PRINTF_STATS) || defined(MY_PRINTF_POSIX)
+#include <stdatomic.h>
+#endif
+
+#ifdef MY_PRINTF_POSIX
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#endif
 
-// format flag bit flags
-#define FMT_LEFT   0x01 /* -                               */
-#define FMT_SIGN   0x02 /* +                               */
-#define FMT_SPACE  0x04 /* [space]                         */
-#define FMT_POINT  0x08 /* #                               */
-#define FMT_ZERO   0x10 /* 0                               */
-#define FMT_WIDTH  0x20 /* width is passed as argument     */
-#define FMT_PREC   0x40 /* precision is passed as argument */
-#define FMT_ZPREC  0x40 /* precision is zero               */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define MY_PRINTF_URING
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// Format strings are compiled to machine code on x86-64 Linux, unless
+// MY_PRINTF_NO_JIT is defined.
+#if defined(__x86_64__) && defined(__linux__) && defined(MY_PRINTF_POSIX) \
+	&& !defined(MY_PRINTF_NO_JIT)
+#define MY_PRINTF_JIT
+#endif
 
 // format specifiers
 #define SPEC_c 'c'
@@ -26,17 +58,23 @@
 #define SPEC_E 'E'
 #define SPEC_g 'g'
 #define SPEC_G 'G'
+#define SPEC_a 'a'
+#define SPEC_A 'A'
 #define SPEC_o 'o'
 #define SPEC_x 'x'
 #define SPEC_X 'X'
 #define SPEC_p 'p'
 #define SPEC_n 'n'
+#define SPEC_T 'T'
+#define SPEC_J 'J'
+#define SPEC_k 'k'
 #define SPEC_per '%'
 
-// format length bit flags
-#define LEN_h 0x01 /* h */
-#define LEN_l 0x02 /* l */
-#define LEN_L 0x04 /* L */
+// number of named specifiers, with one slot kept empty
+#define NAMED_N 128
+
+// bit of the specifier of a tag that refers to a named specifier
+#define SPEC_NAMED 0x80
 
 // format tag parser states
 #define STATE_FLAGS  1
@@ -79,6 +117,9 @@
     l = c == 'h' ? LEN_h \
     : c == 'l' ? LEN_l   \
     : c == 'L' ? LEN_L   \
+    : c == 'W' ? LEN_W   \
+    : c == 'U' ? LEN_U   \
+    : c == 'Q' ? LEN_Q   \
     : 0                  \
 )
 
@@ -103,57 +144,143 @@
     : c == 'E' ? SPEC_E   \
     : c == 'g' ? SPEC_g   \
     : c == 'G' ? SPEC_G   \
+    : c == 'a' ? SPEC_a   \
+    : c == 'A' ? SPEC_A   \
     : c == 'o' ? SPEC_o   \
     : c == 'x' ? SPEC_x   \
     : c == 'X' ? SPEC_X   \
     : c == 'p' ? SPEC_p   \
     : c == 'n' ? SPEC_n   \
+    : c == 'T' ? SPEC_T   \
+    : c == 'J' ? SPEC_J   \
+    : c == 'k' ? SPEC_k   \
     : c == '%' ? SPEC_per \
     : 0                   \
 )
 
-#define FLOAT_SGN_BIT(n) ((n & 0x80000000) >> 31)
-#define FLOAT_EXP_BIT(n) (((n & 0x7F800000) >> 23) - 0x7F)
-#define FLOAT_MNT_BIT(n) ((n & 0x007FFFFF) | 0x00800000)
-
-// maximum exponent absolute value
-#define FLOAT_EXP_N 151
-
-// maximum digits in binary number component
-#define FLOAT_BIN_DIG 152
-
+/**
+ * Reads the width and precision of a format tag from the argument list
+ * when the tag has '*' in place of them.
+ * A negative width means left-justify, and a negative precision is
+ * treated as if the precision was omitted.
+ *
+ * Params:
+ *   t - a format tag
+ *   argp - the argument list
+ */
+#define tag_args(t, argp) do {                           \
+    int a_;                                              \
+    if ((t).flags & FMT_WIDTH)                           \
+    {                                                    \
+        a_ = va_arg(argp, int);                          \
+        if (a_ < 0)                                      \
+        {                                                \
+            (t).flags |= FMT_LEFT;                       \
+            a_ = -a_;                                    \
+        }                                                \
+        (t).width = (size_t)a_;                          \
+    }                                                    \
+    if ((t).flags & FMT_PREC)                            \
+    {                                                    \
+        a_ = va_arg(argp, int);                          \
+        (t).prec = a_ < 0 ? 0 : (size_t)a_;              \
+        if (a_ >= 0)                                     \
+            (t).flags |= FMT_ZPREC;                      \
+    }                                                    \
+} while (0)
 
 #define DOUBLE_SGN_BIT(n) ((n & 0x8000000000000000) >> 63)
 #define DOUBLE_EXP_BIT(n) (((n & 0x7FF0000000000000) >> 52) - 0x3FF)
 #define DOUBLE_MNT_BIT(n) ((n & 0xFFFFFFFFFFFFF) | 0x10000000000000)
 
-// maximum exponent absolute value
-#define DOUBLE_EXP_N 1200
-
 // maximum digits in binary number component
 #define DOUBLE_BIN_DIG 1200
 
+// base of the limbs of the decimal numbers used to convert floats
+#define LIMB_BASE 1000000000
 
-/**
- * A format tag within a format string.
- */
-typedef struct ftag {
-	unsigned char flags;
-	size_t width;
-	size_t prec;
-	unsigned char len;
-	char spec;
-}ftag;
+// maximum number of limbs, enough for a 53-bit mantissa times 5^1074
+#define LIMB_N 96
+
+// maximum number of limbs of a long double or __float128, enough for a
+// 113-bit mantissa times 5^16494
+#define WIDE_LIMB_N 1290
+
+// largest exponents in the tables of small powers of two and five
+#define POW2_SMALL_MAX 31
+#define POW5_SMALL_MAX 13
+
+// size of the buffers used by the built-in sinks
+#define MY_SINK_BUF 256
+
+// default size of the chunks of an arena
+#define ARENA_CHUNK 4096
+
+// shortest span that a sink takes by reference
+#define SPAN_MIN 64
+
+// number of entries in the vector of a writev sink
+#define IOV_N 64
+
+// number of entries in the io_uring of an asynchronous sink
+#define AIO_RING_N 4
+
+// default size of each buffer of an asynchronous sink
+#define AIO_BUF (64 * 1024)
+
+// records in the first chunk a worker formats, before its cost is known
+#define REC_CHUNK_MIN 8
+
+// time that a chunk of records should take to format, in nanoseconds
+#define REC_CHUNK_NS 200000
+
+// initial size of the buffer of a chunk of records
+#define REC_PIECE_BUF 4096
+
+// longest run of literal characters that compiled code stores inline
+#define JIT_LIT_MAX 32
+
+// log file constants
+#define LOG_MAGIC   0x474F4C464E525000ULL /* "\0PRNFLOG"               */
+#define LOG_WINDOW  (1 << 20)             /* default window size       */
+#define LOG_REC_HDR 4                     /* size of a record header   */
+#define LOG_LEN     0x3FFFFFFFU           /* record length mask        */
+#define LOG_PENDING 0x40000000U           /* record is being written   */
+#define LOG_DONE    0x80000000U           /* record is complete        */
+#define LOG_PAD     0xC0000000U           /* record is padding         */
+
+// statistics counter indices
+#define STAT_CALLS       0
+#define STAT_BYTES       1
+#define STAT_FLOAT_FAST  2
+#define STAT_FLOAT_EXACT 3
+#define STAT_FLUSHES     4
+#define STAT_TRUNC       5
+#define STAT_SPEC        6 /* first of 128 counters, one per character */
+#define STAT_N           (STAT_SPEC + 128)
 
 /**
- * An IEEE 754 single-precision floating point number.
+ * Adds a value to one of the statistics counters of the current thread.
+ * STAT_ADD_TO does the same with counters that were already looked up
+ * with STATS_GET, which saves the thread-local lookup in hot loops.
+ * When the library is built without MY_PRINTF_STATS, these expand to
+ * nothing.
+ *
+ * Params:
+ *   b - a variable declared with STATS_GET
+ *   i - the index of the counter
+ *   n - the value to add
  */
-typedef struct ieee_754_float {
-	uint32_t raw;  // raw, 32-bit binary data
-	uint8_t sign;  // sign (0 for positive, 1 for negative)
-	int8_t exp;    // exponent
-	uint32_t mant; // mantissa
-}ieee_754_float;
+#ifdef MY_PRINTF_STATS
+#define STATS_GET(b) stats_block* b = stats_get()
+#define STAT_ADD_TO(b, i, n) stats_add((b), (i), (n))
+#define STAT_ADD(i, n) stats_add(stats_get(), (i), (n))
+#else
+#define STATS_GET(b)
+#define STAT_ADD_TO(b, i, n)
+#define STAT_ADD(i, n)
+#endif
+
 
 /**
  * An IEEE 754 double-precision floating point number.
@@ -165,64 +292,81 @@ typedef struct ieee_754_double {
 	uint64_t mant; // mantissa
 }ieee_754_double;
 
+/**
+ * An x87 extended precision or IEEE 754 quadruple-precision floating point
+ * number. The mantissa has up to 113 bits, so it is split in two, and the
+ * value is the mantissa times 2^exp.
+ */
+typedef struct ieee_754_wide {
+	uint8_t sign;  // sign (0 for positive, 1 for negative)
+	uint8_t cls;   // 0 for a number, 1 for infinity, 2 for NaN
+	int32_t exp;   // exponent of the lowest bit of the mantissa
+	uint64_t hi;   // upper 64 bits of the mantissa
+	uint64_t lo;   // lower 64 bits of the mantissa
+}ieee_754_wide;
+
 
 
 
 /**
- * Converts a float to a uint32_t by moving the raw binary data into an
+ * Converts a double to a uint64_t by moving the raw binary data into an
  * integer register.
  * This particular implementation is intended for 64-bit Microsoft Windows
  * systems running on an x86 architecture.
  *
  * Params:
- *   float - a 32-bit IEEE 754 single-precision floating point number
+ *   double - a 64-bit IEEE 754 double-precision floating point number
  *
  * Returns:
  *   uint32_t - the raw binary data of the floating point number
  */
 #ifdef _WIN64
-extern uint32_t extract_float_win64(float f);
+extern uint64_t extract_double_win64(double d);
 #endif
 
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
 /**
- * Converts a double to a uint64_t by moving the raw binary data into an
- * integer register.
- * This particular implementation is intended for 64-bit Microsoft Windows
- * systems running on an x86 architecture.
+ * Extracts the raw binary components of a 64-bit IEEE 754 double-precision
+ * floating point number.
  *
  * Params:
  *   double - a 64-bit IEEE 754 double-precision floating point number
  *
  * Returns:
- *   uint32_t - the raw binary data of the floating point number
+ *   ieee_754_double - the individual binary components of the number
  */
-#ifdef _WIN64
-extern uint64_t extract_double_win64(double d);
-#endif
+static ieee_754_double extract_double(double d);
 
 /**
- * Extracts the raw binary components of a 32-bit IEEE 754 single-precision
- * floating point number.
+ * Extracts the binary components of a long double. This is an x87 80-bit
+ * extended precision number on x86, and an IEEE 754 quadruple-precision
+ * number where long double has a 113-bit mantissa. Anywhere else, the
+ * value is taken as a double.
  *
  * Params:
- *   float - a 32-bit IEEE 754 single-precision floating point number
+ *   long double - a long double
  *
  * Returns:
- *   ieee_754_float - the individual binary components of the number
+ *   ieee_754_wide - the individual binary components of the number
  */
-static ieee_754_float extract_float(float f);
+static ieee_754_wide extract_ldouble(long double ld);
 
+#ifdef MY_PRINTF_FLOAT128
 /**
- * Extracts the raw binary components of a 64-bit IEEE 754 double-precision
+ * Extracts the binary components of a 128-bit IEEE 754 quadruple-precision
  * floating point number.
  *
  * Params:
- *   double - a 64-bit IEEE 754 double-precision floating point number
+ *   __float128 - a 128-bit IEEE 754 quadruple-precision number
  *
  * Returns:
- *   ieee_754_double - the individual binary components of the number
+ *   ieee_754_wide - the individual binary components of the number
  */
-static ieee_754_double extract_double(double d);
+static ieee_754_wide extract_float128(__float128 q);
+#endif
+
+#endif
 
 /**
  * Reverses the order of a character array.
@@ -316,28 +460,7 @@ static ftag parse_format(const char* start, char** end);
 
 
 
-static ieee_754_float extract_float(float f)
-{
-	ieee_754_float comp;
-	uint32_t raw;
-
-#ifdef _WIN64
-	raw = extract_float_win64(f);
-#endif
-
-	comp.raw = raw;
-	comp.sign = FLOAT_SGN_BIT(raw);
-	comp.exp = FLOAT_EXP_BIT(raw);
-	comp.mant = FLOAT_MNT_BIT(raw);
-
-	// Remove the implicit 1 bit for denormalized numbers.
-	if (((raw & 0x7F800000) >> 23) == 0)
-	{
-		comp.mant ^= 0x00800000;
-	}
-
-	return comp;
-}
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
 
 static ieee_754_double extract_double(double d)
 {
@@ -346,6 +469,8 @@ static ieee_754_double extract_double(double d)
 
 #ifdef _WIN64
 	raw = extract_double_win64(d);
+#else
+	memcpy(&raw, &d, sizeof(raw));
 #endif
 
 	comp.raw = raw;
@@ -354,14 +479,101 @@ static ieee_754_double extract_double(double d)
 	comp.mant = DOUBLE_MNT_BIT(raw);
 
 	// Remove the implicit 1 bit for denormalized numbers.
+	// Their exponent is the same as the smallest normalized exponent.
 	if (((raw & 0x7FF0000000000000) >> 52) == 0)
 	{
 		comp.mant ^= 0x10000000000000;
+		comp.exp++;
 	}
 
 	return comp;
 }
 
+#if LDBL_MANT_DIG == 113 || defined(MY_PRINTF_FLOAT128)
+/**
+ * Takes apart the two 64-bit halves of an IEEE 754 quadruple-precision
+ * number.
+ */
+static ieee_754_wide extract_quad_bits(uint64_t hi, uint64_t lo)
+{
+	ieee_754_wide comp;
+	int e = (int)((hi >> 48) & 0x7FFF);
+
+	comp.sign = (uint8_t)(hi >> 63);
+	comp.hi = hi & 0xFFFFFFFFFFFF;
+	comp.lo = lo;
+	comp.cls = 0;
+
+	// Normal numbers have an implicit 1 bit, and denormalized numbers have
+	// the exponent of the smallest normalized number.
+	if (e == 0x7FFF)
+		comp.cls = (comp.hi | comp.lo) ? 2 : 1;
+	else if (e != 0)
+		comp.hi |= (uint64_t)1 << 48;
+	comp.exp = (e == 0 ? 1 : e) - 16383 - 112;
+
+	return comp;
+}
+#endif
+
+static ieee_754_wide extract_ldouble(long double ld)
+{
+	ieee_754_wide comp;
+
+#if LDBL_MANT_DIG == 64 && (defined(__i386__) || defined(__x86_64__))
+	uint64_t mant;
+	uint16_t se;
+	int e;
+
+	// The mantissa, with its explicit integer bit, comes first, followed by
+	// the sign and the 15-bit exponent.
+	memcpy(&mant, &ld, sizeof(mant));
+	memcpy(&se, (const char*)&ld + sizeof(mant), sizeof(se));
+	e = se & 0x7FFF;
+
+	comp.sign = (uint8_t)(se >> 15);
+	comp.hi = 0;
+	comp.lo = mant;
+	comp.cls = e != 0x7FFF ? 0 : (mant & 0x7FFFFFFFFFFFFFFF) ? 2 : 1;
+	comp.exp = (e == 0 ? 1 : e) - 16383 - 63;
+#elif LDBL_MANT_DIG == 113
+	uint64_t w[2];
+
+	memcpy(w, &ld, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	comp = extract_quad_bits(w[0], w[1]);
+#else
+	comp = extract_quad_bits(w[1], w[0]);
+#endif
+#else
+	ieee_754_double d = extract_double((double)ld);
+
+	comp.sign = d.sign;
+	comp.hi = 0;
+	comp.lo = d.mant;
+	comp.cls = d.exp != 1024 ? 0 : (d.mant & 0xFFFFFFFFFFFFF) ? 2 : 1;
+	comp.exp = d.exp - 52;
+#endif
+
+	return comp;
+}
+
+#ifdef MY_PRINTF_FLOAT128
+static ieee_754_wide extract_float128(__float128 q)
+{
+	uint64_t w[2];
+
+	memcpy(w, &q, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return extract_quad_bits(w[0], w[1]);
+#else
+	return extract_quad_bits(w[1], w[0]);
+#endif
+}
+#endif
+
+#endif
+
 static void reverse(char* str, size_t len)
 {
 	size_t start;
@@ -443,6 +655,7 @@ static size_t int_to_str(int n, char* buffer, int radix, int cap, int sign)
 	return i;
 }
 
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
 static size_t size_to_str(size_t n, char* buffer, int radix, int cap)
 {
 	size_t i;       // index
@@ -492,6 +705,7 @@ static size_t size_to_str(size_t n, char* buffer, int radix, int cap)
 
 	return i;
 }
+#endif
 
 static size_t uintptr_to_str(uintptr_t n, char* buffer, int cap)
 {
@@ -561,6 +775,99 @@ static size_t parse_udec(const char* str, size_t* res)
 
 
 
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+
+/**
+ * The functions of custom specifiers.
+ * ASCII specifier characters index the first half of the table directly.
+ * The second half holds named specifiers, and a tag that refers to one
+ * has the SPEC_NAMED bit set in its specifier, along with the slot.
+ * Entries are stored with release and loaded with acquire, so that a
+ * thread that finds a function also sees the name it was registered with.
+ */
+static _Atomic(my_spec_fn) custom_specs[256];
+
+/**
+ * The name, its hash and its length of each named specifier, by slot.
+ * Slot 0 is never used.
+ */
+static struct {
+	char* name;          // copy of the name
+	uint64_t hash;
+	size_t len;          // length of the name
+}named_specs[NAMED_N];
+
+// number of slots of named specifiers in use, including slot 0
+static size_t named_used = 1;
+
+/**
+ * Open addressed index of the named specifiers by hash, which holds the
+ * slots of the names. A slot is stored with release once its name is set.
+ */
+static _Atomic unsigned char named_index[2 * NAMED_N];
+
+/**
+ * Hashes the name of a named specifier with FNV-1a.
+ *
+ * Params:
+ *   const char* - the first character of the name
+ *   size_t* - receives the length of the name
+ *
+ * Returns:
+ *   uint64_t - the hash
+ */
+static uint64_t named_hash(const char* name, size_t* len)
+{
+	uint64_t h = 0xCBF29CE484222325ULL;
+	const char* c;
+
+	for (c = name; *c != '\0' && *c != '}'; c++)
+		h = (h ^ (unsigned char)*c) * 0x100000001B3ULL;
+
+	*len = (size_t)(c - name);
+
+	return h;
+}
+
+/**
+ * Finds the index entry of a hash.
+ *
+ * Params:
+ *   uint64_t - the hash of a name
+ *   size_t - the length of the name
+ *
+ * Returns:
+ *   size_t - the index of the entry with the name, or of the empty
+ *     entry where it would go
+ */
+static size_t named_find(uint64_t h, size_t len)
+{
+	size_t i, slot;
+
+	for (i = (size_t)h & (2 * NAMED_N - 1); ; i = (i + 1) & (2 * NAMED_N - 1))
+	{
+		slot = atomic_load_explicit(&named_index[i], memory_order_acquire);
+		if (slot == 0 || (named_specs[slot].hash == h && named_specs[slot].len == len))
+			return i;
+	}
+}
+
+/**
+ * Gets the function of a custom specifier.
+ *
+ * Params:
+ *   unsigned char - an ASCII specifier character, or SPEC_NAMED and a slot
+ *
+ * Returns:
+ *   my_spec_fn - the function, or NULL if there is none
+ */
+static my_spec_fn spec_fn(unsigned char spec)
+{
+	return atomic_load_explicit(&custom_specs[spec], memory_order_acquire);
+}
+
+#endif
+
 static ftag parse_format(const char* start, char** end)
 {
 	size_t n;           // conversion result
@@ -656,9 +963,36 @@ static ftag parse_format(const char* start, char** end)
 		break;
 
 		case STATE_SPEC:
-			tag.spec = is_spec(*start, spec) ? spec : 0;
+		{
+			if (is_spec(*start, spec))
+				tag.spec = spec;
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if (*start == '{')
+			{
+				uint64_t h = named_hash(start + 1, &n);
+
+				tag.spec = 0;
+				if (start[1 + n] == '}')
+				{
+					d = atomic_load_explicit(&named_index[named_find(h, n)],
+						memory_order_acquire);
+					if (d != 0 && spec_fn(SPEC_NAMED | d) != NULL)
+						tag.spec = (char)(SPEC_NAMED | d);
+
+					// Leave the end on the closing brace.
+					start += 1 + n;
+				}
+			}
+			else if ((unsigned char)*start < SPEC_NAMED
+				&& spec_fn((unsigned char)*start) != NULL)
+				tag.spec = *start;
+#endif
+			else
+				tag.spec = 0;
+
 			state++;
-			break;
+		}
+		break;
 
 		default:
 			break;
@@ -677,1043 +1011,8220 @@ FILE* my_get_stdout()
 }
 
 
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
 /**
- * Converts a binary fraction value to decimal.
- * The first argument is a pointer to a character array containing
- * all of the digits to the right of the radix point in a binary number.
- * So for the given binary number 110.010, the input string would be "010",
- * and the expected output would be "25".
- * The second argument is a pointer to the output buffer.
- * The output buffer is assumed to be large enough to hold at least 152
- * 8-bit numbers.
+ * The powers 2^0, 2^64, 2^128, ... 2^960 in base 10^9, with the least
+ * significant limb first. The limbs of 2^(64q) are at
+ * pow2_limbs[pow2_limbs_at[q]] up to pow2_limbs[pow2_limbs_at[q + 1]].
+ * With pow2_small for the rest of the exponent, every power of two that
+ * a double can hold is a table entry times at most two small factors.
+ */
+static const uint32_t pow2_limbs[265] = {
+	// 2^0
+	1,
+	// 2^64
+	709551616, 446744073, 18,
+	// 2^128
+	768211456, 374607431, 938463463, 282366920, 340,
+	// 2^192
+	34512896, 355444464, 666416102, 789423207, 680763835, 101735386,
+	6277,
+	// 2^256
+	129639936, 584007913, 564039457, 984665640, 907853269, 985008687,
+	195423570, 89237316, 115792,
+	// 2^320
+	86936576, 550022962, 725780640, 607822219, 769947041, 522356652,
+	114602704, 706169552, 82395021, 35920910, 2135987,
+	// 2^384
+	990306816, 640806627, 254884915, 611414266, 771497210, 404245721,
+	667948293, 270465446, 805079739, 100143613, 212279040, 196394479,
+	39402006,
+	// 2^448
+	628614656, 933534601, 606266177, 560762521, 713763565, 326191050,
+	113397923, 180639288, 281490199, 687318060, 353641360, 888004534,
+	549323807, 295606890, 726838724,
+	// 2^512
+	6084096, 946433649, 811946569, 853753882, 186486050, 690031858,
+	166903427, 801874298, 73546976, 721764030, 723561443, 592393377,
+	479365820, 205846127, 574024998, 942597099, 407807929, 13,
+	// 2^576
+	148699136, 916606772, 101893167, 967546155, 306751209, 351365034,
+	16139339, 597671426, 243044989, 316401061, 531867170, 897225106,
+	63056092, 211839914, 131349101, 647190035, 502521019, 104534060,
+	330401473, 247,
+	// 2^640
+	246603776, 82874192, 360264950, 251994674, 722214188, 252661319,
+	375437998, 688704721, 594407310, 642309573, 371399778, 912811317,
+	677386505, 275167208, 192517899, 559930579, 228507248, 291324893,
+	171605700, 195218641, 440617622, 4562,
+	// 2^704
+	772502016, 340692027, 149163476, 66620126, 55113571, 283578738,
+	430093599, 45036330, 940861810, 310916002, 851483408, 727501698,
+	415219631, 664580441, 293153818, 714468753, 494449099, 781751972,
+	436845170, 58648805, 838126082, 976115855, 174424773, 84162,
+	// 2^768
+	816057856, 892846853, 716468750, 262999193, 598444825, 265285631,
+	849905550, 454976020, 181139204, 287275041, 814391444, 580044114,
+	73206171, 730697131, 477950487, 408828646, 886330878, 952686376,
+	38026050, 611139052, 17116696, 555256886, 488462502, 935148979,
+	92300708, 1552518,
+	// 2^832
+	474295296, 358787106, 737583615, 930553606, 745247475, 40008231,
+	978776245, 801261478, 212102266, 874307979, 579620512, 26041564,
+	376700445, 860757073, 720074396, 509218999, 375429359, 265824628,
+	159345284, 5352904, 702311064, 529441449, 172170652, 490721739,
+	933674838, 204418783, 918474961, 28638903,
+	// 2^896
+	737998336, 538580897, 36476489, 396898767, 561738838, 28292751,
+	188404148, 232908211, 441053024, 517676426, 84168731, 683999005,
+	576908386, 978462939, 537250538, 559502685, 678882347, 993257128,
+	894674394, 887657187, 474417255, 556724859, 26673902, 127960709,
+	36121522, 518847326, 916516606, 352339784, 135665246, 528294531,
+	// 2^960
+	914110976, 828589991, 277547081, 738803104, 965612827, 363615468,
+	874945746, 597925394, 378873685, 593479218, 648352799, 655490053,
+	29870789, 699956473, 419531277, 296312653, 46577987, 865203094,
+	183459169, 231408668, 225304916, 882010259, 465615065, 766426102,
+	212948690, 867906457, 595007526, 876226857, 875188310, 353382387,
+	399999080, 745314011, 9
+};
+
+static const uint16_t pow2_limbs_at[17] = {
+	0, 1, 4, 9, 16, 25, 36, 49, 64, 82,
+	102, 124, 148, 174, 202, 232, 265
+};
+
+/**
+ * The powers 5^0, 5^64, 5^128, ... 5^1024 in base 10^9, laid out as
+ * pow2_limbs is.
+ * A binary fraction f / 2^k is f * 5^k / 10^k, so the digits of f * 5^k
+ * are the decimal digits of the fraction.
+ */
+static const uint32_t pow5_limbs[681] = {
+	// 5^0
+	1,
+	// 5^64
+	712890625, 434970855, 3726400, 242752217, 542101086,
+	// 5^128
+	212890625, 863681793, 569604314, 377187926, 193021880, 454666389,
+	305561419, 992184134, 705571876, 293873587,
+	// 5^192
+	712890625, 542392730, 692611135, 594098344, 472018268, 94308987,
+	151305816, 338616290, 607388585, 519261878, 559110455, 776771180,
+	702888039, 113245227, 159309191,
+	// 5^256
+	212890625, 471103668, 747746862, 37770580, 466936530, 989468319,
+	635969950, 939461496, 265605472, 34722882, 579715075, 31624270,
+	701685918, 850237034, 644362813, 711160003, 628003995, 253863518,
+	550944446, 86361685,
+	// 5^320
+	712890625, 649814605, 110011495, 914991744, 351194232, 452290906,
+	454151724, 289270907, 692338075, 312046122, 374199149, 196391753,
+	906314200, 334430537, 975392646, 494866350, 766739996, 538603832,
+	163371554, 387941833, 699150233, 138586765, 271558494, 546921983,
+	46816763,
+	// 5^384
+	212890625, 78525543, 154405035, 495048944, 477530234, 827972137,
+	807110513, 528271807, 438068409, 588206682, 950668826, 164997356,
+	797784387, 63576761, 267027807, 713424436, 958466020, 910577508,
+	862296645, 290557842, 739324074, 978892994, 212394766, 816060603,
+	497010955, 468236188, 558305435, 232740245, 373156492, 25379418,
+	// 5^448
+	712890625, 757236480, 255927480, 109729290, 471754681, 176824141,
+	784423224, 247288853, 498848681, 678125897, 244485230, 950336399,
+	885892815, 224459264, 966305645, 315433079, 540942492, 590089077,
+	775561, 688138689, 729483076, 289743809, 7864681, 984866562,
+	351936415, 782046256, 186228035, 709187165, 687804518, 664295482,
+	161360224, 526170065, 763667897, 268297397, 13758210,
+	// 5^512
+	212890625, 685947418, 789578832, 153319891, 326499008, 846968657,
+	927433551, 646003612, 336516628, 337206058, 265350215, 297563699,
+	3222742, 31686823, 588507120, 414217260, 63914765, 446554365,
+	435262941, 204074266, 781377495, 260792318, 84691481, 164829592,
+	302660486, 728095225, 101453412, 603255836, 803361511, 890400427,
+	304936174, 385070118, 333206278, 894271518, 534600406, 837376471,
+	315462933, 743290965, 731200206, 7458340,
+	// 5^576
+	712890625, 864658355, 130359090, 82607858, 494965940, 937654905,
+	685431960, 301373084, 147438283, 4081327, 803649766, 31099836,
+	592646953, 881129376, 937200640, 101215377, 622022885, 36009802,
+	540281829, 130558853, 769592643, 917655300, 847619111, 165586285,
+	365837500, 728219668, 387263920, 646696450, 286346262, 810762895,
+	863682265, 54500821, 565758491, 98843170, 491176108, 724211360,
+	854106881, 806158831, 241135885, 921888273, 32843323, 533437926,
+	906630599, 611952194, 4043174,
+	// 5^640
+	212890625, 293369293, 653268255, 416880298, 984679490, 653202458,
+	475503872, 931934129, 652111858, 353390542, 200433126, 234404316,
+	552560965, 557909463, 782927136, 669085475, 757223525, 148820014,
+	101852455, 427575901, 667152553, 307590053, 665684780, 945223575,
+	653852460, 202719653, 204634550, 795497146, 467333818, 878272092,
+	806279663, 576884703, 211380580, 914062659, 131302343, 9026766,
+	256466934, 594249319, 537175892, 91665704, 738274147, 751315534,
+	608390614, 623272604, 722124036, 832630808, 107141120, 39752693,
+	349008403, 2191809,
+	// 5^704
+	712890625, 972080230, 733306325, 737924322, 451234961, 547569114,
+	56983567, 672626985, 601893786, 667809251, 624849943, 494074064,
+	308107292, 633289160, 163699081, 539244954, 127432587, 66555347,
+	810660578, 443838905, 178114084, 932947762, 470844363, 4407511,
+	375439013, 85224138, 168125264, 891661240, 703447139, 352410094,
+	988850124, 400129858, 860073909, 497050213, 223559615, 834120570,
+	404425644, 829986367, 390364907, 889689715, 414027367, 367921736,
+	643439561, 664501631, 935657888, 127223250, 905798420, 285978658,
+	395276091, 503983449, 443290544, 253646939, 889696920, 228934474,
+	1188182,
+	// 5^768
+	212890625, 900791168, 745473302, 690027039, 292048945, 659543763,
+	931451300, 503677298, 410144597, 919367243, 713702272, 551359607,
+	237792160, 991991988, 752922755, 953943779, 533456482, 507168686,
+	259685362, 979977223, 66509405, 685244835, 114768526, 426648799,
+	323577135, 173884690, 71898745, 397236838, 411215816, 557931021,
+	915217675, 679307732, 58553576, 279969607, 593206960, 34802342,
+	567174784, 634380270, 725910028, 49278870, 80605088, 532953759,
+	222137454, 573459045, 46257464, 474722719, 914667149, 856218084,
+	561260668, 628972522, 756036964, 323626932, 570993229, 633584307,
+	331443965, 250520481, 650336885, 330822703, 876959713, 644114,
+	// 5^832
+	712890625, 79502105, 64769186, 979975559, 740109322, 538564262,
+	479211129, 605982355, 313238409, 703513133, 770482427, 384676832,
+	383827092, 433919992, 446883550, 507880352, 270468258, 893718464,
+	955604755, 626684813, 6130659, 284037716, 751863150, 326522307,
+	794682357, 462820323, 462825730, 673873310, 536919914, 415613691,
+	728846758, 705871864, 445305868, 203802297, 109511591, 505126742,
+	718487416, 549028709, 17718792, 365566616, 739740493, 662058709,
+	841727830, 736685408, 392957433, 736340956, 593432412, 748257019,
+	426051124, 694319168, 311156490, 848456455, 310073786, 417061342,
+	950441384, 207833712, 374337233, 182185571, 730855090, 174610019,
+	380182354, 783003129, 289274717, 374464977, 349175,
+	// 5^896
+	212890625, 508213043, 66193975, 377056990, 957725263, 161160306,
+	543186955, 544353426, 752135210, 616758202, 149221783, 800945662,
+	174229185, 935803884, 722469079, 783339017, 623956413, 283755879,
+	666547840, 897669676, 918219424, 565657243, 498628565, 957726114,
+	127224092, 963970291, 943492021, 503974595, 968061417, 481105458,
+	468310317, 415470701, 15883199, 563743333, 403453168, 544006328,
+	861343716, 496245086, 923424873, 8950252, 736001475, 645738536,
+	473664514, 611620381, 658162711, 604120310, 911913818, 650806746,
+	931586602, 850308505, 172399063, 474091257, 904971161, 480764871,
+	250400657, 553504509, 798520204, 568417368, 297487986, 632702505,
+	72194920, 252581267, 32263073, 548384506, 149424763, 245064349,
+	255602884, 953755640, 349786683, 189288,
+	// 5^960
+	712890625, 186923980, 124747671, 713058442, 130277225, 738021298,
+	171174275, 308872424, 737579931, 881326825, 432901186, 792025870,
+	212883870, 4620926, 324922475, 333150570, 263932247, 436495284,
+	253270296, 709621294, 735809544, 229590477, 871201269, 665581978,
+	956291399, 389034834, 283716680, 440050909, 780278541, 478563610,
+	37711642, 689939291, 289380307, 464737151, 783897129, 636585362,
+	666132429, 319642653, 264756271, 53558834, 303947957, 912568422,
+	714702219, 616865133, 839858798, 509759479, 23459699, 257497062,
+	679412382, 221177644, 587739707, 851396090, 210979044, 986773079,
+	612013839, 980636995, 288753174, 528365073, 363609927, 338771803,
+	553255959, 513683122, 756187038, 913293590, 83375844, 954834316,
+	475400680, 262038474, 289930522, 530683080, 296852190, 732229128,
+	406233400, 420032459, 102613,
+	// 5^1024
+	212890625, 115634918, 615430273, 882267024, 559966957, 411689217,
+	227385153, 373527284, 321466491, 319349449, 971173152, 579376695,
+	352174724, 684328083, 472418242, 579033069, 918822547, 857127117,
+	153763503, 540464179, 604036185, 331102750, 570042246, 347786926,
+	170285190, 941051121, 803070715, 141608771, 140794537, 294051183,
+	662825734, 841586939, 586657834, 816037776, 222290074, 490239782,
+	753719892, 802858809, 299810833, 527144151, 124802899, 838448395,
+	770466127, 996414561, 126272884, 289511290, 843748736, 994522193,
+	957621869, 897719252, 991212515, 499214790, 718012279, 416453973,
+	270166265, 355209381, 173562593, 798039126, 64590901, 990253686,
+	300058261, 269449838, 442970528, 400309634, 836502721, 810854038,
+	895275128, 683493275, 775514101, 78975312, 954896357, 110870347,
+	185422180, 295763833, 399511558, 101605480, 817933310, 34577255,
+	846462680, 55626
+};
+
+static const uint16_t pow5_limbs_at[18] = {
+	0, 1, 6, 16, 31, 51, 76, 106, 141, 181,
+	226, 276, 331, 391, 456, 526, 601, 681
+};
+
+// powers of two below 2^32, for the part of an exponent below 64
+static const uint32_t pow2_small[POW2_SMALL_MAX + 1] = {
+	1u << 0, 1u << 1, 1u << 2, 1u << 3, 1u << 4, 1u << 5, 1u << 6,
+	1u << 7, 1u << 8, 1u << 9, 1u << 10, 1u << 11, 1u << 12, 1u << 13,
+	1u << 14, 1u << 15, 1u << 16, 1u << 17, 1u << 18, 1u << 19, 1u << 20,
+	1u << 21, 1u << 22, 1u << 23, 1u << 24, 1u << 25, 1u << 26, 1u << 27,
+	1u << 28, 1u << 29, 1u << 30, 1u << 31
+};
+
+// powers of five below 2^32, for the part of an exponent below 64
+static const uint32_t pow5_small[POW5_SMALL_MAX + 1] = {
+	1u, 5u, 25u, 125u, 625u, 3125u, 15625u, 78125u, 390625u, 1953125u,
+	9765625u, 48828125u, 244140625u, 1220703125u
+};
+
+/**
+ * Multiplies a number in base 10^9 by a factor of up to 32 bits.
  *
  * Params:
- *   const char* - a pointer to a character array of '1' and '0'
- *   uint8_t* - a pointer to the output buffer
+ *   uint32_t* - the limbs of the number, least significant first
+ *   size_t - the number of limbs
+ *   uint32_t - the factor
+ *
+ * Returns:
+ *   size_t - the new number of limbs
  */
-static size_t fbin_to_fdec_frac(const char* raw, uint8_t* frac)
+static size_t limb_mul(uint32_t* x, size_t n, uint32_t m)
 {
-	size_t i, j, k, c;              // indices
-	uint8_t conv[2][FLOAT_BIN_DIG]; // binary to decimal conversion array
-	uint8_t dec[FLOAT_BIN_DIG];     // decimal number
-	uint8_t next;                   // next digit in conversion array
-	uint8_t half;                   // half of the next conversion digit
-	size_t n;                       // decimal digit counter
+	uint64_t p, carry;
+	size_t i;
 
-	// Prepopulate the fraction evaluator arrays with 0
-	for (i = 0; i < FLOAT_BIN_DIG; i++)
+	carry = 0;
+	for (i = 0; i < n; i++)
 	{
-		dec[i] = 0;
-		conv[0][i] = 0;
-		conv[1][i] = 0;
+		p = (uint64_t)x[i] * m + carry;
+		x[i] = (uint32_t)(p % LIMB_BASE);
+		carry = p / LIMB_BASE;
 	}
 
-	// Give the conversion array a starting value
-	conv[0][0] = 5;
-
-	i = j = k = 0;
-
-	while (*raw != '\0' && i < FLOAT_EXP_N)
+	while (carry)
 	{
-		// If the current binary digit is 1, add the
-		// conversion result to the current decimal value.
-		if (*raw == '1')
-		{
-			for (j = 0; j < FLOAT_BIN_DIG; j++)
-			{
-				dec[j] += conv[k][j];
+		x[n++] = (uint32_t)(carry % LIMB_BASE);
+		carry /= LIMB_BASE;
+	}
 
-				// Handle carries
-				if (dec[j] >= 10)
-				{
-					for (c = j; c > 0 && dec[c] >= 10; c--)
-					{
-						dec[c - 1]++;
-						dec[c] = dec[c] - 10;
-					}
-				}
-			}
-		}
+	return n;
+}
 
-		// Calculate the decimal equivalent of the next binary digit
-		for (j = 0; j < FLOAT_BIN_DIG && i < FLOAT_EXP_N - 1; j++)
-		{
-			next = conv[k][j];
-			half = next / 2;
+/**
+ * Computes m * b^e in base 10^9, where b is 2 or 5.
+ * The low six bits of the exponent are applied to the mantissa with the
+ * small powers, and the result is multiplied by b^(64q) from the limb
+ * table, so no power is built up one bit at a time.
+ *
+ * Params:
+ *   uint64_t - the mantissa m
+ *   unsigned - the exponent e
+ *   const uint32_t* - the limb table of b
+ *   const uint16_t* - the index of each entry of the limb table
+ *   const uint32_t* - the small powers of b
+ *   unsigned - the largest exponent of the small powers
+ *   uint32_t* - receives the limbs, least significant first
+ *
+ * Returns:
+ *   size_t - the number of limbs
+ */
+static size_t limb_pow(uint64_t m,
+	unsigned e,
+	const uint32_t* tab,
+	const uint16_t* at,
+	const uint32_t* small,
+	unsigned small_max,
+	uint32_t* out)
+{
+	uint32_t x[8];     // the mantissa times the small powers
+	const uint32_t* p; // limbs of the table entry
+	uint64_t t, carry;
+	size_t n, np, i, j;
+	unsigned r, s;
+
+	n = 0;
+	do
+	{
+		x[n++] = (uint32_t)(m % LIMB_BASE);
+		m /= LIMB_BASE;
+	} while (m);
 
-			conv[k][j] = 0;
+	for (r = e % 64; r > 0; r -= s)
+	{
+		s = r < small_max ? r : small_max;
+		n = limb_mul(x, n, small[s]);
+	}
 
-			if (half > 0 && !(next & 1))
-				conv[k ? 0 : 1][j] += half;
+	p = tab + at[e / 64];
+	np = at[e / 64 + 1] - at[e / 64];
 
-			else if (j < FLOAT_BIN_DIG - 1)
-			{
-				conv[k ? 0 : 1][j] += half;
-				conv[k ? 0 : 1][j + 1] += next > 0 ? 5 : 0;
-			}
+	memset(out, 0, (n + np) * sizeof(uint32_t));
+	for (i = 0; i < n; i++)
+	{
+		carry = 0;
+		for (j = 0; j < np; j++)
+		{
+			t = out[i + j] + (uint64_t)x[i] * p[j] + carry;
+			out[i + j] = (uint32_t)(t % LIMB_BASE);
+			carry = t / LIMB_BASE;
 		}
-
-		k = k ? 0 : 1;
-		i++;
-		raw++;
+		out[i + np] = (uint32_t)carry;
 	}
 
-	// Determine the number of digits in the final decimal number
-	for (n = FLOAT_BIN_DIG - 1; dec[n] == 0 && n > 0; n--);
-
-	n++;
-
-	for (i = 0; i < n; i++)
-		frac[i] = dec[i];
+	for (n += np; n > 1 && out[n - 1] == 0; n--);
 
 	return n;
 }
 
-
 /**
- * Converts a binary whole number to decimal.
- * The first argument is a pointer to a character array containing
- * all of the digits to the left of the radix point in a binary number.
- * So for the given binary number 110.010, the input string would be "110",
- * and the expected output would be "6".
- * The second argument is a pointer to the output buffer.
- * The output buffer is assumed to be large enough to hold at least 152
- * 8-bit numbers.
+ * Writes the decimal digits of a number in base 10^9, most significant
+ * first, as values from 0 to 9.
  *
  * Params:
- *   const char* - a pointer to a character array of '1' and '0'
- *   uint8_t* - a pointer to the output buffer
+ *   const uint32_t* - the limbs of the number, least significant first
+ *   size_t - the number of limbs
+ *   uint8_t* - receives the digits
  *
  * Returns:
- *   size_t - the number of values written to the output buffer
+ *   size_t - the number of digits
  */
-static size_t fbin_to_fdec_whole(const char* raw, uint8_t* whole)
+static size_t limb_digits(const uint32_t* x, size_t n, uint8_t* out)
 {
-	size_t i, j, k, c;              // indices
-	uint8_t conv[2][FLOAT_BIN_DIG]; // binary to decimal conversion array
-	uint8_t dec[FLOAT_BIN_DIG];     // decimal number
-	uint8_t next;                   // next digit in conversion array
-	uint8_t doub;                   // double of the next conversion digit
-	size_t len;                     // length of the raw string
-	size_t l;                       // length counter
-	size_t n;                       // decimal digit counter
+	uint32_t v;
+	size_t len, i;
+	int k;
 
-	len = strlen(raw);
-	l = len;
+	// The top limb is written without leading zeros.
+	for (v = x[n - 1], len = 0; v > 0; v /= 10)
+		len++;
+	for (v = x[n - 1], k = (int)len - 1; k >= 0; k--, v /= 10)
+		out[k] = (uint8_t)(v % 10);
 
-	// Prepopulate the arrays with 0
-	for (i = 0; i < FLOAT_BIN_DIG; i++)
+	for (i = n - 1; i > 0; i--)
 	{
-		dec[i] = 0;
-		conv[0][i] = 0;
-		conv[1][i] = 0;
+		for (v = x[i - 1], k = 8; k >= 0; k--, v /= 10)
+			out[len + k] = (uint8_t)(v % 10);
+		len += 9;
 	}
 
-	// Give the conversion array a starting value
-	conv[0][FLOAT_BIN_DIG - 1] = 1;
+	return len;
+}
 
-	i = j = k = n = 0;
+/**
+ * Multiplies a number in base 10^9 by another in place. The product is
+ * built from the most significant limb of x down, so each limb is read
+ * before its place is taken by the product.
+ *
+ * Params:
+ *   uint32_t* - the limbs of the number, least significant first, with
+ *     room for the product
+ *   size_t - the number of limbs
+ *   const uint32_t* - the limbs of the factor
+ *   size_t - the number of limbs of the factor
+ *
+ * Returns:
+ *   size_t - the new number of limbs
+ */
+static size_t limb_mul_n(uint32_t* x, size_t n, const uint32_t* p, size_t np)
+{
+	uint64_t t, v, carry;
+	size_t i, j;
 
-	while (l > 0 && i < FLOAT_EXP_N)
+	memset(x + n, 0, np * sizeof(uint32_t));
+	for (i = n; i-- > 0;)
 	{
-		// If the current binary digit is 1, add the
-		// conversion result to the current decimal value.
-		if (raw[l - 1] == '1')
+		v = x[i];
+		x[i] = 0;
+		carry = 0;
+		for (j = 0; j < np; j++)
 		{
-			for (j = FLOAT_BIN_DIG - 1; j > 0; j--)
-			{
-				dec[j] += conv[k][j];
-
-				// Handle carries
-				if (dec[j] >= 10)
-				{
-					for (c = j; c > 0 && dec[c] >= 10; c--)
-					{
-						dec[c - 1]++;
-						dec[c] = dec[c] - 10;
-					}
-				}
-			}
+			t = x[i + j] + v * p[j] + carry;
+			x[i + j] = (uint32_t)(t % LIMB_BASE);
+			carry = t / LIMB_BASE;
 		}
-
-		// Calculate the decimal equivalent of the next binary digit
-		for (j = FLOAT_BIN_DIG - 1; j > 0 && i < FLOAT_EXP_N - 1; j--)
+		for (j = i + np; carry; j++)
 		{
-			next = conv[k][j];
-			doub = next * 2;
+			t = x[j] + carry;
+			x[j] = (uint32_t)(t % LIMB_BASE);
+			carry = t / LIMB_BASE;
+		}
+	}
 
-			conv[k][j] = 0;
+	for (n += np; n > 1 && x[n - 1] == 0; n--);
 
-			conv[k ? 0 : 1][j] += doub;
+	return n;
+}
 
-			// Handle carries
-			if (conv[k ? 0 : 1][j] >= 10)
-			{
-				for (c = j; c > 0 && conv[k ? 0 : 1][c] >= 10; c--)
-				{
-					conv[k ? 0 : 1][c - 1]++;
-					conv[k ? 0 : 1][c] = conv[k ? 0 : 1][c] - 10;
-				}
-			}
+/**
+ * Multiplies a number in base 10^9 by b^e in place, where b is 2 or 5.
+ * This is limb_pow for the exponents of long double and __float128, which
+ * go past the limb table, so powers beyond its last entry are made by
+ * multiplying by that entry more than once.
+ *
+ * When only the leading digits of the product are needed, the number is
+ * cut to its top limbs after each step. The limbs that are cut are
+ * counted, so the product is the limbs times 10^(9 * drop), less than the
+ * exact product by under 10^11 units of its lowest limb when at least
+ * three limbs are kept.
+ *
+ * Params:
+ *   uint32_t* - the limbs of the number, least significant first, with
+ *     room for the product
+ *   size_t - the number of limbs
+ *   unsigned - the base b, 2 or 5
+ *   unsigned - the exponent e
+ *   size_t - the number of limbs to keep
+ *   size_t* - receives the number of limbs cut
+ *   int* - receives 1 if a limb that was cut is not zero, or 0 otherwise
+ *
+ * Returns:
+ *   size_t - the new number of limbs
+ */
+static size_t limb_pow_n(uint32_t* x,
+	size_t n,
+	unsigned b,
+	unsigned e,
+	size_t keep,
+	size_t* drop,
+	int* inexact)
+{
+	const uint32_t* tab = b == 2 ? pow2_limbs : pow5_limbs;
+	const uint16_t* at = b == 2 ? pow2_limbs_at : pow5_limbs_at;
+	const uint32_t* small = b == 2 ? pow2_small : pow5_small;
+	unsigned small_max = b == 2 ? POW2_SMALL_MAX : POW5_SMALL_MAX;
+	unsigned top = b == 2
+		? sizeof(pow2_limbs_at) / sizeof(pow2_limbs_at[0]) - 2
+		: sizeof(pow5_limbs_at) / sizeof(pow5_limbs_at[0]) - 2;
+	unsigned r, s;
+	size_t i, cut;
+
+	*drop = 0;
+	*inexact = 0;
+
+	for (r = e; r > 0; r -= s)
+	{
+		// Small powers go first, while the number is short.
+		if (r % 64 != 0)
+		{
+			s = r % 64 < small_max ? r % 64 : small_max;
+			n = limb_mul(x, n, small[s]);
+		}
+		else
+		{
+			s = r / 64 < top ? r / 64 : top;
+			n = limb_mul_n(x, n, tab + at[s], at[s + 1] - at[s]);
+			s *= 64;
 		}
 
-		k = k ? 0 : 1;
-		i++;
-		l--;
+		if (n > keep)
+		{
+			cut = n - keep;
+			for (i = 0; i < cut; i++)
+				*inexact |= x[i] != 0;
+			memmove(x, x + cut, keep * sizeof(uint32_t));
+			*drop += cut;
+			n = keep;
+		}
 	}
 
-	// Determine the number of digits in the final decimal number
-	for (n = 0; dec[n] == 0 && n < FLOAT_BIN_DIG; n++);
-
-	for (i = n; i < FLOAT_BIN_DIG; i++)
-		whole[i - n] = dec[i];
-
-	return FLOAT_BIN_DIG - n;
+	return n;
 }
 
-static void float_to_str(float f,
-	uint8_t* whole,
-	size_t* w_res,
-	uint8_t* frac,
-	size_t* f_res)
+/**
+ * Counts the decimal digits of a number in base 10^9. Zero has one digit.
+ *
+ * Params:
+ *   const uint32_t* - the limbs of the number, least significant first
+ *   size_t - the number of limbs
+ *
+ * Returns:
+ *   size_t - the number of digits
+ */
+static size_t limb_count(const uint32_t* x, size_t n)
 {
-	ieee_754_float ieeef;
-	char mstr[25];
-	int16_t i, j;
-	uint8_t li;
-	uint8_t ri;
-	uint8_t rad;
-	char left[FLOAT_BIN_DIG];
-	char right[FLOAT_BIN_DIG];
+	uint32_t v;
+	size_t len;
 
+	for (v = x[n - 1] / 10, len = 1; v > 0; v /= 10)
+		len++;
 
-	// Extract the binary components of the float.
-	ieeef = extract_float(f);
-
-	// Prepopulate the character arrays with '\0'.
-	for (i = 0; i < FLOAT_BIN_DIG; i++)
-	{
-		left[i] = '\0';
-		right[i] = '\0';
-		frac[i] = 0;
-		whole[i] = 0;
-	}
+	return len + (n - 1) * 9;
+}
 
-	// Convert the mantissa to a NUL-terminated string.
-	for (i = 23, j = 0; i >= 0; i--)
+/**
+ * Divides a number in base 10^9 by 10^j in place, and rounds the quotient
+ * to the nearest integer, or to the even one on a tie, as the default
+ * rounding mode does. Whole limbs of the divisor are dropped, and the rest
+ * is one pass of division by a small power of ten. The remainder is only
+ * compared with half of the divisor, which takes its leading part and
+ * whether any of the dropped limbs is not zero.
+ *
+ * Params:
+ *   uint32_t* - the limbs of the number, least significant first
+ *   size_t - the number of limbs
+ *   size_t - the exponent j
+ *
+ * Returns:
+ *   size_t - the new number of limbs
+ */
+static size_t limb_round(uint32_t* x, size_t n, size_t j)
+{
+	static const uint32_t pow10[9] = {
+		1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+	};
+	uint64_t cur;
+	uint32_t b, r, half;
+	size_t a, i;
+	int low;     // 1 if a limb below the remainder's leading part is not 0
+	int up;      // 1 if the quotient is rounded up
+
+	if (j == 0)
+		return n;
+
+	a = j / 9;
+	b = pow10[j % 9];
+	if (a > n)
 	{
-		mstr[j++] = ((ieeef.mant & (1 << i)) >> i) ? '1' : '0';
+		x[0] = 0;
+		return 1;
 	}
-	mstr[24] = '\0';
 
-	rad = li = ri = 0;
-
-	// If the exponent is negative, add leading zeros '0'
-	// to the right side array.
-	if (ieeef.exp + 1 < 0)
+	low = 0;
+	if (b == 1)
 	{
-		rad = 1;
-		for (i = 0; i < -(ieeef.exp + 1); i++)
-			right[ri++] = '0';
+		// The remainder is the dropped limbs, led by the top one.
+		for (i = 0; i + 1 < a; i++)
+			low |= x[i] != 0;
+		r = x[a - 1];
+		half = LIMB_BASE / 2;
 	}
-
-	for (i = 0; i < 160; i++)
+	else
 	{
-		if (i == ieeef.exp + 1)
-			rad = 1;
-
-		if (i < 24)
+		for (i = 0; i < a; i++)
+			low |= x[i] != 0;
+		r = 0;
+		for (i = n; i-- > a;)
 		{
-			// Get the characters from the mantissa string.
-			if (rad)
-				right[ri++] = mstr[i];
-
-			else
-				left[li++] = mstr[i];
+			cur = (uint64_t)r * LIMB_BASE + x[i];
+			x[i] = (uint32_t)(cur / b);
+			r = (uint32_t)(cur % b);
 		}
-		else if (i < ieeef.exp + 1)
-		{
-			// Since we've used all the characters from the
-			// mantissa string, we start outputting zeros '0'.
-			if (rad)
-				right[ri++] = '0';
+		half = b / 2;
+	}
 
-			else
-				left[li++] = '0';
-		}
+	n -= a;
+	if (n == 0)
+		x[n++] = 0;
+	else
+		memmove(x, x + a, n * sizeof(uint32_t));
+
+	up = r > half || (r == half && (low || (x[0] & 1)));
+	for (i = 0; up; i++)
+	{
+		if (i == n)
+			x[n++] = 0;
+		up = ++x[i] == LIMB_BASE;
+		if (up)
+			x[i] = 0;
 	}
 
-	*w_res = fbin_to_fdec_whole(left, whole);
-	*f_res = fbin_to_fdec_frac(right, frac);
-}
+	for (; n > 1 && x[n - 1] == 0; n--);
 
+	return n;
+}
 
 /**
- * Converts a binary fraction value to decimal.
- * The first argument is a pointer to a character array containing
- * all of the digits to the right of the radix point in a binary number.
- * So for the given binary number 110.010, the input string would be "010",
- * and the expected output would be "25".
- * The second argument is a pointer to the output buffer.
- * The output buffer is assumed to be large enough to hold at least 152
- * 8-bit numbers.
+ * Converts a binary number m * 2^s to decimal, split at the radix point.
+ * The whole part is m * 2^s, or m shifted right. The bits below the
+ * point are a fraction f / 2^k, which is f * 5^k / 10^k, so the fraction
+ * digits are those of f * 5^k with zeros in front to make k digits.
+ * Trailing zero bits are taken off f first, so the last digit is not 0.
  *
  * Params:
- *   const char* - a pointer to a character array of '1' and '0'
- *   uint8_t* - a pointer to the output buffer
+ *   uint64_t - the mantissa
+ *   int - the binary exponent of the lowest bit of the mantissa
+ *   uint8_t* - receives the digits of the whole part, as values from 0 to 9
+ *   size_t* - receives the number of digits of the whole part, or 0
+ *   uint8_t* - receives the digits of the fraction, as values from 0 to 9
+ *   size_t* - receives the number of digits of the fraction, at least 1
  */
-static size_t dbin_to_ddec_frac(const char* raw, uint8_t* frac)
+static void bin_to_dec(uint64_t m,
+	int s,
+	uint8_t* whole,
+	size_t* w_res,
+	uint8_t* frac,
+	size_t* f_res)
 {
-	size_t i, j, k, c;              // indices
-	uint8_t conv[2][DOUBLE_BIN_DIG]; // binary to decimal conversion array
-	uint8_t dec[DOUBLE_BIN_DIG];     // decimal number
-	uint8_t next;                   // next digit in conversion array
-	uint8_t half;                   // half of the next conversion digit
-	size_t n;                       // decimal digit counter
+	uint32_t x[LIMB_N];
+	uint64_t w, f;
+	unsigned k;
+	size_t n, d;
 
-	// Prepopulate the fraction evaluator arrays with 0
-	for (i = 0; i < DOUBLE_BIN_DIG; i++)
+	if (s >= 0)
 	{
-		dec[i] = 0;
-		conv[0][i] = 0;
-		conv[1][i] = 0;
+		w = m;
+		f = 0;
+		k = 0;
+	}
+	else
+	{
+		k = (unsigned)-s;
+		w = k < 64 ? m >> k : 0;
+		f = k < 64 ? m & (((uint64_t)1 << k) - 1) : m;
 	}
 
-	// Give the conversion array a starting value
-	conv[0][0] = 5;
-
-	i = j = k = 0;
+	*w_res = 0;
+	if (w != 0)
+	{
+		n = limb_pow(w, s > 0 ? (unsigned)s : 0, pow2_limbs, pow2_limbs_at,
+			pow2_small, POW2_SMALL_MAX, x);
+		*w_res = limb_digits(x, n, whole);
+	}
 
-	while (*raw != '\0' && i < DOUBLE_EXP_N)
+	frac[0] = 0;
+	*f_res = 1;
+	if (f != 0)
 	{
-		// If the current binary digit is 1, add the
-		// conversion result to the current decimal value.
-		if (*raw == '1')
-		{
-			for (j = 0; j < DOUBLE_BIN_DIG; j++)
-			{
-				dec[j] += conv[k][j];
+		for (; !(f & 1); f >>= 1)
+			k--;
 
-				// Handle carries
-				if (dec[j] >= 10)
-				{
-					for (c = j; c > 0 && dec[c] >= 10; c--)
-					{
-						dec[c - 1]++;
-						dec[c] = dec[c] - 10;
-					}
-				}
-			}
-		}
+		n = limb_pow(f, k, pow5_limbs, pow5_limbs_at,
+			pow5_small, POW5_SMALL_MAX, x);
+		d = limb_digits(x, n, frac);
 
-		// Calculate the decimal equivalent of the next binary digit
-		for (j = 0; j < DOUBLE_BIN_DIG && i < DOUBLE_EXP_N - 1; j++)
-		{
-			next = conv[k][j];
-			half = next / 2;
+		memmove(frac + (k - d), frac, d);
+		memset(frac, 0, k - d);
+		*f_res = k;
+	}
+}
+
+static void double_to_str(double d,
+	uint8_t* whole,
+	size_t* w_res,
+	uint8_t* frac,
+	size_t* f_res)
+{
+	ieee_754_double ieeed;
 
-			conv[k][j] = 0;
+	// Extract the binary components of the double.
+	ieeed = extract_double(d);
 
-			if (half > 0 && !(next & 1))
-				conv[k ? 0 : 1][j] += half;
+	memset(whole, 0, DOUBLE_BIN_DIG);
+	memset(frac, 0, DOUBLE_BIN_DIG);
 
-			else if (j < DOUBLE_BIN_DIG - 1)
-			{
-				conv[k ? 0 : 1][j] += half;
-				conv[k ? 0 : 1][j + 1] += next > 0 ? 5 : 0;
-			}
-		}
+	bin_to_dec(ieeed.mant, ieeed.exp - 52, whole, w_res, frac, f_res);
+}
 
-		k = k ? 0 : 1;
-		i++;
-		raw++;
-	}
+#endif
 
-	// Determine the number of digits in the final decimal number
-	for (n = DOUBLE_BIN_DIG - 1; dec[n] == 0 && n > 0; n--);
 
-	n++;
 
-	for (i = 0; i < n; i++)
-		frac[i] = dec[i];
+#ifdef MY_PRINTF_STATS
 
-	return n;
-}
+/**
+ * The statistics counters of one thread.
+ * Only the owning thread writes to the counters, so a relaxed load and
+ * store is enough to update them, and other threads can read them at any
+ * time. Blocks are never freed, so that the counts of threads that have
+ * exited remain in the totals. With MY_PRINTF_POSIX, the block of a thread
+ * that has exited is handed to the next new thread, which keeps counting
+ * from where it was left, so there are never more blocks than there have
+ * been threads at the same time.
+ */
+typedef struct stats_block {
+	_Atomic uint64_t val[STAT_N]; // counters
+	struct stats_block* next;     // next block in the list of all threads
+	atomic_int used;              // 1 while a thread owns the block
+}stats_block;
+
+// counters of the current thread
+static _Thread_local stats_block* stats_local;
+
+// list of the counters of all threads
+static _Atomic(stats_block*) stats_head;
+
+// totals at the time of the last reset
+static uint64_t stats_base[STAT_N];
 
+// guards stats_base
+static atomic_flag stats_lock = ATOMIC_FLAG_INIT;
+
+// counters used when a thread's counters could not be allocated
+static stats_block stats_dummy;
+
+#ifdef MY_PRINTF_POSIX
+
+// key whose destructor releases the counters of an exiting thread
+static pthread_key_t stats_key;
+static pthread_once_t stats_key_once = PTHREAD_ONCE_INIT;
+static int stats_key_ok;
 
 /**
- * Converts a binary whole number to decimal.
- * The first argument is a pointer to a character array containing
- * all of the digits to the left of the radix point in a binary number.
- * So for the given binary number 110.010, the input string would be "110",
- * and the expected output would be "6".
- * The second argument is a pointer to the output buffer.
- * The output buffer is assumed to be large enough to hold at least 152
- * 8-bit numbers.
+ * Releases the statistics counters of a thread that is exiting, so that
+ * a new thread can take them. Their counts stay in the totals.
  *
  * Params:
- *   const char* - a pointer to a character array of '1' and '0'
- *   uint8_t* - a pointer to the output buffer
+ *   void* - the stats_block of the thread
+ */
+static void stats_release(void* arg)
+{
+	stats_block* b = arg;
+
+	// Anything formatted later in this thread, by another destructor,
+	// goes to the shared counters instead.
+	stats_local = &stats_dummy;
+	atomic_store_explicit(&b->used, 0, memory_order_release);
+}
+
+static void stats_key_init(void)
+{
+	stats_key_ok = pthread_key_create(&stats_key, stats_release) == 0;
+}
+
+#endif
+
+/**
+ * Gets statistics counters for the current thread, either those released
+ * by a thread that has exited or new ones that are added to the list of
+ * all threads.
  *
  * Returns:
- *   size_t - the number of values written to the output buffer
+ *   stats_block* - the counters of the current thread
  */
-static size_t dbin_to_ddec_whole(const char* raw, uint8_t* whole)
+static stats_block* stats_register(void)
 {
-	size_t i, j, k, c;              // indices
-	uint8_t conv[2][DOUBLE_BIN_DIG]; // binary to decimal conversion array
-	uint8_t dec[DOUBLE_BIN_DIG];     // decimal number
-	uint8_t next;                   // next digit in conversion array
-	uint8_t doub;                   // double of the next conversion digit
-	size_t len;                     // length of the raw string
-	size_t l;                       // length counter
-	size_t n;                       // decimal digit counter
+	stats_block* b;
+	int unused;
 
-	len = strlen(raw);
-	l = len;
+#ifdef MY_PRINTF_POSIX
+	pthread_once(&stats_key_once, stats_key_init);
+#endif
 
-	// Prepopulate the arrays with 0
-	for (i = 0; i < DOUBLE_BIN_DIG; i++)
+	for (b = atomic_load(&stats_head); b != NULL; b = b->next)
 	{
-		dec[i] = 0;
-		conv[0][i] = 0;
-		conv[1][i] = 0;
+		unused = 0;
+		if (atomic_compare_exchange_strong_explicit(&b->used, &unused, 1,
+			memory_order_acquire, memory_order_relaxed))
+			break;
 	}
 
-	// Give the conversion array a starting value
-	conv[0][DOUBLE_BIN_DIG - 1] = 1;
+	if (b == NULL)
+	{
+		b = calloc(1, sizeof(stats_block));
+		if (b == NULL)
+			return &stats_dummy;
 
-	i = j = k = n = 0;
+		atomic_init(&b->used, 1);
+		b->next = atomic_load(&stats_head);
+		while (!atomic_compare_exchange_weak(&stats_head, &b->next, b));
+	}
 
-	while (l > 0 && i < DOUBLE_EXP_N)
-	{
-		// If the current binary digit is 1, add the
-		// conversion result to the current decimal value.
-		if (raw[l - 1] == '1')
-		{
-			for (j = DOUBLE_BIN_DIG - 1; j > 0; j--)
-			{
-				dec[j] += conv[k][j];
+#ifdef MY_PRINTF_POSIX
+	// Without the destructor, the block is kept by this thread for good.
+	if (stats_key_ok)
+		pthread_setspecific(stats_key, b);
+#endif
 
-				// Handle carries
-				if (dec[j] >= 10)
-				{
-					for (c = j; c > 0 && dec[c] >= 10; c--)
-					{
-						dec[c - 1]++;
-						dec[c] = dec[c] - 10;
-					}
-				}
-			}
-		}
+	stats_local = b;
 
-		// Calculate the decimal equivalent of the next binary digit
-		for (j = DOUBLE_BIN_DIG - 1; j > 0 && i < DOUBLE_EXP_N - 1; j--)
-		{
-			next = conv[k][j];
-			doub = next * 2;
+	return b;
+}
 
-			conv[k][j] = 0;
+/**
+ * Gets the statistics counters of the current thread.
+ *
+ * Returns:
+ *   stats_block* - the counters of the current thread
+ */
+static inline stats_block* stats_get(void)
+{
+	stats_block* b = stats_local;
 
-			conv[k ? 0 : 1][j] += doub;
+	return b != NULL ? b : stats_register();
+}
 
-			// Handle carries
-			if (conv[k ? 0 : 1][j] >= 10)
-			{
-				for (c = j; c > 0 && conv[k ? 0 : 1][c] >= 10; c--)
-				{
-					conv[k ? 0 : 1][c - 1]++;
-					conv[k ? 0 : 1][c] = conv[k ? 0 : 1][c] - 10;
-				}
-			}
-		}
+/**
+ * Adds a value to one of the statistics counters of a thread.
+ * This must only be called by the thread that owns the counters.
+ *
+ * Params:
+ *   stats_block* - the counters of the current thread
+ *   int - the index of the counter
+ *   uint64_t - the value to add
+ */
+static inline void stats_add(stats_block* b, int i, uint64_t n)
+{
+	atomic_store_explicit(&b->val[i],
+		atomic_load_explicit(&b->val[i], memory_order_relaxed) + n,
+		memory_order_relaxed);
+}
+
+/**
+ * Adds up the counters of all threads.
+ *
+ * Params:
+ *   uint64_t* - an array of STAT_N values to receive the totals
+ */
+static void stats_sum(uint64_t* total)
+{
+	stats_block* b;
+	size_t i;
+
+	memset(total, 0, sizeof(uint64_t) * STAT_N);
 
-		k = k ? 0 : 1;
-		i++;
-		l--;
+	for (b = atomic_load(&stats_head); b != NULL; b = b->next)
+	{
+		for (i = 0; i < STAT_N; i++)
+			total[i] += atomic_load_explicit(&b->val[i], memory_order_relaxed);
 	}
+}
 
-	// Determine the number of digits in the final decimal number
-	for (n = 0; dec[n] == 0 && n < DOUBLE_BIN_DIG; n++);
+#endif
 
-	for (i = n; i < DOUBLE_BIN_DIG; i++)
-		whole[i - n] = dec[i];
+/**
+ * The state of a sink that writes to a character array.
+ * Once the array is full, the remaining characters are counted
+ * but discarded.
+ */
+typedef struct str_sink {
+	my_sink sink;              // the sink
+	char* end;                 // end of the output in the caller's array
+	char scratch[MY_SINK_BUF]; // space for discarded characters
+}str_sink;
 
-	return DOUBLE_BIN_DIG - n;
+/**
+ * Initializes the common members of a sink.
+ *
+ * Params:
+ *   my_sink* - the sink to initialize
+ *   char* - the output buffer
+ *   size_t - the capacity of the output buffer
+ *   int (*)(my_sink*) - the function that empties the buffer
+ *   void* - sink specific data
+ */
+static void sink_init(my_sink* sink,
+	char* buf,
+	size_t size,
+	int (*flush)(my_sink*),
+	void* data)
+{
+	sink->buf = buf;
+	sink->size = size;
+	sink->pos = 0;
+	sink->count = 0;
+	sink->err = 0;
+	sink->flush = flush;
+	sink->span = NULL;
+	sink->data = data;
 }
 
-static void double_to_str(double d,
-	uint8_t* whole,
-	size_t* w_res,
-	uint8_t* frac,
-	size_t* f_res)
+/**
+ * Empties the buffer of a sink so that more characters can be written.
+ * If the sink cannot make room, its error indicator is set.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if there is no room in the buffer
+ */
+static int sink_flush(my_sink* sink)
 {
-	ieee_754_double ieeed;
-	char mstr[54];
-	int16_t i, j;
-	uint8_t li;
-	uint8_t ri;
-	uint8_t rad;
-	char left[DOUBLE_BIN_DIG];
-	char right[DOUBLE_BIN_DIG];
+	STAT_ADD(STAT_FLUSHES, 1);
+
+	if (sink->err || sink->flush(sink) || sink->pos == sink->size)
+	{
+		sink->err = 1;
+		return 1;
+	}
 
+	return 0;
+}
 
-	// Extract the binary components of the float.
-	ieeed = extract_double(d);
+/**
+ * Writes a character to a sink.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   char - the character to write
+ */
+static void sink_putc(my_sink* sink, char c)
+{
+	if (sink->pos == sink->size && sink_flush(sink))
+		return;
+
+	sink->buf[sink->pos++] = c;
+	sink->count++;
+}
+
+/**
+ * Writes a sequence of characters to a sink.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const char* - the characters to write
+ *   size_t - the number of characters
+ */
+static void sink_write(my_sink* sink, const char* str, size_t len)
+{
+	size_t n; // number of characters that fit in the buffer
 
-	// Prepopulate the character arrays with '\0'.
-	for (i = 0; i < DOUBLE_BIN_DIG; i++)
+	if (sink->span != NULL && len >= SPAN_MIN && !sink->err
+		&& sink->span(sink, str, len) == 0)
 	{
-		left[i] = '\0';
-		right[i] = '\0';
-		frac[i] = 0;
-		whole[i] = 0;
+		sink->count += len;
+		return;
 	}
 
-	// Convert the mantissa to a NUL-terminated string.
-	for (i = 52, j = 0; i >= 0; i--)
+	while (len > 0)
 	{
-		mstr[j++] = ((ieeed.mant & ((uint64_t)1 << i)) >> i) ? '1' : '0';
+		if (sink->pos == sink->size && sink_flush(sink))
+			return;
+
+		n = sink->size - sink->pos;
+		if (n > len)
+			n = len;
+
+		memcpy(sink->buf + sink->pos, str, n);
+		sink->pos += n;
+		sink->count += n;
+		str += n;
+		len -= n;
 	}
-	mstr[53] = '\0';
+}
+
+#ifdef __SSE2__
+
+/**
+ * Determines if 16 bytes can be loaded from an address without crossing
+ * into the next page. A string is only known to extend to its terminator,
+ * but a load that stays within the page of the terminator cannot fault.
+ */
+#define load_in_page(p) (((uintptr_t)(p) & 4095) <= 4096 - 16)
+
+#endif
 
-	rad = li = ri = 0;
+// Loads past the terminator are reported by AddressSanitizer, although
+// they stay within the page, so the functions that do them opt out.
+#if defined(__GNUC__) || defined(__clang__)
+#define NO_ASAN __attribute__((no_sanitize_address))
+#else
+#define NO_ASAN
+#endif
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
 
-	// If the exponent is negative, add leading zeros '0'
-	// to the right side array.
-	if (ieeed.exp + 1 < 0)
+/**
+ * Encodes a Unicode code point as UTF-8.
+ * Surrogates and values above U+10FFFF are replaced with U+FFFD.
+ *
+ * Params:
+ *   uint32_t - a code point
+ *   char* - an output buffer of at least 4 characters
+ *
+ * Returns:
+ *   size_t - the number of characters written
+ */
+static size_t utf8_encode(uint32_t cp, char* out)
+{
+	if (cp < 0x80)
 	{
-		rad = 1;
-		for (i = 0; i < -(ieeed.exp + 1); i++)
-			right[ri++] = '0';
+		out[0] = (char)cp;
+		return 1;
 	}
 
-	for (i = 0; i < 160; i++)
+	if (cp < 0x800)
 	{
-		if (i == ieeed.exp + 1)
-			rad = 1;
-
-		if (i < 24)
-		{
-			// Get the characters from the mantissa string.
-			if (rad)
-				right[ri++] = mstr[i];
+		out[0] = (char)(0xC0 | (cp >> 6));
+		out[1] = (char)(0x80 | (cp & 0x3F));
+		return 2;
+	}
 
-			else
-				left[li++] = mstr[i];
-		}
-		else if (i < ieeed.exp + 1)
-		{
-			// Since we've used all the characters from the
-			// mantissa string, we start outputting zeros '0'.
-			if (rad)
-				right[ri++] = '0';
+	if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		cp = 0xFFFD;
 
-			else
-				left[li++] = '0';
-		}
+	if (cp < 0x10000)
+	{
+		out[0] = (char)(0xE0 | (cp >> 12));
+		out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		out[2] = (char)(0x80 | (cp & 0x3F));
+		return 3;
 	}
 
-	*w_res = dbin_to_ddec_whole(left, whole);
-	*f_res = dbin_to_ddec_frac(right, frac);
+	out[0] = (char)(0xF0 | (cp >> 18));
+	out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+	out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+	out[3] = (char)(0x80 | (cp & 0x3F));
+	return 4;
 }
 
+/**
+ * Gets the number of UTF-8 characters needed for a code point.
+ * This is the length of the output of utf8_encode.
+ */
+static size_t utf8_len(uint32_t cp)
+{
+	return cp < 0x80 ? 1
+		: cp < 0x800 ? 2
+		: cp < 0x10000 || cp > 0x10FFFF ? 3
+		: 4;
+}
 
+/**
+ * Decodes the next code point of a UTF-16 string.
+ * An unpaired surrogate is decoded as U+FFFD.
+ *
+ * Params:
+ *   const uint16_t** - a pointer to a non-zero code unit, which is
+ *     advanced past the code point
+ *
+ * Returns:
+ *   uint32_t - the code point
+ */
+static uint32_t utf16_next(const uint16_t** str)
+{
+	const uint16_t* s = *str;
+	uint32_t cp = *s++;
 
+	if (cp >= 0xD800 && cp <= 0xDFFF)
+	{
+		if (cp <= 0xDBFF && *s >= 0xDC00 && *s <= 0xDFFF)
+			cp = 0x10000 + ((cp - 0xD800) << 10) + (*s++ - 0xDC00);
+		else
+			cp = 0xFFFD;
+	}
 
-//--------------------------------------------------------------------------//
-//                               Public API                                 //
-//--------------------------------------------------------------------------//
+	*str = s;
 
-int my_putc(int c, FILE* stream)
-{
-	return fputc(c, stream);
+	return cp;
 }
 
-int my_fputc(int c, FILE* stream)
+/**
+ * Writes a code point to a sink as UTF-8.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   uint32_t - a code point
+ */
+static void sink_putcp(my_sink* sink, uint32_t cp)
 {
-	return fputc(c, stream);
-}
+	char out[4];
 
-int my_putchar(int c)
-{
-	return my_fputc(c, my_get_stdout());
+	if (sink->size - sink->pos >= 4)
+	{
+		// Encode straight into the buffer.
+		cp = (uint32_t)utf8_encode(cp, sink->buf + sink->pos);
+		sink->pos += cp;
+		sink->count += cp;
+		return;
+	}
+
+	sink_write(sink, out, utf8_encode(cp, out));
 }
 
-int my_printf(const char* fmt, ...)
+/**
+ * Writes a zero terminated UTF-16 string to a sink as UTF-8.
+ * Blocks of eight code units are checked with SSE2. Blocks of ASCII are
+ * narrowed to bytes with a single pack, and blocks without surrogates are
+ * encoded without pairing code units. Only blocks that contain surrogates
+ * are decoded one code point at a time.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const uint16_t* - a zero terminated UTF-16 string
+ */
+NO_ASAN static void sink_utf16(my_sink* sink, const uint16_t* s)
 {
-	size_t i, j;   // index
-	char* end;     // updated character pointer
-	int p;         // flag indicating detection of '%'
-	va_list argp;  // argument pointer
-	char buf[100]; // string conversion buffer
-	size_t len;    // string length
-	int err;
-
-	va_start(argp, fmt);
-
-	i = j = 0;
-	p = 0;
-	err = 0;
-	while (*fmt != '\0' && !err)
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ascii = _mm_set1_epi16((short)0xFF80);
+	const __m128i sur_mask = _mm_set1_epi16((short)0xF800);
+	const __m128i sur = _mm_set1_epi16((short)0xD800);
+	__m128i v;
+	char* out;
+	size_t i, n;
+
+	while (*s != 0)
 	{
-		if (*fmt == '%')
+		// A block needs at most 3 characters per code unit, and one
+		// more if its last code unit pairs with the next block.
+		if (sink->size - sink->pos < 25 || !load_in_page(s))
 		{
-			fmt++;
-			ftag t = parse_format(fmt, &end);
-			fmt = end;
+			sink_putcp(sink, utf16_next(&s));
+			continue;
+		}
+
+		v = _mm_loadu_si128((const __m128i*)s);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(v, zero)) != 0)
+			break;
+
+		out = sink->buf + sink->pos;
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, ascii), zero))
+			== 0xFFFF)
+		{
+			_mm_storel_epi64((__m128i*)out, _mm_packus_epi16(v, v));
+			n = 8;
+			s += 8;
+		}
+		else if (_mm_movemask_epi8(
+			_mm_cmpeq_epi16(_mm_and_si128(v, sur_mask), sur)) == 0)
+		{
+			for (i = 0, n = 0; i < 8; i++)
+				n += utf8_encode(s[i], out + n);
+			s += 8;
+		}
+		else
+		{
+			const uint16_t* e = s + 8;
+
+			// The last surrogate may pair with the next block.
+			for (n = 0; s < e; )
+				n += utf8_encode(utf16_next(&s), out + n);
+		}
+
+		sink->pos += n;
+		sink->count += n;
+	}
+#endif
+
+	while (*s != 0)
+		sink_putcp(sink, utf16_next(&s));
+}
+
+/**
+ * Writes a zero terminated UTF-32 string to a sink as UTF-8.
+ * Blocks of four ASCII code points are narrowed to bytes with SSE2.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const uint32_t* - a zero terminated UTF-32 string
+ */
+NO_ASAN static void sink_utf32(my_sink* sink, const uint32_t* s)
+{
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ascii = _mm_set1_epi32((int)0xFFFFFF80);
+	__m128i v;
+	int bits;
+
+	while (*s != 0)
+	{
+		if (sink->size - sink->pos < 4 || !load_in_page(s))
+		{
+			sink_putcp(sink, *s++);
+			continue;
+		}
+
+		v = _mm_loadu_si128((const __m128i*)s);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(v, zero)) != 0
+			|| _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, ascii), zero))
+			!= 0xFFFF)
+		{
+			sink_putcp(sink, *s++);
+			continue;
+		}
+
+		v = _mm_packs_epi32(v, v);
+		bits = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+		memcpy(sink->buf + sink->pos, &bits, 4);
+		sink->pos += 4;
+		sink->count += 4;
+		s += 4;
+	}
+#endif
+
+	while (*s != 0)
+		sink_putcp(sink, *s++);
+}
+
+/**
+ * Writes a zero terminated wide character string to a sink as UTF-8.
+ * wchar_t holds UTF-16 where it is 16 bits wide and UTF-32 otherwise.
+ */
+static void sink_wcs(my_sink* sink, const wchar_t* s)
+{
+	if (sizeof(wchar_t) == 2)
+		sink_utf16(sink, (const uint16_t*)s);
+	else
+		sink_utf32(sink, (const uint32_t*)s);
+}
+
+/**
+ * Gets the length of a UTF-8 sequence from its first byte.
+ *
+ * Returns:
+ *   size_t - the length, or 0 if the byte cannot start a sequence
+ */
+static size_t utf8_seq_len(unsigned char c)
+{
+	return c < 0x80 ? 1
+		: c >= 0xC2 && c <= 0xDF ? 2
+		: c >= 0xE0 && c <= 0xEF ? 3
+		: c >= 0xF0 && c <= 0xF4 ? 4
+		: 0;
+}
+
+/**
+ * Decodes the UTF-8 sequence at the start of a string.
+ * An invalid sequence is replaced with a single U+FFFD, which stands for
+ * the longest prefix of a valid sequence, or for one byte, as Unicode
+ * recommends.
+ *
+ * Params:
+ *   const unsigned char* - the first byte of the sequence
+ *   size_t - the number of bytes available
+ *   uint32_t* - receives the code point, or U+FFFD if the sequence is
+ *     invalid
+ *
+ * Returns:
+ *   size_t - the number of bytes decoded, or 0 if the sequence is valid
+ *     so far but does not fit in the bytes available
+ */
+static size_t utf8_decode(const unsigned char* s, size_t avail, uint32_t* cp)
+{
+	unsigned char lo, hi;
+	uint32_t c;
+	size_t n, i;
+
+	n = utf8_seq_len(s[0]);
+	c = s[0] & (0x7F >> n);
+
+	*cp = 0xFFFD;
+	if (n == 0)
+		return 1;
+
+	// The range of the second byte excludes overlong encodings,
+	// surrogates and values above U+10FFFF.
+	lo = s[0] == 0xE0 ? 0xA0 : s[0] == 0xF0 ? 0x90 : 0x80;
+	hi = s[0] == 0xED ? 0x9F : s[0] == 0xF4 ? 0x8F : 0xBF;
 
-			if (t.spec == SPEC_c)
+	for (i = 1; i < n; i++)
+	{
+		if (i == avail)
+			return 0;
+		if (s[i] < lo || s[i] > hi)
+			return i;
+		c = (c << 6) | (s[i] & 0x3F);
+		lo = 0x80;
+		hi = 0xBF;
+	}
+
+	*cp = c;
+
+	return n;
+}
+
+/**
+ * Writes a \uXXXX escape to a sink.
+ */
+static void sink_json_u(my_sink* sink, uint32_t u)
+{
+	static const char hex[] = "0123456789abcdef";
+	char esc[6] = { '\\', 'u' };
+
+	esc[2] = hex[(u >> 12) & 0xF];
+	esc[3] = hex[(u >> 8) & 0xF];
+	esc[4] = hex[(u >> 4) & 0xF];
+	esc[5] = hex[u & 0xF];
+
+	sink_write(sink, esc, 6);
+}
+
+/**
+ * Writes a string to a sink with the escapes of a JSON string.
+ * Quotes, backslashes and control characters are escaped. If ascii is
+ * set, other characters are written as \uXXXX escapes of their UTF-16
+ * code units, and invalid UTF-8 as \ufffd. Otherwise, they are written as
+ * they are.
+ * With SSE2, the string is scanned 16 bytes at a time, and runs of bytes
+ * that need no escape are written in one piece.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const char* - a zero terminated string
+ *   size_t - the maximum number of bytes of the string to read
+ *   int - whether to escape non-ASCII characters
+ */
+NO_ASAN static void sink_json(my_sink* sink, const char* str, size_t max, int ascii)
+{
+	const unsigned char* s = (const unsigned char*)str;
+	const unsigned char* start = s;
+	const unsigned char* run = s;  // start of the run without escapes
+	unsigned char c;
+	uint32_t cp;
+	size_t n;
+
+#ifdef __SSE2__
+	const __m128i ctl = _mm_set1_epi8(0x1F);
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i bslash = _mm_set1_epi8('\\');
+	const __m128i space = _mm_set1_epi8(' ');
+	__m128i v, m;
+	int mask;
+#endif
+
+	for (;;)
+	{
+#ifdef __SSE2__
+		if (max - (size_t)(s - start) >= 16 && load_in_page(s))
+		{
+			v = _mm_loadu_si128((const __m128i*)s);
+
+			// A signed compare with ' ' also catches bytes of 0x80 and
+			// above, which are only escaped with ascii.
+			m = ascii
+				? _mm_cmplt_epi8(v, space)
+				: _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl);
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, quote));
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, bslash));
+			mask = _mm_movemask_epi8(m);
+
+			if (mask == 0)
 			{
-				char c = va_arg(argp, int);
-				my_putchar(c);
+				s += 16;
+				continue;
+			}
+
+			s += __builtin_ctz((unsigned)mask);
+		}
+#endif
+
+		if ((size_t)(s - start) >= max || *s == '\0')
+			break;
+
+		c = *s;
+		if (c >= ' ' && c != '"' && c != '\\' && (c < 0x80 || !ascii))
+		{
+			s++;
+			continue;
+		}
+
+		if (c >= 0x80)
+		{
+			// Stop before a character that the precision cuts short.
+			n = utf8_decode(s, max - (size_t)(s - start), &cp);
+			if (n == 0)
+				break;
+
+			sink_write(sink, (const char*)run, (size_t)(s - run));
+
+			if (cp >= 0x10000)
+			{
+				cp -= 0x10000;
+				sink_json_u(sink, 0xD800 + (cp >> 10));
+				sink_json_u(sink, 0xDC00 + (cp & 0x3FF));
 			}
-			else if (t.spec == SPEC_s)
+			else
+				sink_json_u(sink, cp);
+
+			s += n;
+			run = s;
+			continue;
+		}
+
+		sink_write(sink, (const char*)run, (size_t)(s - run));
+
+		switch (c)
+		{
+		case '"': sink_write(sink, "\\\"", 2); break;
+		case '\\': sink_write(sink, "\\\\", 2); break;
+		case '\b': sink_write(sink, "\\b", 2); break;
+		case '\f': sink_write(sink, "\\f", 2); break;
+		case '\n': sink_write(sink, "\\n", 2); break;
+		case '\r': sink_write(sink, "\\r", 2); break;
+		case '\t': sink_write(sink, "\\t", 2); break;
+		default: sink_json_u(sink, c); break;
+		}
+
+		s++;
+		run = s;
+	}
+
+	// Do not end the output in the middle of a character that the
+	// precision cuts short.
+	if ((size_t)(s - start) == max)
+	{
+		for (n = 1; n <= 3 && s - n >= run; n++)
+		{
+			c = s[-n];
+			if ((c & 0xC0) != 0x80)
 			{
-				char* s = va_arg(argp, char*);
-				size_t len = strlen(s);
-				for (i = 0; i < len; i++)
+				if (utf8_seq_len(c) > n)
+					s -= n;
+				break;
+			}
+		}
+	}
+
+	sink_write(sink, (const char*)run, (size_t)(s - run));
+}
+
+#endif
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
+/**
+ * Writes a double to a sink as %f does.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   double - the value
+ */
+static void sink_f(my_sink* sink, double d)
+{
+	size_t i;       // index
+	uint8_t frac[DOUBLE_BIN_DIG];
+	uint8_t whole[DOUBLE_BIN_DIG];
+	size_t w_res, f_res;
+
+	double_to_str(d, whole, &w_res, frac, &f_res);
+
+	if (w_res == 0)
+		sink_putc(sink, '0');
+
+	for (i = 0; i < w_res; i++)
+		sink_putc(sink, whole[i] + '0');
+
+	sink_putc(sink, '.');
+
+	for (i = 0; i < f_res && i < 7; i++)
+	{
+		if (i == 6 && f_res > 7)
+		{
+			if (frac[i + 1] > 4)
+				frac[i]++;
+		}
+
+		sink_putc(sink, frac[i] + '0');
+	}
+}
+
+/**
+ * Writes a double to a sink as %e and %E do.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   double - the value
+ *   ftag - the format tag, for the precision and the case of the 'e'
+ */
+static void sink_e(my_sink* sink, double d, ftag t)
+{
+	size_t i, j;    // index
+	char buf[100];  // string conversion buffer
+	size_t len;     // string length
+	uint8_t right[DOUBLE_BIN_DIG];
+	uint8_t left[DOUBLE_BIN_DIG];
+	size_t l_size, r_size;
+	size_t exp = 0;
+	size_t count = 0;
+	size_t ri = 0;
+	int neg = 0;
+	int extra = 0; // leading 1 due to rounding
+	size_t offset = 0;
+
+	// Default the precision to 6
+	if (t.prec == 0 && !(t.flags & FMT_ZPREC))
+		t.prec = 6;
+
+	double_to_str(d, left, &l_size, right, &r_size);
+
+
+	// Determine how to round the results
+	if (t.prec == 0)
+	{
+		// If precision is zero, we either round
+		// the left side, or the right side.
+		if (l_size > 1)
+		{
+			if (left[1] > 4)
+				left[0]++;
+
+			// Handle carries
+			if (left[0] >= 10)
+			{
+				left[0] = 0;
+				extra = 1;
+			}
+		}
+		else if (r_size > 1)
+		{
+			if (right[1] > 4)
+				right[0]++;
+
+			// Handle carries
+			if (right[0] >= 10)
+			{
+				right[0] = 0;
+				extra = 1;
+			}
+		}
+		else if (r_size > 0)
+		{
+			if (right[0] > 4)
+			{
+				if (l_size == 0)
+				{
+					left[0] = 1;
+					extra = 1;
+				}
+				else
 				{
-					my_putchar(s[i]);
+					left[0]++;
+					if (left[0] >= 10)
+					{
+						left[0] = 1;
+						left[1] = 0;
+						extra = 1;
+					}
 				}
 			}
-			else if (t.spec == SPEC_d || t.spec == SPEC_i)
-			{
-				int n = va_arg(argp, int);
-				len = int_to_str(n, buf, 10, 0, 1);
+		}
+	}
+	else
+	{
+		// If precision is greter than 0, we have to do some thinking.
 
-				for (i = 0; i < len; i++)
+		if (l_size >= 1)
+		{
+			// Determine if the rounding digit
+			// is on the left side or right side.
+			for (i = 0; i < l_size && i < t.prec; i++);
+
+			if (i < l_size && i > 0)
+			{
+				// The precision is within the left side
+				if (left[i] > 4)
 				{
-					my_putchar(buf[i]);
+					left[i - 1]++;
+
+					// Handle carries
+					if (left[i - 1] >= 10)
+					{
+						for (j = i - 1; j > 0 && left[j] >= 10; j--)
+						{
+							left[j - 1]++;
+							left[j] = 0;
+						}
+
+						if (j == 0 && left[j] >= 10)
+						{
+							left[j] = 0;
+							extra = 1;
+						}
+					}
 				}
+
 			}
-			else if (t.spec == SPEC_u)
+			else
 			{
-				unsigned int n = va_arg(argp, unsigned int);
-				len = int_to_str(n, buf, 10, 0, 0);
+				// The precision is within the right side
+				for (j = 0; j < r_size && j + i < t.prec; j++);
 
-				for (i = 0; i < len; i++)
+				if (j < r_size && right[j] > 4)
 				{
-					my_putchar(buf[i]);
+					if (j > 0)
+					{
+						// The precision is after the first element
+						right[j - 1]++;
+
+						j = j - 1;
+
+						// Handle carries
+						if (right[j] >= 10)
+						{
+							for (; j > 0 && right[j] >= 10; j--)
+							{
+								right[j - 1]++;
+								right[j] = 0;
+							}
+
+							if (j == 0 && right[j] >= 10)
+							{
+								right[j] = 0;
+
+								for (j = l_size - 1; j > 0 && left[j] >= 10; j--)
+								{
+									left[j - 1]++;
+									left[j] = 0;
+								}
+
+								if (j == 0 && left[j] >= 10)
+								{
+									left[j] = 0;
+									extra = 1;
+								}
+							}
+						}
+
+					}
+					else
+					{
+						left[l_size - 1]++;
+
+						j = l_size - 1;
+
+						// Handle carries
+						if (left[j] >= 10)
+						{
+							for (; j > 0 && left[j] >= 10; j--)
+							{
+								left[j - 1]++;
+								left[j] = 0;
+							}
+
+							if (j == 0 && left[j] >= 10)
+							{
+								left[j] = 0;
+								extra = 1;
+							}
+						}
+					}
+
+					j = j > 0 ? j - 1 : r_size - 1;
 				}
 			}
-			else if (t.spec == SPEC_X || t.spec == SPEC_x)
+		}
+		else if (r_size >= 1)
+		{
+			// Find the index of the first non zero element
+			for (i = 0; right[i] == 0 && i < r_size && i < t.prec; i++);
+			offset = i;
+			for (; i < r_size && i < t.prec + offset; i++);
+
+			if (i < r_size && i > 0)
 			{
-				int n = va_arg(argp, int);
-				int cap = t.spec == SPEC_X ? 1 : 0;
-				len = int_to_str(n, buf, 16, cap, 0);
+				if (right[i] > 4)
+				{
+					right[i] = 0;
+					right[i - 1]++;
+				}
+
+
+				j = i - 1;
+
+				// Handle carries
+				if (right[j] >= 10)
+				{
+					for (; j > 0 && right[j] >= 10; j--)
+					{
+						right[j - 1]++;
+						right[j] = 0;
+					}
+
+					if (j == 0 && right[j] >= 10)
+					{
+						right[j] = 0;
+						left[0]++;
+						extra = 1;
+					}
+				}
+			}
+		}
+	}
+
+
+	// Print the first character
+	if (extra)
+		sink_putc(sink, '1');
+
+	else if (l_size > 0)
+		sink_putc(sink, left[0] + '0');
+
+	else if (r_size > 0)
+	{
+		neg = 1;
+		exp++;
+		for (i = 0; i < r_size && right[i] == 0; i++)
+			exp++;
+
+		sink_putc(sink, right[i] + '0');
+	}
+	else
+		sink_putc(sink, '0');
+
+	// Print the radix point
+	if (t.prec)
+		sink_putc(sink, '.');
+
+	// Print the rest of the left side
+	if (l_size > 1)
+	{
+		for (i = 1; i < l_size && count < t.prec; i++)
+		{
+			sink_putc(sink, left[i] + '0');
+			exp++;
+			count++;
+		}
+	}
+
+	// Print the right side
+	if (r_size > 0 && l_size > 0)
+	{
+		for (i = 0; i < r_size && count < t.prec; i++)
+		{
+			if (count == t.prec - 1 && i < r_size - 1)
+			{
+				if (right[i + 1] > 4)
+					right[i]++;
+			}
+			sink_putc(sink, right[i] + '0');
+			exp++;
+			count++;
+		}
+	}
+	else if (r_size > 1)
+	{
+		for (i = exp; i < r_size && count < t.prec; i++)
+		{
+			/*if (count == t.prec - 1 && i < r_size - 1)
+			{
+				if (right[i + 1] > 4)
+					right[i]++;
+			}*/
+			sink_putc(sink, right[i] + '0');
+			count++;
+		}
+	}
+	else
+		sink_putc(sink, '0');
+
+	if (count < t.prec)
+	{
+		for (; count < t.prec; count++)
+		{
+			sink_putc(sink, '0');
+		}
+	}
+
+
+	// Print the 'E' or 'e' character
+	if (t.spec == SPEC_E)
+		sink_putc(sink, 'E');
+	else
+		sink_putc(sink, 'e');
+
+
+	if (l_size > 1)
+		exp = l_size - 1;
+	else if (l_size == 1)
+		exp = 0;
+
+	if (l_size >= 1 && extra)
+		exp++;
+	else if (neg && extra)
+	{
+		if (exp > 0)
+			exp--;
+		else
+		{
+			exp++;
+			neg = 0;
+		}
+	}
+
+	len = size_to_str(exp, buf, 10, 0);
+
+	sink_putc(sink, neg ? '-' : '+');
+
+	if (len < 2)
+		sink_putc(sink, '0');
+
+	for (i = 0; i < len; i++)
+		sink_putc(sink, buf[i]);
+}
+
+/**
+ * Writes a double to a sink in hexadecimal, as %a does.
+ * The digits are the nibbles of the mantissa that extract_double gives,
+ * so the conversion is as cheap as that of a hexadecimal integer, and
+ * without a precision it is exact. Normal numbers start with 0x1 and
+ * subnormal numbers with 0x0, with the exponent of the smallest normal
+ * number. A precision rounds the mantissa to that many digits, half to
+ * even, and a carry can make the leading digit 2.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   double - the number
+ *   const ftag* - the format tag, for the case, precision and flags
+ */
+static void sink_hexf(my_sink* sink, double d, const ftag* t)
+{
+	const char* hex = t->spec == SPEC_A ? "0123456789ABCDEF" : "0123456789abcdef";
+	ieee_754_double c = extract_double(d);
+	char buf[48];
+	uint64_t v, rem, half;
+	size_t n, prec, nd, k;
+	unsigned drop;
+	int exp;
+
+	n = 0;
+	if (c.sign)
+		buf[n++] = '-';
+	else if (t->flags & FMT_SIGN)
+		buf[n++] = '+';
+	else if (t->flags & FMT_SPACE)
+		buf[n++] = ' ';
+
+	// Infinity and NaN have the largest exponent.
+	if (c.exp == 1024)
+	{
+		memcpy(buf + n, (c.mant & 0xFFFFFFFFFFFFF)
+			? (t->spec == SPEC_A ? "NAN" : "nan")
+			: (t->spec == SPEC_A ? "INF" : "inf"), 3);
+		sink_write(sink, buf, n + 3);
+		return;
+	}
+
+	v = c.mant;
+	exp = v == 0 ? 0 : c.exp;
+
+	// Without a precision, write every digit up to the last one that is
+	// not zero.
+	if (t->flags & FMT_ZPREC)
+		prec = t->prec;
+	else
+		prec = v & 0xFFFFFFFFFFFFF
+			? 13 - (size_t)__builtin_ctzll(v & 0xFFFFFFFFFFFFF) / 4
+			: 0;
+
+	nd = prec < 13 ? prec : 13;
+	if (nd < 13)
+	{
+		drop = 4 * (13 - (unsigned)nd);
+		rem = v & (((uint64_t)1 << drop) - 1);
+		half = (uint64_t)1 << (drop - 1);
+		v >>= drop;
+		if (rem > half || (rem == half && (v & 1)))
+			v++;
+	}
+
+	buf[n++] = '0';
+	buf[n++] = t->spec == SPEC_A ? 'X' : 'x';
+	buf[n++] = hex[v >> (4 * nd)];
+	if (prec > 0 || (t->flags & FMT_POINT))
+		buf[n++] = '.';
+	for (k = nd; k > 0; k--)
+		buf[n++] = hex[(v >> (4 * (k - 1))) & 0xF];
+	sink_write(sink, buf, n);
+
+	// Digits past the 13 of the mantissa are zeros.
+	for (k = nd; k < prec; k++)
+		sink_putc(sink, '0');
+
+	n = 0;
+	buf[n++] = t->spec == SPEC_A ? 'P' : 'p';
+	buf[n++] = exp < 0 ? '-' : '+';
+	n += size_to_str(exp < 0 ? (size_t)-exp : (size_t)exp, buf + n, 10, 0);
+	sink_write(sink, buf, n);
+}
+
+/**
+ * Writes the digits of a number in base 10^9, most significant first and
+ * without leading zeros, straight from its limbs.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const uint32_t* - the limbs of the number, least significant first
+ *   size_t - the number of limbs
+ *   size_t - the number of digits before a decimal point, or SIZE_MAX for
+ *     no point
+ */
+static void sink_limbs(my_sink* sink, const uint32_t* x, size_t n, size_t point)
+{
+	char buf[9];
+	const char* s;
+	uint32_t v;
+	size_t len, i;
+	int k;
+
+	for (i = n; i-- > 0;)
+	{
+		for (v = x[i], k = 8; k >= 0; k--, v /= 10)
+			buf[k] = (char)('0' + v % 10);
+
+		s = buf;
+		len = 9;
+		if (i == n - 1)
+		{
+			for (; len > 1 && *s == '0'; len--)
+				s++;
+		}
+
+		if (point < len)
+		{
+			sink_write(sink, s, point);
+			sink_putc(sink, '.');
+			sink_write(sink, s + point, len - point);
+			point = SIZE_MAX;
+		}
+		else
+		{
+			sink_write(sink, s, len);
+			if (point != SIZE_MAX)
+				point -= len;
+		}
+	}
+
+	if (point == 0)
+		sink_putc(sink, '.');
+}
+
+/**
+ * Makes the limbs of a number m * 2^e that has a mantissa of up to 128
+ * bits. For e >= 0, that is the number itself, and otherwise it is
+ * m * 5^-e, which is the number times 10^-e. At most keep limbs are kept,
+ * as limb_pow_n does.
+ *
+ * Params:
+ *   uint32_t* - receives the limbs, least significant first
+ *   uint64_t - the upper 64 bits of the mantissa
+ *   uint64_t - the lower 64 bits of the mantissa
+ *   int - the exponent e
+ *   size_t - the number of limbs to keep
+ *   size_t* - receives the number of limbs cut
+ *   int* - receives 1 if a limb that was cut is not zero, or 0 otherwise
+ *
+ * Returns:
+ *   size_t - the number of limbs
+ */
+static size_t wide_limbs(uint32_t* x,
+	uint64_t hi,
+	uint64_t lo,
+	int e,
+	size_t keep,
+	size_t* drop,
+	int* inexact)
+{
+	uint32_t w[4];
+	uint64_t v;
+	size_t n, i;
+
+	// The mantissa is split into 32-bit words, and divided by 10^9 one
+	// word at a time.
+	n = 0;
+	do
+	{
+		w[0] = (uint32_t)(hi >> 32);
+		w[1] = (uint32_t)hi;
+		w[2] = (uint32_t)(lo >> 32);
+		w[3] = (uint32_t)lo;
+		for (v = 0, i = 0; i < 4; i++)
+		{
+			v = (v << 32) | w[i];
+			w[i] = (uint32_t)(v / LIMB_BASE);
+			v %= LIMB_BASE;
+		}
+		x[n++] = (uint32_t)v;
+		hi = ((uint64_t)w[0] << 32) | w[1];
+		lo = ((uint64_t)w[2] << 32) | w[3];
+	} while (hi | lo);
+
+	return e >= 0
+		? limb_pow_n(x, n, 2, (unsigned)e, keep, drop, inexact)
+		: limb_pow_n(x, n, 5, (unsigned)-e, keep, drop, inexact);
+}
+
+/**
+ * Rounds the limbs of a number times 10^k to the precision of %f or %e.
+ * For %f, they are left with min(k, precision) digits after the point,
+ * and for %e with precision + 1 digits, or fewer if the number is exact
+ * with fewer.
+ *
+ * Params:
+ *   uint32_t* - the limbs, least significant first
+ *   size_t - the number of limbs
+ *   size_t - the number of limbs cut from the bottom by wide_limbs
+ *   size_t - k
+ *   size_t - the precision
+ *   char - the specifier
+ *   long* - receives the decimal exponent for %e
+ *
+ * Returns:
+ *   size_t - the new number of limbs, or 0 if digits that were cut are
+ *     needed
+ */
+static size_t wide_round(uint32_t* x,
+	size_t n,
+	size_t drop,
+	size_t k,
+	size_t prec,
+	char spec,
+	long* exp)
+{
+	size_t d, j;
+
+	*exp = 0;
+	if (spec == SPEC_f)
+	{
+		if (k <= prec)
+			return drop ? 0 : n;
+
+		j = k - prec;
+		return j > 9 * drop ? limb_round(x, n, j - 9 * drop) : 0;
+	}
+
+	d = limb_count(x, n) + 9 * drop;
+	if (x[n - 1] != 0)
+		*exp = (long)d - 1 - (long)k;
+	if (d <= prec + 1)
+		return drop ? 0 : n;
+
+	j = d - prec - 1;
+	if (j <= 9 * drop)
+		return 0;
+	n = limb_round(x, n, j - 9 * drop);
+
+	// Rounding up from all nines adds a digit.
+	if (limb_count(x, n) > prec + 1)
+	{
+		n = limb_round(x, n, 1);
+		++*exp;
+	}
+
+	return n;
+}
+
+/**
+ * Writes a long double or __float128 to a sink as %f, %e and %E do, for
+ * any precision, and with the '+', ' ' and '#' flags.
+ * The number is m * 2^e. For e < 0, that is m * 5^-e / 10^-e, so its exact
+ * decimal expansion is the single integer m * 5^-e in base 10^9, with -e
+ * digits after the point. Rounding to the precision is then a division of
+ * that integer by a power of ten, and the digits are written from its
+ * limbs, so no array of digits is made.
+ *
+ * That integer has thousands of digits at the ends of the exponent range,
+ * so at first only its leading limbs are made, as many as the precision
+ * needs and a few more. The limbs that are cut make it smaller by less
+ * than 10^11 units of the lowest limb left, and if it rounds to the same
+ * digits with that added, those are the digits of the exact number.
+ * Otherwise, which is rare, the exact integer is made.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const ieee_754_wide* - the number
+ *   const ftag* - the format tag, for the specifier, precision and flags
+ *
+ * Returns:
+ *   int - 1 if the exact integer was made, else 0
+ */
+static int sink_wide(my_sink* sink, const ieee_754_wide* c, const ftag* t)
+{
+	uint32_t x[WIDE_LIMB_N];
+	uint32_t y[WIDE_LIMB_N];
+	char buf[16];
+	uint64_t hi, lo, v;
+	size_t n, ny, k, d, keep, drop, prec, i;
+	long exp, exp_y;
+	int e, bits, inexact;
+	int exact = 0;
+
+	if (c->sign)
+		sink_putc(sink, '-');
+	else if (t->flags & FMT_SIGN)
+		sink_putc(sink, '+');
+	else if (t->flags & FMT_SPACE)
+		sink_putc(sink, ' ');
+
+	if (c->cls != 0)
+	{
+		sink_write(sink, c->cls == 2
+			? (t->spec == SPEC_E ? "NAN" : "nan")
+			: (t->spec == SPEC_E ? "INF" : "inf"), 3);
+		return 0;
+	}
+
+	// Default the precision to 6
+	prec = t->prec;
+	if (prec == 0 && !(t->flags & FMT_ZPREC))
+		prec = 6;
+
+	// Trailing zero bits below the point would only add digits that are 0.
+	hi = c->hi;
+	lo = c->lo;
+	e = (hi | lo) ? c->exp : 0;
+	while (e < 0 && !(lo & 1) && (hi | lo))
+	{
+		lo = (lo >> 1) | (hi << 63);
+		hi >>= 1;
+		e++;
+	}
+	k = e < 0 ? (size_t)-e : 0;
+
+	// d is at least the number of digits of m * 2^e or m * 5^k, from
+	// log10(2) and log10(5) rounded up.
+	bits = hi ? 128 - __builtin_clzll(hi) : lo ? 64 - __builtin_clzll(lo) : 0;
+	d = ((((size_t)bits + (e > 0 ? (size_t)e : 0)) * 78914
+		+ k * 183236) >> 18) + 1;
+	if (t->spec != SPEC_f)
+		keep = (prec + 1) / 9 + 4;
+	else if (d + prec > k)
+		keep = (d + prec - k) / 9 + 4;
+	else
+		keep = 4;
+	if (keep > WIDE_LIMB_N - 96)
+		keep = WIDE_LIMB_N - 96;
+
+	n = wide_limbs(x, hi, lo, e, keep, &drop, &inexact);
+	if (inexact)
+	{
+		memcpy(y, x, n * sizeof(uint32_t));
+		ny = n;
+		for (i = 1, v = 100; v > 0; i++)
+		{
+			if (i == ny)
+				y[ny++] = 0;
+			v += y[i];
+			y[i] = (uint32_t)(v % LIMB_BASE);
+			v /= LIMB_BASE;
+		}
+
+		n = wide_round(x, n, drop, k, prec, t->spec, &exp);
+		ny = wide_round(y, ny, drop, k, prec, t->spec, &exp_y);
+		if (n != ny || exp != exp_y || memcmp(x, y, n * sizeof(uint32_t)) != 0)
+			n = 0;
+	}
+	else
+	{
+		n = wide_round(x, n, drop, k, prec, t->spec, &exp);
+	}
+
+	if (n == 0)
+	{
+		n = wide_limbs(x, hi, lo, e, WIDE_LIMB_N, &drop, &inexact);
+		n = wide_round(x, n, 0, k, prec, t->spec, &exp);
+		exact = 1;
+	}
+
+	if (t->spec == SPEC_f)
+	{
+		// x now has k digits after the point, and prec - k zeros follow.
+		if (k > prec)
+			k = prec;
+
+		d = limb_count(x, n);
+		if (d <= k)
+		{
+			sink_putc(sink, '0');
+			sink_putc(sink, '.');
+			for (i = d; i < k; i++)
+				sink_putc(sink, '0');
+			sink_limbs(sink, x, n, SIZE_MAX);
+		}
+		else
+		{
+			sink_limbs(sink, x, n,
+				prec > 0 || (t->flags & FMT_POINT) ? d - k : SIZE_MAX);
+		}
+
+		for (i = k; i < prec; i++)
+			sink_putc(sink, '0');
+
+		return exact;
+	}
+
+	// x now has prec + 1 digits, or fewer when the rest are zeros.
+	sink_limbs(sink, x, n, prec > 0 || (t->flags & FMT_POINT) ? 1 : SIZE_MAX);
+	for (i = limb_count(x, n); i <= prec; i++)
+		sink_putc(sink, '0');
+
+	i = 0;
+	buf[i++] = t->spec == SPEC_E ? 'E' : 'e';
+	buf[i++] = exp < 0 ? '-' : '+';
+	if (exp > -10 && exp < 10)
+		buf[i++] = '0';
+	i += size_to_str(exp < 0 ? (size_t)-exp : (size_t)exp, buf + i, 10, 0);
+	sink_write(sink, buf, i);
+
+	return exact;
+}
+
+#endif
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+
+/**
+ * Writes an integer scaled by 10^scale to a sink as an exact decimal, as
+ * %k does. The scale is the precision, and that many of the low digits
+ * go after the point, with zeros in front when there are fewer. With the
+ * '#' flag, the whole digits are grouped by thousands with commas. The
+ * width is filled with spaces, or with zeros after the sign for the '0'
+ * flag, and the '-' flag fills it on the right.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   int64_t - the scaled integer
+ *   const ftag* - the format tag, for the scale, width and flags
+ */
+static void sink_fixed(my_sink* sink, int64_t v, const ftag* t)
+{
+	char buf[48];     // digits, then the whole part with its separators
+	char* d;          // digits of the absolute value
+	uint64_t u;
+	size_t nd, whole, len, n, pad, i;
+	char sign;
+
+	u = v < 0 ? 0 - (uint64_t)v : (uint64_t)v;
+	d = buf + sizeof(buf);
+	do
+	{
+		*--d = (char)('0' + u % 10);
+		u /= 10;
+	} while (u);
+	nd = (size_t)(buf + sizeof(buf) - d);
+
+	sign = v < 0 ? '-'
+		: t->flags & FMT_SIGN ? '+'
+		: t->flags & FMT_SPACE ? ' '
+		: 0;
+
+	// The whole part is written to the front of the buffer, which the
+	// digits of a 64-bit integer leave room for.
+	whole = nd > t->prec ? nd - t->prec : 0;
+	n = 0;
+	if (whole == 0)
+		buf[n++] = '0';
+	for (i = 0; i < whole; i++)
+	{
+		if ((t->flags & FMT_POINT) && i > 0 && (whole - i) % 3 == 0)
+			buf[n++] = ',';
+		buf[n++] = d[i];
+	}
+
+	len = (sign != 0) + n + (t->prec > 0 ? 1 + t->prec : 0);
+	pad = t->width > len ? t->width - len : 0;
+
+	if (!(t->flags & (FMT_LEFT | FMT_ZERO)))
+		for (i = 0; i < pad; i++)
+			sink_putc(sink, ' ');
+	if (sign)
+		sink_putc(sink, sign);
+	if ((t->flags & (FMT_LEFT | FMT_ZERO)) == FMT_ZERO)
+		for (i = 0; i < pad; i++)
+			sink_putc(sink, '0');
+
+	sink_write(sink, buf, n);
+	if (t->prec > 0)
+	{
+		sink_putc(sink, '.');
+		for (i = nd; i < t->prec; i++)
+			sink_putc(sink, '0');
+		sink_write(sink, d + whole, nd - whole);
+	}
+
+	if (t->flags & FMT_LEFT)
+		for (i = 0; i < pad; i++)
+			sink_putc(sink, ' ');
+}
+
+#endif
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
+/**
+ * Reads the argument of a float specifier with the L or Q length.
+ *
+ * Params:
+ *   va_list* - the arguments
+ *   unsigned char - the LEN_ bit flags of the tag
+ *   ieee_754_wide* - receives the number
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if the Q length is not supported, in which
+ *     case the argument can't be read
+ */
+static int va_wide(va_list* argp, unsigned char len, ieee_754_wide* c)
+{
+	if (len & LEN_Q)
+	{
+#ifdef MY_PRINTF_FLOAT128
+		*c = extract_float128(va_arg(*argp, __float128));
+		return 0;
+#else
+		return 1;
+#endif
+	}
+
+	*c = extract_ldouble(va_arg(*argp, long double));
+
+	return 0;
+}
+
+#endif
+
+#ifdef MY_PRINTF_POSIX
+
+/**
+ * The state of a sink that writes to a file descriptor with writev.
+ * The vector refers to spans in the caller's memory and to ranges of
+ * the buffer, which holds everything that was copied.
+ */
+typedef struct iov_sink {
+	my_sink sink;              // the sink
+	int fd;                    // file descriptor
+	int n;                     // number of entries in the vector
+	size_t mark;               // start of the buffer not yet in the vector
+	struct iovec iov[IOV_N];   // vector of output ranges
+	char buf[MY_SINK_BUF];     // buffer for copied characters
+}iov_sink;
+
+/**
+ * Adds the characters in the buffer of a writev sink that are not yet in
+ * its vector to the vector.
+ *
+ * Params:
+ *   iov_sink* - a writev sink with at least one free vector entry
+ */
+static void iov_mark(iov_sink* is)
+{
+	if (is->sink.pos > is->mark)
+	{
+		is->iov[is->n].iov_base = is->buf + is->mark;
+		is->iov[is->n].iov_len = is->sink.pos - is->mark;
+		is->n++;
+		is->mark = is->sink.pos;
+	}
+}
+
+/**
+ * Writes out everything in the vector and the buffer of a writev sink,
+ * and empties them.
+ *
+ * Params:
+ *   my_sink* - the sink member of an iov_sink
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int iov_flush(my_sink* sink)
+{
+	iov_sink* is = (iov_sink*)sink;
+	struct iovec* v;
+	ssize_t w;
+	int n;
+
+	iov_mark(is);
+
+	v = is->iov;
+	n = is->n;
+
+	while (n > 0)
+	{
+		w = writev(is->fd, v, n);
+		if (w < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return 1;
+		}
+
+		// Skip past what was written, which may end in the middle
+		// of an entry.
+		for (; n > 0 && (size_t)w >= v->iov_len; v++, n--)
+			w -= v->iov_len;
+
+		if (n > 0)
+		{
+			v->iov_base = (char*)v->iov_base + w;
+			v->iov_len -= w;
+		}
+	}
+
+	is->n = 0;
+	is->mark = 0;
+	sink->pos = 0;
+
+	return 0;
+}
+
+/**
+ * Adds a span of the caller's memory to the vector of a writev sink.
+ *
+ * Params:
+ *   my_sink* - the sink member of an iov_sink
+ *   const char* - the span
+ *   size_t - the length of the span
+ *
+ * Returns:
+ *   int - 0 if the span was taken, or 1 if it has to be copied
+ */
+static int iov_span(my_sink* sink, const char* str, size_t len)
+{
+	iov_sink* is = (iov_sink*)sink;
+
+	// Leave room for the buffer contents before and after the span.
+	if (is->n + 2 >= IOV_N && iov_flush(sink))
+		return 1;
+
+	iov_mark(is);
+
+	is->iov[is->n].iov_base = (void*)str;
+	is->iov[is->n].iov_len = len;
+	is->n++;
+
+	return 0;
+}
+
+/**
+ * The output of my_dprintf_safe: a small buffer on the stack that is
+ * written to a file descriptor with write. It is not a my_sink, because
+ * sink flushes are counted in the statistics of the thread, which are
+ * allocated on first use.
+ */
+typedef struct safe_out {
+	int fd;                 // file descriptor
+	int err;                // error indicator
+	size_t pos;             // number of characters in the buffer
+	size_t count;           // total number of characters written
+	char buf[MY_SINK_BUF];  // output buffer
+}safe_out;
+
+/**
+ * Writes the buffer of a safe_out to its file descriptor with write,
+ * which is async-signal-safe.
+ *
+ * Params:
+ *   safe_out* - the output
+ */
+static void safe_flush(safe_out* out)
+{
+	const char* p = out->buf;
+	size_t n = out->pos;
+	ssize_t w;
+
+	while (n > 0 && !out->err)
+	{
+		// Only an interrupted write is tried again. A write of nothing
+		// would never make progress.
+		w = write(out->fd, p, n);
+		if (w <= 0)
+		{
+			if (w == 0 || errno != EINTR)
+				out->err = 1;
+			continue;
+		}
+
+		p += w;
+		n -= (size_t)w;
+	}
+
+	out->pos = 0;
+}
+
+/**
+ * Writes characters to a safe_out.
+ *
+ * Params:
+ *   safe_out* - the output
+ *   const char* - the characters
+ *   size_t - the number of characters
+ */
+static void safe_write(safe_out* out, const char* str, size_t len)
+{
+	size_t n;
+
+	out->count += len;
+	while (len > 0)
+	{
+		if (out->pos == sizeof(out->buf))
+			safe_flush(out);
+
+		n = sizeof(out->buf) - out->pos;
+		if (n > len)
+			n = len;
+		memcpy(out->buf + out->pos, str, n);
+		out->pos += n;
+		str += n;
+		len -= n;
+	}
+}
+
+/**
+ * Writes a character to a safe_out a number of times.
+ *
+ * Params:
+ *   safe_out* - the output
+ *   char - the character
+ *   size_t - the number of times
+ */
+static void safe_fill(safe_out* out, char c, size_t n)
+{
+	for (; n > 0; n--)
+		safe_write(out, &c, 1);
+}
+
+/**
+ * Writes an integer to a safe_out with the width, precision and flags of
+ * its tag, as printf does.
+ *
+ * Params:
+ *   safe_out* - the output
+ *   uint64_t - the absolute value
+ *   char - the sign to write, or 0 for none
+ *   unsigned - the base, 8, 10 or 16
+ *   const ftag* - the format tag
+ */
+static void safe_int(safe_out* out,
+	uint64_t u,
+	char sign,
+	unsigned base,
+	const ftag* t)
+{
+	const char* hex = t->spec == SPEC_X ? "0123456789ABCDEF" : "0123456789abcdef";
+	char digits[24];
+	char* d = digits + sizeof(digits);
+	size_t n, prec, pre, len, pad;
+
+	// A precision of 0 writes nothing for 0.
+	if (u != 0 || !(t->flags & FMT_ZPREC) || t->prec > 0)
+	{
+		do
+		{
+			*--d = hex[u % base];
+			u /= base;
+		} while (u);
+	}
+	n = (size_t)(digits + sizeof(digits) - d);
+
+	prec = t->flags & FMT_ZPREC ? t->prec : 1;
+	pre = 0;
+	if ((t->flags & FMT_POINT) && base == 16 && n > 0 && *d != '0')
+		pre = 2;
+	else if ((t->flags & FMT_POINT) && base == 8 && prec <= n
+		&& (n == 0 || *d != '0'))
+		prec = n + 1;
+	if (prec < n)
+		prec = n;
+
+	len = (sign != 0) + pre + prec;
+	pad = t->width > len ? t->width - len : 0;
+
+	// The '0' flag is ignored with a precision.
+	if ((t->flags & (FMT_LEFT | FMT_ZERO | FMT_ZPREC)) == FMT_ZERO)
+	{
+		prec += pad;
+		pad = 0;
+	}
+
+	if (!(t->flags & FMT_LEFT))
+		safe_fill(out, ' ', pad);
+	if (sign)
+		safe_write(out, &sign, 1);
+	if (pre)
+		safe_write(out, t->spec == SPEC_X ? "0X" : "0x", 2);
+	safe_fill(out, '0', prec - n);
+	safe_write(out, d, n);
+	if (t->flags & FMT_LEFT)
+		safe_fill(out, ' ', pad);
+}
+
+#endif
+
+/**
+ * Writes the buffer of a sink to the output stream in its data member.
+ *
+ * Params:
+ *   my_sink* - a sink with a FILE* as its data
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int file_flush(my_sink* sink)
+{
+	size_t n;
+
+	n = sink->pos > 0 ? fwrite(sink->buf, 1, sink->pos, sink->data) : 0;
+	if (n != sink->pos)
+		return 1;
+
+	sink->pos = 0;
+
+	return 0;
+}
+
+/**
+ * Handles a full character array in a str_sink.
+ * The end of the output is recorded, and the rest of the characters
+ * are sent to the scratch buffer so that they can be counted.
+ *
+ * Params:
+ *   my_sink* - the sink member of a str_sink
+ *
+ * Returns:
+ *   int - always 0
+ */
+static int str_flush(my_sink* sink)
+{
+	str_sink* ss = (str_sink*)sink;
+
+	if (ss->end == NULL)
+	{
+		ss->end = sink->buf + sink->pos;
+		STAT_ADD(STAT_TRUNC, 1);
+	}
+
+	sink->buf = ss->scratch;
+	sink->size = sizeof(ss->scratch);
+	sink->pos = 0;
+
+	return 0;
+}
+
+
+/**
+ * Powers of ten as doubles, from 1e0 to 1e308.
+ * Each entry is the double nearest to the exact power of ten, so a double
+ * that compares greater than or less than an entry is also greater than or
+ * less than the exact power of ten.
+ */
+static const double pow10_pos[309] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+	1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22, 1e23, 1e24, 1e25,
+	1e26, 1e27, 1e28, 1e29, 1e30, 1e31, 1e32, 1e33, 1e34, 1e35, 1e36, 1e37,
+	1e38, 1e39, 1e40, 1e41, 1e42, 1e43, 1e44, 1e45, 1e46, 1e47, 1e48, 1e49,
+	1e50, 1e51, 1e52, 1e53, 1e54, 1e55, 1e56, 1e57, 1e58, 1e59, 1e60, 1e61,
+	1e62, 1e63, 1e64, 1e65, 1e66, 1e67, 1e68, 1e69, 1e70, 1e71, 1e72, 1e73,
+	1e74, 1e75, 1e76, 1e77, 1e78, 1e79, 1e80, 1e81, 1e82, 1e83, 1e84, 1e85,
+	1e86, 1e87, 1e88, 1e89, 1e90, 1e91, 1e92, 1e93, 1e94, 1e95, 1e96, 1e97,
+	1e98, 1e99, 1e100, 1e101, 1e102, 1e103, 1e104, 1e105, 1e106, 1e107, 1e108,
+	1e109, 1e110, 1e111, 1e112, 1e113, 1e114, 1e115, 1e116, 1e117, 1e118, 1e119,
+	1e120, 1e121, 1e122, 1e123, 1e124, 1e125, 1e126, 1e127, 1e128, 1e129, 1e130,
+	1e131, 1e132, 1e133, 1e134, 1e135, 1e136, 1e137, 1e138, 1e139, 1e140, 1e141,
+	1e142, 1e143, 1e144, 1e145, 1e146, 1e147, 1e148, 1e149, 1e150, 1e151, 1e152,
+	1e153, 1e154, 1e155, 1e156, 1e157, 1e158, 1e159, 1e160, 1e161, 1e162, 1e163,
+	1e164, 1e165, 1e166, 1e167, 1e168, 1e169, 1e170, 1e171, 1e172, 1e173, 1e174,
+	1e175, 1e176, 1e177, 1e178, 1e179, 1e180, 1e181, 1e182, 1e183, 1e184, 1e185,
+	1e186, 1e187, 1e188, 1e189, 1e190, 1e191, 1e192, 1e193, 1e194, 1e195, 1e196,
+	1e197, 1e198, 1e199, 1e200, 1e201, 1e202, 1e203, 1e204, 1e205, 1e206, 1e207,
+	1e208, 1e209, 1e210, 1e211, 1e212, 1e213, 1e214, 1e215, 1e216, 1e217, 1e218,
+	1e219, 1e220, 1e221, 1e222, 1e223, 1e224, 1e225, 1e226, 1e227, 1e228, 1e229,
+	1e230, 1e231, 1e232, 1e233, 1e234, 1e235, 1e236, 1e237, 1e238, 1e239, 1e240,
+	1e241, 1e242, 1e243, 1e244, 1e245, 1e246, 1e247, 1e248, 1e249, 1e250, 1e251,
+	1e252, 1e253, 1e254, 1e255, 1e256, 1e257, 1e258, 1e259, 1e260, 1e261, 1e262,
+	1e263, 1e264, 1e265, 1e266, 1e267, 1e268, 1e269, 1e270, 1e271, 1e272, 1e273,
+	1e274, 1e275, 1e276, 1e277, 1e278, 1e279, 1e280, 1e281, 1e282, 1e283, 1e284,
+	1e285, 1e286, 1e287, 1e288, 1e289, 1e290, 1e291, 1e292, 1e293, 1e294, 1e295,
+	1e296, 1e297, 1e298, 1e299, 1e300, 1e301, 1e302, 1e303, 1e304, 1e305, 1e306,
+	1e307, 1e308
+};
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
+/**
+ * Negative powers of ten as doubles, from 1e-0 to 1e-323.
+ * These are rounded in the same way as pow10_pos.
+ */
+static const double pow10_neg[324] = {
+	1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9, 1e-10, 1e-11,
+	1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18, 1e-19, 1e-20, 1e-21, 1e-22,
+	1e-23, 1e-24, 1e-25, 1e-26, 1e-27, 1e-28, 1e-29, 1e-30, 1e-31, 1e-32, 1e-33,
+	1e-34, 1e-35, 1e-36, 1e-37, 1e-38, 1e-39, 1e-40, 1e-41, 1e-42, 1e-43, 1e-44,
+	1e-45, 1e-46, 1e-47, 1e-48, 1e-49, 1e-50, 1e-51, 1e-52, 1e-53, 1e-54, 1e-55,
+	1e-56, 1e-57, 1e-58, 1e-59, 1e-60, 1e-61, 1e-62, 1e-63, 1e-64, 1e-65, 1e-66,
+	1e-67, 1e-68, 1e-69, 1e-70, 1e-71, 1e-72, 1e-73, 1e-74, 1e-75, 1e-76, 1e-77,
+	1e-78, 1e-79, 1e-80, 1e-81, 1e-82, 1e-83, 1e-84, 1e-85, 1e-86, 1e-87, 1e-88,
+	1e-89, 1e-90, 1e-91, 1e-92, 1e-93, 1e-94, 1e-95, 1e-96, 1e-97, 1e-98, 1e-99,
+	1e-100, 1e-101, 1e-102, 1e-103, 1e-104, 1e-105, 1e-106, 1e-107, 1e-108,
+	1e-109, 1e-110, 1e-111, 1e-112, 1e-113, 1e-114, 1e-115, 1e-116, 1e-117,
+	1e-118, 1e-119, 1e-120, 1e-121, 1e-122, 1e-123, 1e-124, 1e-125, 1e-126,
+	1e-127, 1e-128, 1e-129, 1e-130, 1e-131, 1e-132, 1e-133, 1e-134, 1e-135,
+	1e-136, 1e-137, 1e-138, 1e-139, 1e-140, 1e-141, 1e-142, 1e-143, 1e-144,
+	1e-145, 1e-146, 1e-147, 1e-148, 1e-149, 1e-150, 1e-151, 1e-152, 1e-153,
+	1e-154, 1e-155, 1e-156, 1e-157, 1e-158, 1e-159, 1e-160, 1e-161, 1e-162,
+	1e-163, 1e-164, 1e-165, 1e-166, 1e-167, 1e-168, 1e-169, 1e-170, 1e-171,
+	1e-172, 1e-173, 1e-174, 1e-175, 1e-176, 1e-177, 1e-178, 1e-179, 1e-180,
+	1e-181, 1e-182, 1e-183, 1e-184, 1e-185, 1e-186, 1e-187, 1e-188, 1e-189,
+	1e-190, 1e-191, 1e-192, 1e-193, 1e-194, 1e-195, 1e-196, 1e-197, 1e-198,
+	1e-199, 1e-200, 1e-201, 1e-202, 1e-203, 1e-204, 1e-205, 1e-206, 1e-207,
+	1e-208, 1e-209, 1e-210, 1e-211, 1e-212, 1e-213, 1e-214, 1e-215, 1e-216,
+	1e-217, 1e-218, 1e-219, 1e-220, 1e-221, 1e-222, 1e-223, 1e-224, 1e-225,
+	1e-226, 1e-227, 1e-228, 1e-229, 1e-230, 1e-231, 1e-232, 1e-233, 1e-234,
+	1e-235, 1e-236, 1e-237, 1e-238, 1e-239, 1e-240, 1e-241, 1e-242, 1e-243,
+	1e-244, 1e-245, 1e-246, 1e-247, 1e-248, 1e-249, 1e-250, 1e-251, 1e-252,
+	1e-253, 1e-254, 1e-255, 1e-256, 1e-257, 1e-258, 1e-259, 1e-260, 1e-261,
+	1e-262, 1e-263, 1e-264, 1e-265, 1e-266, 1e-267, 1e-268, 1e-269, 1e-270,
+	1e-271, 1e-272, 1e-273, 1e-274, 1e-275, 1e-276, 1e-277, 1e-278, 1e-279,
+	1e-280, 1e-281, 1e-282, 1e-283, 1e-284, 1e-285, 1e-286, 1e-287, 1e-288,
+	1e-289, 1e-290, 1e-291, 1e-292, 1e-293, 1e-294, 1e-295, 1e-296, 1e-297,
+	1e-298, 1e-299, 1e-300, 1e-301, 1e-302, 1e-303, 1e-304, 1e-305, 1e-306,
+	1e-307, 1e-308, 1e-309, 1e-310, 1e-311, 1e-312, 1e-313, 1e-314, 1e-315,
+	1e-316, 1e-317, 1e-318, 1e-319, 1e-320, 1e-321, 1e-322, 1e-323
+};
+
+#endif
+
+/**
+ * Powers of ten that fit in 64 bits, from 1 to 10^19.
+ */
+static const uint64_t pow10_u64[20] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+/**
+ * Counts the significant bits of an unsigned integer.
+ * 0 is counted as having one bit.
+ *
+ * Params:
+ *   uint64_t - an unsigned integer
+ *
+ * Returns:
+ *   size_t - the number of significant bits
+ */
+static size_t bit_len(uint64_t n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return 64 - __builtin_clzll(n | 1);
+#else
+	size_t b = 1;
+
+	while (n >>= 1)
+		b++;
+
+	return b;
+#endif
+}
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
+/**
+ * Counts the trailing zero bits of a non-zero unsigned integer.
+ *
+ * Params:
+ *   uint64_t - a non-zero unsigned integer
+ *
+ * Returns:
+ *   size_t - the number of trailing zero bits
+ */
+static size_t bit_tz(uint64_t n)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(n);
+#else
+	size_t b = 0;
+
+	while (!(n & 1))
+	{
+		n >>= 1;
+		b++;
+	}
+
+	return b;
+#endif
+}
+
+#endif
+
+/**
+ * Counts the decimal digits of an unsigned integer without converting it.
+ * The bit length gives an estimate of log10, which is corrected with a
+ * table of powers of ten.
+ *
+ * Params:
+ *   uint64_t - an unsigned integer
+ *
+ * Returns:
+ *   size_t - the number of decimal digits
+ */
+static size_t udec_len(uint64_t n)
+{
+	size_t d;
+
+	// 1233 / 4096 is slightly more than log10(2)
+	d = (bit_len(n) * 1233) >> 12;
+
+	return d + ((n | 1) >= pow10_u64[d]);
+}
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+
+/**
+ * Counts the characters of a formatted double without converting it.
+ * This is an estimate from the binary exponent that is checked against
+ * tables of powers of ten. When a value is exactly equal to one of the
+ * table entries, the estimate cannot be trusted, and 0 is stored in the
+ * exact flag so that the caller can count the real output instead.
+ *
+ * Params:
+ *   ieee_754_double - the binary components of the value
+ *   double - the absolute value
+ *   size_t* - receives the number of digits in the whole part
+ *   size_t* - receives the number of binary digits in the fraction
+ *   int* - receives 1 if the counts are exact, or 0 if they are not
+ */
+static void double_len(ieee_754_double c,
+	double a,
+	size_t* w_len,
+	size_t* f_bits,
+	int* exact)
+{
+	int e2; // binary exponent of the leading bit
+	int n;  // power of ten
+	int frac;
+
+	*w_len = 0;
+	*f_bits = 0;
+	*exact = 1;
+
+	if (c.mant == 0)
+		return;
+
+	e2 = c.exp + (int)bit_len(c.mant) - 53;
+
+	// The fraction has every bit below the radix point up to the
+	// lowest set bit.
+	frac = 52 - c.exp - (int)bit_tz(c.mant);
+	if (frac > 0)
+		*f_bits = frac;
+
+	if (e2 < 0)
+		return;
+
+	if (e2 < 64)
+	{
+		*w_len = udec_len(c.exp >= 52
+			? c.mant << (c.exp - 52)
+			: c.mant >> (52 - c.exp));
+		return;
+	}
+
+	// 78913 / 2^18 is slightly less than log10(2), so 10^n <= a.
+	n = (e2 * 78913) >> 18;
+	while (n < 308 && a > pow10_pos[n + 1])
+		n++;
+
+	if (n < 308 && a == pow10_pos[n + 1])
+		*exact = 0;
+
+	*w_len = n + 1;
+}
+
+/**
+ * Finds the position of the first non-zero decimal digit after the radix
+ * point of a value between 0 and 1, without converting it.
+ *
+ * Params:
+ *   ieee_754_double - the binary components of the value
+ *   double - the absolute value
+ *   int* - receives 0 if the position could not be determined exactly
+ *
+ * Returns:
+ *   size_t - the position of the first non-zero digit, starting at 1
+ */
+static size_t double_frac_pos(ieee_754_double c, double a, int* exact)
+{
+	int e2; // binary exponent of the leading bit
+	int p;  // position
+
+	e2 = c.exp + (int)bit_len(c.mant) - 53;
+
+	// a < 2^(e2 + 1) <= 10^-p, so the first digit is after position p.
+	p = ((-(e2 + 1)) * 78913) >> 18;
+
+	for (p++; p < 324 && a < pow10_neg[p]; p++);
+
+	if (p < 324 && a == pow10_neg[p])
+		*exact = 0;
+
+	return p;
+}
+
+/**
+ * Makes room in a sink that only counts characters by discarding the
+ * contents of its buffer.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *
+ * Returns:
+ *   int - always 0
+ */
+static int count_flush(my_sink* sink)
+{
+	sink->pos = 0;
+
+	return 0;
+}
+
+/**
+ * Counts the characters of a formatted string by formatting it into a
+ * sink that discards its output.
+ * This is used for the rare values that the length functions cannot
+ * count exactly without converting them.
+ *
+ * Params:
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   size_t - the number of characters
+ */
+static size_t format_count(const char* fmt, ...)
+{
+	my_sink sink;
+	char buf[MY_SINK_BUF];
+	va_list argp;
+
+	sink_init(&sink, buf, sizeof(buf), count_flush, NULL);
+
+	va_start(argp, fmt);
+	my_vformat(&sink, fmt, argp);
+	va_end(argp);
+
+	return sink.count;
+}
+
+/**
+ * Counts the characters written by the %f conversion of a double.
+ *
+ * Params:
+ *   double - the value
+ *
+ * Returns:
+ *   size_t - the number of characters
+ */
+static size_t f_len(double d)
+{
+	ieee_754_double c;
+	size_t w_len, f_bits;
+	int exact;
+
+	c = extract_double(d);
+	if (c.exp == 1024)
+		return format_count("%f", d);
+
+	double_len(c, d < 0 ? -d : d, &w_len, &f_bits, &exact);
+	if (!exact)
+		return format_count("%f", d);
+
+	// A whole part of 0 is written as "0", and the fraction has as many
+	// decimal digits as binary digits, but at least one and at most seven.
+	if (f_bits < 1)
+		f_bits = 1;
+	if (f_bits > 7)
+		f_bits = 7;
+
+	return (w_len ? w_len : 1) + 1 + f_bits;
+}
+
+/**
+ * Counts the characters written by the %e conversion of a double.
+ *
+ * Params:
+ *   double - the value
+ *   size_t - the precision
+ *
+ * Returns:
+ *   size_t - the number of characters
+ */
+static size_t e_len(double d, size_t prec)
+{
+	ieee_754_double c;
+	size_t w_len, f_bits, exp, n;
+	double a;
+	int exact;
+
+	c = extract_double(d);
+	if (c.exp == 1024)
+		return format_count("%.*e", (int)prec, d);
+
+	a = d < 0 ? -d : d;
+	double_len(c, a, &w_len, &f_bits, &exact);
+
+	// first digit, radix point and the digits after it
+	n = 1 + (prec ? 1 : 0) + prec;
+
+	if (w_len > 0)
+		exp = w_len - 1;
+	else if (c.mant == 0)
+	{
+		// Zero has a single fraction digit, which is counted
+		// as a leading zero.
+		exp = 2;
+		n++;
+	}
+	else
+	{
+		exp = double_frac_pos(c, a, &exact);
+
+		// A single fraction digit is followed by an extra '0'.
+		if (f_bits <= 1)
+			n++;
+	}
+
+	// Rounding can carry into a new leading digit, which moves the
+	// exponent across 100 only from these values.
+	if (!exact || (w_len > 0 && exp == 99) || (w_len == 0 && exp == 100))
+		return format_count("%.*e", (int)prec, d);
+
+	// 'e', sign and at least two exponent digits
+	return n + 2 + (exp >= 100 ? 3 : 2);
+}
+
+#endif
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+
+/**
+ * Gets the number of UTF-8 characters that sink_utf16 writes for a string.
+ *
+ * Params:
+ *   const uint16_t* - a zero terminated UTF-16 string
+ *
+ * Returns:
+ *   size_t - the number of characters
+ */
+NO_ASAN static size_t utf16_len(const uint16_t* s)
+{
+	size_t n = 0;
+
+#ifdef __SSE2__
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ascii = _mm_set1_epi16((short)0xFF80);
+
+	// Skip blocks of ASCII, which take one character per code unit.
+	while (load_in_page(s))
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)s);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, ascii), zero))
+			!= 0xFFFF || _mm_movemask_epi8(_mm_cmpeq_epi16(v, zero)) != 0)
+			break;
+
+		n += 8;
+		s += 8;
+	}
+#endif
+
+	while (*s != 0)
+		n += utf8_len(utf16_next(&s));
+
+	return n;
+}
+
+/**
+ * Gets the number of UTF-8 characters that sink_utf32 writes for a string.
+ *
+ * Params:
+ *   const uint32_t* - a zero terminated UTF-32 string
+ *
+ * Returns:
+ *   size_t - the number of characters
+ */
+static size_t utf32_len(const uint32_t* s)
+{
+	size_t n = 0;
+
+	while (*s != 0)
+		n += utf8_len(*s++);
+
+	return n;
+}
+
+#endif
+
+/**
+ * A chunk of memory in an arena.
+ * The chunks of an arena form a list that is kept when the arena is reset,
+ * so that they can be filled again.
+ */
+struct my_arena_chunk {
+	struct my_arena_chunk* next; // next chunk
+	size_t size;                 // capacity of the data array
+	size_t used;                 // number of bytes in use
+	char data[];                 // the memory of the chunk
+};
+
+/**
+ * Moves an arena to the next chunk that has at least a given number of
+ * bytes, allocating a new chunk if the next one is too small.
+ *
+ * Params:
+ *   my_arena* - an arena
+ *   size_t - the number of bytes needed
+ *
+ * Returns:
+ *   my_arena_chunk* - the new current chunk, or NULL on failure
+ */
+static struct my_arena_chunk* arena_next(my_arena* arena, size_t need)
+{
+	struct my_arena_chunk* c;  // chunk
+	struct my_arena_chunk** p; // link to the next chunk
+	size_t size;
+
+	p = arena->cur != NULL ? &arena->cur->next : &arena->head;
+	c = *p;
+
+	if (c == NULL || c->size < need)
+	{
+		size = arena->chunk_size > need ? arena->chunk_size : need;
+
+		c = malloc(sizeof(struct my_arena_chunk) + size);
+		if (c == NULL)
+			return NULL;
+
+		// A chunk that is too small stays after the new one,
+		// so it can still be used for shorter strings.
+		c->next = *p;
+		c->size = size;
+		*p = c;
+	}
+
+	c->used = 0;
+	arena->cur = c;
+
+	return c;
+}
+
+/**
+ * Makes room in a sink that writes into an arena.
+ * Since the output must be contiguous, the characters written so far are
+ * moved to a chunk with at least twice as much space.
+ *
+ * Params:
+ *   my_sink* - a sink with a my_arena* as its data
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if no memory could be allocated
+ */
+static int arena_flush(my_sink* sink)
+{
+	struct my_arena_chunk* c;
+
+	c = arena_next(sink->data, sink->pos * 2 + 2);
+	if (c == NULL)
+		return 1;
+
+	memcpy(c->data, sink->buf, sink->pos);
+	sink->buf = c->data;
+
+	// Keep one byte for the NUL character.
+	sink->size = c->size - 1;
+
+	return 0;
+}
+
+
+#ifdef MY_PRINTF_POSIX
+
+/**
+ * The header at the start of a log file.
+ * The header is shared by every process that has the file open, and the
+ * tail offset is only ever changed with an atomic fetch-add.
+ */
+struct my_log_header {
+	_Atomic uint64_t magic; // LOG_MAGIC once the header is complete
+	uint64_t window;        // size of a window
+	uint64_t data;          // file offset of the first window
+	_Atomic uint64_t tail;  // next free offset after the first window
+};
+
+/**
+ * Makes sure that a range of a log file is allocated on disk,
+ * without ever making the file shorter.
+ *
+ * Params:
+ *   int - a file descriptor
+ *   off_t - the start of the range
+ *   off_t - the length of the range
+ *
+ * Returns:
+ *   int - 0 on success, or non-zero on failure
+ */
+static int log_extend(int fd, off_t start, off_t len)
+{
+#ifdef __linux__
+	return posix_fallocate(fd, start, len);
+#else
+	struct stat st;
+
+	if (fstat(fd, &st))
+		return 1;
+
+	return st.st_size < start + len ? ftruncate(fd, start + len) : 0;
+#endif
+}
+
+/**
+ * Gets a pointer to an offset in the data area of a log file, mapping the
+ * window that contains it in place of the current window if necessary.
+ *
+ * Params:
+ *   my_log* - a log
+ *   uint64_t - an offset in the data area
+ *
+ * Returns:
+ *   char* - a pointer to the offset, or NULL on failure
+ */
+static char* log_map(my_log* log, uint64_t off)
+{
+	uint64_t win;  // index of the window
+	off_t start;   // file offset of the window
+	void* map;
+
+	win = off / log->window;
+
+	if (log->map == NULL || win != log->win)
+	{
+		start = (off_t)(log->header->data + win * log->window);
+
+		if (log_extend(log->fd, start, (off_t)log->window))
+			return NULL;
+
+		map = mmap(NULL, log->window, PROT_READ | PROT_WRITE, MAP_SHARED,
+			log->fd, start);
+		if (map == MAP_FAILED)
+			return NULL;
+
+		if (log->map != NULL)
+			munmap(log->map, log->window);
+
+		log->map = map;
+		log->win = win;
+	}
+
+	return log->map + off % log->window;
+}
+
+/**
+ * Writes a padding record that covers a range of the data area.
+ *
+ * Params:
+ *   my_log* - a log
+ *   uint64_t - the offset of the range
+ *   uint64_t - the size of the range, a multiple of 8
+ */
+static void log_pad(my_log* log, uint64_t off, uint64_t size)
+{
+	char* rec = log_map(log, off);
+
+	if (rec != NULL)
+	{
+		atomic_store_explicit((_Atomic uint32_t*)rec,
+			(uint32_t)(size - LOG_REC_HDR) | LOG_PAD, memory_order_release);
+	}
+}
+
+/**
+ * Handles a log record that is longer than the length that was reserved
+ * for it. This should not happen, since the length is computed exactly.
+ *
+ * Returns:
+ *   int - always 1
+ */
+static int log_flush(my_sink* sink)
+{
+	(void)sink;
+
+	return 1;
+}
+
+#endif
+
+
+#ifdef MY_PRINTF_URING
+
+/**
+ * An io_uring instance with its submission and completion rings mapped.
+ */
+struct my_aio_ring {
+	int fd;                      // io_uring file descriptor
+	int fixed;                   // the output buffers are registered
+	unsigned* sq_tail;           // submission queue tail
+	unsigned* sq_mask;           // submission queue index mask
+	unsigned* sq_array;          // submission queue index array
+	unsigned* cq_head;           // completion queue head
+	unsigned* cq_tail;           // completion queue tail
+	unsigned* cq_mask;           // completion queue index mask
+	struct io_uring_sqe* sqes;   // submission queue entries
+	struct io_uring_cqe* cqes;   // completion queue entries
+	void* sq_map;                // mapping of the submission ring
+	size_t sq_len;               // size of the submission ring mapping
+	void* cq_map;                // mapping of the completion ring
+	size_t cq_len;               // size of the completion ring mapping
+	size_t sqe_len;              // size of the entry mapping
+};
+
+/**
+ * Unmaps and closes an io_uring.
+ *
+ * Params:
+ *   struct my_aio_ring* - a ring, or NULL
+ */
+static void ring_close(struct my_aio_ring* r)
+{
+	if (r == NULL)
+		return;
+
+	if (r->sqes != NULL && r->sqes != MAP_FAILED)
+		munmap(r->sqes, r->sqe_len);
+
+	if (r->cq_map != NULL && r->cq_map != MAP_FAILED && r->cq_map != r->sq_map)
+		munmap(r->cq_map, r->cq_len);
+
+	if (r->sq_map != NULL && r->sq_map != MAP_FAILED)
+		munmap(r->sq_map, r->sq_len);
+
+	if (r->fd >= 0)
+		close(r->fd);
+
+	free(r);
+}
+
+/**
+ * Creates an io_uring for writing the buffers of an asynchronous sink.
+ * If fixed is set, the buffers are registered with the ring so that the
+ * kernel does not have to map them on every write.
+ *
+ * Params:
+ *   char** - the two output buffers
+ *   size_t - the size of each buffer
+ *   int - whether to register the buffers
+ *   int - whether writes must use the current file position
+ *
+ * Returns:
+ *   struct my_aio_ring* - the ring, or NULL if io_uring is not available
+ */
+static struct my_aio_ring* ring_open(char** bufs, size_t size, int fixed, int cur_pos)
+{
+	struct io_uring_params p;
+	struct my_aio_ring* r;
+	struct iovec iov[2];
+	char* sq;
+	char* cq;
+
+	r = calloc(1, sizeof(struct my_aio_ring));
+	if (r == NULL)
+		return NULL;
+
+	memset(&p, 0, sizeof(p));
+
+	r->fd = (int)syscall(__NR_io_uring_setup, AIO_RING_N, &p);
+	if (r->fd < 0)
+		goto fail;
+
+	if (cur_pos && !(p.features & IORING_FEAT_RW_CUR_POS))
+		goto fail;
+
+	r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	r->sqe_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (r->cq_len > r->sq_len)
+			r->sq_len = r->cq_len;
+		r->cq_len = r->sq_len;
+	}
+
+	r->sq_map = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_map == MAP_FAILED)
+		goto fail;
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		r->cq_map = r->sq_map;
+	else
+	{
+		r->cq_map = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+		if (r->cq_map == MAP_FAILED)
+			goto fail;
+	}
+
+	r->sqes = mmap(NULL, r->sqe_len, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED)
+		goto fail;
+
+	sq = r->sq_map;
+	cq = r->cq_map;
+	r->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+	r->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+	r->sq_array = (unsigned*)(sq + p.sq_off.array);
+	r->cq_head = (unsigned*)(cq + p.cq_off.head);
+	r->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+	r->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+	if (fixed)
+	{
+		iov[0].iov_base = bufs[0];
+		iov[0].iov_len = size;
+		iov[1].iov_base = bufs[1];
+		iov[1].iov_len = size;
+
+		// Registering can fail, for example because of the locked
+		// memory limit. Plain writes still work in that case.
+		r->fixed = syscall(__NR_io_uring_register, r->fd,
+			IORING_REGISTER_BUFFERS, iov, 2) == 0;
+	}
+
+	return r;
+
+fail:
+	ring_close(r);
+
+	return NULL;
+}
+
+/**
+ * Submits a write of one of the buffers of an asynchronous sink.
+ *
+ * Params:
+ *   struct my_aio_ring* - a ring
+ *   int - the output file descriptor
+ *   const char* - the data to write
+ *   size_t - the number of bytes
+ *   long long - the file offset, or -1 for the current file position
+ *   int - the index of the buffer
+ *
+ * Returns:
+ *   int - 0 on success, or non-zero on failure
+ */
+static int ring_write(struct my_aio_ring* r,
+	int fd,
+	const char* buf,
+	size_t len,
+	long long off,
+	int idx)
+{
+	struct io_uring_sqe* sqe;
+	unsigned tail, i;
+
+	tail = *r->sq_tail;
+	i = tail & *r->sq_mask;
+	sqe = &r->sqes[i];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = r->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = (unsigned long long)(uintptr_t)buf;
+	sqe->len = (unsigned)len;
+	sqe->off = (unsigned long long)off;
+	sqe->buf_index = (unsigned short)idx;
+	sqe->user_data = (unsigned long long)idx;
+
+	r->sq_array[i] = i;
+	__atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	while (syscall(__NR_io_uring_enter, r->fd, 1, 0, 0, NULL, 0) < 0)
+	{
+		if (errno != EINTR && errno != EAGAIN)
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Waits for the next completed write.
+ *
+ * Params:
+ *   struct my_aio_ring* - a ring
+ *   int* - receives the index of the buffer that was written
+ *   int* - receives the number of bytes written, or a negative errno
+ *
+ * Returns:
+ *   int - 0 on success, or non-zero on failure
+ */
+static int ring_wait(struct my_aio_ring* r, int* idx, int* res)
+{
+	struct io_uring_cqe* cqe;
+	unsigned head;
+
+	head = *r->cq_head;
+
+	while (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE))
+	{
+		if (syscall(__NR_io_uring_enter, r->fd, 0, 1,
+			IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+			return 1;
+	}
+
+	cqe = &r->cqes[head & *r->cq_mask];
+	*idx = (int)cqe->user_data;
+	*res = cqe->res;
+
+	__atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+#endif
+
+#ifdef MY_PRINTF_POSIX
+
+/**
+ * Writes part of a buffer of an asynchronous sink without io_uring.
+ *
+ * Params:
+ *   my_aio* - an asynchronous sink
+ *   int - the index of the buffer
+ *   size_t - the number of bytes of the buffer that were already written
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int aio_write_sync(my_aio* aio, int i, size_t done)
+{
+	ssize_t w;
+
+	while (done < aio->lens[i])
+	{
+		if (aio->offs[i] >= 0)
+		{
+			w = pwrite(aio->fd, aio->bufs[i] + done, aio->lens[i] - done,
+				(off_t)(aio->offs[i] + (long long)done));
+		}
+		else
+			w = write(aio->fd, aio->bufs[i] + done, aio->lens[i] - done);
+
+		if (w < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return 1;
+		}
+
+		done += (size_t)w;
+	}
+
+	return 0;
+}
+
+/**
+ * Waits until a buffer of an asynchronous sink has no write in flight.
+ * Writes that completed short, or failed in the ring, are finished with
+ * plain writes.
+ *
+ * Params:
+ *   my_aio* - an asynchronous sink
+ *   int - the index of the buffer
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int aio_wait(my_aio* aio, int i)
+{
+#ifdef MY_PRINTF_URING
+	int idx, res;
+
+	while (aio->busy[i])
+	{
+		if (ring_wait(aio->ring, &idx, &res))
+			return 1;
+
+		aio->busy[idx] = 0;
+
+		if (res < 0 || (size_t)res < aio->lens[idx])
+		{
+			// The ring cannot do this write, so finish it and all
+			// later writes with plain writes.
+			if (res < 0)
+			{
+				res = 0;
+				aio->sync = 1;
+			}
+
+			if (aio_write_sync(aio, idx, (size_t)res))
+				return 1;
+		}
+	}
+#else
+	(void)aio;
+	(void)i;
+#endif
+
+	return 0;
+}
+
+/**
+ * Submits the buffer that is being filled, and switches the sink to the
+ * other buffer once that buffer is no longer in flight.
+ *
+ * Params:
+ *   my_sink* - the sink member of a my_aio
+ *
+ * Returns:
+ *   int - 0 on success, or 1 on failure
+ */
+static int aio_flush(my_sink* sink)
+{
+	my_aio* aio = (my_aio*)sink;
+	int i = aio->cur;
+
+	if (sink->pos == 0)
+		return 0;
+
+	aio->lens[i] = sink->pos;
+	aio->offs[i] = aio->off;
+	if (aio->off >= 0)
+		aio->off += (long long)sink->pos;
+
+	// Without explicit offsets, the writes have to complete in order.
+	if (aio->off < 0 && aio_wait(aio, i ^ 1))
+		return 1;
+
+#ifdef MY_PRINTF_URING
+	if (!aio->sync)
+	{
+		if (ring_write(aio->ring, aio->fd, aio->bufs[i], aio->lens[i],
+			aio->offs[i], i))
+			return 1;
+
+		aio->busy[i] = 1;
+	}
+	else
+#endif
+	if (aio_write_sync(aio, i, 0))
+		return 1;
+
+	// Keep formatting into the other buffer while this one is written.
+	aio->cur = i ^ 1;
+	if (aio_wait(aio, aio->cur))
+		return 1;
+
+	sink->buf = aio->bufs[aio->cur];
+	sink->pos = 0;
+
+	return 0;
+}
+
+#endif
+
+
+#if defined(MY_PRINTF_POSIX) && MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+
+/**
+ * The rendered date and time of one second, as written by the timestamp
+ * specifier. Each thread keeps one for UTC and one for local time, so only
+ * the fraction of the second has to be written while the second stays the
+ * same.
+ */
+typedef struct ts_cache {
+	time_t sec;       // second that the strings belong to
+	const char* std;  // tzname[0] when the strings were rendered
+	const char* dst;  // tzname[1] when the strings were rendered
+	long off;         // timezone when the strings were rendered
+	int valid;        // the strings have been rendered
+	size_t len;       // length of the date and time
+	size_t zone_len;  // length of the time zone
+	char date[24];    // date and time, up to the seconds
+	char zone[8];     // "Z" or the UTC offset
+}ts_cache;
+
+static _Thread_local ts_cache ts_caches[2];
+
+/**
+ * Gets the offset of standard time from UTC that tzset set, in seconds
+ * west. The timezone variable is an XSI extension, so elsewhere the names
+ * of the zone are all that tell a new zone apart.
+ */
+#ifdef __linux__
+#define ts_timezone() ((long)timezone)
+#else
+#define ts_timezone() 0L
+#endif
+
+/**
+ * Writes a number as a fixed number of decimal digits.
+ *
+ * Params:
+ *   char* - the output buffer
+ *   unsigned long - the number
+ *   size_t - the number of digits
+ */
+static void ts_digits(char* out, unsigned long n, size_t digits)
+{
+	while (digits > 0)
+	{
+		out[--digits] = (char)('0' + n % 10);
+		n /= 10;
+	}
+}
+
+/**
+ * Renders the date, time and time zone of a second into a cache.
+ *
+ * Params:
+ *   ts_cache* - a cache
+ *   time_t - the second
+ *   int - non-zero for local time, or 0 for UTC
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if the time cannot be converted
+ */
+static int ts_render(ts_cache* c, time_t sec, int local)
+{
+	struct tm tm;
+	long year, off;
+	size_t n;
+
+	if ((local ? localtime_r(&sec, &tm) : gmtime_r(&sec, &tm)) == NULL)
+		return 1;
+
+	year = tm.tm_year + 1900L;
+	if (year < 0 || year > 9999)
+		return 1;
+
+	// YYYY-MM-DDTHH:MM:SS
+	ts_digits(c->date, (unsigned long)year, 4);
+	c->date[4] = '-';
+	ts_digits(c->date + 5, (unsigned long)tm.tm_mon + 1, 2);
+	c->date[7] = '-';
+	ts_digits(c->date + 8, (unsigned long)tm.tm_mday, 2);
+	c->date[10] = 'T';
+	ts_digits(c->date + 11, (unsigned long)tm.tm_hour, 2);
+	c->date[13] = ':';
+	ts_digits(c->date + 14, (unsigned long)tm.tm_min, 2);
+	c->date[16] = ':';
+	ts_digits(c->date + 17, (unsigned long)tm.tm_sec, 2);
+	c->len = 19;
+
+	if (local)
+	{
+		// +HH:MM
+		off = tm.tm_gmtoff / 60;
+		n = 0;
+		c->zone[n++] = off < 0 ? '-' : '+';
+		if (off < 0)
+			off = -off;
+		ts_digits(c->zone + n, (unsigned long)(off / 60), 2);
+		c->zone[n + 2] = ':';
+		ts_digits(c->zone + n + 3, (unsigned long)(off % 60), 2);
+		c->zone_len = n + 5;
+	}
+	else
+	{
+		c->zone[0] = 'Z';
+		c->zone_len = 1;
+	}
+
+	c->sec = sec;
+	c->std = tzname[0];
+	c->dst = tzname[1];
+	c->off = ts_timezone();
+	c->valid = 1;
+
+	return 0;
+}
+
+/**
+ * Formats an ISO 8601 timestamp for the T specifier.
+ * The precision is the number of digits of the fraction of the second,
+ * from 0 to 9, and the '+' flag selects local time with its UTC offset.
+ * The date and time up to the seconds come from a cache of this thread.
+ *
+ * Params:
+ *   char* - an output buffer of at least 40 characters
+ *   const ftag* - the format tag
+ *   const struct timespec* - the time, or NULL for the current time
+ *
+ * Returns:
+ *   size_t - the number of characters, or 0 on failure
+ */
+static size_t ts_format(char* out, const ftag* t, const struct timespec* time)
+{
+	static const unsigned long scale[10] = {
+		1000000000, 100000000, 10000000, 1000000, 100000,
+		10000, 1000, 100, 10, 1
+	};
+	struct timespec now;
+	ts_cache* c;
+	size_t prec, n;
+	int local;
+
+	if (time == NULL)
+	{
+		if (clock_gettime(CLOCK_REALTIME, &now))
+			return 0;
+		time = &now;
+	}
+
+	local = (t->flags & FMT_SIGN) != 0;
+	c = &ts_caches[local];
+
+	// Local time also depends on the time zone, which tzset changes when
+	// TZ changes, so the names and offset that it sets are compared too.
+	if ((!c->valid || c->sec != time->tv_sec || (local && (c->std != tzname[0]
+		|| c->dst != tzname[1] || c->off != ts_timezone())))
+		&& ts_render(c, time->tv_sec, local))
+		return 0;
+
+	memcpy(out, c->date, c->len);
+	n = c->len;
+
+	prec = t->prec > 9 ? 9 : t->prec;
+	if (prec > 0)
+	{
+		out[n++] = '.';
+		ts_digits(out + n, (unsigned long)time->tv_nsec / scale[prec], prec);
+		n += prec;
+	}
+
+	memcpy(out + n, c->zone, c->zone_len);
+
+	return n + c->zone_len;
+}
+
+#endif
+
+
+/**
+ * Determines if a character is white space, as isspace does in the
+ * C locale.
+ *
+ * Params:
+ *   c - a character
+ */
+#define is_space(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+/**
+ * Powers of ten that fit in 32 bits, for combining groups of digits.
+ */
+static const uint64_t scan_pow10[9] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+/**
+ * Converts eight ASCII digits to their value with SWAR arithmetic.
+ * The first digit is in the lowest byte. Pairs, then quads, then both
+ * halves are combined with three multiplications instead of eight.
+ *
+ * Params:
+ *   uint64_t - eight digits, with '0' already subtracted from each byte
+ *
+ * Returns:
+ *   uint64_t - the value of the digits
+ */
+static uint64_t swar_digits(uint64_t v)
+{
+	v = (v * 10) + (v >> 8);
+	v = ((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))
+		+ ((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+
+	return v;
+}
+
+/**
+ * Reads up to eight decimal digits.
+ * On little endian machines, the eight bytes are loaded at once, the run
+ * of leading digits is found with SWAR tests, and the digits are
+ * converted with swar_digits. Other machines, and loads that could cross
+ * into the next page, read one digit at a time.
+ *
+ * Params:
+ *   const char* - the first character
+ *   size_t - the maximum number of characters to read
+ *   uint64_t* - receives the value of the digits
+ *
+ * Returns:
+ *   size_t - the number of digits read
+ */
+NO_ASAN static size_t scan_digits8(const char* s, size_t max, uint64_t* part)
+{
+	uint64_t v;
+	size_t k;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t bad;
+
+	// A load that stays within the page of the terminator cannot fault.
+	if (((uintptr_t)s & 4095) <= 4096 - 8)
+	{
+		memcpy(&v, s, 8);
+
+		// A byte is a digit if its high nibble is 3, and adding 6 does
+		// not carry out of its low nibble. Carries only spread past
+		// bytes that are not digits already.
+		bad = ((v & 0xF0F0F0F0F0F0F0F0ULL) ^ 0x3030303030303030ULL)
+			| (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL)
+			^ 0x3030303030303030ULL);
+
+		k = bad ? (size_t)__builtin_ctzll(bad) / 8 : 8;
+		if (k > max)
+			k = max;
+
+		// Shift the digits up, so that the bytes below them are
+		// leading zeros.
+		*part = k > 0 ? swar_digits((v - 0x3030303030303030ULL) << (8 * (8 - k))) : 0;
+
+		return k;
+	}
+#endif
+
+	for (k = 0, v = 0; k < 8 && k < max && s[k] >= '0' && s[k] <= '9'; k++)
+		v = v * 10 + (uint64_t)(s[k] - '0');
+
+	*part = v;
+
+	return k;
+}
+
+/**
+ * Reads an unsigned decimal number, eight digits at a time.
+ * A value that does not fit in 64 bits is saturated.
+ *
+ * Params:
+ *   const char* - the first character of the number
+ *   size_t - the maximum number of characters to read
+ *   uint64_t* - receives the value
+ *
+ * Returns:
+ *   size_t - the number of digits read
+ */
+static size_t scan_udec(const char* s, size_t max, uint64_t* res)
+{
+	uint64_t n = 0;  // value
+	uint64_t part;   // value of a group of digits
+	size_t count = 0;
+	size_t k;
+	int sat = 0;
+
+	do
+	{
+		k = scan_digits8(s + count, max - count, &part);
+
+		if (n > (UINT64_MAX - part) / scan_pow10[k])
+			sat = 1;
+		n = n * scan_pow10[k] + part;
+		count += k;
+	} while (k == 8);
+
+	*res = sat ? UINT64_MAX : n;
+
+	return count;
+}
+
+/**
+ * Reads an unsigned number in base 8 or 16.
+ *
+ * Params:
+ *   const char* - the first character of the number
+ *   size_t - the maximum number of characters to read
+ *   int - the base
+ *   uint64_t* - receives the value
+ *
+ * Returns:
+ *   size_t - the number of digits read
+ */
+static size_t scan_ubase(const char* s, size_t max, int base, uint64_t* res)
+{
+	uint64_t n = 0;
+	size_t count;
+	int d;
+
+	for (count = 0; count < max; count++, s++)
+	{
+		d = *s >= '0' && *s <= '9' ? *s - '0'
+			: *s >= 'a' && *s <= 'f' ? *s - 'a' + 10
+			: *s >= 'A' && *s <= 'F' ? *s - 'A' + 10
+			: 16;
+
+		if (d >= base)
+			break;
+
+		n = n > (UINT64_MAX - (uint64_t)d) / (uint64_t)base
+			? UINT64_MAX
+			: n * (uint64_t)base + (uint64_t)d;
+	}
+
+	*res = n;
+
+	return count;
+}
+
+/**
+ * Reads an integer for the d, i, u, o, x and X specifiers, with an
+ * optional sign and, where the base allows it, a prefix.
+ *
+ * Params:
+ *   const char* - the first character of the integer
+ *   size_t - the maximum number of characters to read
+ *   char - the specifier
+ *   uint64_t* - receives the value, negated if it had a '-' sign
+ *
+ * Returns:
+ *   size_t - the number of characters read, or 0 if there was no integer
+ */
+static size_t scan_int(const char* s, size_t max, char spec, uint64_t* res)
+{
+	const char* start = s;
+	size_t n, digits;
+	int neg = 0;
+	int base;
+
+	if (max > 0 && (*s == '-' || *s == '+'))
+	{
+		neg = *s == '-';
+		s++;
+		max--;
+	}
+
+	base = spec == SPEC_o ? 8 : spec == SPEC_x || spec == SPEC_X ? 16 : 10;
+
+	if ((base == 16 || spec == SPEC_i) && max >= 2 && s[0] == '0'
+		&& (s[1] == 'x' || s[1] == 'X'))
+	{
+		// A prefix on its own is read as 0, as glibc does.
+		if (scan_ubase(s + 2, max - 2, 16, res) == 0)
+		{
+			*res = 0;
+			return (size_t)(s + 2 - start);
+		}
+
+		base = 16;
+		s += 2;
+		max -= 2;
+	}
+	else if (spec == SPEC_i && max >= 1 && s[0] == '0')
+		base = 8;
+
+	digits = base == 10
+		? scan_udec(s, max, res)
+		: scan_ubase(s, max, base, res);
+
+	if (digits == 0)
+		return 0;
+
+	// Values out of range are clamped the way strtoll and strtoull
+	// clamp them.
+	if (spec == SPEC_d || spec == SPEC_i)
+	{
+		if (*res > (uint64_t)INT64_MAX + neg)
+			*res = neg ? (uint64_t)INT64_MIN : (uint64_t)INT64_MAX;
+		else if (neg)
+			*res = 0 - *res;
+	}
+	else if (neg && *res != UINT64_MAX)
+		*res = 0 - *res;
+
+	n = (size_t)(s - start) + digits;
+
+	return n;
+}
+
+/**
+ * Stores a converted integer in the argument that its length modifier
+ * calls for.
+ *
+ * Params:
+ *   void* - the argument
+ *   unsigned char - the length bit flags of the tag
+ *   int - 1 if the length letter was doubled, as in hh and ll
+ *   uint64_t - the value
+ */
+static void scan_store(void* p, unsigned char len, int twice, uint64_t n)
+{
+	if (len & LEN_h)
+	{
+		if (twice)
+			*(signed char*)p = (signed char)n;
+		else
+			*(short*)p = (short)n;
+	}
+	else if (len & LEN_l)
+	{
+		if (twice)
+			*(long long*)p = (long long)n;
+		else
+			*(long*)p = (long)n;
+	}
+	else
+		*(int*)p = (int)n;
+}
+
+/**
+ * The 128-bit mantissas of the powers of ten from 1e-342 to 1e308,
+ * normalized so that the top bit is set and rounded down. The low half
+ * comes first.
+ * These are the same as the mantissas of the powers of five, so they are
+ * used to multiply a decimal mantissa by a power of ten in one 64x128-bit
+ * product.
+ */
+static const uint64_t pow5_128[651][2] = {
+	{ 0x113FAA2906A13B3FULL, 0xEEF453D6923BD65AULL }, // 1e-342
+	{ 0x4AC7CA59A424C507ULL, 0x9558B4661B6565F8ULL }, // 1e-341
+	{ 0x5D79BCF00D2DF649ULL, 0xBAAEE17FA23EBF76ULL }, // 1e-340
+	{ 0xF4D82C2C107973DCULL, 0xE95A99DF8ACE6F53ULL }, // 1e-339
+	{ 0x79071B9B8A4BE869ULL, 0x91D8A02BB6C10594ULL }, // 1e-338
+	{ 0x9748E2826CDEE284ULL, 0xB64EC836A47146F9ULL }, // 1e-337
+	{ 0xFD1B1B2308169B25ULL, 0xE3E27A444D8D98B7ULL }, // 1e-336
+	{ 0xFE30F0F5E50E20F7ULL, 0x8E6D8C6AB0787F72ULL }, // 1e-335
+	{ 0xBDBD2D335E51A935ULL, 0xB208EF855C969F4FULL }, // 1e-334
+	{ 0xAD2C788035E61382ULL, 0xDE8B2B66B3BC4723ULL }, // 1e-333
+	{ 0x4C3BCB5021AFCC31ULL, 0x8B16FB203055AC76ULL }, // 1e-332
+	{ 0xDF4ABE242A1BBF3DULL, 0xADDCB9E83C6B1793ULL }, // 1e-331
+	{ 0xD71D6DAD34A2AF0DULL, 0xD953E8624B85DD78ULL }, // 1e-330
+	{ 0x8672648C40E5AD68ULL, 0x87D4713D6F33AA6BULL }, // 1e-329
+	{ 0x680EFDAF511F18C2ULL, 0xA9C98D8CCB009506ULL }, // 1e-328
+	{ 0x0212BD1B2566DEF2ULL, 0xD43BF0EFFDC0BA48ULL }, // 1e-327
+	{ 0x014BB630F7604B57ULL, 0x84A57695FE98746DULL }, // 1e-326
+	{ 0x419EA3BD35385E2DULL, 0xA5CED43B7E3E9188ULL }, // 1e-325
+	{ 0x52064CAC828675B9ULL, 0xCF42894A5DCE35EAULL }, // 1e-324
+	{ 0x7343EFEBD1940993ULL, 0x818995CE7AA0E1B2ULL }, // 1e-323
+	{ 0x1014EBE6C5F90BF8ULL, 0xA1EBFB4219491A1FULL }, // 1e-322
+	{ 0xD41A26E077774EF6ULL, 0xCA66FA129F9B60A6ULL }, // 1e-321
+	{ 0x8920B098955522B4ULL, 0xFD00B897478238D0ULL }, // 1e-320
+	{ 0x55B46E5F5D5535B0ULL, 0x9E20735E8CB16382ULL }, // 1e-319
+	{ 0xEB2189F734AA831DULL, 0xC5A890362FDDBC62ULL }, // 1e-318
+	{ 0xA5E9EC7501D523E4ULL, 0xF712B443BBD52B7BULL }, // 1e-317
+	{ 0x47B233C92125366EULL, 0x9A6BB0AA55653B2DULL }, // 1e-316
+	{ 0x999EC0BB696E840AULL, 0xC1069CD4EABE89F8ULL }, // 1e-315
+	{ 0xC00670EA43CA250DULL, 0xF148440A256E2C76ULL }, // 1e-314
+	{ 0x380406926A5E5728ULL, 0x96CD2A865764DBCAULL }, // 1e-313
+	{ 0xC605083704F5ECF2ULL, 0xBC807527ED3E12BCULL }, // 1e-312
+	{ 0xF7864A44C633682EULL, 0xEBA09271E88D976BULL }, // 1e-311
+	{ 0x7AB3EE6AFBE0211DULL, 0x93445B8731587EA3ULL }, // 1e-310
+	{ 0x5960EA05BAD82964ULL, 0xB8157268FDAE9E4CULL }, // 1e-309
+	{ 0x6FB92487298E33BDULL, 0xE61ACF033D1A45DFULL }, // 1e-308
+	{ 0xA5D3B6D479F8E056ULL, 0x8FD0C16206306BABULL }, // 1e-307
+	{ 0x8F48A4899877186CULL, 0xB3C4F1BA87BC8696ULL }, // 1e-306
+	{ 0x331ACDABFE94DE87ULL, 0xE0B62E2929ABA83CULL }, // 1e-305
+	{ 0x9FF0C08B7F1D0B14ULL, 0x8C71DCD9BA0B4925ULL }, // 1e-304
+	{ 0x07ECF0AE5EE44DD9ULL, 0xAF8E5410288E1B6FULL }, // 1e-303
+	{ 0xC9E82CD9F69D6150ULL, 0xDB71E91432B1A24AULL }, // 1e-302
+	{ 0xBE311C083A225CD2ULL, 0x892731AC9FAF056EULL }, // 1e-301
+	{ 0x6DBD630A48AAF406ULL, 0xAB70FE17C79AC6CAULL }, // 1e-300
+	{ 0x092CBBCCDAD5B108ULL, 0xD64D3D9DB981787DULL }, // 1e-299
+	{ 0x25BBF56008C58EA5ULL, 0x85F0468293F0EB4EULL }, // 1e-298
+	{ 0xAF2AF2B80AF6F24EULL, 0xA76C582338ED2621ULL }, // 1e-297
+	{ 0x1AF5AF660DB4AEE1ULL, 0xD1476E2C07286FAAULL }, // 1e-296
+	{ 0x50D98D9FC890ED4DULL, 0x82CCA4DB847945CAULL }, // 1e-295
+	{ 0xE50FF107BAB528A0ULL, 0xA37FCE126597973CULL }, // 1e-294
+	{ 0x1E53ED49A96272C8ULL, 0xCC5FC196FEFD7D0CULL }, // 1e-293
+	{ 0x25E8E89C13BB0F7AULL, 0xFF77B1FCBEBCDC4FULL }, // 1e-292
+	{ 0x77B191618C54E9ACULL, 0x9FAACF3DF73609B1ULL }, // 1e-291
+	{ 0xD59DF5B9EF6A2417ULL, 0xC795830D75038C1DULL }, // 1e-290
+	{ 0x4B0573286B44AD1DULL, 0xF97AE3D0D2446F25ULL }, // 1e-289
+	{ 0x4EE367F9430AEC32ULL, 0x9BECCE62836AC577ULL }, // 1e-288
+	{ 0x229C41F793CDA73FULL, 0xC2E801FB244576D5ULL }, // 1e-287
+	{ 0x6B43527578C1110FULL, 0xF3A20279ED56D48AULL }, // 1e-286
+	{ 0x830A13896B78AAA9ULL, 0x9845418C345644D6ULL }, // 1e-285
+	{ 0x23CC986BC656D553ULL, 0xBE5691EF416BD60CULL }, // 1e-284
+	{ 0x2CBFBE86B7EC8AA8ULL, 0xEDEC366B11C6CB8FULL }, // 1e-283
+	{ 0x7BF7D71432F3D6A9ULL, 0x94B3A202EB1C3F39ULL }, // 1e-282
+	{ 0xDAF5CCD93FB0CC53ULL, 0xB9E08A83A5E34F07ULL }, // 1e-281
+	{ 0xD1B3400F8F9CFF68ULL, 0xE858AD248F5C22C9ULL }, // 1e-280
+	{ 0x23100809B9C21FA1ULL, 0x91376C36D99995BEULL }, // 1e-279
+	{ 0xABD40A0C2832A78AULL, 0xB58547448FFFFB2DULL }, // 1e-278
+	{ 0x16C90C8F323F516CULL, 0xE2E69915B3FFF9F9ULL }, // 1e-277
+	{ 0xAE3DA7D97F6792E3ULL, 0x8DD01FAD907FFC3BULL }, // 1e-276
+	{ 0x99CD11CFDF41779CULL, 0xB1442798F49FFB4AULL }, // 1e-275
+	{ 0x40405643D711D583ULL, 0xDD95317F31C7FA1DULL }, // 1e-274
+	{ 0x482835EA666B2572ULL, 0x8A7D3EEF7F1CFC52ULL }, // 1e-273
+	{ 0xDA3243650005EECFULL, 0xAD1C8EAB5EE43B66ULL }, // 1e-272
+	{ 0x90BED43E40076A82ULL, 0xD863B256369D4A40ULL }, // 1e-271
+	{ 0x5A7744A6E804A291ULL, 0x873E4F75E2224E68ULL }, // 1e-270
+	{ 0x711515D0A205CB36ULL, 0xA90DE3535AAAE202ULL }, // 1e-269
+	{ 0x0D5A5B44CA873E03ULL, 0xD3515C2831559A83ULL }, // 1e-268
+	{ 0xE858790AFE9486C2ULL, 0x8412D9991ED58091ULL }, // 1e-267
+	{ 0x626E974DBE39A872ULL, 0xA5178FFF668AE0B6ULL }, // 1e-266
+	{ 0xFB0A3D212DC8128FULL, 0xCE5D73FF402D98E3ULL }, // 1e-265
+	{ 0x7CE66634BC9D0B99ULL, 0x80FA687F881C7F8EULL }, // 1e-264
+	{ 0x1C1FFFC1EBC44E80ULL, 0xA139029F6A239F72ULL }, // 1e-263
+	{ 0xA327FFB266B56220ULL, 0xC987434744AC874EULL }, // 1e-262
+	{ 0x4BF1FF9F0062BAA8ULL, 0xFBE9141915D7A922ULL }, // 1e-261
+	{ 0x6F773FC3603DB4A9ULL, 0x9D71AC8FADA6C9B5ULL }, // 1e-260
+	{ 0xCB550FB4384D21D3ULL, 0xC4CE17B399107C22ULL }, // 1e-259
+	{ 0x7E2A53A146606A48ULL, 0xF6019DA07F549B2BULL }, // 1e-258
+	{ 0x2EDA7444CBFC426DULL, 0x99C102844F94E0FBULL }, // 1e-257
+	{ 0xFA911155FEFB5308ULL, 0xC0314325637A1939ULL }, // 1e-256
+	{ 0x793555AB7EBA27CAULL, 0xF03D93EEBC589F88ULL }, // 1e-255
+	{ 0x4BC1558B2F3458DEULL, 0x96267C7535B763B5ULL }, // 1e-254
+	{ 0x9EB1AAEDFB016F16ULL, 0xBBB01B9283253CA2ULL }, // 1e-253
+	{ 0x465E15A979C1CADCULL, 0xEA9C227723EE8BCBULL }, // 1e-252
+	{ 0x0BFACD89EC191EC9ULL, 0x92A1958A7675175FULL }, // 1e-251
+	{ 0xCEF980EC671F667BULL, 0xB749FAED14125D36ULL }, // 1e-250
+	{ 0x82B7E12780E7401AULL, 0xE51C79A85916F484ULL }, // 1e-249
+	{ 0xD1B2ECB8B0908810ULL, 0x8F31CC0937AE58D2ULL }, // 1e-248
+	{ 0x861FA7E6DCB4AA15ULL, 0xB2FE3F0B8599EF07ULL }, // 1e-247
+	{ 0x67A791E093E1D49AULL, 0xDFBDCECE67006AC9ULL }, // 1e-246
+	{ 0xE0C8BB2C5C6D24E0ULL, 0x8BD6A141006042BDULL }, // 1e-245
+	{ 0x58FAE9F773886E18ULL, 0xAECC49914078536DULL }, // 1e-244
+	{ 0xAF39A475506A899EULL, 0xDA7F5BF590966848ULL }, // 1e-243
+	{ 0x6D8406C952429603ULL, 0x888F99797A5E012DULL }, // 1e-242
+	{ 0xC8E5087BA6D33B83ULL, 0xAAB37FD7D8F58178ULL }, // 1e-241
+	{ 0xFB1E4A9A90880A64ULL, 0xD5605FCDCF32E1D6ULL }, // 1e-240
+	{ 0x5CF2EEA09A55067FULL, 0x855C3BE0A17FCD26ULL }, // 1e-239
+	{ 0xF42FAA48C0EA481EULL, 0xA6B34AD8C9DFC06FULL }, // 1e-238
+	{ 0xF13B94DAF124DA26ULL, 0xD0601D8EFC57B08BULL }, // 1e-237
+	{ 0x76C53D08D6B70858ULL, 0x823C12795DB6CE57ULL }, // 1e-236
+	{ 0x54768C4B0C64CA6EULL, 0xA2CB1717B52481EDULL }, // 1e-235
+	{ 0xA9942F5DCF7DFD09ULL, 0xCB7DDCDDA26DA268ULL }, // 1e-234
+	{ 0xD3F93B35435D7C4CULL, 0xFE5D54150B090B02ULL }, // 1e-233
+	{ 0xC47BC5014A1A6DAFULL, 0x9EFA548D26E5A6E1ULL }, // 1e-232
+	{ 0x359AB6419CA1091BULL, 0xC6B8E9B0709F109AULL }, // 1e-231
+	{ 0xC30163D203C94B62ULL, 0xF867241C8CC6D4C0ULL }, // 1e-230
+	{ 0x79E0DE63425DCF1DULL, 0x9B407691D7FC44F8ULL }, // 1e-229
+	{ 0x985915FC12F542E4ULL, 0xC21094364DFB5636ULL }, // 1e-228
+	{ 0x3E6F5B7B17B2939DULL, 0xF294B943E17A2BC4ULL }, // 1e-227
+	{ 0xA705992CEECF9C42ULL, 0x979CF3CA6CEC5B5AULL }, // 1e-226
+	{ 0x50C6FF782A838353ULL, 0xBD8430BD08277231ULL }, // 1e-225
+	{ 0xA4F8BF5635246428ULL, 0xECE53CEC4A314EBDULL }, // 1e-224
+	{ 0x871B7795E136BE99ULL, 0x940F4613AE5ED136ULL }, // 1e-223
+	{ 0x28E2557B59846E3FULL, 0xB913179899F68584ULL }, // 1e-222
+	{ 0x331AEADA2FE589CFULL, 0xE757DD7EC07426E5ULL }, // 1e-221
+	{ 0x3FF0D2C85DEF7621ULL, 0x9096EA6F3848984FULL }, // 1e-220
+	{ 0x0FED077A756B53A9ULL, 0xB4BCA50B065ABE63ULL }, // 1e-219
+	{ 0xD3E8495912C62894ULL, 0xE1EBCE4DC7F16DFBULL }, // 1e-218
+	{ 0x64712DD7ABBBD95CULL, 0x8D3360F09CF6E4BDULL }, // 1e-217
+	{ 0xBD8D794D96AACFB3ULL, 0xB080392CC4349DECULL }, // 1e-216
+	{ 0xECF0D7A0FC5583A0ULL, 0xDCA04777F541C567ULL }, // 1e-215
+	{ 0xF41686C49DB57244ULL, 0x89E42CAAF9491B60ULL }, // 1e-214
+	{ 0x311C2875C522CED5ULL, 0xAC5D37D5B79B6239ULL }, // 1e-213
+	{ 0x7D633293366B828BULL, 0xD77485CB25823AC7ULL }, // 1e-212
+	{ 0xAE5DFF9C02033197ULL, 0x86A8D39EF77164BCULL }, // 1e-211
+	{ 0xD9F57F830283FDFCULL, 0xA8530886B54DBDEBULL }, // 1e-210
+	{ 0xD072DF63C324FD7BULL, 0xD267CAA862A12D66ULL }, // 1e-209
+	{ 0x4247CB9E59F71E6DULL, 0x8380DEA93DA4BC60ULL }, // 1e-208
+	{ 0x52D9BE85F074E608ULL, 0xA46116538D0DEB78ULL }, // 1e-207
+	{ 0x67902E276C921F8BULL, 0xCD795BE870516656ULL }, // 1e-206
+	{ 0x00BA1CD8A3DB53B6ULL, 0x806BD9714632DFF6ULL }, // 1e-205
+	{ 0x80E8A40ECCD228A4ULL, 0xA086CFCD97BF97F3ULL }, // 1e-204
+	{ 0x6122CD128006B2CDULL, 0xC8A883C0FDAF7DF0ULL }, // 1e-203
+	{ 0x796B805720085F81ULL, 0xFAD2A4B13D1B5D6CULL }, // 1e-202
+	{ 0xCBE3303674053BB0ULL, 0x9CC3A6EEC6311A63ULL }, // 1e-201
+	{ 0xBEDBFC4411068A9CULL, 0xC3F490AA77BD60FCULL }, // 1e-200
+	{ 0xEE92FB5515482D44ULL, 0xF4F1B4D515ACB93BULL }, // 1e-199
+	{ 0x751BDD152D4D1C4AULL, 0x991711052D8BF3C5ULL }, // 1e-198
+	{ 0xD262D45A78A0635DULL, 0xBF5CD54678EEF0B6ULL }, // 1e-197
+	{ 0x86FB897116C87C34ULL, 0xEF340A98172AACE4ULL }, // 1e-196
+	{ 0xD45D35E6AE3D4DA0ULL, 0x9580869F0E7AAC0EULL }, // 1e-195
+	{ 0x8974836059CCA109ULL, 0xBAE0A846D2195712ULL }, // 1e-194
+	{ 0x2BD1A438703FC94BULL, 0xE998D258869FACD7ULL }, // 1e-193
+	{ 0x7B6306A34627DDCFULL, 0x91FF83775423CC06ULL }, // 1e-192
+	{ 0x1A3BC84C17B1D542ULL, 0xB67F6455292CBF08ULL }, // 1e-191
+	{ 0x20CABA5F1D9E4A93ULL, 0xE41F3D6A7377EECAULL }, // 1e-190
+	{ 0x547EB47B7282EE9CULL, 0x8E938662882AF53EULL }, // 1e-189
+	{ 0xE99E619A4F23AA43ULL, 0xB23867FB2A35B28DULL }, // 1e-188
+	{ 0x6405FA00E2EC94D4ULL, 0xDEC681F9F4C31F31ULL }, // 1e-187
+	{ 0xDE83BC408DD3DD04ULL, 0x8B3C113C38F9F37EULL }, // 1e-186
+	{ 0x9624AB50B148D445ULL, 0xAE0B158B4738705EULL }, // 1e-185
+	{ 0x3BADD624DD9B0957ULL, 0xD98DDAEE19068C76ULL }, // 1e-184
+	{ 0xE54CA5D70A80E5D6ULL, 0x87F8A8D4CFA417C9ULL }, // 1e-183
+	{ 0x5E9FCF4CCD211F4CULL, 0xA9F6D30A038D1DBCULL }, // 1e-182
+	{ 0x7647C3200069671FULL, 0xD47487CC8470652BULL }, // 1e-181
+	{ 0x29ECD9F40041E073ULL, 0x84C8D4DFD2C63F3BULL }, // 1e-180
+	{ 0xF468107100525890ULL, 0xA5FB0A17C777CF09ULL }, // 1e-179
+	{ 0x7182148D4066EEB4ULL, 0xCF79CC9DB955C2CCULL }, // 1e-178
+	{ 0xC6F14CD848405530ULL, 0x81AC1FE293D599BFULL }, // 1e-177
+	{ 0xB8ADA00E5A506A7CULL, 0xA21727DB38CB002FULL }, // 1e-176
+	{ 0xA6D90811F0E4851CULL, 0xCA9CF1D206FDC03BULL }, // 1e-175
+	{ 0x908F4A166D1DA663ULL, 0xFD442E4688BD304AULL }, // 1e-174
+	{ 0x9A598E4E043287FEULL, 0x9E4A9CEC15763E2EULL }, // 1e-173
+	{ 0x40EFF1E1853F29FDULL, 0xC5DD44271AD3CDBAULL }, // 1e-172
+	{ 0xD12BEE59E68EF47CULL, 0xF7549530E188C128ULL }, // 1e-171
+	{ 0x82BB74F8301958CEULL, 0x9A94DD3E8CF578B9ULL }, // 1e-170
+	{ 0xE36A52363C1FAF01ULL, 0xC13A148E3032D6E7ULL }, // 1e-169
+	{ 0xDC44E6C3CB279AC1ULL, 0xF18899B1BC3F8CA1ULL }, // 1e-168
+	{ 0x29AB103A5EF8C0B9ULL, 0x96F5600F15A7B7E5ULL }, // 1e-167
+	{ 0x7415D448F6B6F0E7ULL, 0xBCB2B812DB11A5DEULL }, // 1e-166
+	{ 0x111B495B3464AD21ULL, 0xEBDF661791D60F56ULL }, // 1e-165
+	{ 0xCAB10DD900BEEC34ULL, 0x936B9FCEBB25C995ULL }, // 1e-164
+	{ 0x3D5D514F40EEA742ULL, 0xB84687C269EF3BFBULL }, // 1e-163
+	{ 0x0CB4A5A3112A5112ULL, 0xE65829B3046B0AFAULL }, // 1e-162
+	{ 0x47F0E785EABA72ABULL, 0x8FF71A0FE2C2E6DCULL }, // 1e-161
+	{ 0x59ED216765690F56ULL, 0xB3F4E093DB73A093ULL }, // 1e-160
+	{ 0x306869C13EC3532CULL, 0xE0F218B8D25088B8ULL }, // 1e-159
+	{ 0x1E414218C73A13FBULL, 0x8C974F7383725573ULL }, // 1e-158
+	{ 0xE5D1929EF90898FAULL, 0xAFBD2350644EEACFULL }, // 1e-157
+	{ 0xDF45F746B74ABF39ULL, 0xDBAC6C247D62A583ULL }, // 1e-156
+	{ 0x6B8BBA8C328EB783ULL, 0x894BC396CE5DA772ULL }, // 1e-155
+	{ 0x066EA92F3F326564ULL, 0xAB9EB47C81F5114FULL }, // 1e-154
+	{ 0xC80A537B0EFEFEBDULL, 0xD686619BA27255A2ULL }, // 1e-153
+	{ 0xBD06742CE95F5F36ULL, 0x8613FD0145877585ULL }, // 1e-152
+	{ 0x2C48113823B73704ULL, 0xA798FC4196E952E7ULL }, // 1e-151
+	{ 0xF75A15862CA504C5ULL, 0xD17F3B51FCA3A7A0ULL }, // 1e-150
+	{ 0x9A984D73DBE722FBULL, 0x82EF85133DE648C4ULL }, // 1e-149
+	{ 0xC13E60D0D2E0EBBAULL, 0xA3AB66580D5FDAF5ULL }, // 1e-148
+	{ 0x318DF905079926A8ULL, 0xCC963FEE10B7D1B3ULL }, // 1e-147
+	{ 0xFDF17746497F7052ULL, 0xFFBBCFE994E5C61FULL }, // 1e-146
+	{ 0xFEB6EA8BEDEFA633ULL, 0x9FD561F1FD0F9BD3ULL }, // 1e-145
+	{ 0xFE64A52EE96B8FC0ULL, 0xC7CABA6E7C5382C8ULL }, // 1e-144
+	{ 0x3DFDCE7AA3C673B0ULL, 0xF9BD690A1B68637BULL }, // 1e-143
+	{ 0x06BEA10CA65C084EULL, 0x9C1661A651213E2DULL }, // 1e-142
+	{ 0x486E494FCFF30A62ULL, 0xC31BFA0FE5698DB8ULL }, // 1e-141
+	{ 0x5A89DBA3C3EFCCFAULL, 0xF3E2F893DEC3F126ULL }, // 1e-140
+	{ 0xF89629465A75E01CULL, 0x986DDB5C6B3A76B7ULL }, // 1e-139
+	{ 0xF6BBB397F1135823ULL, 0xBE89523386091465ULL }, // 1e-138
+	{ 0x746AA07DED582E2CULL, 0xEE2BA6C0678B597FULL }, // 1e-137
+	{ 0xA8C2A44EB4571CDCULL, 0x94DB483840B717EFULL }, // 1e-136
+	{ 0x92F34D62616CE413ULL, 0xBA121A4650E4DDEBULL }, // 1e-135
+	{ 0x77B020BAF9C81D17ULL, 0xE896A0D7E51E1566ULL }, // 1e-134
+	{ 0x0ACE1474DC1D122EULL, 0x915E2486EF32CD60ULL }, // 1e-133
+	{ 0x0D819992132456BAULL, 0xB5B5ADA8AAFF80B8ULL }, // 1e-132
+	{ 0x10E1FFF697ED6C69ULL, 0xE3231912D5BF60E6ULL }, // 1e-131
+	{ 0xCA8D3FFA1EF463C1ULL, 0x8DF5EFABC5979C8FULL }, // 1e-130
+	{ 0xBD308FF8A6B17CB2ULL, 0xB1736B96B6FD83B3ULL }, // 1e-129
+	{ 0xAC7CB3F6D05DDBDEULL, 0xDDD0467C64BCE4A0ULL }, // 1e-128
+	{ 0x6BCDF07A423AA96BULL, 0x8AA22C0DBEF60EE4ULL }, // 1e-127
+	{ 0x86C16C98D2C953C6ULL, 0xAD4AB7112EB3929DULL }, // 1e-126
+	{ 0xE871C7BF077BA8B7ULL, 0xD89D64D57A607744ULL }, // 1e-125
+	{ 0x11471CD764AD4972ULL, 0x87625F056C7C4A8BULL }, // 1e-124
+	{ 0xD598E40D3DD89BCFULL, 0xA93AF6C6C79B5D2DULL }, // 1e-123
+	{ 0x4AFF1D108D4EC2C3ULL, 0xD389B47879823479ULL }, // 1e-122
+	{ 0xCEDF722A585139BAULL, 0x843610CB4BF160CBULL }, // 1e-121
+	{ 0xC2974EB4EE658828ULL, 0xA54394FE1EEDB8FEULL }, // 1e-120
+	{ 0x733D226229FEEA32ULL, 0xCE947A3DA6A9273EULL }, // 1e-119
+	{ 0x0806357D5A3F525FULL, 0x811CCC668829B887ULL }, // 1e-118
+	{ 0xCA07C2DCB0CF26F7ULL, 0xA163FF802A3426A8ULL }, // 1e-117
+	{ 0xFC89B393DD02F0B5ULL, 0xC9BCFF6034C13052ULL }, // 1e-116
+	{ 0xBBAC2078D443ACE2ULL, 0xFC2C3F3841F17C67ULL }, // 1e-115
+	{ 0xD54B944B84AA4C0DULL, 0x9D9BA7832936EDC0ULL }, // 1e-114
+	{ 0x0A9E795E65D4DF11ULL, 0xC5029163F384A931ULL }, // 1e-113
+	{ 0x4D4617B5FF4A16D5ULL, 0xF64335BCF065D37DULL }, // 1e-112
+	{ 0x504BCED1BF8E4E45ULL, 0x99EA0196163FA42EULL }, // 1e-111
+	{ 0xE45EC2862F71E1D6ULL, 0xC06481FB9BCF8D39ULL }, // 1e-110
+	{ 0x5D767327BB4E5A4CULL, 0xF07DA27A82C37088ULL }, // 1e-109
+	{ 0x3A6A07F8D510F86FULL, 0x964E858C91BA2655ULL }, // 1e-108
+	{ 0x890489F70A55368BULL, 0xBBE226EFB628AFEAULL }, // 1e-107
+	{ 0x2B45AC74CCEA842EULL, 0xEADAB0ABA3B2DBE5ULL }, // 1e-106
+	{ 0x3B0B8BC90012929DULL, 0x92C8AE6B464FC96FULL }, // 1e-105
+	{ 0x09CE6EBB40173744ULL, 0xB77ADA0617E3BBCBULL }, // 1e-104
+	{ 0xCC420A6A101D0515ULL, 0xE55990879DDCAABDULL }, // 1e-103
+	{ 0x9FA946824A12232DULL, 0x8F57FA54C2A9EAB6ULL }, // 1e-102
+	{ 0x47939822DC96ABF9ULL, 0xB32DF8E9F3546564ULL }, // 1e-101
+	{ 0x59787E2B93BC56F7ULL, 0xDFF9772470297EBDULL }, // 1e-100
+	{ 0x57EB4EDB3C55B65AULL, 0x8BFBEA76C619EF36ULL }, // 1e-99
+	{ 0xEDE622920B6B23F1ULL, 0xAEFAE51477A06B03ULL }, // 1e-98
+	{ 0xE95FAB368E45ECEDULL, 0xDAB99E59958885C4ULL }, // 1e-97
+	{ 0x11DBCB0218EBB414ULL, 0x88B402F7FD75539BULL }, // 1e-96
+	{ 0xD652BDC29F26A119ULL, 0xAAE103B5FCD2A881ULL }, // 1e-95
+	{ 0x4BE76D3346F0495FULL, 0xD59944A37C0752A2ULL }, // 1e-94
+	{ 0x6F70A4400C562DDBULL, 0x857FCAE62D8493A5ULL }, // 1e-93
+	{ 0xCB4CCD500F6BB952ULL, 0xA6DFBD9FB8E5B88EULL }, // 1e-92
+	{ 0x7E2000A41346A7A7ULL, 0xD097AD07A71F26B2ULL }, // 1e-91
+	{ 0x8ED400668C0C28C8ULL, 0x825ECC24C873782FULL }, // 1e-90
+	{ 0x728900802F0F32FAULL, 0xA2F67F2DFA90563BULL }, // 1e-89
+	{ 0x4F2B40A03AD2FFB9ULL, 0xCBB41EF979346BCAULL }, // 1e-88
+	{ 0xE2F610C84987BFA8ULL, 0xFEA126B7D78186BCULL }, // 1e-87
+	{ 0x0DD9CA7D2DF4D7C9ULL, 0x9F24B832E6B0F436ULL }, // 1e-86
+	{ 0x91503D1C79720DBBULL, 0xC6EDE63FA05D3143ULL }, // 1e-85
+	{ 0x75A44C6397CE912AULL, 0xF8A95FCF88747D94ULL }, // 1e-84
+	{ 0xC986AFBE3EE11ABAULL, 0x9B69DBE1B548CE7CULL }, // 1e-83
+	{ 0xFBE85BADCE996168ULL, 0xC24452DA229B021BULL }, // 1e-82
+	{ 0xFAE27299423FB9C3ULL, 0xF2D56790AB41C2A2ULL }, // 1e-81
+	{ 0xDCCD879FC967D41AULL, 0x97C560BA6B0919A5ULL }, // 1e-80
+	{ 0x5400E987BBC1C920ULL, 0xBDB6B8E905CB600FULL }, // 1e-79
+	{ 0x290123E9AAB23B68ULL, 0xED246723473E3813ULL }, // 1e-78
+	{ 0xF9A0B6720AAF6521ULL, 0x9436C0760C86E30BULL }, // 1e-77
+	{ 0xF808E40E8D5B3E69ULL, 0xB94470938FA89BCEULL }, // 1e-76
+	{ 0xB60B1D1230B20E04ULL, 0xE7958CB87392C2C2ULL }, // 1e-75
+	{ 0xB1C6F22B5E6F48C2ULL, 0x90BD77F3483BB9B9ULL }, // 1e-74
+	{ 0x1E38AEB6360B1AF3ULL, 0xB4ECD5F01A4AA828ULL }, // 1e-73
+	{ 0x25C6DA63C38DE1B0ULL, 0xE2280B6C20DD5232ULL }, // 1e-72
+	{ 0x579C487E5A38AD0EULL, 0x8D590723948A535FULL }, // 1e-71
+	{ 0x2D835A9DF0C6D851ULL, 0xB0AF48EC79ACE837ULL }, // 1e-70
+	{ 0xF8E431456CF88E65ULL, 0xDCDB1B2798182244ULL }, // 1e-69
+	{ 0x1B8E9ECB641B58FFULL, 0x8A08F0F8BF0F156BULL }, // 1e-68
+	{ 0xE272467E3D222F3FULL, 0xAC8B2D36EED2DAC5ULL }, // 1e-67
+	{ 0x5B0ED81DCC6ABB0FULL, 0xD7ADF884AA879177ULL }, // 1e-66
+	{ 0x98E947129FC2B4E9ULL, 0x86CCBB52EA94BAEAULL }, // 1e-65
+	{ 0x3F2398D747B36224ULL, 0xA87FEA27A539E9A5ULL }, // 1e-64
+	{ 0x8EEC7F0D19A03AADULL, 0xD29FE4B18E88640EULL }, // 1e-63
+	{ 0x1953CF68300424ACULL, 0x83A3EEEEF9153E89ULL }, // 1e-62
+	{ 0x5FA8C3423C052DD7ULL, 0xA48CEAAAB75A8E2BULL }, // 1e-61
+	{ 0x3792F412CB06794DULL, 0xCDB02555653131B6ULL }, // 1e-60
+	{ 0xE2BBD88BBEE40BD0ULL, 0x808E17555F3EBF11ULL }, // 1e-59
+	{ 0x5B6ACEAEAE9D0EC4ULL, 0xA0B19D2AB70E6ED6ULL }, // 1e-58
+	{ 0xF245825A5A445275ULL, 0xC8DE047564D20A8BULL }, // 1e-57
+	{ 0xEED6E2F0F0D56712ULL, 0xFB158592BE068D2EULL }, // 1e-56
+	{ 0x55464DD69685606BULL, 0x9CED737BB6C4183DULL }, // 1e-55
+	{ 0xAA97E14C3C26B886ULL, 0xC428D05AA4751E4CULL }, // 1e-54
+	{ 0xD53DD99F4B3066A8ULL, 0xF53304714D9265DFULL }, // 1e-53
+	{ 0xE546A8038EFE4029ULL, 0x993FE2C6D07B7FABULL }, // 1e-52
+	{ 0xDE98520472BDD033ULL, 0xBF8FDB78849A5F96ULL }, // 1e-51
+	{ 0x963E66858F6D4440ULL, 0xEF73D256A5C0F77CULL }, // 1e-50
+	{ 0xDDE7001379A44AA8ULL, 0x95A8637627989AADULL }, // 1e-49
+	{ 0x5560C018580D5D52ULL, 0xBB127C53B17EC159ULL }, // 1e-48
+	{ 0xAAB8F01E6E10B4A6ULL, 0xE9D71B689DDE71AFULL }, // 1e-47
+	{ 0xCAB3961304CA70E8ULL, 0x9226712162AB070DULL }, // 1e-46
+	{ 0x3D607B97C5FD0D22ULL, 0xB6B00D69BB55C8D1ULL }, // 1e-45
+	{ 0x8CB89A7DB77C506AULL, 0xE45C10C42A2B3B05ULL }, // 1e-44
+	{ 0x77F3608E92ADB242ULL, 0x8EB98A7A9A5B04E3ULL }, // 1e-43
+	{ 0x55F038B237591ED3ULL, 0xB267ED1940F1C61CULL }, // 1e-42
+	{ 0x6B6C46DEC52F6688ULL, 0xDF01E85F912E37A3ULL }, // 1e-41
+	{ 0x2323AC4B3B3DA015ULL, 0x8B61313BBABCE2C6ULL }, // 1e-40
+	{ 0xABEC975E0A0D081AULL, 0xAE397D8AA96C1B77ULL }, // 1e-39
+	{ 0x96E7BD358C904A21ULL, 0xD9C7DCED53C72255ULL }, // 1e-38
+	{ 0x7E50D64177DA2E54ULL, 0x881CEA14545C7575ULL }, // 1e-37
+	{ 0xDDE50BD1D5D0B9E9ULL, 0xAA242499697392D2ULL }, // 1e-36
+	{ 0x955E4EC64B44E864ULL, 0xD4AD2DBFC3D07787ULL }, // 1e-35
+	{ 0xBD5AF13BEF0B113EULL, 0x84EC3C97DA624AB4ULL }, // 1e-34
+	{ 0xECB1AD8AEACDD58EULL, 0xA6274BBDD0FADD61ULL }, // 1e-33
+	{ 0x67DE18EDA5814AF2ULL, 0xCFB11EAD453994BAULL }, // 1e-32
+	{ 0x80EACF948770CED7ULL, 0x81CEB32C4B43FCF4ULL }, // 1e-31
+	{ 0xA1258379A94D028DULL, 0xA2425FF75E14FC31ULL }, // 1e-30
+	{ 0x096EE45813A04330ULL, 0xCAD2F7F5359A3B3EULL }, // 1e-29
+	{ 0x8BCA9D6E188853FCULL, 0xFD87B5F28300CA0DULL }, // 1e-28
+	{ 0x775EA264CF55347DULL, 0x9E74D1B791E07E48ULL }, // 1e-27
+	{ 0x95364AFE032A819DULL, 0xC612062576589DDAULL }, // 1e-26
+	{ 0x3A83DDBD83F52204ULL, 0xF79687AED3EEC551ULL }, // 1e-25
+	{ 0xC4926A9672793542ULL, 0x9ABE14CD44753B52ULL }, // 1e-24
+	{ 0x75B7053C0F178293ULL, 0xC16D9A0095928A27ULL }, // 1e-23
+	{ 0x5324C68B12DD6338ULL, 0xF1C90080BAF72CB1ULL }, // 1e-22
+	{ 0xD3F6FC16EBCA5E03ULL, 0x971DA05074DA7BEEULL }, // 1e-21
+	{ 0x88F4BB1CA6BCF584ULL, 0xBCE5086492111AEAULL }, // 1e-20
+	{ 0x2B31E9E3D06C32E5ULL, 0xEC1E4A7DB69561A5ULL }, // 1e-19
+	{ 0x3AFF322E62439FCFULL, 0x9392EE8E921D5D07ULL }, // 1e-18
+	{ 0x09BEFEB9FAD487C2ULL, 0xB877AA3236A4B449ULL }, // 1e-17
+	{ 0x4C2EBE687989A9B3ULL, 0xE69594BEC44DE15BULL }, // 1e-16
+	{ 0x0F9D37014BF60A10ULL, 0x901D7CF73AB0ACD9ULL }, // 1e-15
+	{ 0x538484C19EF38C94ULL, 0xB424DC35095CD80FULL }, // 1e-14
+	{ 0x2865A5F206B06FB9ULL, 0xE12E13424BB40E13ULL }, // 1e-13
+	{ 0xF93F87B7442E45D3ULL, 0x8CBCCC096F5088CBULL }, // 1e-12
+	{ 0xF78F69A51539D748ULL, 0xAFEBFF0BCB24AAFEULL }, // 1e-11
+	{ 0xB573440E5A884D1BULL, 0xDBE6FECEBDEDD5BEULL }, // 1e-10
+	{ 0x31680A88F8953030ULL, 0x89705F4136B4A597ULL }, // 1e-9
+	{ 0xFDC20D2B36BA7C3DULL, 0xABCC77118461CEFCULL }, // 1e-8
+	{ 0x3D32907604691B4CULL, 0xD6BF94D5E57A42BCULL }, // 1e-7
+	{ 0xA63F9A49C2C1B10FULL, 0x8637BD05AF6C69B5ULL }, // 1e-6
+	{ 0x0FCF80DC33721D53ULL, 0xA7C5AC471B478423ULL }, // 1e-5
+	{ 0xD3C36113404EA4A8ULL, 0xD1B71758E219652BULL }, // 1e-4
+	{ 0x645A1CAC083126E9ULL, 0x83126E978D4FDF3BULL }, // 1e-3
+	{ 0x3D70A3D70A3D70A3ULL, 0xA3D70A3D70A3D70AULL }, // 1e-2
+	{ 0xCCCCCCCCCCCCCCCCULL, 0xCCCCCCCCCCCCCCCCULL }, // 1e-1
+	{ 0x0000000000000000ULL, 0x8000000000000000ULL }, // 1e0
+	{ 0x0000000000000000ULL, 0xA000000000000000ULL }, // 1e1
+	{ 0x0000000000000000ULL, 0xC800000000000000ULL }, // 1e2
+	{ 0x0000000000000000ULL, 0xFA00000000000000ULL }, // 1e3
+	{ 0x0000000000000000ULL, 0x9C40000000000000ULL }, // 1e4
+	{ 0x0000000000000000ULL, 0xC350000000000000ULL }, // 1e5
+	{ 0x0000000000000000ULL, 0xF424000000000000ULL }, // 1e6
+	{ 0x0000000000000000ULL, 0x9896800000000000ULL }, // 1e7
+	{ 0x0000000000000000ULL, 0xBEBC200000000000ULL }, // 1e8
+	{ 0x0000000000000000ULL, 0xEE6B280000000000ULL }, // 1e9
+	{ 0x0000000000000000ULL, 0x9502F90000000000ULL }, // 1e10
+	{ 0x0000000000000000ULL, 0xBA43B74000000000ULL }, // 1e11
+	{ 0x0000000000000000ULL, 0xE8D4A51000000000ULL }, // 1e12
+	{ 0x0000000000000000ULL, 0x9184E72A00000000ULL }, // 1e13
+	{ 0x0000000000000000ULL, 0xB5E620F480000000ULL }, // 1e14
+	{ 0x0000000000000000ULL, 0xE35FA931A0000000ULL }, // 1e15
+	{ 0x0000000000000000ULL, 0x8E1BC9BF04000000ULL }, // 1e16
+	{ 0x0000000000000000ULL, 0xB1A2BC2EC5000000ULL }, // 1e17
+	{ 0x0000000000000000ULL, 0xDE0B6B3A76400000ULL }, // 1e18
+	{ 0x0000000000000000ULL, 0x8AC7230489E80000ULL }, // 1e19
+	{ 0x0000000000000000ULL, 0xAD78EBC5AC620000ULL }, // 1e20
+	{ 0x0000000000000000ULL, 0xD8D726B7177A8000ULL }, // 1e21
+	{ 0x0000000000000000ULL, 0x878678326EAC9000ULL }, // 1e22
+	{ 0x0000000000000000ULL, 0xA968163F0A57B400ULL }, // 1e23
+	{ 0x0000000000000000ULL, 0xD3C21BCECCEDA100ULL }, // 1e24
+	{ 0x0000000000000000ULL, 0x84595161401484A0ULL }, // 1e25
+	{ 0x0000000000000000ULL, 0xA56FA5B99019A5C8ULL }, // 1e26
+	{ 0x0000000000000000ULL, 0xCECB8F27F4200F3AULL }, // 1e27
+	{ 0x4000000000000000ULL, 0x813F3978F8940984ULL }, // 1e28
+	{ 0x5000000000000000ULL, 0xA18F07D736B90BE5ULL }, // 1e29
+	{ 0xA400000000000000ULL, 0xC9F2C9CD04674EDEULL }, // 1e30
+	{ 0x4D00000000000000ULL, 0xFC6F7C4045812296ULL }, // 1e31
+	{ 0xF020000000000000ULL, 0x9DC5ADA82B70B59DULL }, // 1e32
+	{ 0x6C28000000000000ULL, 0xC5371912364CE305ULL }, // 1e33
+	{ 0xC732000000000000ULL, 0xF684DF56C3E01BC6ULL }, // 1e34
+	{ 0x3C7F400000000000ULL, 0x9A130B963A6C115CULL }, // 1e35
+	{ 0x4B9F100000000000ULL, 0xC097CE7BC90715B3ULL }, // 1e36
+	{ 0x1E86D40000000000ULL, 0xF0BDC21ABB48DB20ULL }, // 1e37
+	{ 0x1314448000000000ULL, 0x96769950B50D88F4ULL }, // 1e38
+	{ 0x17D955A000000000ULL, 0xBC143FA4E250EB31ULL }, // 1e39
+	{ 0x5DCFAB0800000000ULL, 0xEB194F8E1AE525FDULL }, // 1e40
+	{ 0x5AA1CAE500000000ULL, 0x92EFD1B8D0CF37BEULL }, // 1e41
+	{ 0xF14A3D9E40000000ULL, 0xB7ABC627050305ADULL }, // 1e42
+	{ 0x6D9CCD05D0000000ULL, 0xE596B7B0C643C719ULL }, // 1e43
+	{ 0xE4820023A2000000ULL, 0x8F7E32CE7BEA5C6FULL }, // 1e44
+	{ 0xDDA2802C8A800000ULL, 0xB35DBF821AE4F38BULL }, // 1e45
+	{ 0xD50B2037AD200000ULL, 0xE0352F62A19E306EULL }, // 1e46
+	{ 0x4526F422CC340000ULL, 0x8C213D9DA502DE45ULL }, // 1e47
+	{ 0x9670B12B7F410000ULL, 0xAF298D050E4395D6ULL }, // 1e48
+	{ 0x3C0CDD765F114000ULL, 0xDAF3F04651D47B4CULL }, // 1e49
+	{ 0xA5880A69FB6AC800ULL, 0x88D8762BF324CD0FULL }, // 1e50
+	{ 0x8EEA0D047A457A00ULL, 0xAB0E93B6EFEE0053ULL }, // 1e51
+	{ 0x72A4904598D6D880ULL, 0xD5D238A4ABE98068ULL }, // 1e52
+	{ 0x47A6DA2B7F864750ULL, 0x85A36366EB71F041ULL }, // 1e53
+	{ 0x999090B65F67D924ULL, 0xA70C3C40A64E6C51ULL }, // 1e54
+	{ 0xFFF4B4E3F741CF6DULL, 0xD0CF4B50CFE20765ULL }, // 1e55
+	{ 0xBFF8F10E7A8921A4ULL, 0x82818F1281ED449FULL }, // 1e56
+	{ 0xAFF72D52192B6A0DULL, 0xA321F2D7226895C7ULL }, // 1e57
+	{ 0x9BF4F8A69F764490ULL, 0xCBEA6F8CEB02BB39ULL }, // 1e58
+	{ 0x02F236D04753D5B4ULL, 0xFEE50B7025C36A08ULL }, // 1e59
+	{ 0x01D762422C946590ULL, 0x9F4F2726179A2245ULL }, // 1e60
+	{ 0x424D3AD2B7B97EF5ULL, 0xC722F0EF9D80AAD6ULL }, // 1e61
+	{ 0xD2E0898765A7DEB2ULL, 0xF8EBAD2B84E0D58BULL }, // 1e62
+	{ 0x63CC55F49F88EB2FULL, 0x9B934C3B330C8577ULL }, // 1e63
+	{ 0x3CBF6B71C76B25FBULL, 0xC2781F49FFCFA6D5ULL }, // 1e64
+	{ 0x8BEF464E3945EF7AULL, 0xF316271C7FC3908AULL }, // 1e65
+	{ 0x97758BF0E3CBB5ACULL, 0x97EDD871CFDA3A56ULL }, // 1e66
+	{ 0x3D52EEED1CBEA317ULL, 0xBDE94E8E43D0C8ECULL }, // 1e67
+	{ 0x4CA7AAA863EE4BDDULL, 0xED63A231D4C4FB27ULL }, // 1e68
+	{ 0x8FE8CAA93E74EF6AULL, 0x945E455F24FB1CF8ULL }, // 1e69
+	{ 0xB3E2FD538E122B44ULL, 0xB975D6B6EE39E436ULL }, // 1e70
+	{ 0x60DBBCA87196B616ULL, 0xE7D34C64A9C85D44ULL }, // 1e71
+	{ 0xBC8955E946FE31CDULL, 0x90E40FBEEA1D3A4AULL }, // 1e72
+	{ 0x6BABAB6398BDBE41ULL, 0xB51D13AEA4A488DDULL }, // 1e73
+	{ 0xC696963C7EED2DD1ULL, 0xE264589A4DCDAB14ULL }, // 1e74
+	{ 0xFC1E1DE5CF543CA2ULL, 0x8D7EB76070A08AECULL }, // 1e75
+	{ 0x3B25A55F43294BCBULL, 0xB0DE65388CC8ADA8ULL }, // 1e76
+	{ 0x49EF0EB713F39EBEULL, 0xDD15FE86AFFAD912ULL }, // 1e77
+	{ 0x6E3569326C784337ULL, 0x8A2DBF142DFCC7ABULL }, // 1e78
+	{ 0x49C2C37F07965404ULL, 0xACB92ED9397BF996ULL }, // 1e79
+	{ 0xDC33745EC97BE906ULL, 0xD7E77A8F87DAF7FBULL }, // 1e80
+	{ 0x69A028BB3DED71A3ULL, 0x86F0AC99B4E8DAFDULL }, // 1e81
+	{ 0xC40832EA0D68CE0CULL, 0xA8ACD7C0222311BCULL }, // 1e82
+	{ 0xF50A3FA490C30190ULL, 0xD2D80DB02AABD62BULL }, // 1e83
+	{ 0x792667C6DA79E0FAULL, 0x83C7088E1AAB65DBULL }, // 1e84
+	{ 0x577001B891185938ULL, 0xA4B8CAB1A1563F52ULL }, // 1e85
+	{ 0xED4C0226B55E6F86ULL, 0xCDE6FD5E09ABCF26ULL }, // 1e86
+	{ 0x544F8158315B05B4ULL, 0x80B05E5AC60B6178ULL }, // 1e87
+	{ 0x696361AE3DB1C721ULL, 0xA0DC75F1778E39D6ULL }, // 1e88
+	{ 0x03BC3A19CD1E38E9ULL, 0xC913936DD571C84CULL }, // 1e89
+	{ 0x04AB48A04065C723ULL, 0xFB5878494ACE3A5FULL }, // 1e90
+	{ 0x62EB0D64283F9C76ULL, 0x9D174B2DCEC0E47BULL }, // 1e91
+	{ 0x3BA5D0BD324F8394ULL, 0xC45D1DF942711D9AULL }, // 1e92
+	{ 0xCA8F44EC7EE36479ULL, 0xF5746577930D6500ULL }, // 1e93
+	{ 0x7E998B13CF4E1ECBULL, 0x9968BF6ABBE85F20ULL }, // 1e94
+	{ 0x9E3FEDD8C321A67EULL, 0xBFC2EF456AE276E8ULL }, // 1e95
+	{ 0xC5CFE94EF3EA101EULL, 0xEFB3AB16C59B14A2ULL }, // 1e96
+	{ 0xBBA1F1D158724A12ULL, 0x95D04AEE3B80ECE5ULL }, // 1e97
+	{ 0x2A8A6E45AE8EDC97ULL, 0xBB445DA9CA61281FULL }, // 1e98
+	{ 0xF52D09D71A3293BDULL, 0xEA1575143CF97226ULL }, // 1e99
+	{ 0x593C2626705F9C56ULL, 0x924D692CA61BE758ULL }, // 1e100
+	{ 0x6F8B2FB00C77836CULL, 0xB6E0C377CFA2E12EULL }, // 1e101
+	{ 0x0B6DFB9C0F956447ULL, 0xE498F455C38B997AULL }, // 1e102
+	{ 0x4724BD4189BD5EACULL, 0x8EDF98B59A373FECULL }, // 1e103
+	{ 0x58EDEC91EC2CB657ULL, 0xB2977EE300C50FE7ULL }, // 1e104
+	{ 0x2F2967B66737E3EDULL, 0xDF3D5E9BC0F653E1ULL }, // 1e105
+	{ 0xBD79E0D20082EE74ULL, 0x8B865B215899F46CULL }, // 1e106
+	{ 0xECD8590680A3AA11ULL, 0xAE67F1E9AEC07187ULL }, // 1e107
+	{ 0xE80E6F4820CC9495ULL, 0xDA01EE641A708DE9ULL }, // 1e108
+	{ 0x3109058D147FDCDDULL, 0x884134FE908658B2ULL }, // 1e109
+	{ 0xBD4B46F0599FD415ULL, 0xAA51823E34A7EEDEULL }, // 1e110
+	{ 0x6C9E18AC7007C91AULL, 0xD4E5E2CDC1D1EA96ULL }, // 1e111
+	{ 0x03E2CF6BC604DDB0ULL, 0x850FADC09923329EULL }, // 1e112
+	{ 0x84DB8346B786151CULL, 0xA6539930BF6BFF45ULL }, // 1e113
+	{ 0xE612641865679A63ULL, 0xCFE87F7CEF46FF16ULL }, // 1e114
+	{ 0x4FCB7E8F3F60C07EULL, 0x81F14FAE158C5F6EULL }, // 1e115
+	{ 0xE3BE5E330F38F09DULL, 0xA26DA3999AEF7749ULL }, // 1e116
+	{ 0x5CADF5BFD3072CC5ULL, 0xCB090C8001AB551CULL }, // 1e117
+	{ 0x73D9732FC7C8F7F6ULL, 0xFDCB4FA002162A63ULL }, // 1e118
+	{ 0x2867E7FDDCDD9AFAULL, 0x9E9F11C4014DDA7EULL }, // 1e119
+	{ 0xB281E1FD541501B8ULL, 0xC646D63501A1511DULL }, // 1e120
+	{ 0x1F225A7CA91A4226ULL, 0xF7D88BC24209A565ULL }, // 1e121
+	{ 0x3375788DE9B06958ULL, 0x9AE757596946075FULL }, // 1e122
+	{ 0x0052D6B1641C83AEULL, 0xC1A12D2FC3978937ULL }, // 1e123
+	{ 0xC0678C5DBD23A49AULL, 0xF209787BB47D6B84ULL }, // 1e124
+	{ 0xF840B7BA963646E0ULL, 0x9745EB4D50CE6332ULL }, // 1e125
+	{ 0xB650E5A93BC3D898ULL, 0xBD176620A501FBFFULL }, // 1e126
+	{ 0xA3E51F138AB4CEBEULL, 0xEC5D3FA8CE427AFFULL }, // 1e127
+	{ 0xC66F336C36B10137ULL, 0x93BA47C980E98CDFULL }, // 1e128
+	{ 0xB80B0047445D4184ULL, 0xB8A8D9BBE123F017ULL }, // 1e129
+	{ 0xA60DC059157491E5ULL, 0xE6D3102AD96CEC1DULL }, // 1e130
+	{ 0x87C89837AD68DB2FULL, 0x9043EA1AC7E41392ULL }, // 1e131
+	{ 0x29BABE4598C311FBULL, 0xB454E4A179DD1877ULL }, // 1e132
+	{ 0xF4296DD6FEF3D67AULL, 0xE16A1DC9D8545E94ULL }, // 1e133
+	{ 0x1899E4A65F58660CULL, 0x8CE2529E2734BB1DULL }, // 1e134
+	{ 0x5EC05DCFF72E7F8FULL, 0xB01AE745B101E9E4ULL }, // 1e135
+	{ 0x76707543F4FA1F73ULL, 0xDC21A1171D42645DULL }, // 1e136
+	{ 0x6A06494A791C53A8ULL, 0x899504AE72497EBAULL }, // 1e137
+	{ 0x0487DB9D17636892ULL, 0xABFA45DA0EDBDE69ULL }, // 1e138
+	{ 0x45A9D2845D3C42B6ULL, 0xD6F8D7509292D603ULL }, // 1e139
+	{ 0x0B8A2392BA45A9B2ULL, 0x865B86925B9BC5C2ULL }, // 1e140
+	{ 0x8E6CAC7768D7141EULL, 0xA7F26836F282B732ULL }, // 1e141
+	{ 0x3207D795430CD926ULL, 0xD1EF0244AF2364FFULL }, // 1e142
+	{ 0x7F44E6BD49E807B8ULL, 0x8335616AED761F1FULL }, // 1e143
+	{ 0x5F16206C9C6209A6ULL, 0xA402B9C5A8D3A6E7ULL }, // 1e144
+	{ 0x36DBA887C37A8C0FULL, 0xCD036837130890A1ULL }, // 1e145
+	{ 0xC2494954DA2C9789ULL, 0x802221226BE55A64ULL }, // 1e146
+	{ 0xF2DB9BAA10B7BD6CULL, 0xA02AA96B06DEB0FDULL }, // 1e147
+	{ 0x6F92829494E5ACC7ULL, 0xC83553C5C8965D3DULL }, // 1e148
+	{ 0xCB772339BA1F17F9ULL, 0xFA42A8B73ABBF48CULL }, // 1e149
+	{ 0xFF2A760414536EFBULL, 0x9C69A97284B578D7ULL }, // 1e150
+	{ 0xFEF5138519684ABAULL, 0xC38413CF25E2D70DULL }, // 1e151
+	{ 0x7EB258665FC25D69ULL, 0xF46518C2EF5B8CD1ULL }, // 1e152
+	{ 0xEF2F773FFBD97A61ULL, 0x98BF2F79D5993802ULL }, // 1e153
+	{ 0xAAFB550FFACFD8FAULL, 0xBEEEFB584AFF8603ULL }, // 1e154
+	{ 0x95BA2A53F983CF38ULL, 0xEEAABA2E5DBF6784ULL }, // 1e155
+	{ 0xDD945A747BF26183ULL, 0x952AB45CFA97A0B2ULL }, // 1e156
+	{ 0x94F971119AEEF9E4ULL, 0xBA756174393D88DFULL }, // 1e157
+	{ 0x7A37CD5601AAB85DULL, 0xE912B9D1478CEB17ULL }, // 1e158
+	{ 0xAC62E055C10AB33AULL, 0x91ABB422CCB812EEULL }, // 1e159
+	{ 0x577B986B314D6009ULL, 0xB616A12B7FE617AAULL }, // 1e160
+	{ 0xED5A7E85FDA0B80BULL, 0xE39C49765FDF9D94ULL }, // 1e161
+	{ 0x14588F13BE847307ULL, 0x8E41ADE9FBEBC27DULL }, // 1e162
+	{ 0x596EB2D8AE258FC8ULL, 0xB1D219647AE6B31CULL }, // 1e163
+	{ 0x6FCA5F8ED9AEF3BBULL, 0xDE469FBD99A05FE3ULL }, // 1e164
+	{ 0x25DE7BB9480D5854ULL, 0x8AEC23D680043BEEULL }, // 1e165
+	{ 0xAF561AA79A10AE6AULL, 0xADA72CCC20054AE9ULL }, // 1e166
+	{ 0x1B2BA1518094DA04ULL, 0xD910F7FF28069DA4ULL }, // 1e167
+	{ 0x90FB44D2F05D0842ULL, 0x87AA9AFF79042286ULL }, // 1e168
+	{ 0x353A1607AC744A53ULL, 0xA99541BF57452B28ULL }, // 1e169
+	{ 0x42889B8997915CE8ULL, 0xD3FA922F2D1675F2ULL }, // 1e170
+	{ 0x69956135FEBADA11ULL, 0x847C9B5D7C2E09B7ULL }, // 1e171
+	{ 0x43FAB9837E699095ULL, 0xA59BC234DB398C25ULL }, // 1e172
+	{ 0x94F967E45E03F4BBULL, 0xCF02B2C21207EF2EULL }, // 1e173
+	{ 0x1D1BE0EEBAC278F5ULL, 0x8161AFB94B44F57DULL }, // 1e174
+	{ 0x6462D92A69731732ULL, 0xA1BA1BA79E1632DCULL }, // 1e175
+	{ 0x7D7B8F7503CFDCFEULL, 0xCA28A291859BBF93ULL }, // 1e176
+	{ 0x5CDA735244C3D43EULL, 0xFCB2CB35E702AF78ULL }, // 1e177
+	{ 0x3A0888136AFA64A7ULL, 0x9DEFBF01B061ADABULL }, // 1e178
+	{ 0x088AAA1845B8FDD0ULL, 0xC56BAEC21C7A1916ULL }, // 1e179
+	{ 0x8AAD549E57273D45ULL, 0xF6C69A72A3989F5BULL }, // 1e180
+	{ 0x36AC54E2F678864BULL, 0x9A3C2087A63F6399ULL }, // 1e181
+	{ 0x84576A1BB416A7DDULL, 0xC0CB28A98FCF3C7FULL }, // 1e182
+	{ 0x656D44A2A11C51D5ULL, 0xF0FDF2D3F3C30B9FULL }, // 1e183
+	{ 0x9F644AE5A4B1B325ULL, 0x969EB7C47859E743ULL }, // 1e184
+	{ 0x873D5D9F0DDE1FEEULL, 0xBC4665B596706114ULL }, // 1e185
+	{ 0xA90CB506D155A7EAULL, 0xEB57FF22FC0C7959ULL }, // 1e186
+	{ 0x09A7F12442D588F2ULL, 0x9316FF75DD87CBD8ULL }, // 1e187
+	{ 0x0C11ED6D538AEB2FULL, 0xB7DCBF5354E9BECEULL }, // 1e188
+	{ 0x8F1668C8A86DA5FAULL, 0xE5D3EF282A242E81ULL }, // 1e189
+	{ 0xF96E017D694487BCULL, 0x8FA475791A569D10ULL }, // 1e190
+	{ 0x37C981DCC395A9ACULL, 0xB38D92D760EC4455ULL }, // 1e191
+	{ 0x85BBE253F47B1417ULL, 0xE070F78D3927556AULL }, // 1e192
+	{ 0x93956D7478CCEC8EULL, 0x8C469AB843B89562ULL }, // 1e193
+	{ 0x387AC8D1970027B2ULL, 0xAF58416654A6BABBULL }, // 1e194
+	{ 0x06997B05FCC0319EULL, 0xDB2E51BFE9D0696AULL }, // 1e195
+	{ 0x441FECE3BDF81F03ULL, 0x88FCF317F22241E2ULL }, // 1e196
+	{ 0xD527E81CAD7626C3ULL, 0xAB3C2FDDEEAAD25AULL }, // 1e197
+	{ 0x8A71E223D8D3B074ULL, 0xD60B3BD56A5586F1ULL }, // 1e198
+	{ 0xF6872D5667844E49ULL, 0x85C7056562757456ULL }, // 1e199
+	{ 0xB428F8AC016561DBULL, 0xA738C6BEBB12D16CULL }, // 1e200
+	{ 0xE13336D701BEBA52ULL, 0xD106F86E69D785C7ULL }, // 1e201
+	{ 0xECC0024661173473ULL, 0x82A45B450226B39CULL }, // 1e202
+	{ 0x27F002D7F95D0190ULL, 0xA34D721642B06084ULL }, // 1e203
+	{ 0x31EC038DF7B441F4ULL, 0xCC20CE9BD35C78A5ULL }, // 1e204
+	{ 0x7E67047175A15271ULL, 0xFF290242C83396CEULL }, // 1e205
+	{ 0x0F0062C6E984D386ULL, 0x9F79A169BD203E41ULL }, // 1e206
+	{ 0x52C07B78A3E60868ULL, 0xC75809C42C684DD1ULL }, // 1e207
+	{ 0xA7709A56CCDF8A82ULL, 0xF92E0C3537826145ULL }, // 1e208
+	{ 0x88A66076400BB691ULL, 0x9BBCC7A142B17CCBULL }, // 1e209
+	{ 0x6ACFF893D00EA435ULL, 0xC2ABF989935DDBFEULL }, // 1e210
+	{ 0x0583F6B8C4124D43ULL, 0xF356F7EBF83552FEULL }, // 1e211
+	{ 0xC3727A337A8B704AULL, 0x98165AF37B2153DEULL }, // 1e212
+	{ 0x744F18C0592E4C5CULL, 0xBE1BF1B059E9A8D6ULL }, // 1e213
+	{ 0x1162DEF06F79DF73ULL, 0xEDA2EE1C7064130CULL }, // 1e214
+	{ 0x8ADDCB5645AC2BA8ULL, 0x9485D4D1C63E8BE7ULL }, // 1e215
+	{ 0x6D953E2BD7173692ULL, 0xB9A74A0637CE2EE1ULL }, // 1e216
+	{ 0xC8FA8DB6CCDD0437ULL, 0xE8111C87C5C1BA99ULL }, // 1e217
+	{ 0x1D9C9892400A22A2ULL, 0x910AB1D4DB9914A0ULL }, // 1e218
+	{ 0x2503BEB6D00CAB4BULL, 0xB54D5E4A127F59C8ULL }, // 1e219
+	{ 0x2E44AE64840FD61DULL, 0xE2A0B5DC971F303AULL }, // 1e220
+	{ 0x5CEAECFED289E5D2ULL, 0x8DA471A9DE737E24ULL }, // 1e221
+	{ 0x7425A83E872C5F47ULL, 0xB10D8E1456105DADULL }, // 1e222
+	{ 0xD12F124E28F77719ULL, 0xDD50F1996B947518ULL }, // 1e223
+	{ 0x82BD6B70D99AAA6FULL, 0x8A5296FFE33CC92FULL }, // 1e224
+	{ 0x636CC64D1001550BULL, 0xACE73CBFDC0BFB7BULL }, // 1e225
+	{ 0x3C47F7E05401AA4EULL, 0xD8210BEFD30EFA5AULL }, // 1e226
+	{ 0x65ACFAEC34810A71ULL, 0x8714A775E3E95C78ULL }, // 1e227
+	{ 0x7F1839A741A14D0DULL, 0xA8D9D1535CE3B396ULL }, // 1e228
+	{ 0x1EDE48111209A050ULL, 0xD31045A8341CA07CULL }, // 1e229
+	{ 0x934AED0AAB460432ULL, 0x83EA2B892091E44DULL }, // 1e230
+	{ 0xF81DA84D5617853FULL, 0xA4E4B66B68B65D60ULL }, // 1e231
+	{ 0x36251260AB9D668EULL, 0xCE1DE40642E3F4B9ULL }, // 1e232
+	{ 0xC1D72B7C6B426019ULL, 0x80D2AE83E9CE78F3ULL }, // 1e233
+	{ 0xB24CF65B8612F81FULL, 0xA1075A24E4421730ULL }, // 1e234
+	{ 0xDEE033F26797B627ULL, 0xC94930AE1D529CFCULL }, // 1e235
+	{ 0x169840EF017DA3B1ULL, 0xFB9B7CD9A4A7443CULL }, // 1e236
+	{ 0x8E1F289560EE864EULL, 0x9D412E0806E88AA5ULL }, // 1e237
+	{ 0xF1A6F2BAB92A27E2ULL, 0xC491798A08A2AD4EULL }, // 1e238
+	{ 0xAE10AF696774B1DBULL, 0xF5B5D7EC8ACB58A2ULL }, // 1e239
+	{ 0xACCA6DA1E0A8EF29ULL, 0x9991A6F3D6BF1765ULL }, // 1e240
+	{ 0x17FD090A58D32AF3ULL, 0xBFF610B0CC6EDD3FULL }, // 1e241
+	{ 0xDDFC4B4CEF07F5B0ULL, 0xEFF394DCFF8A948EULL }, // 1e242
+	{ 0x4ABDAF101564F98EULL, 0x95F83D0A1FB69CD9ULL }, // 1e243
+	{ 0x9D6D1AD41ABE37F1ULL, 0xBB764C4CA7A4440FULL }, // 1e244
+	{ 0x84C86189216DC5EDULL, 0xEA53DF5FD18D5513ULL }, // 1e245
+	{ 0x32FD3CF5B4E49BB4ULL, 0x92746B9BE2F8552CULL }, // 1e246
+	{ 0x3FBC8C33221DC2A1ULL, 0xB7118682DBB66A77ULL }, // 1e247
+	{ 0x0FABAF3FEAA5334AULL, 0xE4D5E82392A40515ULL }, // 1e248
+	{ 0x29CB4D87F2A7400EULL, 0x8F05B1163BA6832DULL }, // 1e249
+	{ 0x743E20E9EF511012ULL, 0xB2C71D5BCA9023F8ULL }, // 1e250
+	{ 0x914DA9246B255416ULL, 0xDF78E4B2BD342CF6ULL }, // 1e251
+	{ 0x1AD089B6C2F7548EULL, 0x8BAB8EEFB6409C1AULL }, // 1e252
+	{ 0xA184AC2473B529B1ULL, 0xAE9672ABA3D0C320ULL }, // 1e253
+	{ 0xC9E5D72D90A2741EULL, 0xDA3C0F568CC4F3E8ULL }, // 1e254
+	{ 0x7E2FA67C7A658892ULL, 0x8865899617FB1871ULL }, // 1e255
+	{ 0xDDBB901B98FEEAB7ULL, 0xAA7EEBFB9DF9DE8DULL }, // 1e256
+	{ 0x552A74227F3EA565ULL, 0xD51EA6FA85785631ULL }, // 1e257
+	{ 0xD53A88958F87275FULL, 0x8533285C936B35DEULL }, // 1e258
+	{ 0x8A892ABAF368F137ULL, 0xA67FF273B8460356ULL }, // 1e259
+	{ 0x2D2B7569B0432D85ULL, 0xD01FEF10A657842CULL }, // 1e260
+	{ 0x9C3B29620E29FC73ULL, 0x8213F56A67F6B29BULL }, // 1e261
+	{ 0x8349F3BA91B47B8FULL, 0xA298F2C501F45F42ULL }, // 1e262
+	{ 0x241C70A936219A73ULL, 0xCB3F2F7642717713ULL }, // 1e263
+	{ 0xED238CD383AA0110ULL, 0xFE0EFB53D30DD4D7ULL }, // 1e264
+	{ 0xF4363804324A40AAULL, 0x9EC95D1463E8A506ULL }, // 1e265
+	{ 0xB143C6053EDCD0D5ULL, 0xC67BB4597CE2CE48ULL }, // 1e266
+	{ 0xDD94B7868E94050AULL, 0xF81AA16FDC1B81DAULL }, // 1e267
+	{ 0xCA7CF2B4191C8326ULL, 0x9B10A4E5E9913128ULL }, // 1e268
+	{ 0xFD1C2F611F63A3F0ULL, 0xC1D4CE1F63F57D72ULL }, // 1e269
+	{ 0xBC633B39673C8CECULL, 0xF24A01A73CF2DCCFULL }, // 1e270
+	{ 0xD5BE0503E085D813ULL, 0x976E41088617CA01ULL }, // 1e271
+	{ 0x4B2D8644D8A74E18ULL, 0xBD49D14AA79DBC82ULL }, // 1e272
+	{ 0xDDF8E7D60ED1219EULL, 0xEC9C459D51852BA2ULL }, // 1e273
+	{ 0xCABB90E5C942B503ULL, 0x93E1AB8252F33B45ULL }, // 1e274
+	{ 0x3D6A751F3B936243ULL, 0xB8DA1662E7B00A17ULL }, // 1e275
+	{ 0x0CC512670A783AD4ULL, 0xE7109BFBA19C0C9DULL }, // 1e276
+	{ 0x27FB2B80668B24C5ULL, 0x906A617D450187E2ULL }, // 1e277
+	{ 0xB1F9F660802DEDF6ULL, 0xB484F9DC9641E9DAULL }, // 1e278
+	{ 0x5E7873F8A0396973ULL, 0xE1A63853BBD26451ULL }, // 1e279
+	{ 0xDB0B487B6423E1E8ULL, 0x8D07E33455637EB2ULL }, // 1e280
+	{ 0x91CE1A9A3D2CDA62ULL, 0xB049DC016ABC5E5FULL }, // 1e281
+	{ 0x7641A140CC7810FBULL, 0xDC5C5301C56B75F7ULL }, // 1e282
+	{ 0xA9E904C87FCB0A9DULL, 0x89B9B3E11B6329BAULL }, // 1e283
+	{ 0x546345FA9FBDCD44ULL, 0xAC2820D9623BF429ULL }, // 1e284
+	{ 0xA97C177947AD4095ULL, 0xD732290FBACAF133ULL }, // 1e285
+	{ 0x49ED8EABCCCC485DULL, 0x867F59A9D4BED6C0ULL }, // 1e286
+	{ 0x5C68F256BFFF5A74ULL, 0xA81F301449EE8C70ULL }, // 1e287
+	{ 0x73832EEC6FFF3111ULL, 0xD226FC195C6A2F8CULL }, // 1e288
+	{ 0xC831FD53C5FF7EABULL, 0x83585D8FD9C25DB7ULL }, // 1e289
+	{ 0xBA3E7CA8B77F5E55ULL, 0xA42E74F3D032F525ULL }, // 1e290
+	{ 0x28CE1BD2E55F35EBULL, 0xCD3A1230C43FB26FULL }, // 1e291
+	{ 0x7980D163CF5B81B3ULL, 0x80444B5E7AA7CF85ULL }, // 1e292
+	{ 0xD7E105BCC332621FULL, 0xA0555E361951C366ULL }, // 1e293
+	{ 0x8DD9472BF3FEFAA7ULL, 0xC86AB5C39FA63440ULL }, // 1e294
+	{ 0xB14F98F6F0FEB951ULL, 0xFA856334878FC150ULL }, // 1e295
+	{ 0x6ED1BF9A569F33D3ULL, 0x9C935E00D4B9D8D2ULL }, // 1e296
+	{ 0x0A862F80EC4700C8ULL, 0xC3B8358109E84F07ULL }, // 1e297
+	{ 0xCD27BB612758C0FAULL, 0xF4A642E14C6262C8ULL }, // 1e298
+	{ 0x8038D51CB897789CULL, 0x98E7E9CCCFBD7DBDULL }, // 1e299
+	{ 0xE0470A63E6BD56C3ULL, 0xBF21E44003ACDD2CULL }, // 1e300
+	{ 0x1858CCFCE06CAC74ULL, 0xEEEA5D5004981478ULL }, // 1e301
+	{ 0x0F37801E0C43EBC8ULL, 0x95527A5202DF0CCBULL }, // 1e302
+	{ 0xD30560258F54E6BAULL, 0xBAA718E68396CFFDULL }, // 1e303
+	{ 0x47C6B82EF32A2069ULL, 0xE950DF20247C83FDULL }, // 1e304
+	{ 0x4CDC331D57FA5441ULL, 0x91D28B7416CDD27EULL }, // 1e305
+	{ 0xE0133FE4ADF8E952ULL, 0xB6472E511C81471DULL }, // 1e306
+	{ 0x58180FDDD97723A6ULL, 0xE3D8F9E563A198E5ULL }, // 1e307
+	{ 0x570F09EAA7EA7648ULL, 0x8E679C2F5E44FF8FULL }, // 1e308
+};
+
+// range of the exponents of pow5_128
+#define POW5_MIN_EXP (-342)
+#define POW5_MAX_EXP 308
+
+// maximum number of digits kept by the exact decimal conversion
+#define DEC_DIGITS 800
+
+/**
+ * The layout of a binary floating point format.
+ */
+typedef struct flt_info {
+	unsigned mant_bits; // number of explicit mantissa bits
+	unsigned exp_bits;  // number of exponent bits
+	int bias;           // exponent bias, minus one
+}flt_info;
+
+static const flt_info flt_double = { 52, 11, -1023 };
+static const flt_info flt_float = { 23, 8, -127 };
+
+/**
+ * A decimal number that was split into its parts by parse_decimal.
+ */
+typedef struct dec_parse {
+	uint64_t mant;          // up to 19 significant digits
+	int64_t exp;            // power of ten to multiply mant with
+	int neg;                // the number is negative
+	int trunc;              // mant does not hold all of the digits
+	int special;            // 0 for a number, 1 for infinity, 2 for NaN
+	const char* digits;     // first digit of the number
+	const char* digits_end; // character after the digits and the point
+	int64_t exp_explicit;   // exponent after the 'e'
+	const char* end;        // character after the number
+}dec_parse;
+
+/**
+ * A decimal number with many digits, for the exact conversion.
+ * It is 0.d[0]d[1]...d[nd-1] * 10^dp.
+ */
+typedef struct dec_big {
+	unsigned char d[DEC_DIGITS + 32]; // digits, as values from 0 to 9
+	int nd;                           // number of digits
+	int dp;                           // position of the decimal point
+	int trunc;                        // digits were dropped
+}dec_big;
+
+/**
+ * Multiplies two 64-bit numbers into a 128-bit product.
+ *
+ * Params:
+ *   uint64_t - a factor
+ *   uint64_t - a factor
+ *   uint64_t* - receives the low half of the product
+ *
+ * Returns:
+ *   uint64_t - the high half of the product
+ */
+static uint64_t mul_64x64(uint64_t a, uint64_t b, uint64_t* lo)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 p = (unsigned __int128)a * b;
+
+	*lo = (uint64_t)p;
+
+	return (uint64_t)(p >> 64);
+#else
+	uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+	uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi;
+	uint64_t hl = a_hi * b_lo, hh = a_hi * b_hi;
+	uint64_t mid = (ll >> 32) + (uint32_t)lh + (uint32_t)hl;
+
+	*lo = (mid << 32) | (uint32_t)ll;
+
+	return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+/**
+ * Splits a decimal number into a mantissa of up to 19 digits and a power
+ * of ten. Infinity and NaN are recognized as strtod recognizes them.
+ * Digits are read eight at a time with scan_digits8.
+ *
+ * Params:
+ *   const char* - the first character of the number, after white space
+ *   size_t - the maximum number of characters to read
+ *   dec_parse* - receives the parts of the number
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if there is no number
+ */
+static int parse_decimal(const char* str, size_t max, dec_parse* p)
+{
+	const char* s = str;
+	const char* int_end;    // end of the integer digits
+	const char* frac;       // first digit of the fraction
+	const char* frac_end;   // end of the fraction digits
+	const char* c;
+	uint64_t v, part;
+	int64_t exp;            // explicit exponent
+	size_t digits, k;
+	int eneg;
+
+// Determines if a character is within the number's limit.
+#define dec_has(q) ((size_t)((q) - str) < max && *(q) != '\0')
+#define dec_digit(q) (dec_has(q) && *(q) >= '0' && *(q) <= '9')
+#define dec_left(q) (max - (size_t)((q) - str))
+
+	p->neg = 0;
+	p->trunc = 0;
+	p->special = 0;
+	p->exp = 0;
+	p->mant = 0;
+
+	if (dec_has(s) && (*s == '-' || *s == '+'))
+	{
+		p->neg = *s == '-';
+		s++;
+	}
+
+	p->digits = s;
+
+	// Digits before the point. The value wraps if there are more than
+	// 19, and is read again below.
+	v = 0;
+	do
+	{
+		k = scan_digits8(s, dec_left(s), &part);
+		v = v * scan_pow10[k] + part;
+		s += k;
+	} while (k == 8);
+	int_end = s;
+
+	frac = frac_end = s;
+	if (dec_has(s) && *s == '.')
+	{
+		frac = ++s;
+		do
+		{
+			k = scan_digits8(s, dec_left(s), &part);
+			v = v * scan_pow10[k] + part;
+			s += k;
+		} while (k == 8);
+		frac_end = s;
+	}
+
+	digits = (size_t)(int_end - p->digits) + (size_t)(frac_end - frac);
+	if (digits == 0)
+	{
+		s = p->digits;
+
+		// Infinity and NaN, in any case
+		for (k = 0; k < 8 && dec_has(s + k) && (s[k] | 0x20) == "infinity"[k]; k++);
+		if (k >= 3)
+		{
+			p->special = 1;
+			p->end = s + (k == 8 ? 8 : 3);
+			return 0;
+		}
+
+		for (k = 0; k < 3 && dec_has(s + k) && (s[k] | 0x20) == "nan"[k]; k++);
+		if (k != 3)
+			return 1;
+
+		// An optional sequence of letters, digits and underscores in
+		// parentheses
+		p->special = 2;
+		p->end = s + 3;
+		if (dec_has(s + 3) && s[3] == '(')
+		{
+			for (c = s + 4; dec_has(c) && (*c == '_' || (*c >= '0' && *c <= '9')
+				|| ((*c | 0x20) >= 'a' && (*c | 0x20) <= 'z')); c++);
+			if (dec_has(c) && *c == ')')
+				p->end = c + 1;
+		}
+
+		return 0;
+	}
+
+	// exponent
+	exp = 0;
+	if (dec_has(s) && (*s == 'e' || *s == 'E'))
+	{
+		c = s + 1;
+		eneg = 0;
+		if (dec_has(c) && (*c == '-' || *c == '+'))
+		{
+			eneg = *c == '-';
+			c++;
+		}
+
+		// Without digits, the 'e' is not part of the number.
+		if (dec_digit(c))
+		{
+			for (; dec_digit(c); c++)
+			{
+				// Exponents this large only decide between zero and
+				// infinity.
+				if (exp < 100000000)
+					exp = exp * 10 + (*c - '0');
+			}
+
+			s = c;
+			if (eneg)
+				exp = -exp;
+		}
+	}
+
+	p->end = s;
+	p->digits_end = frac_end;
+	p->exp_explicit = exp;
+	p->mant = v;
+	p->exp = exp - (int64_t)(frac_end - frac);
+
+	if (digits > 19)
+	{
+		// Leading zeros are not significant.
+		for (c = p->digits; c < frac_end && (*c == '0' || *c == '.'); c++)
+		{
+			if (*c == '0')
+				digits--;
+		}
+
+		if (digits > 19)
+		{
+			// Keep the first 19 significant digits. Whether the rest
+			// are zeros does not matter, since the caller checks that
+			// rounding the mantissa up gives the same result.
+			p->trunc = 1;
+			v = 0;
+			for (k = 0; k < 19; c++)
+			{
+				if (*c != '.')
+				{
+					v = v * 10 + (uint64_t)(*c - '0');
+					k++;
+				}
+			}
+
+			p->mant = v;
+			p->exp = c <= int_end
+				? exp + (int64_t)(int_end - c)
+				: exp - (int64_t)(c - frac);
+		}
+	}
+
+#undef dec_has
+#undef dec_digit
+#undef dec_left
+
+	return 0;
+}
+
+/**
+ * Converts a decimal mantissa and power of ten to a binary floating point
+ * number with the algorithm of Eisel and Lemire. The mantissa is
+ * normalized and multiplied by the 128-bit mantissa of the power of ten,
+ * and the top bits of the product are rounded. This fails in the rare
+ * cases where the truncated power of ten leaves the rounding in doubt,
+ * or where the result is subnormal, infinite or zero.
+ *
+ * Params:
+ *   uint64_t - a non-zero decimal mantissa
+ *   int64_t - the power of ten
+ *   const flt_info* - the binary format
+ *   uint64_t* - receives the bits of the number, without the sign
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if the exact conversion has to be used
+ */
+static int eisel_lemire(uint64_t mant, int64_t exp10, const flt_info* f, uint64_t* bits)
+{
+	const uint64_t* pow;
+	uint64_t x_hi, x_lo, y_hi, y_lo, m_hi, m_lo, res, exp2;
+	unsigned shift, clz;
+	uint64_t low;
+
+	if (exp10 < POW5_MIN_EXP || exp10 > POW5_MAX_EXP)
+		return 1;
+
+	pow = pow5_128[exp10 - POW5_MIN_EXP];
+
+	// the bits below the mantissa and its rounding bit
+	shift = 64 - f->mant_bits - 3;
+	low = ((uint64_t)1 << shift) - 1;
+
+	clz = (unsigned)__builtin_clzll(mant);
+	mant <<= clz;
+
+	// 217706 / 2^16 is log2(10).
+	exp2 = (uint64_t)(((217706 * exp10) >> 16) + 64 - f->bias) - clz;
+
+	x_hi = mul_64x64(mant, pow[1], &x_lo);
+
+	// If the bits below the mantissa are all ones, the product with the
+	// truncated power may be short by one, so use the low half too.
+	if ((x_hi & low) == low && x_lo + mant < mant)
+	{
+		y_hi = mul_64x64(mant, pow[0], &y_lo);
+		m_hi = x_hi;
+		m_lo = x_lo + y_hi;
+		if (m_lo < x_lo)
+			m_hi++;
+
+		if ((m_hi & low) == low && m_lo + 1 == 0 && y_lo + mant < mant)
+			return 1;
+
+		x_hi = m_hi;
+		x_lo = m_lo;
+	}
+
+	// Keep the mantissa bits and one rounding bit.
+	res = x_hi >> ((x_hi >> 63) + shift);
+	exp2 -= 1 ^ (x_hi >> 63);
+
+	// exactly halfway, so the exact conversion has to decide
+	if (x_lo == 0 && (x_hi & low) == 0 && (res & 3) == 1)
+		return 1;
+
+	res += res & 1;
+	res >>= 1;
+	if (res >> (f->mant_bits + 1))
+	{
+		res >>= 1;
+		exp2++;
+	}
+
+	// subnormal, infinite or zero
+	if (exp2 - 1 >= ((uint64_t)1 << f->exp_bits) - 2)
+		return 1;
+
+	*bits = (exp2 << f->mant_bits) | (res & (((uint64_t)1 << f->mant_bits) - 1));
+
+	return 0;
+}
+
+/**
+ * Removes trailing zeros from a big decimal.
+ */
+static void big_trim(dec_big* b)
+{
+	while (b->nd > 0 && b->d[b->nd - 1] == 0)
+		b->nd--;
+
+	if (b->nd == 0)
+		b->dp = 0;
+}
+
+/**
+ * Multiplies a big decimal by 2^k, for k up to 60.
+ * Digits are produced from the last one to the first, up to 19 places
+ * after the end of the old digits, and then moved to the front.
+ */
+static void big_lshift(dec_big* b, unsigned k)
+{
+	uint64_t n = 0, quo;
+	int r, w, len, i;
+
+	w = b->nd + 19;
+	for (r = b->nd - 1; r >= 0; r--)
+	{
+		n += (uint64_t)b->d[r] << k;
+		quo = n / 10;
+		b->d[--w] = (unsigned char)(n - 10 * quo);
+		n = quo;
+	}
+
+	while (n > 0)
+	{
+		quo = n / 10;
+		b->d[--w] = (unsigned char)(n - 10 * quo);
+		n = quo;
+	}
+
+	len = b->nd + 19 - w;
+	b->dp += len - b->nd;
+	memmove(b->d, b->d + w, (size_t)len);
+
+	if (len > DEC_DIGITS)
+	{
+		for (i = DEC_DIGITS; i < len; i++)
+		{
+			if (b->d[i] != 0)
+				b->trunc = 1;
+		}
+		len = DEC_DIGITS;
+	}
+
+	b->nd = len;
+	big_trim(b);
+}
+
+/**
+ * Divides a big decimal by 2^k, for k up to 60.
+ */
+static void big_rshift(dec_big* b, unsigned k)
+{
+	uint64_t n = 0, mask, dig;
+	int r = 0, w = 0;
+
+	// Pick up enough leading digits to cover the first shift.
+	for (; (n >> k) == 0; r++)
+	{
+		if (r >= b->nd)
+		{
+			if (n == 0)
+			{
+				b->nd = 0;
+				return;
+			}
+
+			while ((n >> k) == 0)
+			{
+				n *= 10;
+				r++;
+			}
+			break;
+		}
+
+		n = n * 10 + b->d[r];
+	}
+
+	b->dp -= r - 1;
+	mask = ((uint64_t)1 << k) - 1;
+
+	// Pick up a digit, put down a digit.
+	for (; r < b->nd; r++)
+	{
+		dig = n >> k;
+		n &= mask;
+		b->d[w++] = (unsigned char)dig;
+		n = n * 10 + b->d[r];
+	}
+
+	// Put down the rest.
+	while (n > 0)
+	{
+		dig = n >> k;
+		n &= mask;
+		if (w < DEC_DIGITS)
+			b->d[w++] = (unsigned char)dig;
+		else if (dig > 0)
+			b->trunc = 1;
+		n *= 10;
+	}
+
+	b->nd = w;
+	big_trim(b);
+}
+
+/**
+ * Multiplies a big decimal by 2^k, or divides it by 2^-k.
+ */
+static void big_shift(dec_big* b, int k)
+{
+	if (b->nd == 0)
+		return;
+
+	for (; k > 60; k -= 60)
+		big_lshift(b, 60);
+	for (; k < -60; k += 60)
+		big_rshift(b, 60);
+
+	if (k > 0)
+		big_lshift(b, (unsigned)k);
+	else if (k < 0)
+		big_rshift(b, (unsigned)-k);
+}
+
+/**
+ * Rounds a big decimal to an integer, with ties to even.
+ */
+static uint64_t big_round(const dec_big* b)
+{
+	uint64_t n = 0;
+	int i, up;
+
+	if (b->dp > 20)
+		return UINT64_MAX;
+
+	for (i = 0; i < b->dp && i < b->nd; i++)
+		n = n * 10 + b->d[i];
+	for (; i < b->dp; i++)
+		n *= 10;
+
+	if (b->dp < 0 || b->dp >= b->nd)
+		up = 0;
+	else if (b->d[b->dp] == 5 && b->dp + 1 == b->nd)
+	{
+		// exactly halfway, unless digits were dropped
+		up = b->trunc || (b->dp > 0 && b->d[b->dp - 1] % 2 == 1);
+	}
+	else
+		up = b->d[b->dp] >= 5;
+
+	return n + (uint64_t)up;
+}
+
+/**
+ * Converts a decimal number to a binary floating point number exactly.
+ * All of the digits, up to 800, are kept in a big decimal, which is
+ * scaled by powers of two until its integer part holds the mantissa.
+ * This is the slow path for the cases that eisel_lemire cannot decide.
+ *
+ * Params:
+ *   const dec_parse* - the parts of the number
+ *   const flt_info* - the binary format
+ *
+ * Returns:
+ *   uint64_t - the bits of the number, without the sign
+ */
+static uint64_t dec_exact(const dec_parse* p, const flt_info* f)
+{
+	static const int powtab[9] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };
+	dec_big b;
+	const char* c;
+	int64_t dp;
+	uint64_t mant;
+	int exp, n, point;
+
+	b.nd = 0;
+	b.trunc = 0;
+	dp = 0;
+	point = 0;
+
+	for (c = p->digits; c < p->digits_end; c++)
+	{
+		if (*c == '.')
+		{
+			point = 1;
+			dp = b.nd;
+			continue;
+		}
+
+		// Leading zeros only move the point.
+		if (*c == '0' && b.nd == 0)
+		{
+			dp--;
+			continue;
+		}
+
+		if (b.nd < DEC_DIGITS)
+			b.d[b.nd++] = (unsigned char)(*c - '0');
+		else if (*c != '0')
+			b.trunc = 1;
+	}
+
+	if (!point)
+		dp = b.nd;
+	dp += p->exp_explicit;
+
+	mant = 0;
+	exp = f->bias;
+
+	if (b.nd == 0 || dp < -330)
+		goto out;
+	if (dp > 310)
+		goto overflow;
+
+	b.dp = (int)dp;
+	exp = 0;
+
+	// Scale into [0.5, 1).
+	while (b.dp > 0)
+	{
+		n = b.dp >= 9 ? 27 : powtab[b.dp];
+		big_shift(&b, -n);
+		exp += n;
+	}
+
+	while (b.dp < 0 || (b.dp == 0 && b.d[0] < 5))
+	{
+		n = -b.dp >= 9 ? 27 : powtab[-b.dp];
+		big_shift(&b, n);
+		exp -= n;
+	}
+
+	// The binary range is [1, 2).
+	exp--;
+
+	// Subnormal numbers have the smallest exponent.
+	if (exp < f->bias + 1)
+	{
+		n = f->bias + 1 - exp;
+		big_shift(&b, -n);
+		exp += n;
+	}
+
+	if (exp - f->bias >= (1 << f->exp_bits) - 1)
+		goto overflow;
+
+	big_shift(&b, (int)f->mant_bits + 1);
+	mant = big_round(&b);
+
+	// Rounding may carry into a new bit.
+	if (mant == (uint64_t)2 << f->mant_bits)
+	{
+		mant >>= 1;
+		exp++;
+		if (exp - f->bias >= (1 << f->exp_bits) - 1)
+			goto overflow;
+	}
+
+	if ((mant & ((uint64_t)1 << f->mant_bits)) == 0)
+		exp = f->bias;
+
+	goto out;
+
+overflow:
+	mant = 0;
+	exp = (1 << f->exp_bits) - 1 + f->bias;
+
+out:
+	return (mant & (((uint64_t)1 << f->mant_bits) - 1))
+		| ((uint64_t)((exp - f->bias) & ((1 << f->exp_bits) - 1)) << f->mant_bits);
+}
+
+/**
+ * Converts a parsed decimal number to a binary floating point number,
+ * correctly rounded. Small exact mantissas and powers of ten are handled
+ * with a single floating point operation, most other numbers with
+ * eisel_lemire, and the rest with dec_exact.
+ *
+ * Params:
+ *   const dec_parse* - the parts of the number
+ *   const flt_info* - the binary format
+ *
+ * Returns:
+ *   uint64_t - the bits of the number, with the sign
+ */
+static uint64_t dec_to_bits(const dec_parse* p, const flt_info* f)
+{
+	uint64_t bits, up;
+	uint64_t exp_mask = (((uint64_t)1 << f->exp_bits) - 1) << f->mant_bits;
+	uint64_t sign = (uint64_t)p->neg << (f->mant_bits + f->exp_bits);
+
+	if (p->special == 1)
+		return sign | exp_mask;
+	if (p->special == 2)
+		return sign | exp_mask | ((uint64_t)1 << (f->mant_bits - 1));
+
+	if (p->mant == 0)
+		return sign;
+
+	// Clinger's fast path, where the mantissa and the power of ten are
+	// both exact, so one operation rounds correctly.
+#if FLT_EVAL_METHOD == 0
+	if (!p->trunc && p->exp >= -22 && p->exp <= 22 && p->mant <= ((uint64_t)1 << 53)
+		&& f == &flt_double)
+	{
+		double d = (double)p->mant;
+
+		d = p->exp < 0 ? d / pow10_pos[-p->exp] : d * pow10_pos[p->exp];
+		memcpy(&bits, &d, sizeof(bits));
+
+		return sign | bits;
+	}
+
+	if (!p->trunc && p->exp >= -10 && p->exp <= 10 && p->mant <= ((uint64_t)1 << 24)
+		&& f == &flt_float)
+	{
+		float x = (float)p->mant;
+		uint32_t b32;
+
+		x = p->exp < 0 ? x / (float)pow10_pos[-p->exp] : x * (float)pow10_pos[p->exp];
+		memcpy(&b32, &x, sizeof(b32));
+
+		return sign | b32;
+	}
+#endif
+
+	// Too small to round to anything but zero, or too large for
+	// anything but infinity
+	if (p->exp < POW5_MIN_EXP)
+		return sign;
+	if (p->exp > POW5_MAX_EXP)
+		return sign | exp_mask;
+
+	// If digits were dropped, the number is between the mantissa and
+	// the next one up, and both have to round the same way.
+	if (!eisel_lemire(p->mant, p->exp, f, &bits)
+		&& (!p->trunc || (!eisel_lemire(p->mant + 1, p->exp, f, &up) && up == bits)))
+		return sign | bits;
+
+	return sign | dec_exact(p, f);
+}
+
+/**
+ * Reads a decimal floating point number with strtod's syntax.
+ *
+ * Params:
+ *   const char* - the string to read
+ *   size_t - the maximum number of characters to read
+ *   const flt_info* - the binary format
+ *   char** - receives the character after the number, or NULL
+ *
+ * Returns:
+ *   uint64_t - the bits of the number
+ */
+static uint64_t parse_float_bits(const char* str, size_t max, const flt_info* f, char** end)
+{
+	const char* s = str;
+	dec_parse p;
+	uint64_t bits, mag;
+
+	while (max > 0 && is_space(*s))
+	{
+		s++;
+		max--;
+	}
+
+	if (parse_decimal(s, max, &p))
+	{
+		if (end != NULL)
+			*end = (char*)str;
+		return 0;
+	}
+
+	if (end != NULL)
+		*end = (char*)p.end;
+
+	bits = dec_to_bits(&p, f);
+
+	// Report overflow to infinity, and underflow to a subnormal or to
+	// zero, which both have an exponent field of 0, as strtod does.
+	mag = bits & ~((uint64_t)1 << (f->mant_bits + f->exp_bits));
+	if (p.special == 0 && p.mant != 0 && (mag >> f->mant_bits == 0
+		|| mag == (((uint64_t)1 << f->exp_bits) - 1) << f->mant_bits))
+		errno = ERANGE;
+
+	return bits;
+}
+
+
+/**
+ * The formatted output of a chunk of records.
+ */
+typedef struct rec_piece {
+	size_t lo;              // first record
+	size_t hi;              // record after the last one
+	char* buf;              // formatted characters
+	size_t cap;             // capacity of the buffer
+	size_t len;             // number of characters
+	int err;                // a record could not be formatted
+	struct rec_piece* next; // next piece in a list
+}rec_piece;
+
+/**
+ * Makes room in a sink that writes into a rec_piece by doubling the size
+ * of its buffer.
+ *
+ * Params:
+ *   my_sink* - a sink with a rec_piece* as its data
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if no memory could be allocated
+ */
+static int piece_flush(my_sink* sink)
+{
+	rec_piece* p = sink->data;
+	char* buf;
+
+	buf = realloc(p->buf, p->cap * 2);
+	if (buf == NULL)
+		return 1;
+
+	p->buf = buf;
+	p->cap *= 2;
+	sink->buf = buf;
+	sink->size = p->cap;
+
+	return 0;
+}
+
+/**
+ * The shared state of a call to my_format_records.
+ */
+typedef struct rec_job {
+	my_sink* sink;        // output, only used by the thread that writes
+	const char* fmt;      // format string for each record
+	const char* recs;     // first record
+	size_t rec_size;      // size of a record
+	my_record_fn fn;      // formats one record
+	struct rec_worker* workers;
+	size_t n_workers;
+#ifdef MY_PRINTF_POSIX
+	pthread_mutex_t lock; // protects everything below
+#endif
+	rec_piece* pending;   // finished pieces that are not written yet, in order
+	rec_piece* free;      // pieces that can be reused
+	size_t next;          // first record that is not written yet
+	int writing;          // a thread is writing to the sink
+	int err;              // a record could not be formatted
+}rec_job;
+
+/**
+ * A worker of a call to my_format_records.
+ * Each worker owns a range of records and formats them from the front, a
+ * chunk at a time. A worker that runs out steals the back half of the
+ * range of another worker.
+ */
+typedef struct rec_worker {
+	rec_job* job;
+	size_t lo;             // first record of the range
+	size_t hi;             // record after the range
+	size_t chunk;          // records in the next chunk
+#ifdef MY_PRINTF_POSIX
+	pthread_mutex_t lock;  // protects lo and hi
+	pthread_t thread;
+#endif
+}rec_worker;
+
+/**
+ * Takes a chunk of records from the front of a worker's range, or steals
+ * half of the range of another worker when the range is empty.
+ *
+ * Params:
+ *   rec_worker* - a worker
+ *   size_t* - receives the first record of the chunk
+ *   size_t* - receives the record after the chunk
+ *
+ * Returns:
+ *   int - 1 if a chunk was taken, or 0 if there are no records left
+ */
+static int rec_take(rec_worker* w, size_t* lo, size_t* hi)
+{
+	rec_job* job = w->job;
+	rec_worker* v;
+	size_t i, mid, end;
+
+	for (;;)
+	{
+#ifdef MY_PRINTF_POSIX
+		pthread_mutex_lock(&w->lock);
+#endif
+		if (w->lo < w->hi)
+		{
+			*lo = w->lo;
+			*hi = w->hi - w->lo > w->chunk ? w->lo + w->chunk : w->hi;
+			w->lo = *hi;
+#ifdef MY_PRINTF_POSIX
+			pthread_mutex_unlock(&w->lock);
+#endif
+			return 1;
+		}
+#ifdef MY_PRINTF_POSIX
+		pthread_mutex_unlock(&w->lock);
+#endif
+
+		// Steal the back half of the first range that has records left,
+		// starting from the next worker.
+		for (i = 1; i < job->n_workers; i++)
+		{
+			v = &job->workers[(w - job->workers + i) % job->n_workers];
+
+#ifdef MY_PRINTF_POSIX
+			pthread_mutex_lock(&v->lock);
+#endif
+			mid = v->lo + (v->hi - v->lo) / 2;
+			end = v->hi;
+			v->hi = mid;
+#ifdef MY_PRINTF_POSIX
+			pthread_mutex_unlock(&v->lock);
+#endif
+
+			if (mid < end)
+			{
+				// Only one lock is held at a time, so workers that
+				// steal from each other cannot deadlock.
+#ifdef MY_PRINTF_POSIX
+				pthread_mutex_lock(&w->lock);
+#endif
+				w->lo = mid;
+				w->hi = end;
+#ifdef MY_PRINTF_POSIX
+				pthread_mutex_unlock(&w->lock);
+#endif
+				break;
+			}
+		}
+
+		if (i == job->n_workers)
+			return 0;
+	}
+}
+
+/**
+ * Hands the output of a chunk to the job, and writes every piece that is
+ * next in order to the sink, unless another thread is already doing so.
+ * Only one thread writes to the sink at a time, and the lock is not held
+ * while it writes.
+ *
+ * Params:
+ *   rec_job* - the job
+ *   rec_piece* - a finished piece
+ */
+static void rec_put(rec_job* job, rec_piece* p)
+{
+	rec_piece** link;
+
+#ifdef MY_PRINTF_POSIX
+	pthread_mutex_lock(&job->lock);
+#endif
+
+	// Keep the pending pieces in the order of their records.
+	for (link = &job->pending; *link != NULL && (*link)->lo < p->lo;
+		link = &(*link)->next);
+	p->next = *link;
+	*link = p;
+
+	if (p->err)
+		job->err = 1;
+
+	if (!job->writing && !job->err)
+	{
+		job->writing = 1;
+
+		while (job->pending != NULL && job->pending->lo == job->next)
+		{
+			p = job->pending;
+			job->pending = p->next;
+			job->next = p->hi;
+
+#ifdef MY_PRINTF_POSIX
+			pthread_mutex_unlock(&job->lock);
+#endif
+			sink_write(job->sink, p->buf, p->len);
+#ifdef MY_PRINTF_POSIX
+			pthread_mutex_lock(&job->lock);
+#endif
+
+			p->next = job->free;
+			job->free = p;
+		}
+
+		job->writing = 0;
+	}
+
+#ifdef MY_PRINTF_POSIX
+	pthread_mutex_unlock(&job->lock);
+#endif
+}
+
+/**
+ * Gets a piece with an empty buffer, reusing one that was already written
+ * if there is one.
+ *
+ * Params:
+ *   rec_job* - the job
+ *
+ * Returns:
+ *   rec_piece* - a piece, or NULL if the job failed or no memory could be
+ *     allocated
+ */
+static rec_piece* rec_piece_get(rec_job* job)
+{
+	rec_piece* p;
+	int err;
+
+#ifdef MY_PRINTF_POSIX
+	pthread_mutex_lock(&job->lock);
+#endif
+	err = job->err;
+	p = err ? NULL : job->free;
+	if (p != NULL)
+		job->free = p->next;
+#ifdef MY_PRINTF_POSIX
+	pthread_mutex_unlock(&job->lock);
+#endif
+
+	if (p == NULL && !err)
+	{
+		p = malloc(sizeof(rec_piece));
+		if (p != NULL)
+		{
+			p->cap = REC_PIECE_BUF;
+			p->buf = malloc(p->cap);
+			if (p->buf == NULL)
+			{
+				free(p);
+				p = NULL;
+			}
+		}
+
+		if (p == NULL)
+		{
+#ifdef MY_PRINTF_POSIX
+			pthread_mutex_lock(&job->lock);
+#endif
+			job->err = 1;
+#ifdef MY_PRINTF_POSIX
+			pthread_mutex_unlock(&job->lock);
+#endif
+		}
+	}
+
+	return p;
+}
+
+/**
+ * Gets the current time in nanoseconds, for sizing chunks.
+ */
+static uint64_t rec_clock(void)
+{
+#ifdef MY_PRINTF_POSIX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Formats chunks of records until there are none left.
+ * The size of each chunk is picked from the time the last one took, so
+ * that a chunk takes about REC_CHUNK_NS whatever the cost of a record.
+ *
+ * Params:
+ *   void* - a rec_worker
+ */
+static void* rec_run(void* arg)
+{
+	rec_worker* w = arg;
+	rec_job* job = w->job;
+	rec_piece* p;
+	my_sink sink;
+	size_t lo, hi, i;
+	uint64_t start, ns;
+
+	while (rec_take(w, &lo, &hi))
+	{
+		p = rec_piece_get(job);
+		if (p == NULL)
+			break;
+
+		p->lo = lo;
+		p->hi = hi;
+
+		sink_init(&sink, p->buf, p->cap, piece_flush, p);
+		start = rec_clock();
+
+		for (i = lo; i < hi; i++)
+		{
+			if (job->fn(&sink, job->fmt, job->recs + i * job->rec_size) < 0)
+				sink.err = 1;
+		}
+
+		ns = rec_clock() - start;
+		if (ns > 0)
+		{
+			w->chunk = (size_t)((uint64_t)(hi - lo) * REC_CHUNK_NS / ns);
+			if (w->chunk < 1)
+				w->chunk = 1;
+		}
+		else
+			w->chunk *= 2;
+
+		// The buffer may have moved while it grew, so only the length
+		// is taken from the sink.
+		p->len = sink.pos;
+		p->err = sink.err;
+
+		rec_put(job, p);
+	}
+
+	return NULL;
+}
+
+/**
+ * A compiled format string.
+ * When the format could be compiled, code points to machine code that
+ * formats the arguments of a va_list into a sink. Otherwise, it is NULL,
+ * and the format string is interpreted by my_vformat.
+ */
+struct my_jit {
+	void (*code)(my_sink* sink, void* argp); // compiled code, or NULL
+	size_t code_size;                        // size of the code mapping
+	char* fmt;                               // the format string
+	char* lits;                              // literal characters of the code
+	ftag* tags;                              // format tags of the code
+};
+
+#ifdef MY_PRINTF_JIT
+
+/**
+ * A growing buffer of machine code.
+ */
+typedef struct jit_buf {
+	unsigned char* p; // code
+	size_t len;       // number of bytes
+	size_t cap;       // capacity
+	int err;          // no memory could be allocated
+}jit_buf;
+
+/**
+ * Appends bytes to a code buffer.
+ *
+ * Params:
+ *   jit_buf* - a code buffer
+ *   const void* - the bytes
+ *   size_t - the number of bytes
+ */
+static void jit_emit(jit_buf* b, const void* bytes, size_t n)
+{
+	unsigned char* p;
+
+	if (b->len + n > b->cap)
+	{
+		p = realloc(b->p, (b->len + n) * 2);
+		if (p == NULL)
+		{
+			b->err = 1;
+			return;
+		}
+
+		b->p = p;
+		b->cap = (b->len + n) * 2;
+	}
+
+	memcpy(b->p + b->len, bytes, n);
+	b->len += n;
+}
+
+static void jit_u8(jit_buf* b, uint8_t v)
+{
+	jit_emit(b, &v, 1);
+}
+
+static void jit_u32(jit_buf* b, uint32_t v)
+{
+	unsigned char le[4] = {
+		(unsigned char)v, (unsigned char)(v >> 8),
+		(unsigned char)(v >> 16), (unsigned char)(v >> 24)
+	};
+
+	jit_emit(b, le, 4);
+}
+
+static void jit_u64(jit_buf* b, uint64_t v)
+{
+	jit_u32(b, (uint32_t)v);
+	jit_u32(b, (uint32_t)(v >> 32));
+}
+
+/**
+ * Emits a call to a function, with the sink as its first argument.
+ * The address is loaded as an immediate, since the code can be mapped
+ * anywhere relative to the library.
+ *
+ * Params:
+ *   jit_buf* - a code buffer
+ *   void (*)(void) - the function
+ */
+static void jit_call(jit_buf* b, void (*fn)(void))
+{
+	// mov rdi, rbx
+	jit_emit(b, "\x48\x89\xDF", 3);
+	// mov rax, fn; call rax
+	jit_emit(b, "\x48\xB8", 2);
+	jit_u64(b, (uint64_t)(uintptr_t)fn);
+	jit_emit(b, "\xFF\xD0", 2);
+}
+
+/**
+ * Emits the code of va_arg for an integer or pointer, which leaves the
+ * argument in rsi.
+ * The va_list is read as the x86-64 System V ABI lays it out, with r12
+ * pointing to it: the offset of the next integer register at 0, the
+ * offset of the next vector register at 4, the arguments on the stack at
+ * 8, and the saved registers at 16.
+ */
+static void jit_arg_gp(jit_buf* b)
+{
+	static const unsigned char code[] = {
+		0x41, 0x8B, 0x04, 0x24,             // mov eax, [r12]
+		0x83, 0xF8, 0x30,                   // cmp eax, 48
+		0x73, 0x12,                         // jae stack
+		0x49, 0x8B, 0x74, 0x24, 0x10,       // mov rsi, [r12 + 16]
+		0x48, 0x8B, 0x34, 0x06,             // mov rsi, [rsi + rax]
+		0x83, 0xC0, 0x08,                   // add eax, 8
+		0x41, 0x89, 0x04, 0x24,             // mov [r12], eax
+		0xEB, 0x11,                         // jmp done
+		0x49, 0x8B, 0x44, 0x24, 0x08,       // stack: mov rax, [r12 + 8]
+		0x48, 0x8B, 0x30,                   // mov rsi, [rax]
+		0x48, 0x83, 0xC0, 0x08,             // add rax, 8
+		0x49, 0x89, 0x44, 0x24, 0x08        // mov [r12 + 8], rax
+	};                                      // done:
+
+	jit_emit(b, code, sizeof(code));
+}
+
+/**
+ * Emits the code of va_arg for a double, which leaves the argument in
+ * xmm0. See jit_arg_gp.
+ */
+static void jit_arg_fp(jit_buf* b)
+{
+	static const unsigned char code[] = {
+		0x41, 0x8B, 0x44, 0x24, 0x04,       // mov eax, [r12 + 4]
+		0x3D, 0xB0, 0x00, 0x00, 0x00,       // cmp eax, 176
+		0x73, 0x14,                         // jae stack
+		0x49, 0x8B, 0x4C, 0x24, 0x10,       // mov rcx, [r12 + 16]
+		0xF2, 0x0F, 0x10, 0x04, 0x01,       // movsd xmm0, [rcx + rax]
+		0x83, 0xC0, 0x10,                   // add eax, 16
+		0x41, 0x89, 0x44, 0x24, 0x04,       // mov [r12 + 4], eax
+		0xEB, 0x12,                         // jmp done
+		0x49, 0x8B, 0x44, 0x24, 0x08,       // stack: mov rax, [r12 + 8]
+		0xF2, 0x0F, 0x10, 0x00,             // movsd xmm0, [rax]
+		0x48, 0x83, 0xC0, 0x08,             // add rax, 8
+		0x49, 0x89, 0x44, 0x24, 0x08        // mov [r12 + 8], rax
+	};                                      // done:
+
+	jit_emit(b, code, sizeof(code));
+}
+
+/**
+ * Emits the code that writes a run of literal characters.
+ * Short runs are stored into the buffer of the sink as immediates, after
+ * a single check that there is room for all of them. Long runs, and runs
+ * that do not fit, are passed to sink_write.
+ *
+ * Params:
+ *   jit_buf* - a code buffer
+ *   const char* - the characters, which must outlive the code
+ *   size_t - the number of characters
+ */
+static void jit_literal(jit_buf* b, const char* lit, size_t len)
+{
+	size_t slow = 0, done = 0, k, n;
+	uint64_t v;
+	int32_t rel;
+
+	if (len == 0)
+		return;
+
+	if (len <= JIT_LIT_MAX)
+	{
+		// mov rax, [rbx + pos]; mov rcx, [rbx + size]
+		jit_emit(b, "\x48\x8B\x43", 3);
+		jit_u8(b, offsetof(my_sink, pos));
+		jit_emit(b, "\x48\x8B\x4B", 3);
+		jit_u8(b, offsetof(my_sink, size));
+		// sub rcx, rax; cmp rcx, len; jb slow
+		jit_emit(b, "\x48\x29\xC1\x48\x83\xF9", 6);
+		jit_u8(b, (uint8_t)len);
+		jit_emit(b, "\x0F\x82", 2);
+		slow = b->len;
+		jit_u32(b, 0);
+		// add rax, [rbx + buf]
+		jit_emit(b, "\x48\x03\x43", 3);
+		jit_u8(b, offsetof(my_sink, buf));
+
+		for (k = 0; k < len; k += n)
+		{
+			n = len - k >= 8 ? 8 : len - k >= 4 ? 4 : len - k >= 2 ? 2 : 1;
+			v = 0;
+			memcpy(&v, lit + k, n);
+
+			if (n == 8)
+			{
+				// mov rcx, v; mov [rax + k], rcx
+				jit_emit(b, "\x48\xB9", 2);
+				jit_u64(b, v);
+				jit_emit(b, "\x48\x89\x48", 3);
+			}
+			else if (n == 4)
+				jit_emit(b, "\xC7\x40", 2);     // mov dword [rax + k], v
+			else if (n == 2)
+				jit_emit(b, "\x66\xC7\x40", 3); // mov word [rax + k], v
+			else
+				jit_emit(b, "\xC6\x40", 2);     // mov byte [rax + k], v
+
+			jit_u8(b, (uint8_t)k);
+			if (n < 8)
+				jit_emit(b, &v, n);
+		}
+
+		// add qword [rbx + pos], len; add qword [rbx + count], len
+		jit_emit(b, "\x48\x83\x43", 3);
+		jit_u8(b, offsetof(my_sink, pos));
+		jit_u8(b, (uint8_t)len);
+		jit_emit(b, "\x48\x83\x43", 3);
+		jit_u8(b, offsetof(my_sink, count));
+		jit_u8(b, (uint8_t)len);
+		// jmp done
+		jit_u8(b, 0xE9);
+		done = b->len;
+		jit_u32(b, 0);
+
+		if (!b->err)
+		{
+			rel = (int32_t)(b->len - (slow + 4));
+			memcpy(b->p + slow, &rel, 4);
+		}
+	}
+
+	// mov rsi, lit; mov edx, len; call sink_write
+	jit_emit(b, "\x48\xBE", 2);
+	jit_u64(b, (uint64_t)(uintptr_t)lit);
+	jit_u8(b, 0xBA);
+	jit_u32(b, (uint32_t)len);
+	jit_call(b, (void (*)(void))sink_write);
+
+	if (done && !b->err)
+	{
+		rel = (int32_t)(b->len - (done + 4));
+		memcpy(b->p + done, &rel, 4);
+	}
+}
+
+/**
+ * Compiles a format string into machine code.
+ * The code is built in ordinary memory, then copied to a mapping that is
+ * only made executable once it is no longer writable.
+ * Formats with conversions that the code cannot do are left to the
+ * interpreter.
+ *
+ * Params:
+ *   my_jit* - a compiled format with its format string set
+ *
+ * Returns:
+ *   int - 0 on success, or 1 if the format is left to the interpreter
+ */
+static int jit_build(my_jit* jit)
+{
+	jit_buf b = { NULL, 0, 0, 0 };
+	const char* fmt = jit->fmt;
+	char* lit;            // start of the pending run of literal characters
+	char* lits;           // end of the literal characters
+	char* end;
+	ftag t;
+	size_t n_tags;
+	void (*kernel)(void);
+	void* map;
+	int fp;
+
+	n_tags = 0;
+	for (end = jit->fmt; *end != '\0'; end++)
+		n_tags += *end == '%';
+
+	jit->lits = malloc(strlen(fmt) + 1);
+	jit->tags = malloc((n_tags + 1) * sizeof(ftag));
+	if (jit->lits == NULL || jit->tags == NULL)
+		return 1;
+
+	// push rbx; push r12; sub rsp, 8; mov rbx, rdi; mov r12, rsi
+	jit_emit(&b, "\x53\x41\x54\x48\x83\xEC\x08\x48\x89\xFB\x49\x89\xF4", 13);
+
+	lit = lits = jit->lits;
+	n_tags = 0;
+	while (*fmt != '\0')
+	{
+		if (*fmt != '%')
+		{
+			*lits++ = *fmt++;
+			continue;
+		}
+
+		t = parse_format(fmt + 1, &end);
+		if (t.spec == SPEC_per)
+		{
+			*lits++ = '%';
+			fmt = end + 1;
+			continue;
+		}
+
+		// Arguments for the width or precision, wide characters and
+		// strings, and the less common conversions are left to the
+		// interpreter.
+		fp = 0;
+		kernel = NULL;
+		if (!(t.flags & (FMT_WIDTH | FMT_PREC)) && *end != '\0')
+		{
+			switch (t.spec)
+			{
+			case SPEC_c:
+				if (!(t.len & (LEN_l | LEN_W | LEN_U)))
+					kernel = (void (*)(void))my_conv_c;
+				break;
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_STR
+			case SPEC_s:
+				if (!(t.len & (LEN_l | LEN_W | LEN_U)))
+					kernel = (void (*)(void))my_conv_s;
+				break;
+#endif
+			case SPEC_d:
+			case SPEC_i: kernel = (void (*)(void))my_conv_d; break;
+			case SPEC_u: kernel = (void (*)(void))my_conv_u; break;
+			case SPEC_x: kernel = (void (*)(void))my_conv_x; break;
+			case SPEC_X: kernel = (void (*)(void))my_conv_X; break;
+			case SPEC_o: kernel = (void (*)(void))my_conv_o; break;
+			case SPEC_p: kernel = (void (*)(void))my_conv_p; break;
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+			case SPEC_f: kernel = (void (*)(void))my_conv_f; fp = 1; break;
+			case SPEC_e:
+			case SPEC_E: kernel = (void (*)(void))my_conv_e; fp = 2; break;
+			case SPEC_a:
+			case SPEC_A: kernel = (void (*)(void))my_conv_a; fp = 2; break;
+#endif
+			default: break;
+			}
+
+			// long double and __float128 aren't passed in SSE registers
+			if (fp && (t.len & (LEN_L | LEN_Q)))
+				kernel = NULL;
+		}
+
+		if (kernel == NULL)
+		{
+			free(b.p);
+			return 1;
+		}
+
+		jit_literal(&b, lit, (size_t)(lits - lit));
+		lit = lits;
+
+		if (fp)
+		{
+			jit_arg_fp(&b);
+			if (fp == 2)
+			{
+				// mov rsi, tag
+				jit->tags[n_tags] = t;
+				jit_emit(&b, "\x48\xBE", 2);
+				jit_u64(&b, (uint64_t)(uintptr_t)&jit->tags[n_tags++]);
+			}
+		}
+		else
+			jit_arg_gp(&b);
+
+		jit_call(&b, kernel);
+
+		fmt = end + 1;
+	}
+
+	jit_literal(&b, lit, (size_t)(lits - lit));
+
+	// add rsp, 8; pop r12; pop rbx; ret
+	jit_emit(&b, "\x48\x83\xC4\x08\x41\x5C\x5B\xC3", 8);
+
+	if (b.err)
+	{
+		free(b.p);
+		return 1;
+	}
+
+	// W^X: the mapping is never writable and executable at once.
+	map = mmap(NULL, b.len, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (map == MAP_FAILED)
+	{
+		free(b.p);
+		return 1;
+	}
+
+	memcpy(map, b.p, b.len);
+	free(b.p);
+
+	if (mprotect(map, b.len, PROT_READ | PROT_EXEC))
+	{
+		munmap(map, b.len);
+		return 1;
+	}
+
+	jit->code = (void (*)(my_sink*, void*))map;
+	jit->code_size = b.len;
+
+	return 0;
+}
+
+#endif
+
+//--------------------------------------------------------------------------//
+//                               Public API                                 //
+//--------------------------------------------------------------------------//
+
+int my_putc(int c, FILE* stream)
+{
+	return fputc(c, stream);
+}
+
+int my_fputc(int c, FILE* stream)
+{
+	return fputc(c, stream);
+}
+
+int my_putchar(int c)
+{
+	return my_fputc(c, my_get_stdout());
+}
+
+int my_vformat(my_sink* sink, const char* fmt, va_list args)
+{
+	size_t i, j;       // index
+	char* end;         // updated character pointer
+	const char* lit;   // start of a run of literal characters
+	char buf[100];     // string conversion buffer
+	size_t len;        // string length
+	size_t start;      // character count of the sink before formatting
+	va_list argp;      // arguments, as a variable that custom specifiers
+	                   // can be given a pointer to
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+	my_spec_fn fn;     // function of a custom specifier
+#endif
+	int err;
+	STATS_GET(stats);  // statistics counters of this thread
+
+	i = j = 0;
+	err = 0;
+	start = sink->count;
+	va_copy(argp, args);
+
+	while (*fmt != '\0' && !err)
+	{
+		if (*fmt == '%')
+		{
+			fmt++;
+			ftag t = parse_format(fmt, &end);
+			fmt = end;
+			tag_args(t, argp);
+
+			// Named specifiers are all counted under '{'.
+			STAT_ADD_TO(stats, STAT_SPEC + (t.spec & SPEC_NAMED ? '{' : t.spec), 1);
+
+			if (t.spec == SPEC_c && !(t.len & (LEN_l | LEN_W | LEN_U)))
+			{
+				char c = va_arg(argp, int);
+				sink_putc(sink, c);
+			}
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if (t.spec == SPEC_c)
+			{
+				// wint_t and char16_t are promoted, so all wide
+				// characters are read as unsigned int.
+				uint32_t c = va_arg(argp, unsigned int);
+				if (t.len & LEN_W)
+					c &= 0xFFFF;
+				sink_putcp(sink, c);
+			}
+			else if (t.spec == SPEC_s && (t.len & LEN_W))
+			{
+				sink_utf16(sink, va_arg(argp, const uint16_t*));
+			}
+			else if (t.spec == SPEC_s && (t.len & LEN_U))
+			{
+				sink_utf32(sink, va_arg(argp, const uint32_t*));
+			}
+			else if (t.spec == SPEC_s && (t.len & LEN_l))
+			{
+				sink_wcs(sink, va_arg(argp, const wchar_t*));
+			}
+#endif
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_STR
+			else if (t.spec == SPEC_s && !(t.len & (LEN_l | LEN_W | LEN_U)))
+			{
+				char* s = va_arg(argp, char*);
+				sink_write(sink, s, strlen(s));
+			}
+#endif
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if (t.spec == SPEC_J)
+			{
+				sink_json(sink, va_arg(argp, char*),
+					t.flags & FMT_ZPREC ? t.prec : SIZE_MAX,
+					t.flags & FMT_POINT);
+			}
+			else if (t.spec == SPEC_k)
+			{
+				sink_fixed(sink, va_arg(argp, int64_t), &t);
+			}
+#endif
+			else if (t.spec == SPEC_d || t.spec == SPEC_i)
+			{
+				int n = va_arg(argp, int);
+				len = int_to_str(n, buf, 10, 0, 1);
+
+				for (i = 0; i < len; i++)
+				{
+					sink_putc(sink, buf[i]);
+				}
+			}
+			else if (t.spec == SPEC_u)
+			{
+				unsigned int n = va_arg(argp, unsigned int);
+				len = int_to_str(n, buf, 10, 0, 0);
+
+				for (i = 0; i < len; i++)
+				{
+					sink_putc(sink, buf[i]);
+				}
+			}
+			else if (t.spec == SPEC_X || t.spec == SPEC_x)
+			{
+				int n = va_arg(argp, int);
+				int cap = t.spec == SPEC_X ? 1 : 0;
+				len = int_to_str(n, buf, 16, cap, 0);
+
+				for (i = 0; i < len; i++)
+				{
+					sink_putc(sink, buf[i]);
+				}
+			}
+			else if (t.spec == SPEC_o)
+			{
+				int n = va_arg(argp, int);
+				len = int_to_str(n, buf, 8, 0, 1);
+
+				for (i = 0; i < len; i++)
+				{
+					sink_putc(sink, buf[i]);
+				}
+			}
+			else if (t.spec == SPEC_p)
+			{
+				uintptr_t n = va_arg(argp, uintptr_t);
+				len = uintptr_to_str(n, buf, 1);
+				size_t plen = sizeof(uintptr_t) * 2;
+
+				if (len < plen)
+				{
+					for (i = 0; i < plen - len; i++)
+					{
+						sink_putc(sink, '0');
+					}
+				}
+				for (i = 0; i < len; i++)
+				{
+					sink_putc(sink, buf[i]);
+				}
+			}
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+			else if ((t.len & (LEN_L | LEN_Q)) && (t.spec == SPEC_f
+				|| t.spec == SPEC_E || t.spec == SPEC_e))
+			{
+				ieee_754_wide c;
+
+				err = va_wide(&argp, t.len, &c);
+				if (!err && sink_wide(sink, &c, &t))
+				{
+					STAT_ADD_TO(stats, STAT_FLOAT_EXACT, 1);
+				}
+				else if (!err)
+				{
+					STAT_ADD_TO(stats, STAT_FLOAT_FAST, 1);
+				}
+			}
+			else if ((t.len & (LEN_L | LEN_Q)) && (t.spec == SPEC_G
+				|| t.spec == SPEC_g || t.spec == SPEC_A || t.spec == SPEC_a))
+			{
+				// g is not implemented, and a has no long double form
+				ieee_754_wide c;
+
+				err = va_wide(&argp, t.len, &c) || t.spec == SPEC_A
+					|| t.spec == SPEC_a;
+			}
+			else if (t.spec == SPEC_f)
+			{
+				// Doubles are always converted with the limb tables.
+				sink_f(sink, va_arg(argp, double));
+				STAT_ADD_TO(stats, STAT_FLOAT_FAST, 1);
+			}
+			else if (t.spec == SPEC_E || t.spec == SPEC_e)
+			{
+				sink_e(sink, va_arg(argp, double), t);
+				STAT_ADD_TO(stats, STAT_FLOAT_FAST, 1);
+			}
+			else if (t.spec == SPEC_G || t.spec == SPEC_g)
+			{
+				// not implemented
+				va_arg(argp, double);
+			}
+			else if (t.spec == SPEC_A || t.spec == SPEC_a)
+			{
+				sink_hexf(sink, va_arg(argp, double), &t);
+				STAT_ADD_TO(stats, STAT_FLOAT_FAST, 1);
+			}
+#endif
+			else if (t.spec == SPEC_n)
+			{
+				// Nothing is printed, the character count is stored instead.
+				int* n = va_arg(argp, int*);
+				*n = (int)(sink->count - start);
+			}
+#if defined(MY_PRINTF_POSIX) && MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if (t.spec == SPEC_T)
+			{
+				const struct timespec* ts = t.flags & FMT_POINT
+					? va_arg(argp, const struct timespec*)
+					: NULL;
+
+				len = ts_format(buf, &t, ts);
+				if (len == 0)
+					err = 1;
+				sink_write(sink, buf, len);
+			}
+#endif
+			else if (t.spec == SPEC_per)
+			{
+				sink_putc(sink, '%');
+			}
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if ((fn = spec_fn((unsigned char)t.spec)) != NULL)
+			{
+				if (fn(sink, &t, &argp))
+					err = 1;
+			}
+#endif
+			else
+			{
+				// invalid specifier
+				err = 1;
+			}
+		}
+		else
+		{
+			// Write the literal characters up to the next format tag.
+			for (lit = fmt; *fmt != '\0' && *fmt != '%'; fmt++);
+			sink_write(sink, lit, fmt - lit);
+			continue;
+		}
+
+		// Move past the specifier, unless the format string ended
+		// in the middle of a format tag.
+		if (*fmt != '\0')
+			fmt++;
+	}
+
+	va_end(argp);
+
+	STAT_ADD_TO(stats, STAT_CALLS, 1);
+	STAT_ADD_TO(stats, STAT_BYTES, sink->count - start);
+
+	if (err || sink->err)
+		return -1;
+
+	return (int)sink->count;
+}
+
+int my_format(my_sink* sink, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vformat(sink, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_format_records(my_sink* sink,
+	const char* fmt,
+	const void* recs,
+	size_t n,
+	size_t rec_size,
+	my_record_fn fn,
+	int threads)
+{
+	rec_job job;
+	rec_worker* workers;
+	rec_piece* p;
+	size_t n_workers, i;
+
+#ifdef MY_PRINTF_POSIX
+	if (threads <= 0)
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	n_workers = threads > 0 ? (size_t)threads : 1;
+
+	// Do not start workers that would not get a first chunk.
+	if (n_workers > n / REC_CHUNK_MIN)
+		n_workers = n / REC_CHUNK_MIN > 0 ? n / REC_CHUNK_MIN : 1;
+
+#ifndef MY_PRINTF_POSIX
+	n_workers = 1;
+#endif
+
+	workers = malloc(n_workers * sizeof(rec_worker));
+	if (workers == NULL)
+		return -1;
+
+	job.sink = sink;
+	job.fmt = fmt;
+	job.recs = recs;
+	job.rec_size = rec_size;
+	job.fn = fn;
+	job.workers = workers;
+	job.n_workers = n_workers;
+	job.pending = NULL;
+	job.free = NULL;
+	job.next = 0;
+	job.writing = 0;
+	job.err = 0;
+
+	// Each worker starts with an equal share of the records.
+	for (i = 0; i < n_workers; i++)
+	{
+		workers[i].job = &job;
+		workers[i].lo = n / n_workers * i;
+		workers[i].hi = i + 1 < n_workers ? n / n_workers * (i + 1) : n;
+		workers[i].chunk = REC_CHUNK_MIN;
+	}
+
+#ifdef MY_PRINTF_POSIX
+	pthread_mutex_init(&job.lock, NULL);
+	for (i = 0; i < n_workers; i++)
+		pthread_mutex_init(&workers[i].lock, NULL);
+
+	// The calling thread is the first worker. If a thread cannot be
+	// started, its records are stolen by the others.
+	workers[0].thread = pthread_self();
+	for (i = 1; i < n_workers; i++)
+	{
+		if (pthread_create(&workers[i].thread, NULL, rec_run, &workers[i]))
+			workers[i].thread = workers[0].thread;
+	}
+#endif
+
+	rec_run(&workers[0]);
+
+#ifdef MY_PRINTF_POSIX
+	for (i = 1; i < n_workers; i++)
+	{
+		if (!pthread_equal(workers[i].thread, workers[0].thread))
+			pthread_join(workers[i].thread, NULL);
+	}
+
+	for (i = 0; i < n_workers; i++)
+		pthread_mutex_destroy(&workers[i].lock);
+	pthread_mutex_destroy(&job.lock);
+#endif
+
+	// Pieces are only left pending after a failure.
+	while (job.pending != NULL || job.free != NULL)
+	{
+		p = job.pending != NULL ? job.pending : job.free;
+		if (p == job.pending)
+			job.pending = p->next;
+		else
+			job.free = p->next;
+
+		free(p->buf);
+		free(p);
+	}
+
+	free(workers);
+
+	if (job.err || sink->err)
+		return -1;
+
+	return 0;
+}
+
+my_jit* my_jit_compile(const char* fmt)
+{
+	my_jit* jit;
+	size_t len;
+
+	jit = malloc(sizeof(my_jit));
+	if (jit == NULL)
+		return NULL;
+
+	len = strlen(fmt);
+	jit->code = NULL;
+	jit->code_size = 0;
+	jit->lits = NULL;
+	jit->tags = NULL;
+	jit->fmt = malloc(len + 1);
+	if (jit->fmt == NULL)
+	{
+		free(jit);
+		return NULL;
+	}
+	memcpy(jit->fmt, fmt, len + 1);
+
+#ifdef MY_PRINTF_JIT
+	if (jit_build(jit))
+	{
+		free(jit->lits);
+		free(jit->tags);
+		jit->lits = NULL;
+		jit->tags = NULL;
+	}
+#endif
+
+	return jit;
+}
+
+int my_jit_native(const my_jit* jit)
+{
+	return jit->code != NULL;
+}
+
+void my_jit_free(my_jit* jit)
+{
+	if (jit == NULL)
+		return;
+
+#ifdef MY_PRINTF_JIT
+	if (jit->code != NULL)
+		munmap((void*)jit->code, jit->code_size);
+#endif
+
+	free(jit->fmt);
+	free(jit->lits);
+	free(jit->tags);
+	free(jit);
+}
+
+int my_jit_vformat(my_sink* sink, const my_jit* jit, va_list args)
+{
+#ifdef MY_PRINTF_JIT
+	va_list argp;  // arguments, read by the code in place
+#ifdef MY_PRINTF_STATS
+	size_t start = sink->count;
+#endif
+
+	if (jit->code != NULL)
+	{
+		va_copy(argp, args);
+		jit->code(sink, argp);
+		va_end(argp);
+
+		STAT_ADD(STAT_CALLS, 1);
+		STAT_ADD(STAT_BYTES, sink->count - start);
+
+		return sink->err ? -1 : (int)sink->count;
+	}
+#endif
+
+	return my_vformat(sink, jit->fmt, args);
+}
+
+int my_jit_format(my_sink* sink, const my_jit* jit, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, jit);
+	res = my_jit_vformat(sink, jit, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_jit_vfprintf(FILE* stream, const my_jit* jit, va_list argp)
+{
+	my_sink sink;
+	char buf[MY_SINK_BUF]; // output buffer
+	int res;
+
+	sink_init(&sink, buf, sizeof(buf), file_flush, stream);
+
+	res = my_jit_vformat(&sink, jit, argp);
+
+	// Write whatever is left in the buffer.
+	if (sink_flush(&sink) || res < 0)
+		return -1;
+
+	return res;
+}
+
+int my_jit_vsnprintf(char* str, size_t size, const my_jit* jit, va_list argp)
+{
+	str_sink ss;
+	int res;
+
+	// Keep one character for the NUL terminator.
+	sink_init(&ss.sink, str, size > 0 ? size - 1 : 0, str_flush, NULL);
+	ss.end = NULL;
+
+	res = my_jit_vformat(&ss.sink, jit, argp);
+
+	if (size > 0)
+	{
+		if (ss.end == NULL)
+			ss.end = str + ss.sink.pos;
+
+		*ss.end = '\0';
+	}
+
+	return res;
+}
+
+int my_jit_snprintf(char* str, size_t size, const my_jit* jit, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, jit);
+	res = my_jit_vsnprintf(str, size, jit, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_fn_vformat(my_sink* sink, my_format_fn fn, va_list args)
+{
+	va_list argp;  // arguments, read by the function
+#ifdef MY_PRINTF_STATS
+	size_t start = sink->count;
+#endif
+
+	va_copy(argp, args);
+	fn(sink, argp);
+	va_end(argp);
+
+	STAT_ADD(STAT_CALLS, 1);
+	STAT_ADD(STAT_BYTES, sink->count - start);
+
+	return sink->err ? -1 : (int)sink->count;
+}
+
+int my_fn_vfprintf(FILE* stream, my_format_fn fn, va_list argp)
+{
+	my_sink sink;
+	char buf[MY_SINK_BUF]; // output buffer
+	int res;
+
+	sink_init(&sink, buf, sizeof(buf), file_flush, stream);
+
+	res = my_fn_vformat(&sink, fn, argp);
+
+	// Write whatever is left in the buffer.
+	if (sink_flush(&sink) || res < 0)
+		return -1;
+
+	return res;
+}
+
+int my_fn_vsnprintf(char* str, size_t size, my_format_fn fn, va_list argp)
+{
+	str_sink ss;
+	int res;
+
+	// Keep one character for the NUL terminator.
+	sink_init(&ss.sink, str, size > 0 ? size - 1 : 0, str_flush, NULL);
+	ss.end = NULL;
+
+	res = my_fn_vformat(&ss.sink, fn, argp);
+
+	if (size > 0)
+	{
+		if (ss.end == NULL)
+			ss.end = str + ss.sink.pos;
+
+		*ss.end = '\0';
+	}
+
+	return res;
+}
+
+void my_conv_c(my_sink* sink, int c)
+{
+	STAT_ADD(STAT_SPEC + 'c', 1);
+	sink_putc(sink, (char)c);
+}
+
+void my_conv_s(my_sink* sink, const char* s)
+{
+	STAT_ADD(STAT_SPEC + 's', 1);
+	sink_write(sink, s, strlen(s));
+}
+
+void my_conv_d(my_sink* sink, int n)
+{
+	char buf[16];
+
+	STAT_ADD(STAT_SPEC + 'd', 1);
+	sink_write(sink, buf, int_to_str(n, buf, 10, 0, 1));
+}
+
+void my_conv_u(my_sink* sink, unsigned int n)
+{
+	char buf[16];
+
+	STAT_ADD(STAT_SPEC + 'u', 1);
+	sink_write(sink, buf, int_to_str(n, buf, 10, 0, 0));
+}
+
+void my_conv_x(my_sink* sink, int n)
+{
+	char buf[16];
+
+	STAT_ADD(STAT_SPEC + 'x', 1);
+	sink_write(sink, buf, int_to_str(n, buf, 16, 0, 0));
+}
+
+void my_conv_X(my_sink* sink, int n)
+{
+	char buf[16];
+
+	STAT_ADD(STAT_SPEC + 'X', 1);
+	sink_write(sink, buf, int_to_str(n, buf, 16, 1, 0));
+}
+
+void my_conv_o(my_sink* sink, int n)
+{
+	char buf[16];
+
+	STAT_ADD(STAT_SPEC + 'o', 1);
+	sink_write(sink, buf, int_to_str(n, buf, 8, 0, 1));
+}
+
+void my_conv_p(my_sink* sink, const void* p)
+{
+	char buf[24];
+	size_t len, i;
+
+	STAT_ADD(STAT_SPEC + 'p', 1);
+	len = uintptr_to_str((uintptr_t)p, buf, 1);
+	for (i = len; i < sizeof(uintptr_t) * 2; i++)
+		sink_putc(sink, '0');
+	sink_write(sink, buf, len);
+}
+
+void my_conv_ull(my_sink* sink, unsigned long long n, const ftag* t)
+{
+	const char* hex = t->spec == SPEC_X ? "0123456789ABCDEF" : "0123456789abcdef";
+	unsigned int base;
+	char buf[24];     // digits, from the end, up to 22 in octal
+	size_t i;
+
+	base = t->spec == SPEC_o ? 8 : t->spec == SPEC_x || t->spec == SPEC_X ? 16 : 10;
+	STAT_ADD(STAT_SPEC + t->spec, 1);
+
+	i = sizeof(buf);
+	do
+	{
+		buf[--i] = hex[n % base];
+		n /= base;
+	} while (n != 0);
+
+	sink_write(sink, buf + i, sizeof(buf) - i);
+}
+
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+void my_conv_f(my_sink* sink, double d)
+{
+	STAT_ADD(STAT_SPEC + 'f', 1);
+	STAT_ADD(STAT_FLOAT_FAST, 1);
+	sink_f(sink, d);
+}
+
+void my_conv_e(my_sink* sink, double d, const ftag* t)
+{
+	STAT_ADD(STAT_SPEC + t->spec, 1);
+	STAT_ADD(STAT_FLOAT_FAST, 1);
+	sink_e(sink, d, *t);
+}
+
+void my_conv_a(my_sink* sink, double d, const ftag* t)
+{
+	STAT_ADD(STAT_SPEC + t->spec, 1);
+	STAT_ADD(STAT_FLOAT_FAST, 1);
+	sink_hexf(sink, d, t);
+}
+
+void my_conv_Lf(my_sink* sink, long double d, const ftag* t)
+{
+	ieee_754_wide c = extract_ldouble(d);
+	ftag f = *t;
+
+	f.spec = SPEC_f;
+	STAT_ADD(STAT_SPEC + 'f', 1);
+	if (sink_wide(sink, &c, &f))
+	{
+		STAT_ADD(STAT_FLOAT_EXACT, 1);
+	}
+	else
+	{
+		STAT_ADD(STAT_FLOAT_FAST, 1);
+	}
+}
+
+void my_conv_Le(my_sink* sink, long double d, const ftag* t)
+{
+	ieee_754_wide c = extract_ldouble(d);
+	ftag e = *t;
+
+	if (e.spec != SPEC_E)
+		e.spec = SPEC_e;
+	STAT_ADD(STAT_SPEC + e.spec, 1);
+	if (sink_wide(sink, &c, &e))
+	{
+		STAT_ADD(STAT_FLOAT_EXACT, 1);
+	}
+	else
+	{
+		STAT_ADD(STAT_FLOAT_FAST, 1);
+	}
+}
+#endif
+
+void my_sink_write(my_sink* sink, const char* str, size_t len)
+{
+	sink_write(sink, str, len);
+}
+
+void my_sink_putc(my_sink* sink, char c)
+{
+	sink_putc(sink, c);
+}
+
+int my_register_spec(char spec, my_spec_fn fn)
+{
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+	unsigned char c = (unsigned char)spec;
+	unsigned char f, l;
+	char s;
+
+	if (c <= ' ' || c >= SPEC_NAMED || is_spec(c, s) || is_flag(c, f)
+		|| is_len(c, l) || (c >= '0' && c <= '9')
+		|| c == '.' || c == '*' || c == '{')
+		return -1;
+
+	atomic_store_explicit(&custom_specs[c], fn, memory_order_release);
+
+	return 0;
+#else
+	(void)spec;
+	(void)fn;
+
+	return -1;
+#endif
+}
+
+int my_register_named_spec(const char* name, my_spec_fn fn)
+{
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+	size_t len, i, slot;
+	uint64_t h;
+	char* copy;
+
+	h = named_hash(name, &len);
+	if (name[len] != '\0')
+		return -1;
+
+	i = named_find(h, len);
+	slot = atomic_load_explicit(&named_index[i], memory_order_relaxed);
+
+	if (slot == 0)
+	{
+		if (fn == NULL)
+			return 0;
+
+		// Removed names keep their slot, so that the index never has
+		// to be rebuilt.
+		if (named_used == NAMED_N)
+			return -1;
+
+		copy = malloc(len + 1);
+		if (copy == NULL)
+			return -1;
+		memcpy(copy, name, len + 1);
+
+		// The slot is only published once the entry is complete.
+		slot = named_used++;
+		named_specs[slot].name = copy;
+		named_specs[slot].hash = h;
+		named_specs[slot].len = len;
+		atomic_store_explicit(&named_index[i], (unsigned char)slot, memory_order_release);
+	}
+	else if (memcmp(named_specs[slot].name, name, len) != 0)
+		return -1;
+
+	atomic_store_explicit(&custom_specs[SPEC_NAMED | slot], fn, memory_order_release);
+
+	return 0;
+#else
+	(void)name;
+	(void)fn;
+
+	return -1;
+#endif
+}
+
+int my_vfprintf(FILE* stream, const char* fmt, va_list argp)
+{
+	my_sink sink;
+	char buf[MY_SINK_BUF]; // output buffer
+	int res;
+
+	sink_init(&sink, buf, sizeof(buf), file_flush, stream);
+
+	res = my_vformat(&sink, fmt, argp);
+
+	// Write whatever is left in the buffer.
+	if (sink_flush(&sink) || res < 0)
+		return -1;
+
+	return res;
+}
+
+int my_fprintf(FILE* stream, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vfprintf(stream, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_vprintf(const char* fmt, va_list argp)
+{
+	return my_vfprintf(my_get_stdout(), fmt, argp);
+}
+
+int my_printf(const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vprintf(fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_vsnprintf(char* str, size_t size, const char* fmt, va_list argp)
+{
+	str_sink ss;
+	int res;
+
+	// Keep one character for the NUL terminator.
+	sink_init(&ss.sink, str, size > 0 ? size - 1 : 0, str_flush, NULL);
+	ss.end = NULL;
+
+	res = my_vformat(&ss.sink, fmt, argp);
+
+	if (size > 0)
+	{
+		if (ss.end == NULL)
+			ss.end = str + ss.sink.pos;
+
+		*ss.end = '\0';
+	}
+
+	return res;
+}
+
+int my_snprintf(char* str, size_t size, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vsnprintf(str, size, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_vformat_length(const char* fmt, va_list args)
+{
+	char* end;         // updated character pointer
+	const char* lit;   // start of a run of literal characters
+	size_t len;        // number of characters
+	size_t n;          // number of characters in a conversion
+	va_list argp;      // arguments, for custom specifiers
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+	my_spec_fn fn;     // function of a custom specifier
+#endif
+	int err;
+
+	len = 0;
+	err = 0;
+	va_copy(argp, args);
+
+	while (*fmt != '\0' && !err)
+	{
+		if (*fmt == '%')
+		{
+			fmt++;
+			ftag t = parse_format(fmt, &end);
+			fmt = end;
+			tag_args(t, argp);
+
+			n = 0;
+
+			if (t.spec == SPEC_c && !(t.len & (LEN_l | LEN_W | LEN_U)))
+			{
+				va_arg(argp, int);
+				n = 1;
+			}
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if (t.spec == SPEC_c)
+			{
+				uint32_t c = va_arg(argp, unsigned int);
+				if (t.len & LEN_W)
+					c &= 0xFFFF;
+				n = utf8_len(c);
+			}
+			else if (t.spec == SPEC_s && (t.len & LEN_W))
+			{
+				n = utf16_len(va_arg(argp, const uint16_t*));
+			}
+			else if (t.spec == SPEC_s && (t.len & LEN_U))
+			{
+				n = utf32_len(va_arg(argp, const uint32_t*));
+			}
+			else if (t.spec == SPEC_s && (t.len & LEN_l))
+			{
+				const wchar_t* s = va_arg(argp, const wchar_t*);
+				n = sizeof(wchar_t) == 2
+					? utf16_len((const uint16_t*)s)
+					: utf32_len((const uint32_t*)s);
+			}
+#endif
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_STR
+			else if (t.spec == SPEC_s && !(t.len & (LEN_l | LEN_W | LEN_U)))
+			{
+				n = strlen(va_arg(argp, char*));
+			}
+#endif
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if (t.spec == SPEC_J)
+			{
+				// Escapes are counted by writing them to a sink that
+				// discards them.
+				my_sink sink;
+				char buf[MY_SINK_BUF];
+
+				sink_init(&sink, buf, sizeof(buf), count_flush, NULL);
+				sink_json(&sink, va_arg(argp, char*),
+					t.flags & FMT_ZPREC ? t.prec : SIZE_MAX,
+					t.flags & FMT_POINT);
+				n = sink.count;
+			}
+			else if (t.spec == SPEC_k)
+			{
+				int64_t v = va_arg(argp, int64_t);
+				size_t nd, whole;
+
+				nd = udec_len(v < 0 ? 0 - (uint64_t)v : (uint64_t)v);
+				whole = nd > t.prec ? nd - t.prec : 0;
+				n = (v < 0 || (t.flags & (FMT_SIGN | FMT_SPACE)))
+					+ (whole > 0 ? whole : 1)
+					+ ((t.flags & FMT_POINT) && whole > 0 ? (whole - 1) / 3 : 0)
+					+ (t.prec > 0 ? 1 + t.prec : 0);
+				if (n < t.width)
+					n = t.width;
+			}
+#endif
+			else if (t.spec == SPEC_d || t.spec == SPEC_i)
+			{
+				int i = va_arg(argp, int);
+				n = i < 0
+					? 1 + udec_len(0 - (uint64_t)(int64_t)i)
+					: udec_len((uint64_t)i);
+			}
+			else if (t.spec == SPEC_u)
+			{
+				n = udec_len(va_arg(argp, unsigned int));
+			}
+			else if (t.spec == SPEC_X || t.spec == SPEC_x)
+			{
+				n = (bit_len(va_arg(argp, unsigned int)) + 3) / 4;
+			}
+			else if (t.spec == SPEC_o)
+			{
+				int i = va_arg(argp, int);
+				uint64_t u = i < 0 ? 0 - (uint64_t)(int64_t)i : (uint64_t)i;
+				n = (i < 0) + (bit_len(u) + 2) / 3;
+			}
+			else if (t.spec == SPEC_p)
+			{
+				n = (bit_len(va_arg(argp, uintptr_t)) + 3) / 4;
+				if (n < sizeof(uintptr_t) * 2)
+					n = sizeof(uintptr_t) * 2;
+			}
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+			else if ((t.len & (LEN_L | LEN_Q)) && (t.spec == SPEC_f
+				|| t.spec == SPEC_E || t.spec == SPEC_e))
+			{
+				my_sink sink;
+				char buf[MY_SINK_BUF];
+				ieee_754_wide c;
+
+				err = va_wide(&argp, t.len, &c);
+				if (!err)
+				{
+					sink_init(&sink, buf, sizeof(buf), count_flush, NULL);
+					sink_wide(&sink, &c, &t);
+					n = sink.count;
+				}
+			}
+			else if ((t.len & (LEN_L | LEN_Q)) && (t.spec == SPEC_G
+				|| t.spec == SPEC_g || t.spec == SPEC_A || t.spec == SPEC_a))
+			{
+				ieee_754_wide c;
+
+				err = va_wide(&argp, t.len, &c) || t.spec == SPEC_A
+					|| t.spec == SPEC_a;
+			}
+			else if (t.spec == SPEC_f)
+			{
+				n = f_len(va_arg(argp, double));
+			}
+			else if (t.spec == SPEC_E || t.spec == SPEC_e)
+			{
+				// Default the precision to 6
+				if (t.prec == 0 && !(t.flags & FMT_ZPREC))
+					t.prec = 6;
+
+				n = e_len(va_arg(argp, double), t.prec);
+			}
+			else if (t.spec == SPEC_G || t.spec == SPEC_g)
+			{
+				// not implemented
+				va_arg(argp, double);
+			}
+			else if (t.spec == SPEC_A || t.spec == SPEC_a)
+			{
+				my_sink sink;
+				char buf[MY_SINK_BUF];
+
+				sink_init(&sink, buf, sizeof(buf), count_flush, NULL);
+				sink_hexf(&sink, va_arg(argp, double), &t);
+				n = sink.count;
+			}
+#endif
+			else if (t.spec == SPEC_n)
+			{
+				va_arg(argp, int*);
+			}
+#if defined(MY_PRINTF_POSIX) && MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if (t.spec == SPEC_T)
+			{
+				char buf[64];
+				const struct timespec* ts = t.flags & FMT_POINT
+					? va_arg(argp, const struct timespec*)
+					: NULL;
+
+				n = ts_format(buf, &t, ts);
+				if (n == 0)
+					err = 1;
+			}
+#endif
+			else if (t.spec == SPEC_per)
+			{
+				n = 1;
+			}
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_EXT
+			else if ((fn = spec_fn((unsigned char)t.spec)) != NULL)
+			{
+				// Custom output can only be counted by formatting it.
+				my_sink sink;
+				char buf[MY_SINK_BUF];
+
+				sink_init(&sink, buf, sizeof(buf), count_flush, NULL);
+				if (fn(&sink, &t, &argp))
+					err = 1;
+				n = sink.count;
+			}
+#endif
+			else
+			{
+				// invalid specifier
+				err = 1;
+			}
+
+			len += n;
+
+			if (*fmt != '\0')
+				fmt++;
+		}
+		else
+		{
+			for (lit = fmt; *fmt != '\0' && *fmt != '%'; fmt++);
+			len += fmt - lit;
+		}
+	}
+
+	va_end(argp);
+
+	return err ? -1 : (int)len;
+}
+
+int my_format_length(const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vformat_length(fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_vasprintf(char** strp, const char* fmt, va_list argp)
+{
+	va_list argc; // copy of the arguments for the length pass
+	int len;
+
+	*strp = NULL;
+
+	va_copy(argc, argp);
+	len = my_vformat_length(fmt, argc);
+	va_end(argc);
+
+	if (len < 0)
+		return -1;
+
+	*strp = malloc((size_t)len + 1);
+	if (*strp == NULL)
+		return -1;
+
+	return my_vsnprintf(*strp, (size_t)len + 1, fmt, argp);
+}
+
+int my_asprintf(char** strp, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vasprintf(strp, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+void my_arena_init(my_arena* arena, size_t chunk_size)
+{
+	arena->head = NULL;
+	arena->cur = NULL;
+	arena->chunk_size = chunk_size > 0 ? chunk_size : ARENA_CHUNK;
+}
+
+void my_arena_reset(my_arena* arena)
+{
+	// The rest of the chunks are emptied as they are reached again.
+	arena->cur = arena->head;
+
+	if (arena->cur != NULL)
+		arena->cur->used = 0;
+}
+
+void my_arena_free(my_arena* arena)
+{
+	struct my_arena_chunk* c;
+	struct my_arena_chunk* next;
+
+	for (c = arena->head; c != NULL; c = next)
+	{
+		next = c->next;
+		free(c);
+	}
+
+	arena->head = NULL;
+	arena->cur = NULL;
+}
+
+char* my_arena_vprintf(my_arena* arena,
+	size_t* len,
+	const char* fmt,
+	va_list argp)
+{
+	struct my_arena_chunk* c;
+	my_sink sink;
+
+	// Make sure that there is room for at least the NUL character.
+	c = arena->cur;
+	if (c == NULL || c->size - c->used < 2)
+	{
+		c = arena_next(arena, 2);
+		if (c == NULL)
+			return NULL;
+	}
+
+	sink_init(&sink, c->data + c->used, c->size - c->used - 1,
+		arena_flush, arena);
+
+	if (my_vformat(&sink, fmt, argp) < 0)
+		return NULL;
+
+	// The sink may have moved to another chunk.
+	c = arena->cur;
+	sink.buf[sink.pos] = '\0';
+	c->used = (size_t)(sink.buf - c->data) + sink.pos + 1;
+
+	if (len != NULL)
+		*len = sink.pos;
+
+	return sink.buf;
+}
+
+char* my_arena_printf(my_arena* arena, size_t* len, const char* fmt, ...)
+{
+	va_list argp;
+	char* res;
+
+	va_start(argp, fmt);
+	res = my_arena_vprintf(arena, len, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+#ifdef MY_PRINTF_POSIX
+
+int my_log_open(my_log* log, const char* path, size_t window)
+{
+	struct my_log_header* h;
+	struct stat st;
+	size_t page;
+	int created, i;
+
+	log->header = NULL;
+	log->map = NULL;
+	log->win = 0;
+
+	page = (size_t)sysconf(_SC_PAGESIZE);
+
+	// Windows are whole pages, so that they can be mapped.
+	if (window == 0)
+		window = LOG_WINDOW;
+	window = (window + page - 1) / page * page;
+
+	log->fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+	created = log->fd >= 0;
+
+	if (!created)
+	{
+		if (errno != EEXIST)
+			return -1;
+
+		log->fd = open(path, O_RDWR);
+		if (log->fd < 0)
+			return -1;
+	}
+	else if (log_extend(log->fd, 0, (off_t)page))
+		goto fail;
+
+	// Wait for the process that created the file to size it.
+	for (i = 0; i < 1000; i++)
+	{
+		if (fstat(log->fd, &st))
+			goto fail;
+
+		if ((size_t)st.st_size >= sizeof(struct my_log_header))
+			break;
+
+		nanosleep(&(struct timespec){ 0, 1000000 }, NULL);
+	}
+
+	h = mmap(NULL, page, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+	if (h == MAP_FAILED)
+		goto fail;
+
+	log->header = h;
+
+	if (created)
+	{
+		h->window = window;
+		h->data = page;
+		atomic_store(&h->tail, 0);
+		atomic_store_explicit(&h->magic, LOG_MAGIC, memory_order_release);
+	}
+	else
+	{
+		// Wait for the process that created the file to write the header.
+		for (i = 0; i < 1000; i++)
+		{
+			if (atomic_load_explicit(&h->magic, memory_order_acquire) == LOG_MAGIC)
+				break;
+
+			nanosleep(&(struct timespec){ 0, 1000000 }, NULL);
+		}
+
+		if (i == 1000)
+			goto fail;
+	}
+
+	log->window = (size_t)h->window;
+
+	return 0;
+
+fail:
+	my_log_close(log);
+
+	return -1;
+}
+
+void my_log_close(my_log* log)
+{
+	if (log->map != NULL)
+		munmap(log->map, log->window);
+
+	if (log->header != NULL)
+		munmap(log->header, (size_t)sysconf(_SC_PAGESIZE));
+
+	if (log->fd >= 0)
+		close(log->fd);
+
+	log->map = NULL;
+	log->header = NULL;
+	log->fd = -1;
+}
+
+int my_log_vprintf(my_log* log, const char* fmt, va_list argp)
+{
+	va_list argc;  // copy of the arguments for the length pass
+	uint64_t off;  // offset of the record
+	uint64_t size; // size of the record
+	uint64_t end;  // end of the window that contains the record
+	_Atomic uint32_t* hdr;
+	my_sink sink;
+	char* rec;
+	int len, res;
+
+	va_copy(argc, argp);
+	len = my_vformat_length(fmt, argc);
+	va_end(argc);
+
+	if (len < 0 || (uint32_t)len > LOG_LEN)
+		return -1;
+
+	// Records start on 8 byte boundaries.
+	size = ((uint64_t)LOG_REC_HDR + (uint64_t)len + 7) & ~(uint64_t)7;
+	if (size > log->window)
+		return -1;
+
+	for (;;)
+	{
+		off = atomic_fetch_add(&log->header->tail, size);
+		end = (off / log->window + 1) * log->window;
+
+		if (off + size <= end)
+			break;
+
+		// Records never cross windows. The part of the range in each window
+		// is padded out, and another range is reserved.
+		log_pad(log, off, end - off);
+		log_pad(log, end, off + size - end);
+	}
+
+	// From here on, the range is reserved, and a failure must still turn
+	// it into padding so that readers can skip it.
+	rec = log_map(log, off);
+	if (rec == NULL)
+	{
+		log_pad(log, off, size);
+		return -1;
+	}
+
+	hdr = (_Atomic uint32_t*)rec;
+	atomic_store_explicit(hdr, (uint32_t)len | LOG_PENDING, memory_order_relaxed);
+
+	sink_init(&sink, rec + LOG_REC_HDR, (size_t)len, log_flush, NULL);
+	res = my_vformat(&sink, fmt, argp);
+
+	// The record is only marked complete once all of it is written,
+	// so a crash leaves it marked as pending.
+	if (res != len)
+	{
+		log_pad(log, off, size);
+		return -1;
+	}
+
+	atomic_store_explicit(hdr, (uint32_t)len | LOG_DONE, memory_order_release);
+
+	return res;
+}
+
+int my_log_printf(my_log* log, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_log_vprintf(log, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+#endif
+
+#ifdef MY_PRINTF_POSIX
+
+int my_vdprintf(int fd, const char* fmt, va_list argp)
+{
+	iov_sink is;
+	int res;
+
+	sink_init(&is.sink, is.buf, sizeof(is.buf), iov_flush, NULL);
+	is.sink.span = iov_span;
+	is.fd = fd;
+	is.n = 0;
+	is.mark = 0;
+
+	res = my_vformat(&is.sink, fmt, argp);
+
+	// Write whatever is left in the vector and the buffer.
+	if (iov_flush(&is.sink) || res < 0)
+		return -1;
+
+	return res;
+}
+
+int my_dprintf(int fd, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vdprintf(fd, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int my_vdprintf_safe(int fd, const char* fmt, va_list args)
+{
+	safe_out out;
+	const char* lit;   // start of a run of literal characters
+	const char* s;
+	char* end;         // updated character pointer
+	va_list argp;
+	uint64_t u;
+	int64_t v;
+	size_t len;
+	int saved, err, ll, hh;
+	char c;
+
+	saved = errno;
+	out.fd = fd;
+	out.err = 0;
+	out.pos = 0;
+	out.count = 0;
+	err = 0;
+	va_copy(argp, args);
+
+	while (*fmt != '\0' && !err)
+	{
+		if (*fmt != '%')
+		{
+			// Write the literal characters up to the next format tag.
+			for (lit = fmt; *fmt != '\0' && *fmt != '%'; fmt++);
+			safe_write(&out, lit, (size_t)(fmt - lit));
+			continue;
+		}
+
+		ftag t = parse_format(fmt + 1, &end);
+		tag_args(t, argp);
+
+		// The length flags don't tell ll from l or hh from h.
+		ll = end - fmt > 2 && end[-1] == 'l' && end[-2] == 'l';
+		hh = end - fmt > 2 && end[-1] == 'h' && end[-2] == 'h';
+		fmt = end;
+
+		// Only the integers take a length, and only h, hh, l and ll,
+		// since the rest would read an argument of another type.
+		if ((t.len & ~(LEN_h | LEN_l)) || (t.len != 0 && (t.spec == SPEC_c
+			|| t.spec == SPEC_s || t.spec == SPEC_p)))
+		{
+			err = 1;
+			break;
+		}
 
-				for (i = 0; i < len; i++)
-				{
-					my_putchar(buf[i]);
-				}
-			}
-			else if (t.spec == SPEC_o)
+		switch (t.spec)
+		{
+		case SPEC_d:
+		case SPEC_i:
+			v = ll ? va_arg(argp, long long)
+				: t.len & LEN_l ? va_arg(argp, long)
+				: va_arg(argp, int);
+			if (t.len & LEN_h)
+				v = hh ? (signed char)v : (short)v;
+			safe_int(&out, v < 0 ? 0 - (uint64_t)v : (uint64_t)v,
+				v < 0 ? '-'
+				: t.flags & FMT_SIGN ? '+'
+				: t.flags & FMT_SPACE ? ' '
+				: 0, 10, &t);
+			break;
+		case SPEC_u:
+		case SPEC_o:
+		case SPEC_x:
+		case SPEC_X:
+			u = ll ? va_arg(argp, unsigned long long)
+				: t.len & LEN_l ? va_arg(argp, unsigned long)
+				: va_arg(argp, unsigned int);
+			if (t.len & LEN_h)
+				u = hh ? (unsigned char)u : (unsigned short)u;
+			safe_int(&out, u, 0,
+				t.spec == SPEC_u ? 10 : t.spec == SPEC_o ? 8 : 16, &t);
+			break;
+		case SPEC_p:
+			// Pointers have all of their digits, as with my_printf.
+			if (!(t.flags & FMT_ZPREC))
 			{
-				int n = va_arg(argp, int);
-				len = int_to_str(n, buf, 8, 0, 1);
-
-				for (i = 0; i < len; i++)
-				{
-					my_putchar(buf[i]);
-				}
+				t.prec = sizeof(uintptr_t) * 2;
+				t.flags |= FMT_ZPREC;
 			}
-			else if (t.spec == SPEC_p)
+			safe_int(&out, (uintptr_t)va_arg(argp, void*), 0, 16, &t);
+			break;
+		case SPEC_c:
+			c = (char)va_arg(argp, int);
+			len = 1;
+			s = &c;
+			goto text;
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_STR
+		case SPEC_s:
+			// NULL is written as (null), or not at all if the precision
+			// would cut it short, as glibc does.
+			s = va_arg(argp, const char*);
+			if (s == NULL)
+				s = (t.flags & FMT_ZPREC) && t.prec < 6 ? "" : "(null)";
+			for (len = 0; s[len] != '\0'; len++)
 			{
-				uintptr_t n = va_arg(argp, uintptr_t);
-				len = uintptr_to_str(n, buf, 1);
-				size_t plen = sizeof(uintptr_t) * 2;
-
-				if (len < plen)
-				{
-					for (j = 0; i < plen - len; i++)
-					{
-						my_putchar('0');
-					}
-				}
-				for (i = 0; i < len; i++)
-				{
-					my_putchar(buf[i]);
-				}
+				if ((t.flags & FMT_ZPREC) && len == t.prec)
+					break;
 			}
-			else if (t.spec == SPEC_f)
-			{
-				double d;
-				uint8_t frac[DOUBLE_BIN_DIG];
-				uint8_t whole[DOUBLE_BIN_DIG];
-				size_t w_res, f_res;
+#endif
+		text:
+			if (!(t.flags & FMT_LEFT))
+				safe_fill(&out, ' ', t.width > len ? t.width - len : 0);
+			safe_write(&out, s, len);
+			if (t.flags & FMT_LEFT)
+				safe_fill(&out, ' ', t.width > len ? t.width - len : 0);
+			break;
+		case SPEC_per:
+			safe_write(&out, "%", 1);
+			break;
+		default:
+			// Floats, custom specifiers and the rest are not safe.
+			err = 1;
+			break;
+		}
 
-				d = va_arg(argp, double);
+		// Move past the specifier, unless the format string ended
+		// in the middle of a format tag.
+		if (*fmt != '\0')
+			fmt++;
+	}
 
-				double_to_str(d, whole, &w_res, frac, &f_res);
+	va_end(argp);
 
-				if (w_res == 0)
-					my_putchar('0');
+	// What was formatted before a failure is still written.
+	safe_flush(&out);
+	errno = saved;
 
-				for (i = 0; i < w_res; i++)
-					my_putchar(whole[i] + '0');
+	if (err || out.err)
+		return -1;
 
-				my_putchar('.');
+	return (int)out.count;
+}
 
-				for (i = 0; i < f_res && i < 7; i++)
-				{
-					if (i == 6 && f_res > 7)
-					{
-						if (frac[i + 1] > 4)
-							frac[i]++;
-					}
+int my_dprintf_safe(int fd, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
 
-					my_putchar(frac[i] + '0');
-				}
-			}
-			else if (t.spec == SPEC_E || t.spec == SPEC_e)
-			{
-				double d;
-				uint8_t right[DOUBLE_BIN_DIG];
-				uint8_t left[DOUBLE_BIN_DIG];
-				size_t l_size, r_size;
-				size_t exp = 0;
-				size_t count = 0;
-				size_t ri = 0;
-				int neg = 0;
-				int extra = 0; // leading 1 due to rounding
-				size_t offset = 0;
+	va_start(argp, fmt);
+	res = my_vdprintf_safe(fd, fmt, argp);
+	va_end(argp);
 
-				// Default the precision to 6
-				if (t.prec == 0 && !(t.flags & FMT_ZPREC))
-					t.prec = 6;
+	return res;
+}
 
-				d = va_arg(argp, double);
+#endif
 
-				double_to_str(d, left, &l_size, right, &r_size);
+#ifdef MY_PRINTF_POSIX
 
+int my_aio_open(my_aio* aio, int fd, size_t size, int flags)
+{
+	void* bufs[2];
+	int fl;
 
-				// Determine how to round the results
-				if (t.prec == 0)
-				{
-					// If precision is zero, we either round
-					// the left side, or the right side.
-					if (l_size > 1)
-					{
-						if (left[1] > 4)
-							left[0]++;
+	if (size == 0)
+		size = AIO_BUF;
 
-						// Handle carries
-						if (left[0] >= 10)
-						{
-							left[0] = 0;
-							extra = 1;
-						}
-					}
-					else if (r_size > 1)
-					{
-						if (right[1] > 4)
-							right[0]++;
+	bufs[0] = bufs[1] = NULL;
 
-						// Handle carries
-						if (right[0] >= 10)
-						{
-							right[0] = 0;
-							extra = 1;
-						}
-					}
-					else if (r_size > 0)
-					{
-						if (right[0] > 4)
-						{
-							if (l_size == 0)
-							{
-								left[0] = 1;
-								extra = 1;
-							}
-							else
-							{
-								left[0]++;
-								if (left[0] >= 10)
-								{
-									left[0] = 1;
-									left[1] = 0;
-									extra = 1;
-								}
-							}
-						}
-					}
-				}
-				else
-				{
-					// If precision is greter than 0, we have to do some thinking.
+	// Page aligned buffers can be registered with the kernel.
+	if (posix_memalign(&bufs[0], 4096, size) || posix_memalign(&bufs[1], 4096, size))
+	{
+		free(bufs[0]);
+		return -1;
+	}
 
-					if (l_size >= 1)
-					{
-						// Determine if the rounding digit
-						// is on the left side or right side.
-						for (i = 0; i < l_size && i < t.prec; i++);
+	sink_init(&aio->sink, bufs[0], size, aio_flush, NULL);
+	aio->fd = fd;
+	aio->ring = NULL;
+	aio->bufs[0] = bufs[0];
+	aio->bufs[1] = bufs[1];
+	aio->lens[0] = aio->lens[1] = 0;
+	aio->offs[0] = aio->offs[1] = 0;
+	aio->busy[0] = aio->busy[1] = 0;
+	aio->cur = 0;
+	aio->sync = 1;
+
+	// Writes go to explicit offsets, unless the file is not seekable or
+	// is opened for appending.
+	fl = fcntl(fd, F_GETFL);
+	aio->off = (long long)lseek(fd, 0, SEEK_CUR);
+	if (fl < 0 || (fl & O_APPEND))
+		aio->off = -1;
+
+#ifdef MY_PRINTF_URING
+	if (!(flags & MY_AIO_SYNC))
+	{
+		aio->ring = ring_open(aio->bufs, size, flags & MY_AIO_FIXED, aio->off < 0);
+		aio->sync = aio->ring == NULL;
+	}
+#else
+	(void)flags;
+#endif
 
-						if (i < l_size && i > 0)
-						{
-							// The precision is within the left side
-							if (left[i] > 4)
-							{
-								left[i - 1]++;
+	return 0;
+}
 
-								// Handle carries
-								if (left[i - 1] >= 10)
-								{
-									for (j = i - 1; j > 0 && left[j] >= 10; j--)
-									{
-										left[j - 1]++;
-										left[j] = 0;
-									}
-
-									if (j == 0 && left[j] >= 10)
-									{
-										left[j] = 0;
-										extra = 1;
-									}
-								}
-							}
+int my_aio_flush(my_aio* aio)
+{
+	int err;
 
-						}
-						else
-						{
-							// The precision is within the right side
-							for (j = 0; j < r_size && j + i < t.prec; j++);
+	err = aio_flush(&aio->sink);
+	err |= aio_wait(aio, 0);
+	err |= aio_wait(aio, 1);
 
-							if (j < r_size && right[j] > 4)
-							{
-								if (j > 0)
-								{
-									// The precision is after the first element
-									right[j - 1]++;
-
-									j = j - 1;
-
-									// Handle carries
-									if (right[j] >= 10)
-									{
-										for (; j > 0 && right[j] >= 10; j--)
-										{
-											right[j - 1]++;
-											right[j] = 0;
-										}
-
-										if (j == 0 && right[j] >= 10)
-										{
-											right[j] = 0;
-
-											for (j = l_size - 1; j > 0 && left[j] >= 10; j--)
-											{
-												left[j - 1]++;
-												left[j] = 0;
-											}
-
-											if (j == 0 && left[j] >= 10)
-											{
-												left[j] = 0;
-												extra = 1;
-											}
-										}
-									}
+	return err || aio->sink.err ? -1 : 0;
+}
 
-								}
-								else
-								{
-									left[l_size - 1]++;
-
-									j = l_size - 1;
-
-									// Handle carries
-									if (left[j] >= 10)
-									{
-										for (; j > 0 && left[j] >= 10; j--)
-										{
-											left[j - 1]++;
-											left[j] = 0;
-										}
-
-										if (j == 0 && left[j] >= 10)
-										{
-											left[j] = 0;
-											extra = 1;
-										}
-									}
-								}
+int my_aio_close(my_aio* aio)
+{
+	int res;
 
-								j = j > 0 ? j - 1 : r_size - 1;
-							}
-						}
-					}
-					else if (r_size >= 1)
-					{
-						// Find the index of the first non zero element
-						for (i = 0; right[i] == 0 && i < r_size && i < t.prec; i++);
-						offset = i;
-						for (; i < r_size && i < t.prec + offset; i++);
+	res = my_aio_flush(aio);
 
-						if (i < r_size && i > 0)
-						{
-							if (right[i] > 4)
-							{
-								right[i] = 0;
-								right[i - 1]++;
-							}
+	// Leave the file position after everything that was written.
+	if (aio->off >= 0)
+		lseek(aio->fd, (off_t)aio->off, SEEK_SET);
 
+#ifdef MY_PRINTF_URING
+	ring_close(aio->ring);
+#endif
 
-							j = i - 1;
+	free(aio->bufs[0]);
+	free(aio->bufs[1]);
+	aio->ring = NULL;
+	aio->bufs[0] = aio->bufs[1] = NULL;
 
-							// Handle carries
-							if (right[j] >= 10)
-							{
-								for (; j > 0 && right[j] >= 10; j--)
-								{
-									right[j - 1]++;
-									right[j] = 0;
-								}
+	return res;
+}
 
-								if (j == 0 && right[j] >= 10)
-								{
-									right[j] = 0;
-									left[0]++;
-									extra = 1;
-								}
-							}
-						}
-					}
-				}
+int my_aio_vprintf(my_aio* aio, const char* fmt, va_list argp)
+{
+	// The sink is kept between calls, so only this call is counted.
+	aio->sink.count = 0;
 
+	return my_vformat(&aio->sink, fmt, argp);
+}
 
-				// Print the first character
-				if (extra)
-					my_putchar('1');
+int my_aio_printf(my_aio* aio, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
 
-				else if (l_size > 0)
-					my_putchar(left[0] + '0');
+	va_start(argp, fmt);
+	res = my_aio_vprintf(aio, fmt, argp);
+	va_end(argp);
 
-				else if (r_size > 0)
-				{
-					neg = 1;
-					exp++;
-					for (i = 0; i < r_size && right[i] == 0; i++)
-						exp++;
+	return res;
+}
 
-					my_putchar(right[i] + '0');
-				}
-				else
-					my_putchar('0');
+#endif
 
-				// Print the radix point
-				if (t.prec)
-					my_putchar('.');
+int my_vsscanf(const char* str, const char* fmt, va_list args)
+{
+	const char* s = str;  // position in the input
+	char* end;            // updated character pointer
+	va_list argp;         // arguments
+	uint64_t n;           // converted integer
+	size_t max;           // maximum number of characters to read
+	size_t k;             // number of characters read
+	int assigned;         // number of arguments assigned
+	int input;            // the input ended before a conversion
+	int skip;             // the assignment is suppressed
+	int twice;            // the length is hh or ll
+
+	va_copy(argp, args);
+	assigned = 0;
+	input = 0;
+
+	while (*fmt != '\0')
+	{
+		if (is_space(*fmt))
+		{
+			// White space matches any amount of white space.
+			while (is_space(*s))
+				s++;
+			fmt++;
+			continue;
+		}
 
-				// Print the rest of the left side
-				if (l_size > 1)
-				{
-					for (i = 1; i < l_size && count < t.prec; i++)
-					{
-						my_putchar(left[i] + '0');
-						exp++;
-						count++;
-					}
-				}
+		if (*fmt != '%' || fmt[1] == '%')
+		{
+			if (*fmt == '%')
+			{
+				fmt++;
+				while (is_space(*s))
+					s++;
+			}
 
-				// Print the right side
-				if (r_size > 0 && l_size > 0)
-				{
-					for (i = 0; i < r_size && count < t.prec; i++)
-					{
-						if (count == t.prec - 1 && i < r_size - 1)
-						{
-							if (right[i + 1] > 4)
-								right[i]++;
-						}
-						my_putchar(right[i] + '0');
-						exp++;
-						count++;
-					}
-				}
-				else if (r_size > 1)
-				{
-					for (i = exp; i < r_size && count < t.prec; i++)
-					{
-						/*if (count == t.prec - 1 && i < r_size - 1)
-						{
-							if (right[i + 1] > 4)
-								right[i]++;
-						}*/
-						my_putchar(right[i] + '0');
-						count++;
-					}
-				}
-				else
-					my_putchar('0');
+			if (*s == '\0')
+				input = 1;
+			if (*s != *fmt)
+				break;
 
-				if (count < t.prec)
-				{
-					for (; count < t.prec; count++)
-					{
-						my_putchar('0');
-					}
-				}
+			s++;
+			fmt++;
+			continue;
+		}
 
+		fmt++;
+		ftag t = parse_format(fmt, &end);
+
+		// The length flags don't tell ll from l or hh from h.
+		twice = end - fmt >= 2 && end[-1] == end[-2]
+			&& (end[-1] == 'h' || end[-1] == 'l');
+		fmt = end;
+
+		// Integers are only read with the h, hh, l and ll lengths, since
+		// the rest would store an argument of another type.
+		if ((t.spec == SPEC_d || t.spec == SPEC_i || t.spec == SPEC_u
+			|| t.spec == SPEC_o || t.spec == SPEC_x || t.spec == SPEC_X
+			|| t.spec == SPEC_n) && (t.len & ~(LEN_h | LEN_l)))
+			break;
 
-				// Print the 'E' or 'e' character
-				if (t.spec == SPEC_E)
-					my_putchar('E');
-				else
-					my_putchar('e');
+		// For scanf, a '*' suppresses the assignment instead of
+		// taking the width from the arguments.
+		skip = (t.flags & FMT_WIDTH) != 0;
+		max = t.width > 0 ? t.width : SIZE_MAX;
 
+		if (t.spec == SPEC_n)
+		{
+			if (!skip)
+				scan_store(va_arg(argp, void*), t.len, twice, (uint64_t)(s - str));
+			fmt++;
+			continue;
+		}
 
-				if (l_size > 1)
-					exp = l_size - 1;
-				else if (l_size == 1)
-					exp = 0;
+		// Every specifier but c skips leading white space.
+		if (t.spec != SPEC_c)
+		{
+			while (is_space(*s))
+				s++;
+		}
 
-				if (l_size >= 1 && extra)
-					exp++;
-				else if (neg && extra)
-				{
-					if (exp > 0)
-						exp--;
-					else
-					{
-						exp++;
-						neg = 0;
-					}
-				}
+		if (*s == '\0')
+		{
+			input = 1;
+			break;
+		}
 
-				len = size_to_str(exp, buf, 10, 0);
+		if (t.spec == SPEC_d || t.spec == SPEC_i || t.spec == SPEC_u
+			|| t.spec == SPEC_o || t.spec == SPEC_x || t.spec == SPEC_X)
+		{
+			k = scan_int(s, max, t.spec, &n);
+			if (k == 0)
+				break;
 
-				my_putchar(neg ? '-' : '+');
+			if (!skip)
+				scan_store(va_arg(argp, void*), t.len, twice, n);
+		}
+		else if (t.spec == SPEC_f || t.spec == SPEC_e || t.spec == SPEC_E
+			|| t.spec == SPEC_g || t.spec == SPEC_G)
+		{
+			int wide = (t.len & (LEN_l | LEN_L)) != 0;
+			uint64_t bits;
+			char* e;
 
-				if (len < 2)
-					my_putchar('0');
+			bits = parse_float_bits(s, max, wide ? &flt_double : &flt_float, &e);
+			k = (size_t)(e - s);
+			if (k == 0)
+				break;
 
-				for (i = 0; i < len; i++)
-					my_putchar(buf[i]);
-			}
-			else if (t.spec == SPEC_G || t.spec == SPEC_g)
+			if (!skip)
 			{
-				// not implemented
+				void* out = va_arg(argp, void*);
+
+				if (wide)
+				{
+					double d;
+
+					memcpy(&d, &bits, sizeof(d));
+					if (t.len & LEN_L)
+						*(long double*)out = d;
+					else
+						*(double*)out = d;
+				}
+				else
+				{
+					uint32_t b32 = (uint32_t)bits;
+
+					memcpy(out, &b32, sizeof(float));
+				}
 			}
-			else if (t.spec == SPEC_n)
+		}
+		else if (t.spec == SPEC_s)
+		{
+			char* out = skip ? NULL : va_arg(argp, char*);
+
+			for (k = 0; k < max && s[k] != '\0' && !is_space(s[k]); k++);
+
+			if (out != NULL)
 			{
-				// Do nothing
+				memcpy(out, s, k);
+				out[k] = '\0';
 			}
-			else
+		}
+		else if (t.spec == SPEC_c)
+		{
+			char* out = skip ? NULL : va_arg(argp, char*);
+
+			if (max == SIZE_MAX)
+				max = 1;
+
+			for (k = 0; k < max && s[k] != '\0'; k++);
+			if (k < max)
 			{
-				// invalid specifier
-				err = 1;
+				input = 1;
+				break;
 			}
+
+			if (out != NULL)
+				memcpy(out, s, k);
 		}
 		else
 		{
-			my_putchar(*fmt);
+			// invalid specifier
+			break;
 		}
 
-		fmt++;
+		s += k;
+		if (!skip)
+			assigned++;
+
+		if (*fmt != '\0')
+			fmt++;
 	}
 
 	va_end(argp);
 
-	return 1;
+	// Running out of input before the first conversion is reported as
+	// EOF, as scanf does.
+	return input && assigned == 0 ? EOF : assigned;
+}
+
+int my_sscanf(const char* str, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = my_vsscanf(str, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+double my_strtod(const char* str, char** end)
+{
+	uint64_t bits;
+	double d;
+
+	bits = parse_float_bits(str, SIZE_MAX, &flt_double, end);
+	memcpy(&d, &bits, sizeof(d));
+
+	return d;
+}
+
+float my_strtof(const char* str, char** end)
+{
+	uint32_t bits;
+	float f;
+
+	bits = (uint32_t)parse_float_bits(str, SIZE_MAX, &flt_float, end);
+	memcpy(&f, &bits, sizeof(f));
+
+	return f;
+}
+
+void my_printf_stats(my_stats* stats)
+{
+#ifdef MY_PRINTF_STATS
+	uint64_t total[STAT_N];
+	size_t i;
+
+	stats_sum(total);
+
+	while (atomic_flag_test_and_set(&stats_lock));
+
+	for (i = 0; i < STAT_N; i++)
+		total[i] -= stats_base[i];
+
+	atomic_flag_clear(&stats_lock);
+
+	stats->calls = total[STAT_CALLS];
+	stats->bytes = total[STAT_BYTES];
+	stats->tags = 0;
+	stats->float_fast = total[STAT_FLOAT_FAST];
+	stats->float_exact = total[STAT_FLOAT_EXACT];
+	stats->flushes = total[STAT_FLUSHES];
+	stats->truncations = total[STAT_TRUNC];
+
+	// Every parsed tag is counted under its specifier.
+	for (i = 0; i < 128; i++)
+	{
+		stats->specs[i] = total[STAT_SPEC + i];
+		stats->tags += total[STAT_SPEC + i];
+	}
+#else
+	memset(stats, 0, sizeof(my_stats));
+#endif
+}
+
+void my_printf_stats_reset(void)
+{
+#ifdef MY_PRINTF_STATS
+	uint64_t total[STAT_N];
+
+	stats_sum(total);
+
+	while (atomic_flag_test_and_set(&stats_lock));
+	memcpy(stats_base, total, sizeof(stats_base));
+	atomic_flag_clear(&stats_lock);
+#endif
 }
@@ -2,6 +2,218 @@
 #define MY_PRINTF_H
 
 #include <stdio.h>
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MY_PRINTF_POSIX
+#endif
+
+// The Q length, for __float128 arguments, is available where the compiler
+// has the type.
+#if defined(__SIZEOF_FLOAT128__) && !defined(__cplusplus)
+#define MY_PRINTF_FLOAT128
+#endif
+
+// feature tiers, each including the ones before it
+#define MY_PRINTF_TIER_INT   1 /* c, d, i, u, x, X, o, p, n and %      */
+#define MY_PRINTF_TIER_STR   2 /* s                                    */
+#define MY_PRINTF_TIER_FLOAT 3 /* f, e, E, g, G, a, A, L and Q         */
+#define MY_PRINTF_TIER_EXT   4 /* wide characters, J, k, T and custom  */
+
+/**
+ * The conversions built into the format functions are selected at compile
+ * time by defining MY_PRINTF_TIER to one of the tiers above, the same way
+ * for my_printf.c and every file that includes this header. A program that
+ * only prints integers and strings then carries none of the float code.
+ * In a smaller tier, a tag for a conversion of a larger tier fails as an
+ * unknown specifier does: formatting stops at the tag, and -1 is returned.
+ * The default is the extensions tier, which has everything.
+ */
+#ifndef MY_PRINTF_TIER
+#define MY_PRINTF_TIER MY_PRINTF_TIER_EXT
+#endif
+
+/**
+ * An output sink for formatted characters.
+ * Characters are collected in a buffer. Whenever the buffer is full,
+ * the flush function is called to make room for more characters, either
+ * by writing out the contents of the buffer or by replacing the buffer.
+ * The flush function returns 0 on success, or non-zero on failure.
+ *
+ * A sink may also have a span function, which is offered long runs of
+ * characters that stay in memory until formatting is done, such as the
+ * literal text of the format string and %s arguments. If it returns 0,
+ * the sink has taken the span by reference, and it is not copied into
+ * the buffer. Otherwise, the span is copied as usual.
+ */
+typedef struct my_sink my_sink;
+
+struct my_sink {
+	char* buf;                   // output buffer
+	size_t size;                 // capacity of the output buffer
+	size_t pos;                  // number of characters in the buffer
+	size_t count;                // total number of characters formatted
+	int err;                     // error indicator
+	int (*flush)(my_sink* sink); // makes room in the buffer
+	int (*span)(my_sink* sink, const char* str, size_t len); // takes a span
+	void* data;                  // sink specific data
+};
+
+// format flag bit flags
+#define FMT_LEFT   0x01 /* -                               */
+#define FMT_SIGN   0x02 /* +                               */
+#define FMT_SPACE  0x04 /* [space]                         */
+#define FMT_POINT  0x08 /* #                               */
+#define FMT_ZERO   0x10 /* 0                               */
+#define FMT_WIDTH  0x20 /* width is passed as argument     */
+#define FMT_PREC   0x40 /* precision is passed as argument */
+#define FMT_ZPREC  0x80 /* precision is zero               */
+
+// format length bit flags
+#define LEN_h 0x01 /* h */
+#define LEN_l 0x02 /* l */
+#define LEN_L 0x04 /* L */
+#define LEN_W 0x08 /* W */
+#define LEN_U 0x10 /* U */
+#define LEN_Q 0x20 /* Q */
+
+/**
+ * A format tag within a format string.
+ * By the time a tag is handed to a custom specifier, a width or precision
+ * that was passed as an argument has already been read into the tag.
+ */
+typedef struct ftag {
+	unsigned char flags; // FMT_ bit flags
+	size_t width;        // minimum number of characters
+	size_t prec;         // precision
+	unsigned char len;   // LEN_ bit flags
+	char spec;           // specifier
+}ftag;
+
+/**
+ * A function that formats the argument of a custom specifier.
+ * It reads its arguments from the list with va_arg, and writes its output
+ * with my_sink_write and my_sink_putc.
+ *
+ * Params:
+ *   my_sink* - the sink being written
+ *   const ftag* - the parsed format tag
+ *   va_list* - the remaining arguments
+ *
+ * Returns:
+ *   int - 0 on success, or non-zero on failure
+ */
+typedef int (*my_spec_fn)(my_sink* sink, const ftag* tag, va_list* argp);
+
+/**
+ * A function that formats one record for my_format_records.
+ * It usually passes the format string and the fields of the record to
+ * my_format. It is called from several threads at once.
+ *
+ * Params:
+ *   my_sink* - the sink to write the record to
+ *   const char* - the format string given to my_format_records
+ *   const void* - the record
+ *
+ * Returns:
+ *   int - a negative number on failure
+ */
+typedef int (*my_record_fn)(my_sink* sink, const char* fmt, const void* rec);
+
+/**
+ * An arena of memory for formatted strings.
+ * Strings are formatted directly into the current chunk of the arena, one
+ * after the other. Strings are never freed individually. Instead, the
+ * whole arena is reset at once, and its chunks are reused.
+ */
+typedef struct my_arena {
+	struct my_arena_chunk* head; // first chunk
+	struct my_arena_chunk* cur;  // chunk being filled
+	size_t chunk_size;           // minimum size of new chunks
+}my_arena;
+
+#ifdef MY_PRINTF_POSIX
+
+/**
+ * A log file that is shared by any number of processes.
+ * The file starts with a header page, followed by fixed-size windows that
+ * are mapped into memory one at a time. Each record is a 4 byte header
+ * followed by the formatted characters, padded to a multiple of 8 bytes.
+ * The low 30 bits of a record header are the number of characters, and
+ * the top two bits are its state: 01 while it is being written, 10 once
+ * it is complete, and 11 for padding. A header of 0 means that the space
+ * was reserved but never written, and the rest of its window is lost.
+ * Records never cross windows.
+ *
+ * A my_log must only be used by one thread at a time. Threads and
+ * processes that want to write to the same file each open their own.
+ */
+typedef struct my_log {
+	int fd;                             // file descriptor of the log file
+	struct my_log_header* header;       // mapped header page
+	char* map;                          // mapped window
+	unsigned long long win;             // index of the mapped window
+	size_t window;                      // size of a window
+}my_log;
+
+/**
+ * An asynchronous, double buffered sink for a file descriptor.
+ * Output is formatted into one buffer while the other one is being
+ * written. On Linux, full buffers are submitted as io_uring writes, and
+ * elsewhere, or when io_uring is not available, they are written with
+ * plain writes.
+ */
+typedef struct my_aio {
+	my_sink sink;                       // sink that fills the current buffer
+	int fd;                             // output file descriptor
+	int cur;                            // index of the buffer being filled
+	int sync;                           // writes are done without io_uring
+	int busy[2];                        // a buffer has a write in flight
+	char* bufs[2];                      // output buffers
+	size_t lens[2];                     // bytes submitted from each buffer
+	long long offs[2];                  // file offset of each submission
+	long long off;                      // file offset of the next buffer
+	struct my_aio_ring* ring;           // io_uring state, or NULL
+}my_aio;
+
+// my_aio_open flags
+#define MY_AIO_FIXED 0x01 /* register the buffers with io_uring */
+#define MY_AIO_SYNC  0x02 /* do not use io_uring                */
+
+#endif
+
+/**
+ * Counters of the work done by the formatter since the last reset.
+ * The counters are only collected when the library is built with
+ * MY_PRINTF_STATS defined. Otherwise they are always 0.
+ *
+ * Each thread that formats gets about 1 KiB of counters, which are kept
+ * when it exits so that its counts stay in the totals. On POSIX systems,
+ * they are taken over by the next thread that starts formatting, so the
+ * memory used is bounded by the largest number of threads at once.
+ * Elsewhere, the counters of every thread stay allocated until the
+ * process exits.
+ *
+ * Formats run with my_jit_ or my_fn_ functions, and fields written by
+ * my::format, count their conversions in the my_conv_ functions that
+ * write them, so %i is counted under 'd' there and %% is not counted.
+ * Doubles always take the fast path. A long double takes the exact path
+ * when its leading digits are not enough to round it.
+ */
+typedef struct my_stats {
+	unsigned long long calls;       // formats run
+	unsigned long long bytes;       // characters formatted
+	unsigned long long tags;        // format tags parsed
+	unsigned long long specs[128];  // conversions per specifier character
+	unsigned long long float_fast;  // float conversions on a fast path
+	unsigned long long float_exact; // float conversions on the exact path
+	unsigned long long flushes;     // sink buffers flushed
+	unsigned long long truncations; // outputs truncated by my_snprintf
+}my_stats;
 
 /**
  * Writes a character to an output stream.
@@ -73,7 +285,7 @@ int my_putchar(int c);
  *
  * <precision> can be one of the following values:
  *   .[number] for integers, this is the minimum number of digits to be
- *     written. For e, E, and f, it's the number of digits to be written
+ *     written. For a, A, e, E, and f, it's the number of digits to be written
  *     after then decimal point. For g and G, it's maximum number of
  *     significant digits to be printed. For s, it's the maximum number of
  *     characters to be printed.
@@ -85,6 +297,15 @@ int my_putchar(int c);
  *   l the argument is interpreted as a long int or unsigned long int
  *     or as a wide character or wide character string
  *   L the argument is interpreted as a long double
+ *   Q the argument is interpreted as a __float128, where MY_PRINTF_FLOAT128
+ *     is defined. Elsewhere, a tag with Q fails.
+ *   W for c and s, the argument is a UTF-16 code unit or a zero terminated
+ *     string of UTF-16 code units (char16_t or uint16_t)
+ *   U for c and s, the argument is a UTF-32 code point or a zero terminated
+ *     string of UTF-32 code points (char32_t or uint32_t)
+ *
+ * Wide characters and strings are written as UTF-8. Unpaired surrogates
+ * and values above U+10FFFF are written as U+FFFD.
  *
  * Potential format specifiers:
  *   c character
@@ -93,8 +314,25 @@ int my_putchar(int c);
  *   e scientific notation using 'e' character (not implemented)
  *   E scientific notation using 'E' character (not implemented)
  *   f decimal floating point (not implemented)
+ *     With the L or Q length, e, E and f are exact for any precision, with
+ *     the '+', ' ' and '#' flags, and round half to even. The digits come
+ *     from the exact value of the x87 extended, quadruple or double
+ *     precision number, whichever long double is. a and A fail with L or
+ *     Q, and g and G read the argument and write nothing.
  *   g uses shorter of e or f (not implemented)
  *   G uses shorter of E or f (not implemented)
+ *   a hexadecimal floating point, such as -0x1.8p+3 (lower case letters)
+ *   A hexadecimal floating point, such as -0X1.8P+3 (capital letters).
+ *     Without a precision, all of the digits needed to write the value
+ *     exactly are written, and with one, the value is rounded to that
+ *     many digits after the point.
+ *   k fixed-point decimal of an int64_t scaled by 10^precision, so
+ *     %.2k of 12345 writes 123.45. The value is exact, and the precision
+ *     is the number of digits after the point, which is usually passed
+ *     with %.*k. Unlike the other specifiers, the width is honored, with
+ *     the '-' and '0' flags, as are the '+' and ' ' flags. The '#' flag
+ *     groups the whole digits by thousands with commas, as in 1,234.50.
+ *     Length characters are ignored.
  *   o signed octal
  *   s string of characters
  *   u unsigned decimal integer
@@ -102,8 +340,25 @@ int my_putchar(int c);
  *   X unsigned hexadecimal integer (capital letters)
  *   p pointer address
  *   n nothing printed
+ *   J string of characters with the escapes of a JSON string. Quotes,
+ *     backslashes and control characters are escaped, and with the '#'
+ *     flag, so are all non-ASCII characters, as \uXXXX. The precision is
+ *     the maximum number of bytes of the string to read, and a UTF-8
+ *     character that it cuts short is left out. The quotes around the
+ *     string are not written.
+ *   T ISO 8601 timestamp of the current time, such as
+ *     2024-05-01T12:34:56.789Z. The precision is the number of digits of
+ *     the fraction of the second, from 0 to 9, so %.3T, %.6T and %.9T give
+ *     milliseconds, microseconds and nanoseconds. The '+' flag writes the
+ *     local time with its UTC offset instead of UTC, and the '#' flag takes
+ *     the time from a const struct timespec* argument instead of the clock.
+ *     The date and time up to the seconds are cached per thread. After
+ *     TZ is changed, tzset must be called for local times to follow it.
+ *     Only available on POSIX systems.
  *   % the '%' character
  *
+ * Which of these are available depends on MY_PRINTF_TIER.
+ *
  * Params:
  *   const char* - a pointer to a string
  *   va_list - a list of arguments to be converted to strings
@@ -113,4 +368,875 @@ int my_putchar(int c);
  */
 int my_printf(const char* fmt, ...);
 
+/**
+ * Writes a formatted string of characters to stdout.
+ * This is the same as my_printf, except that the arguments are passed
+ * as a va_list.
+ *
+ * Params:
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_vprintf(const char* fmt, va_list argp);
+
+/**
+ * Writes a formatted string of characters to an output stream.
+ * The format string is the same as for my_printf.
+ *
+ * Params:
+ *   FILE* - an output stream
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_fprintf(FILE* stream, const char* fmt, ...);
+
+/**
+ * Writes a formatted string of characters to an output stream.
+ * This is the same as my_fprintf, except that the arguments are passed
+ * as a va_list.
+ *
+ * Params:
+ *   FILE* - an output stream
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_vfprintf(FILE* stream, const char* fmt, va_list argp);
+
+/**
+ * Writes a formatted string of characters to a character array.
+ * At most size - 1 characters are written, followed by a NUL character.
+ * The format string is the same as for my_printf.
+ *
+ * Params:
+ *   char* - a character array
+ *   size_t - the capacity of the array
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters that would have been written if the
+ *     array was large enough, not including the NUL character,
+ *     or -1 on failure
+ */
+int my_snprintf(char* str, size_t size, const char* fmt, ...);
+
+/**
+ * Writes a formatted string of characters to a character array.
+ * This is the same as my_snprintf, except that the arguments are passed
+ * as a va_list.
+ *
+ * Params:
+ *   char* - a character array
+ *   size_t - the capacity of the array
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters that would have been written if the
+ *     array was large enough, not including the NUL character,
+ *     or -1 on failure
+ */
+int my_vsnprintf(char* str, size_t size, const char* fmt, va_list argp);
+
+/**
+ * Writes a formatted string of characters to a sink.
+ * This is the core of all of the printf functions. The characters are
+ * written to the buffer of the sink, and the flush function of the sink
+ * is called whenever the buffer is full. The caller is responsible for
+ * handling whatever is left in the buffer when this function returns.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters formatted, or -1 on failure
+ */
+int my_vformat(my_sink* sink, const char* fmt, va_list argp);
+
+/**
+ * Writes a formatted string of characters to a sink.
+ * This is the same as my_vformat, except that the values are passed as
+ * arguments.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters formatted, or -1 on failure
+ */
+int my_format(my_sink* sink, const char* fmt, ...);
+
+/**
+ * Formats an array of records on several threads, and writes the output
+ * to a sink in the order of the records.
+ *
+ * The records are split evenly between the threads, and a thread that
+ * runs out of records steals half of what another thread has left. Each
+ * thread formats its records in chunks, into buffers of its own, and the
+ * size of the chunks follows the time that each record takes, so that
+ * slow records such as rows of floats are balanced as well as fast ones.
+ * A chunk is written to the sink as soon as all of the records before it
+ * have been, by whichever thread finished it, so the sink is only ever
+ * written by one thread at a time and the output does not have to be
+ * held in memory all at once.
+ *
+ * The calling thread is one of the threads, and the others are started
+ * for the call and stopped before it returns. Without POSIX threads, the
+ * records are formatted by the calling thread alone.
+ *
+ * Params:
+ *   my_sink* - the sink to write the output to
+ *   const char* - the format string, which is passed on to the function
+ *   const void* - the first record
+ *   size_t - the number of records
+ *   size_t - the size of each record
+ *   my_record_fn - the function that formats a record
+ *   int - the number of threads, or 0 for one per processor
+ *
+ * Returns:
+ *   int - 0 on success, or -1 on failure. The number of characters is
+ *     added to the count of the sink.
+ */
+int my_format_records(my_sink* sink,
+	const char* fmt,
+	const void* recs,
+	size_t n,
+	size_t rec_size,
+	my_record_fn fn,
+	int threads);
+
+/**
+ * A format string that was compiled by my_jit_compile.
+ */
+typedef struct my_jit my_jit;
+
+/**
+ * Compiles a format string, so that it can be formatted many times
+ * without being parsed again.
+ *
+ * On x86-64 Linux, the format is turned into machine code that stores
+ * the literal text as immediates and calls the conversion for each tag
+ * directly. The code is written to memory that is made executable only
+ * once it is no longer writable. Formats that use '*' for the width or
+ * precision, wide characters or strings, or any conversion other than
+ * c, s, d, i, u, x, X, o, p, f, e, E, a, A and %, are not compiled and
+ * are interpreted instead, as they are when the library is built with
+ * MY_PRINTF_NO_JIT or on other systems. Either way, the output is the
+ * same as that of my_vformat.
+ *
+ * Params:
+ *   const char* - a format string, which is copied
+ *
+ * Returns:
+ *   my_jit* - the compiled format, or NULL if no memory could be allocated
+ */
+my_jit* my_jit_compile(const char* fmt);
+
+/**
+ * Determines whether a format was compiled to machine code.
+ *
+ * Params:
+ *   const my_jit* - a compiled format
+ *
+ * Returns:
+ *   int - 1 if the format runs as machine code, or 0 if it is interpreted
+ */
+int my_jit_native(const my_jit* jit);
+
+/**
+ * Frees a compiled format.
+ *
+ * Params:
+ *   my_jit* - a compiled format, or NULL
+ */
+void my_jit_free(my_jit* jit);
+
+/**
+ * Writes a compiled format to a sink.
+ * This is the same as my_vformat with the format string that was
+ * compiled.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const my_jit* - a compiled format
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters formatted, or -1 on failure
+ */
+int my_jit_vformat(my_sink* sink, const my_jit* jit, va_list argp);
+
+/**
+ * Writes a compiled format to a sink.
+ * This is the same as my_jit_vformat, except that the values are passed
+ * as arguments.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const my_jit* - a compiled format
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters formatted, or -1 on failure
+ */
+int my_jit_format(my_sink* sink, const my_jit* jit, ...);
+
+/**
+ * Writes a compiled format to a character array.
+ * This is the same as my_snprintf with the format string that was
+ * compiled.
+ *
+ * Params:
+ *   char* - a pointer to a character array
+ *   size_t - the size of the character array
+ *   const my_jit* - a compiled format
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters that would have been written if the
+ *     array was large enough, not including the NUL character,
+ *     or -1 on failure
+ */
+int my_jit_snprintf(char* str, size_t size, const my_jit* jit, ...);
+
+/**
+ * Writes a compiled format to an output stream.
+ * This is the same as my_vfprintf with the format string that was
+ * compiled.
+ *
+ * Params:
+ *   FILE* - an output stream
+ *   const my_jit* - a compiled format
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_jit_vfprintf(FILE* stream, const my_jit* jit, va_list argp);
+
+/**
+ * Writes a compiled format to a character array.
+ * This is the same as my_jit_snprintf, except that the arguments are
+ * passed as a va_list.
+ *
+ * Params:
+ *   char* - a pointer to a character array
+ *   size_t - the size of the character array
+ *   const my_jit* - a compiled format
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters that would have been written if the
+ *     array was large enough, not including the NUL character,
+ *     or -1 on failure
+ */
+int my_jit_vsnprintf(char* str, size_t size, const my_jit* jit, va_list argp);
+
+/**
+ * A function that writes one particular format to a sink, reading its
+ * arguments with va_arg. Such functions are generated by fmtgen for the
+ * literal format strings of a program, so that those formats are never
+ * parsed at run time.
+ *
+ * Params:
+ *   my_sink* - the sink to write
+ *   va_list - the arguments of the format
+ */
+typedef void (*my_format_fn)(my_sink* sink, va_list argp);
+
+/**
+ * Writes formatted output to a sink with a format function.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   my_format_fn - a format function
+ *   va_list - a list of arguments for the format function
+ *
+ * Returns:
+ *   int - the number of characters formatted, or -1 on failure
+ */
+int my_fn_vformat(my_sink* sink, my_format_fn fn, va_list argp);
+
+/**
+ * Writes formatted output to an output stream with a format function.
+ *
+ * Params:
+ *   FILE* - an output stream
+ *   my_format_fn - a format function
+ *   va_list - a list of arguments for the format function
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_fn_vfprintf(FILE* stream, my_format_fn fn, va_list argp);
+
+/**
+ * Writes formatted output to a character array with a format function.
+ * As with my_vsnprintf, at most size - 1 characters are written, followed
+ * by a NUL terminator.
+ *
+ * Params:
+ *   char* - a character array
+ *   size_t - the size of the character array
+ *   my_format_fn - a format function
+ *   va_list - a list of arguments for the format function
+ *
+ * Returns:
+ *   int - the number of characters that would have been written had the
+ *         array been large enough, or -1 on failure
+ */
+int my_fn_vsnprintf(char* str, size_t size, my_format_fn fn, va_list argp);
+
+/**
+ * The conversions that format functions and compiled formats call for
+ * each format tag. Each one writes its argument to a sink exactly as
+ * my_vformat writes it for the conversion in its name: my_conv_d is also
+ * used for %i, my_conv_x and my_conv_X for %x and %X, and my_conv_e and
+ * my_conv_a take the tag for the precision, the flags and the case of the
+ * specifier. my_conv_Lf and my_conv_Le do the same for %Lf, %Le and %LE.
+ *
+ * my_conv_ull is for integers wider than an int, which my_vformat does not
+ * read. It writes the digits of its argument in base 8 for a tag with the
+ * o specifier, in base 16 for x and X, and in base 10 otherwise.
+ */
+void my_conv_c(my_sink* sink, int c);
+void my_conv_s(my_sink* sink, const char* s);
+void my_conv_d(my_sink* sink, int n);
+void my_conv_u(my_sink* sink, unsigned int n);
+void my_conv_x(my_sink* sink, int n);
+void my_conv_X(my_sink* sink, int n);
+void my_conv_o(my_sink* sink, int n);
+void my_conv_p(my_sink* sink, const void* p);
+void my_conv_ull(my_sink* sink, unsigned long long n, const ftag* t);
+#if MY_PRINTF_TIER >= MY_PRINTF_TIER_FLOAT
+void my_conv_f(my_sink* sink, double d);
+void my_conv_e(my_sink* sink, double d, const ftag* t);
+void my_conv_a(my_sink* sink, double d, const ftag* t);
+void my_conv_Lf(my_sink* sink, long double d, const ftag* t);
+void my_conv_Le(my_sink* sink, long double d, const ftag* t);
+#endif
+
+/**
+ * Writes a sequence of characters to a sink.
+ * This is meant for custom specifiers.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   const char* - the characters to write
+ *   size_t - the number of characters
+ */
+void my_sink_write(my_sink* sink, const char* str, size_t len);
+
+/**
+ * Writes a character to a sink.
+ * This is meant for custom specifiers.
+ *
+ * Params:
+ *   my_sink* - a sink
+ *   char - the character to write
+ */
+void my_sink_putc(my_sink* sink, char c);
+
+/**
+ * Registers a function for a specifier character.
+ * The character must be ASCII and must not already have a meaning in a
+ * format tag, so it cannot be a built in specifier, a flag, a digit, '.',
+ * '*', '{' or a length character. Registering a character again replaces
+ * its function, and registering NULL removes it.
+ * Other threads may format while a specifier is registered, and see the
+ * new function from their next tag on, but registrations must not run at
+ * the same time as each other.
+ * Below the extensions tier, nothing can be registered.
+ *
+ * Params:
+ *   char - the specifier character
+ *   my_spec_fn - the function that formats the argument, or NULL
+ *
+ * Returns:
+ *   int - 0 on success, or -1 if the character cannot be used
+ */
+int my_register_spec(char spec, my_spec_fn fn);
+
+/**
+ * Registers a function for a named specifier, which is written as
+ * %{name} in a format string, with the usual flags, width, precision and
+ * length before the opening brace. Names are looked up by their hash, so
+ * a name whose hash collides with a registered name is refused. The name
+ * is copied, and the copy is kept until the process exits.
+ * Registering a name again replaces its function, and registering NULL
+ * removes it. Up to 127 names can be registered.
+ * As with my_register_spec, other threads may format meanwhile, but
+ * registrations must not run at the same time as each other.
+ * Below the extensions tier, nothing can be registered.
+ *
+ * Params:
+ *   const char* - the name, which must not contain '}'
+ *   my_spec_fn - the function that formats the argument, or NULL
+ *
+ * Returns:
+ *   int - 0 on success, or -1 if the name cannot be registered or
+ *     memory cannot be allocated
+ */
+int my_register_named_spec(const char* name, my_spec_fn fn);
+
+/**
+ * Computes the exact number of characters that a format string and its
+ * arguments produce, without converting any of the values to digits.
+ * Integers are measured by counting their digits, strings by their length,
+ * and floating point numbers from their binary exponent. Only the rare
+ * floating point values where that estimate is ambiguous are converted.
+ *
+ * This can be used to allocate a buffer of the exact size, or to reserve
+ * space in a ring buffer, before formatting into it.
+ *
+ * Params:
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters, not including a NUL character,
+ *     or -1 if the format string is invalid
+ */
+int my_format_length(const char* fmt, ...);
+
+/**
+ * Computes the exact number of characters that a format string and its
+ * arguments produce. This is the same as my_format_length, except that the
+ * arguments are passed as a va_list.
+ *
+ * Params:
+ *   const char* - a format string
+ *   va_list - a list of arguments
+ *
+ * Returns:
+ *   int - the number of characters, not including a NUL character,
+ *     or -1 if the format string is invalid
+ */
+int my_vformat_length(const char* fmt, va_list argp);
+
+/**
+ * Writes a formatted string of characters to a newly allocated array.
+ * The length of the output is computed first, so the array is allocated
+ * with the exact size needed. The array must be freed by the caller.
+ *
+ * Params:
+ *   char** - a pointer to receive the array, or NULL on failure
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, not including the NUL
+ *     character, or -1 on failure
+ */
+int my_asprintf(char** strp, const char* fmt, ...);
+
+/**
+ * Writes a formatted string of characters to a newly allocated array.
+ * This is the same as my_asprintf, except that the arguments are passed
+ * as a va_list.
+ *
+ * Params:
+ *   char** - a pointer to receive the array, or NULL on failure
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, not including the NUL
+ *     character, or -1 on failure
+ */
+int my_vasprintf(char** strp, const char* fmt, va_list argp);
+
+/**
+ * Initializes an empty arena. No memory is allocated until the first
+ * string is formatted into the arena.
+ *
+ * Params:
+ *   my_arena* - an arena
+ *   size_t - the minimum size of each chunk, or 0 for a default size
+ */
+void my_arena_init(my_arena* arena, size_t chunk_size);
+
+/**
+ * Makes all of the memory of an arena available again. Every string that
+ * was formatted into the arena becomes invalid. This takes constant time,
+ * and the chunks of the arena are kept for reuse.
+ *
+ * Params:
+ *   my_arena* - an arena
+ */
+void my_arena_reset(my_arena* arena);
+
+/**
+ * Frees all of the memory of an arena.
+ * The arena can be used again afterwards.
+ *
+ * Params:
+ *   my_arena* - an arena
+ */
+void my_arena_free(my_arena* arena);
+
+/**
+ * Writes a formatted string of characters into an arena.
+ * The characters are written directly into the arena. If the current chunk
+ * fills up, the string is moved to a larger chunk and formatting continues
+ * there. The string stays valid until the arena is reset or freed.
+ *
+ * Params:
+ *   my_arena* - an arena
+ *   size_t* - a pointer to receive the length of the string, or NULL
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   char* - the NUL-terminated string, or NULL on failure
+ */
+char* my_arena_printf(my_arena* arena, size_t* len, const char* fmt, ...);
+
+/**
+ * Writes a formatted string of characters into an arena.
+ * This is the same as my_arena_printf, except that the arguments are
+ * passed as a va_list.
+ *
+ * Params:
+ *   my_arena* - an arena
+ *   size_t* - a pointer to receive the length of the string, or NULL
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   char* - the NUL-terminated string, or NULL on failure
+ */
+char* my_arena_vprintf(my_arena* arena,
+	size_t* len,
+	const char* fmt,
+	va_list argp);
+
+#ifdef MY_PRINTF_POSIX
+
+/**
+ * Opens a shared log file, creating it if it does not exist.
+ * The window size is only used when the file is created. Otherwise, the
+ * window size of the existing file is used.
+ *
+ * Params:
+ *   my_log* - a log
+ *   const char* - the path of the log file
+ *   size_t - the size of a window, or 0 for a default size of 1 MiB
+ *
+ * Returns:
+ *   int - 0 on success, or -1 on failure
+ */
+int my_log_open(my_log* log, const char* path, size_t window);
+
+/**
+ * Closes a log file. The records that were written remain in the file.
+ *
+ * Params:
+ *   my_log* - a log
+ */
+void my_log_close(my_log* log);
+
+/**
+ * Appends a formatted record to a log file.
+ * The length of the record is computed first, and its range in the file is
+ * reserved with a single atomic fetch-add on the shared header. The record
+ * is then formatted directly into the mapped file. Writers never wait for
+ * each other, and when a record does not fit in the current window, the
+ * next window is mapped. If formatting fails after the range is reserved,
+ * the record is turned into padding. If its window can't be mapped, the
+ * header stays 0.
+ *
+ * Params:
+ *   my_log* - a log
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_log_printf(my_log* log, const char* fmt, ...);
+
+/**
+ * Appends a formatted record to a log file.
+ * This is the same as my_log_printf, except that the arguments are passed
+ * as a va_list.
+ *
+ * Params:
+ *   my_log* - a log
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_log_vprintf(my_log* log, const char* fmt, va_list argp);
+
+#endif
+
+#ifdef MY_PRINTF_POSIX
+
+/**
+ * Writes a formatted string of characters to a file descriptor.
+ * The format string is the same as for my_printf.
+ *
+ * The output is written with as few calls to writev as possible. Long
+ * runs of literal text in the format string and long %s arguments are
+ * referenced where they are in memory instead of being copied, and only
+ * converted values and short runs are copied into a small buffer.
+ *
+ * Params:
+ *   int - a file descriptor
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_dprintf(int fd, const char* fmt, ...);
+
+/**
+ * Writes a formatted string of characters to a file descriptor.
+ * This is the same as my_dprintf, except that the arguments are passed
+ * as a va_list.
+ *
+ * Params:
+ *   int - a file descriptor
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_vdprintf(int fd, const char* fmt, va_list argp);
+
+/**
+ * Writes a formatted string of characters to a file descriptor from a
+ * signal handler. This is async-signal-safe: it takes no locks, allocates
+ * no memory, does not use stdio and leaves errno as it was. The output is
+ * collected in a small buffer on the stack and written with write.
+ *
+ * Only c, s, d, i, u, x, X, o, p and % are supported, and unlike
+ * my_printf, the width, precision, flags and the h, hh, l and ll lengths
+ * are applied as printf does, so %016lx works for registers. A NULL
+ * string is written as (null), as glibc does. Any other specifier,
+ * including floats and custom specifiers, and any length on c, s or p,
+ * such as %lc or %Ws, stops the formatting and fails, after writing what
+ * came before it.
+ *
+ * Params:
+ *   int - a file descriptor
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_dprintf_safe(int fd, const char* fmt, ...);
+
+/**
+ * Writes a formatted string of characters to a file descriptor from a
+ * signal handler. This is the same as my_dprintf_safe, except that the
+ * arguments are passed as a va_list.
+ *
+ * Params:
+ *   int - a file descriptor
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters written, or -1 on failure
+ */
+int my_vdprintf_safe(int fd, const char* fmt, va_list argp);
+
+/**
+ * Opens an asynchronous sink for a file descriptor.
+ * The file descriptor stays open, and it is up to the caller to close it
+ * after my_aio_close.
+ *
+ * Params:
+ *   my_aio* - an asynchronous sink
+ *   int - a file descriptor open for writing
+ *   size_t - the size of each of the two buffers, or 0 for 64 KiB
+ *   int - MY_AIO_FIXED to use registered buffers, MY_AIO_SYNC to never
+ *     use io_uring, or 0
+ *
+ * Returns:
+ *   int - 0 on success, or -1 on failure
+ */
+int my_aio_open(my_aio* aio, int fd, size_t size, int flags);
+
+/**
+ * Writes out everything that was formatted into an asynchronous sink and
+ * waits for all writes to complete.
+ *
+ * Params:
+ *   my_aio* - an asynchronous sink
+ *
+ * Returns:
+ *   int - 0 on success, or -1 if any write failed
+ */
+int my_aio_flush(my_aio* aio);
+
+/**
+ * Flushes an asynchronous sink and frees its buffers.
+ *
+ * Params:
+ *   my_aio* - an asynchronous sink
+ *
+ * Returns:
+ *   int - 0 on success, or -1 if any write failed
+ */
+int my_aio_close(my_aio* aio);
+
+/**
+ * Writes a formatted string of characters to an asynchronous sink.
+ * The characters are written out when a buffer fills up, or when the sink
+ * is flushed or closed.
+ *
+ * Params:
+ *   my_aio* - an asynchronous sink
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters formatted, or -1 on failure
+ */
+int my_aio_printf(my_aio* aio, const char* fmt, ...);
+
+/**
+ * Writes a formatted string of characters to an asynchronous sink.
+ * This is the same as my_aio_printf, except that the arguments are passed
+ * as a va_list.
+ *
+ * Params:
+ *   my_aio* - an asynchronous sink
+ *   const char* - a format string
+ *   va_list - a list of arguments to be converted to strings
+ *
+ * Returns:
+ *   int - the number of characters formatted, or -1 on failure
+ */
+int my_aio_vprintf(my_aio* aio, const char* fmt, va_list argp);
+
+#endif
+
+/**
+ * Reads values from a string of characters according to a format string.
+ * Format tags use the same grammar as the printf functions, with the
+ * meanings of scanf:
+ *   d, i, u, o, x, X read an integer into an int*, a signed char* with
+ *     hh, a short* with h, a long* with l or a long long* with ll. i
+ *     detects the base from a 0x or 0 prefix. Any other length stops the
+ *     reading, as a mismatch does.
+ *   s reads characters up to the next white space into a char*, and
+ *     terminates them with a NUL character.
+ *   f, e, E, g, G read a decimal floating point number into a float*,
+ *     a double* with l or a long double* with L, as my_strtod reads it.
+ *     The long double has the precision of a double.
+ *   c reads the number of characters given by the width, or 1, into a
+ *     char*, without a NUL character.
+ *   n stores the number of characters read so far, with the same
+ *     lengths as d.
+ *   %% matches a '%' character.
+ * The width is the maximum number of characters to read, and a '*' in
+ * place of the width reads a value without assigning it. White space in
+ * the format string matches any amount of white space, including none,
+ * and every specifier but c and n skips white space first.
+ * Decimal integers are read eight digits at a time.
+ *
+ * Params:
+ *   const char* - the string to read
+ *   const char* - a format string
+ *   ... - pointers to receive the values
+ *
+ * Returns:
+ *   int - the number of values assigned, or EOF if the string ended
+ *     before the first value could be read
+ */
+int my_sscanf(const char* str, const char* fmt, ...);
+
+/**
+ * Reads values from a string of characters according to a format string.
+ * This is the same as my_sscanf, except that the arguments are passed as
+ * a va_list.
+ *
+ * Params:
+ *   const char* - the string to read
+ *   const char* - a format string
+ *   va_list - a list of pointers to receive the values
+ *
+ * Returns:
+ *   int - the number of values assigned, or EOF if the string ended
+ *     before the first value could be read
+ */
+int my_vsscanf(const char* str, const char* fmt, va_list argp);
+
+/**
+ * Converts the decimal number at the start of a string to a double,
+ * correctly rounded. Leading white space is skipped, and the syntax is
+ * that of strtod, except that hexadecimal numbers are not recognized.
+ * On overflow, the result is an infinity, and on underflow it is a
+ * subnormal number or zero, and in both cases errno is set to ERANGE.
+ *
+ * Most numbers are converted with one 64x128-bit multiplication by a
+ * precomputed power of ten. The few that this cannot round with
+ * certainty are converted exactly with a big decimal.
+ *
+ * Params:
+ *   const char* - the string to read
+ *   char** - receives a pointer to the character after the number, or
+ *     to the start of the string if there was no number, or NULL
+ *
+ * Returns:
+ *   double - the number, or 0 if there was no number
+ */
+double my_strtod(const char* str, char** end);
+
+/**
+ * Converts the decimal number at the start of a string to a float,
+ * correctly rounded. This is the same as my_strtod, except for the type
+ * of the result, which is rounded only once.
+ *
+ * Params:
+ *   const char* - the string to read
+ *   char** - receives a pointer to the character after the number, or
+ *     to the start of the string if there was no number, or NULL
+ *
+ * Returns:
+ *   float - the number, or 0 if there was no number
+ */
+float my_strtof(const char* str, char** end);
+
+/**
+ * Gets the formatter statistics of all threads since the last reset.
+ * Each thread counts into its own counters, and this function adds them
+ * up, so the counts of other threads may be slightly out of date.
+ *
+ * Params:
+ *   my_stats* - a structure to receive the statistics
+ */
+void my_printf_stats(my_stats* stats);
+
+/**
+ * Resets the formatter statistics of all threads to 0.
+ */
+void my_printf_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,508 @@
+/**
+ * A library that replaces the printf family of the C library, for use
+ * with LD_PRELOAD, so that programs that cannot be rebuilt format with
+ * my_printf.
+ *
+ * printf, fprintf, vprintf, vfprintf, snprintf and vsnprintf are
+ * exported, along with the __*_chk versions that programs built with
+ * _FORTIFY_SOURCE call instead. A call is formatted with my_vfprintf or
+ * my_vsnprintf only if the output is known to be exactly what the C
+ * library would write. The rest go to the C library's own function,
+ * found with dlsym(RTLD_NEXT). The output of a program is therefore the
+ * same with or without the library, which preload_check.sh checks.
+ *
+ * A format is formatted here when every tag in it is one of:
+ *   %%
+ *   %c with any flags, and %s with any flags and no precision
+ *   %d and %i with no flags other than '-' and '0' and no precision,
+ *     for any value but INT_MIN
+ *   %u, %x and %X with no flags other than '-' and '0' and no precision
+ *   %o under the same conditions, for values that are not negative
+ *   %a and %A with any flags and precision
+ * and no tag has a width, a length modifier or a positional argument,
+ * and no %s argument is NULL. Output to a wide oriented stream also goes
+ * to the C library.
+ *
+ * Each format is checked once, and compiled with my_jit_compile if it can
+ * be formatted here. The result is kept in a table keyed by the address
+ * of the format, with a copy of the format to make sure that it has not
+ * changed since. A call is left to the C library if its format is at an
+ * address where a different format was seen, since such formats are
+ * built at run time, or if the table has no room for it.
+ *
+ * Build:
+ *   gcc -O2 -shared -fPIC -pthread -o libmy_printf_preload.so \
+ *     my_printf_preload.c my_printf.c -ldl
+ *
+ * Usage:
+ *   LD_PRELOAD=./libmy_printf_preload.so program [args...]
+ */
+
+#define _GNU_SOURCE
+#undef _FORTIFY_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <wchar.h>
+#include <dlfcn.h>
+#include <pthread.h>
+
+#include "my_printf.h"
+
+// number of slots in the table of formats
+#define PRELOAD_CACHE 1024
+
+// number of slots that are tried for a format
+#define PRELOAD_PROBES 8
+
+/**
+ * A format that was seen by the library.
+ */
+typedef struct preload_fmt {
+	const char* key;   // address the format was seen at
+	my_jit* jit;       // compiled format, or NULL if left to the C library
+	char* args;        // argument checks, see preload_parse
+	char str[];        // copy of the format
+}preload_fmt;
+
+/**
+ * The functions of the C library that formats are sent back to.
+ */
+typedef struct preload_libc {
+	int (*vprintf)(const char*, va_list);
+	int (*vfprintf)(FILE*, const char*, va_list);
+	int (*vsnprintf)(char*, size_t, const char*, va_list);
+	int (*vprintf_chk)(int, const char*, va_list);
+	int (*vfprintf_chk)(FILE*, int, const char*, va_list);
+	int (*vsnprintf_chk)(char*, size_t, int, size_t, const char*, va_list);
+}preload_libc;
+
+static preload_libc libc;
+static pthread_once_t libc_once = PTHREAD_ONCE_INIT;
+
+static _Atomic(preload_fmt*) preload_cache[PRELOAD_CACHE];
+
+static void preload_resolve(void)
+{
+	libc.vprintf = (int (*)(const char*, va_list))dlsym(RTLD_NEXT, "vprintf");
+	libc.vfprintf = (int (*)(FILE*, const char*, va_list))dlsym(RTLD_NEXT, "vfprintf");
+	libc.vsnprintf = (int (*)(char*, size_t, const char*, va_list))
+		dlsym(RTLD_NEXT, "vsnprintf");
+	libc.vprintf_chk = (int (*)(int, const char*, va_list))
+		dlsym(RTLD_NEXT, "__vprintf_chk");
+	libc.vfprintf_chk = (int (*)(FILE*, int, const char*, va_list))
+		dlsym(RTLD_NEXT, "__vfprintf_chk");
+	libc.vsnprintf_chk = (int (*)(char*, size_t, int, size_t, const char*, va_list))
+		dlsym(RTLD_NEXT, "__vsnprintf_chk");
+}
+
+/**
+ * Gets the functions of the C library, looking them up on first use.
+ */
+static const preload_libc* preload_libc_get(void)
+{
+	pthread_once(&libc_once, preload_resolve);
+
+	return &libc;
+}
+
+/**
+ * Parses a format, and determines whether my_printf writes it exactly as
+ * the C library does. The checks that the arguments need are written to
+ * a string, one character for each argument:
+ *   'i' - an int with any value
+ *   'd' - an int that must not be INT_MIN
+ *   'o' - an int that must not be negative
+ *   's' - a string that must not be NULL
+ *   'a' - a double
+ *
+ * Params:
+ *   const char* - a format string
+ *   char* - the argument checks, with room for one character for each
+ *           '%' in the format and a NUL terminator
+ *
+ * Returns:
+ *   int - 1 if my_printf can format the format, or 0 otherwise
+ */
+static int preload_parse(const char* fmt, char* args)
+{
+	const char* flags;  // flags that are allowed for the specifier
+	const char* f;      // start of the flags of a tag
+	int prec;           // 1 if the tag has a precision
+	int prec_ok;        // 1 if the specifier can have a precision
+
+	while ((fmt = strchr(fmt, '%')) != NULL)
+	{
+		fmt++;
+		if (*fmt == '%')
+		{
+			fmt++;
+			continue;
+		}
+
+		for (f = fmt; *fmt != '\0' && strchr("-+ #0", *fmt) != NULL; fmt++);
+
+		prec = *fmt == '.';
+		if (prec)
+		{
+			for (fmt++; *fmt >= '0' && *fmt <= '9'; fmt++);
+		}
+
+		prec_ok = 0;
+		switch (*fmt)
+		{
+		case 'c': flags = "-+ #0"; *args = 'i'; break;
+		case 's': flags = "-+ #0"; *args = 's'; break;
+		case 'd':
+		case 'i': flags = "-0"; *args = 'd'; break;
+		case 'o': flags = "-0"; *args = 'o'; break;
+		case 'u':
+		case 'x':
+		case 'X': flags = "-0"; *args = 'i'; break;
+		case 'a':
+		case 'A': flags = "-+ #0"; prec_ok = 1; *args = 'a'; break;
+		default: return 0;
+		}
+
+		if (prec && !prec_ok)
+			return 0;
+
+		for (; f < fmt && *f != '.'; f++)
+		{
+			if (strchr(flags, *f) == NULL)
+				return 0;
+		}
+
+		args++;
+		fmt++;
+	}
+
+	*args = '\0';
+
+	return 1;
+}
+
+/**
+ * Checks the arguments of a call. The arguments are read from a copy of
+ * the list, so the list itself is left for whichever formats it.
+ *
+ * Params:
+ *   const char* - the argument checks from preload_parse
+ *   va_list - the arguments
+ *
+ * Returns:
+ *   int - 1 if every argument passes its check, or 0 otherwise
+ */
+static int preload_args_ok(const char* args, va_list list)
+{
+	va_list argp;
+	int ok = 1;
+
+	va_copy(argp, list);
+
+	for (; ok && *args != '\0'; args++)
+	{
+		switch (*args)
+		{
+		case 'i': va_arg(argp, int); break;
+		case 'd': ok = va_arg(argp, int) != INT_MIN; break;
+		case 'o': ok = va_arg(argp, int) >= 0; break;
+		case 's': ok = va_arg(argp, const char*) != NULL; break;
+		default: va_arg(argp, double); break;
+		}
+	}
+
+	va_end(argp);
+
+	return ok;
+}
+
+/**
+ * Creates the entry of a format. The format is compiled if my_printf can
+ * format it.
+ *
+ * Returns:
+ *   preload_fmt* - the entry, or NULL if no memory could be allocated
+ */
+static preload_fmt* preload_new(const char* fmt)
+{
+	preload_fmt* e;
+	const char* c;
+	size_t len, n;
+
+	len = strlen(fmt);
+	n = 0;
+	for (c = fmt; *c != '\0'; c++)
+		n += *c == '%';
+
+	e = malloc(sizeof(preload_fmt) + len + 1 + n + 1);
+	if (e == NULL)
+		return NULL;
+
+	e->key = fmt;
+	e->jit = NULL;
+	e->args = e->str + len + 1;
+	memcpy(e->str, fmt, len + 1);
+
+	if (preload_parse(fmt, e->args))
+		e->jit = my_jit_compile(fmt);
+
+	return e;
+}
+
+static void preload_free(preload_fmt* e)
+{
+	my_jit_free(e->jit);
+	free(e);
+}
+
+/**
+ * Finds the entry of a format in the table, adding it if the format has
+ * not been seen before.
+ *
+ * Params:
+ *   const char* - a format string
+ *
+ * Returns:
+ *   const preload_fmt* - the entry of the format, or NULL if the format
+ *                        is not in the table
+ */
+static const preload_fmt* preload_lookup(const char* fmt)
+{
+	preload_fmt* e;
+	preload_fmt* fresh = NULL;  // a new entry that is not in the table yet
+	size_t h, i;
+
+	h = (size_t)(((uint64_t)(uintptr_t)fmt >> 3) * 0x9E3779B97F4A7C15ULL >> 40);
+
+	for (i = 0; i < PRELOAD_PROBES; i++)
+	{
+		_Atomic(preload_fmt*)* slot = &preload_cache[(h + i) % PRELOAD_CACHE];
+
+		e = atomic_load_explicit(slot, memory_order_acquire);
+		if (e == NULL)
+		{
+			if (fresh == NULL)
+			{
+				fresh = preload_new(fmt);
+				if (fresh == NULL)
+					return NULL;
+			}
+
+			// Another thread may take the slot first, in which case its
+			// entry is looked at instead.
+			if (atomic_compare_exchange_strong_explicit(slot, &e, fresh,
+				memory_order_acq_rel, memory_order_acquire))
+				return fresh;
+		}
+
+		if (e->key == fmt)
+		{
+			if (fresh != NULL)
+				preload_free(fresh);
+
+			return strcmp(e->str, fmt) == 0 ? e : NULL;
+		}
+	}
+
+	if (fresh != NULL)
+		preload_free(fresh);
+
+	return NULL;
+}
+
+/**
+ * Gets the compiled format for a call, if my_printf can format it.
+ *
+ * Params:
+ *   const char* - a format string
+ *   va_list - the arguments of the call
+ *
+ * Returns:
+ *   const my_jit* - the compiled format, or NULL if the call must be
+ *                   left to the C library
+ */
+static const my_jit* preload_get(const char* fmt, va_list argp)
+{
+	const preload_fmt* e;
+
+	e = preload_lookup(fmt);
+	if (e == NULL || e->jit == NULL || !preload_args_ok(e->args, argp))
+		return NULL;
+
+	return e->jit;
+}
+
+/**
+ * Determines whether a stream can be written with my_jit_vfprintf.
+ */
+static int preload_stream_ok(FILE* stream)
+{
+	return fwide(stream, 0) <= 0;
+}
+
+/**
+ * Writes a compiled format to a stream, holding the lock of the stream
+ * for the whole call as the C library does.
+ */
+static int preload_vfprintf(FILE* stream, const my_jit* jit, va_list argp)
+{
+	int res;
+
+	flockfile(stream);
+	res = my_jit_vfprintf(stream, jit, argp);
+	funlockfile(stream);
+
+	return res;
+}
+
+int vfprintf(FILE* stream, const char* fmt, va_list argp)
+{
+	const my_jit* jit;
+
+	jit = preload_stream_ok(stream) ? preload_get(fmt, argp) : NULL;
+	if (jit != NULL)
+		return preload_vfprintf(stream, jit, argp);
+
+	return preload_libc_get()->vfprintf(stream, fmt, argp);
+}
+
+int vprintf(const char* fmt, va_list argp)
+{
+	const my_jit* jit;
+
+	jit = preload_stream_ok(stdout) ? preload_get(fmt, argp) : NULL;
+	if (jit != NULL)
+		return preload_vfprintf(stdout, jit, argp);
+
+	return preload_libc_get()->vprintf(fmt, argp);
+}
+
+int vsnprintf(char* str, size_t size, const char* fmt, va_list argp)
+{
+	const my_jit* jit;
+
+	jit = preload_get(fmt, argp);
+	if (jit != NULL)
+		return my_jit_vsnprintf(str, size, jit, argp);
+
+	return preload_libc_get()->vsnprintf(str, size, fmt, argp);
+}
+
+int fprintf(FILE* stream, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = vfprintf(stream, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int printf(const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = vprintf(fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int snprintf(char* str, size_t size, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = vsnprintf(str, size, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+/*
+ * The checked versions. The flag only changes how %n is treated, and %n
+ * always goes to the C library. A buffer that is smaller than its
+ * claimed size is also left to the C library, which aborts.
+ */
+
+int __vfprintf_chk(FILE* stream, int flag, const char* fmt, va_list argp)
+{
+	const my_jit* jit;
+
+	jit = preload_stream_ok(stream) ? preload_get(fmt, argp) : NULL;
+	if (jit != NULL)
+		return preload_vfprintf(stream, jit, argp);
+
+	return preload_libc_get()->vfprintf_chk(stream, flag, fmt, argp);
+}
+
+int __vprintf_chk(int flag, const char* fmt, va_list argp)
+{
+	const my_jit* jit;
+
+	jit = preload_stream_ok(stdout) ? preload_get(fmt, argp) : NULL;
+	if (jit != NULL)
+		return preload_vfprintf(stdout, jit, argp);
+
+	return preload_libc_get()->vprintf_chk(flag, fmt, argp);
+}
+
+int __vsnprintf_chk(char* str, size_t size, int flag, size_t slen,
+	const char* fmt, va_list argp)
+{
+	const my_jit* jit;
+
+	jit = size <= slen ? preload_get(fmt, argp) : NULL;
+	if (jit != NULL)
+		return my_jit_vsnprintf(str, size, jit, argp);
+
+	return preload_libc_get()->vsnprintf_chk(str, size, flag, slen, fmt, argp);
+}
+
+int __fprintf_chk(FILE* stream, int flag, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = __vfprintf_chk(stream, flag, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int __printf_chk(int flag, const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = __vprintf_chk(flag, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
+
+int __snprintf_chk(char* str, size_t size, int flag, size_t slen,
+	const char* fmt, ...)
+{
+	va_list argp;
+	int res;
+
+	va_start(argp, fmt);
+	res = __vsnprintf_chk(str, size, flag, slen, fmt, argp);
+	va_end(argp);
+
+	return res;
+}
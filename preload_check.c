@@ -0,0 +1,205 @@
+/**
+ * Conformance check for my_printf_preload.c.
+ *
+ * The program writes the same list of values with many formats through
+ * printf, fprintf, snprintf and their va_list versions: formats that the
+ * library formats itself, formats that it sends back to the C library,
+ * and formats built at run time in the same buffer. It has no output of
+ * its own to check. It is run once as it is and once with the library
+ * preloaded, and the outputs must be the same byte for byte, which is
+ * what preload_check.sh does.
+ *
+ * Build it once as it is, and once with -D_FORTIFY_SOURCE=2 so that the
+ * __*_chk versions are called instead:
+ *   gcc -O2 -o preload_check preload_check.c
+ *   gcc -O2 -D_FORTIFY_SOURCE=2 -o preload_check_fortify preload_check.c
+ *
+ * Usage:
+ *   preload_check > plain.out 2> plain.err
+ *   LD_PRELOAD=./libmy_printf_preload.so preload_check > preload.out 2> preload.err
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+// size of the snprintf buffers
+#define CHECK_BUF 512
+
+static const int check_ints[] = {
+	0, 1, -1, 7, -42, 255, 4096, 123456789, -987654321, INT_MAX, INT_MIN
+};
+
+static const double check_doubles[] = {
+	0.0, -0.0, 1.0, -1.5, 0.1, 3.14159265358979, 1e-300, 5e-324,
+	1.7976931348623157e308, 123456.789, -2.5e-7, INFINITY, -INFINITY, NAN
+};
+
+static const char* check_strs[] = {
+	"", "a", "hello", "tab\there", "a longer string with spaces", NULL
+};
+
+// formats for one int argument
+static const char* check_int_fmts[] = {
+	"%d\n", "%i\n", "[%-d]\n", "[%0d]\n", "%u\n", "%x\n", "%X\n", "%o\n",
+	"[%-x]\n", "[%0X]\n", "%%d=%d %%%%\n", "%c.\n", "[%-c]\n",
+	"[%5d]\n", "[%-8i]\n", "%+d\n", "% d\n", "%#x\n", "%#o\n", "[%08x]\n",
+	"%.3d\n", "%.0d|\n", "%1$d %1$x\n", "%hd\n", "%hhx\n"
+};
+
+// formats for one double argument
+static const char* check_double_fmts[] = {
+	"%a\n", "%A\n", "%.3a\n", "%+a\n", "[%-a]\n", "%#.0a\n", "% .1A\n",
+	"%f\n", "%.2f\n", "%e\n", "%.10E\n", "%g\n", "%G\n", "[%20.5e]\n",
+	"%-+12.3g|\n"
+};
+
+// formats for one string argument
+static const char* check_str_fmts[] = {
+	"%s\n", "[%-s]\n", "<%s|%%>\n", "[%10s]\n", "[%-10s]\n", "[%.3s]\n",
+	"%s"
+};
+
+/**
+ * Formats with vprintf, vfprintf and vsnprintf.
+ *
+ * Params:
+ *   const char* - a format string
+ *   ... - the values to be converted to strings
+ */
+static void check_va(const char* fmt, ...)
+{
+	char buf[CHECK_BUF];
+	va_list argp;
+	int n;
+
+	va_start(argp, fmt);
+	n = vprintf(fmt, argp);
+	va_end(argp);
+	printf("vprintf=%d\n", n);
+
+	va_start(argp, fmt);
+	n = vfprintf(stderr, fmt, argp);
+	va_end(argp);
+	fprintf(stderr, "vfprintf=%d\n", n);
+
+	va_start(argp, fmt);
+	n = vsnprintf(buf, sizeof(buf), fmt, argp);
+	va_end(argp);
+	fputs(buf, stdout);
+	printf("vsnprintf=%d\n", n);
+
+	// A buffer that is too short is cut, with the full length returned.
+	va_start(argp, fmt);
+	n = vsnprintf(buf, 4, fmt, argp);
+	va_end(argp);
+	printf("[%s] short=%d\n", buf, n);
+}
+
+/**
+ * Formats the ints with printf, fprintf and snprintf.
+ */
+static void check_int(const char* fmt, int v)
+{
+	char buf[CHECK_BUF];
+	int n;
+
+	n = printf(fmt, v);
+	printf("printf=%d\n", n);
+	n = fprintf(stderr, fmt, v);
+	fprintf(stderr, "fprintf=%d\n", n);
+	n = snprintf(buf, sizeof(buf), fmt, v);
+	fputs(buf, stdout);
+	printf("snprintf=%d\n", n);
+	n = snprintf(NULL, 0, fmt, v);
+	printf("length=%d\n", n);
+	check_va(fmt, v);
+}
+
+/**
+ * Formats the doubles with printf, fprintf and snprintf.
+ */
+static void check_double(const char* fmt, double v)
+{
+	char buf[CHECK_BUF];
+	int n;
+
+	n = printf(fmt, v);
+	printf("printf=%d\n", n);
+	n = fprintf(stderr, fmt, v);
+	fprintf(stderr, "fprintf=%d\n", n);
+	n = snprintf(buf, sizeof(buf), fmt, v);
+	fputs(buf, stdout);
+	printf("snprintf=%d\n", n);
+	check_va(fmt, v);
+}
+
+/**
+ * Formats the strings with printf, fprintf and snprintf.
+ */
+static void check_str(const char* fmt, const char* v)
+{
+	char buf[CHECK_BUF];
+	int n;
+
+	n = printf(fmt, v);
+	printf("printf=%d\n", n);
+	n = fprintf(stderr, fmt, v);
+	fprintf(stderr, "fprintf=%d\n", n);
+	n = snprintf(buf, sizeof(buf), fmt, v);
+	fputs(buf, stdout);
+	printf("snprintf=%d\n", n);
+	check_va(fmt, v);
+}
+
+int main(void)
+{
+	char fmt[64];
+	size_t f, i;
+	int w;
+
+	for (f = 0; f < sizeof(check_int_fmts) / sizeof(*check_int_fmts); f++)
+	{
+		for (i = 0; i < sizeof(check_ints) / sizeof(*check_ints); i++)
+			check_int(check_int_fmts[f], check_ints[i]);
+	}
+
+	for (f = 0; f < sizeof(check_double_fmts) / sizeof(*check_double_fmts); f++)
+	{
+		for (i = 0; i < sizeof(check_doubles) / sizeof(*check_doubles); i++)
+			check_double(check_double_fmts[f], check_doubles[i]);
+	}
+
+	for (f = 0; f < sizeof(check_str_fmts) / sizeof(*check_str_fmts); f++)
+	{
+		for (i = 0; i < sizeof(check_strs) / sizeof(*check_strs); i++)
+			check_str(check_str_fmts[f], check_strs[i]);
+	}
+
+	// Formats with several tags and lengths.
+	printf("%s=%d (%x) %c%c %a\n", "value", 1234, 1234u, 'o', 'k', 0.75);
+	printf("%ld %lu %lld %llx %zu %jd\n", LONG_MIN, ULONG_MAX, LLONG_MIN,
+		0xFEDCBA9876543210ULL, (size_t)-1, (intmax_t)-5);
+	printf("%p %p\n", (void*)0, (void*)0x1234);
+	printf("%Lf %Le\n", 1.5L, -2.25L);
+
+	// Formats built at run time in the same buffer, which the library
+	// must not take for the format it saw there before.
+	for (w = 0; w < 64; w++)
+	{
+		if (w % 3 == 0)
+			snprintf(fmt, sizeof(fmt), "%%%dd|%%s\n", w % 12);
+		else if (w % 3 == 1)
+			snprintf(fmt, sizeof(fmt), "%%-%dx|%%s\n", w % 7);
+		else
+			snprintf(fmt, sizeof(fmt), "%%c %d|%%s\n", w);
+		printf(fmt, w * 37, "run time");
+		fprintf(stderr, fmt, w * 37, "run time");
+	}
+
+	return 0;
+}
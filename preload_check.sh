@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# Runs preload_check.c with and without libmy_printf_preload.so, built as
+# it is and with _FORTIFY_SOURCE, and compares the outputs. Prints the
+# differences and exits with status 1 if any output is not the same.
+#
+# Usage:
+#   ./preload_check.sh [build_dir]
+#
+# The library and the programs are built in build_dir, by default a new
+# temporary directory that is removed at the end.
+
+set -eu
+
+src=$(cd "$(dirname "$0")" && pwd)
+cc=${CC:-gcc}
+
+if [ $# -gt 0 ]; then
+	dir=$1
+	mkdir -p "$dir"
+else
+	dir=$(mktemp -d)
+	trap 'rm -rf "$dir"' EXIT
+fi
+
+"$cc" -O2 -shared -fPIC -pthread -o "$dir/libmy_printf_preload.so" \
+	"$src/my_printf_preload.c" "$src/my_printf.c" -ldl
+"$cc" -O2 -o "$dir/preload_check" "$src/preload_check.c"
+"$cc" -O2 -D_FORTIFY_SOURCE=2 -o "$dir/preload_check_fortify" "$src/preload_check.c"
+
+status=0
+for prog in preload_check preload_check_fortify; do
+	"$dir/$prog" > "$dir/$prog.plain.out" 2> "$dir/$prog.plain.err"
+	LD_PRELOAD="$dir/libmy_printf_preload.so" "$dir/$prog" \
+		> "$dir/$prog.preload.out" 2> "$dir/$prog.preload.err"
+
+	for stream in out err; do
+		if cmp -s "$dir/$prog.plain.$stream" "$dir/$prog.preload.$stream"; then
+			echo "$prog std$stream: same"
+		else
+			echo "$prog std$stream: different"
+			diff "$dir/$prog.plain.$stream" "$dir/$prog.preload.$stream" | head -n 40 || true
+			status=1
+		fi
+	done
+done
+
+exit $status
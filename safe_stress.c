@@ -0,0 +1,360 @@
+/**
+ * Stress test of my_dprintf_safe in a signal handler.
+ *
+ * Worker threads allocate memory and format with my_snprintf and
+ * my_fprintf in a loop, so that they are often inside malloc, inside the
+ * engine or holding the lock of a stream when a signal arrives. An
+ * interval timer sends SIGALRM to the process many times a second, and
+ * the handler writes a line with my_dprintf_safe to a pipe. A reader
+ * thread checks that each line is the one that snprintf writes for the
+ * same values.
+ *
+ * The test fails if a line is wrong or missing, if my_dprintf_safe fails
+ * in the handler, if it changes errno, or if a worker stops making
+ * progress, which is what a handler that takes a lock would lead to.
+ * Results are written as key=value lines to stdout, and the program exits
+ * with status 1 on failure.
+ *
+ * Build:
+ *   gcc -O2 -pthread -o safe_stress safe_stress.c my_printf.c
+ *
+ * Usage:
+ *   safe_stress [-t seconds] [-j threads] [-i interval_us]
+ *
+ *   The default is 10 seconds, 4 threads and a signal every 200us.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+
+#include "my_printf.h"
+
+// maximum number of worker threads
+#define STRESS_MAX_THREADS 64
+
+// size of a line written by the handler
+#define STRESS_LINE 128
+
+// seconds without progress after which a worker is deadlocked
+#define STRESS_STALL 5
+
+/**
+ * The state of a worker thread.
+ */
+typedef struct stress_worker {
+	pthread_t thread;          // the thread
+	FILE* null;                // a stream open on /dev/null
+	atomic_ulong progress;     // iterations done
+	atomic_int done;           // set when the thread has stopped
+}stress_worker;
+
+static int stress_pipe[2];
+static atomic_int stress_stop;
+static atomic_ulong stress_signals;   // lines written by the handler
+static atomic_ulong stress_failures;  // failed calls or changed errno
+static unsigned long stress_lines;    // lines read from the pipe
+
+/**
+ * Writes the line of a signal number into a buffer, as the handler
+ * should write it.
+ *
+ * Params:
+ *   char* - a buffer of STRESS_LINE characters
+ *   unsigned long - the number of the signal
+ *   int - the signal
+ *
+ * Returns:
+ *   int - the length of the line
+ */
+static int stress_expect(char* buf, unsigned long n, int sig)
+{
+	// Pointers are written with all of their digits, as with my_printf.
+	return snprintf(buf, STRESS_LINE, "signal %lu: sig=%d %016lx [%-6s] [%5d] %#x %0*lx %c%%\n",
+		n, sig, n * 0x9E3779B97F4A7C15UL, n & 1 ? "odd" : "even",
+		-(int)(n % 10000), (unsigned)(n & 0xFFFF), (int)sizeof(void*) * 2, n << 4,
+		'a' + (int)(n % 26));
+}
+
+/**
+ * Writes a line with my_dprintf_safe, and checks that errno is unchanged.
+ *
+ * Params:
+ *   int - the signal
+ */
+static void stress_handler(int sig)
+{
+	unsigned long n = atomic_fetch_add(&stress_signals, 1);
+	int res;
+
+	errno = EINTR;
+	res = my_dprintf_safe(stress_pipe[1], "signal %lu: sig=%d %016lx [%-6s] [%5d] %#x %p %c%%\n",
+		n, sig, n * 0x9E3779B97F4A7C15UL, n & 1 ? "odd" : "even",
+		-(int)(n % 10000), (unsigned)(n & 0xFFFF), (void*)(n << 4), 'a' + (int)(n % 26));
+
+	if (res < 0 || errno != EINTR)
+		atomic_fetch_add(&stress_failures, 1);
+}
+
+/**
+ * Allocates and formats until the test is stopped.
+ *
+ * Params:
+ *   void* - a stress_worker
+ */
+static void* stress_work(void* arg)
+{
+	stress_worker* w = arg;
+	char buf[256];
+	unsigned long i;
+	void* p;
+
+	for (i = 0; !atomic_load(&stress_stop); i++)
+	{
+		p = malloc(16 + i % 4096);
+		my_snprintf(buf, sizeof(buf), "%d %s %x %e %f", (int)i, "work", (unsigned)i,
+			(double)i * 0.5, (double)i / 7);
+		my_fprintf(w->null, "%s %p\n", buf, p);
+		free(p);
+
+		atomic_store_explicit(&w->progress, i + 1, memory_order_relaxed);
+	}
+
+	atomic_store(&w->done, 1);
+
+	return NULL;
+}
+
+/**
+ * Reads the lines of the handler from the pipe and checks each one.
+ *
+ * Returns:
+ *   void* - the number of lines that were wrong, as a uintptr_t
+ */
+static void* stress_read(void* arg)
+{
+	char buf[4096 + STRESS_LINE];
+	char expect[STRESS_LINE];
+	size_t len = 0, start, i;
+	uintptr_t wrong = 0;
+	unsigned long n;
+	ssize_t r;
+	int e;
+
+	(void)arg;
+
+	while ((r = read(stress_pipe[0], buf + len, sizeof(buf) - len)) > 0)
+	{
+		len += (size_t)r;
+
+		for (start = 0, i = 0; i < len; i++)
+		{
+			if (buf[i] != '\n')
+				continue;
+
+			buf[i] = '\0';
+			stress_lines++;
+			n = strtoul(buf + start + sizeof("signal ") - 1, NULL, 10);
+			e = stress_expect(expect, n, SIGALRM);
+			if (strncmp(buf + start, "signal ", 7) != 0
+				|| i + 1 - start != (size_t)e
+				|| memcmp(buf + start, expect, (size_t)e - 1) != 0)
+			{
+				if (wrong++ < 10)
+					fprintf(stderr, "got: %s\nexpected: %s", buf + start, expect);
+			}
+			start = i + 1;
+		}
+
+		// Keep the start of a line that is not complete yet.
+		memmove(buf, buf + start, len - start);
+		len -= start;
+		if (len == sizeof(buf))
+		{
+			wrong++;
+			len = 0;
+		}
+	}
+
+	if (len > 0)
+		wrong++;
+
+	return (void*)wrong;
+}
+
+/**
+ * Waits for a second and checks that each worker has made progress since
+ * the last call.
+ *
+ * Params:
+ *   stress_worker* - the workers
+ *   long - the number of workers
+ *   unsigned long* - the progress of each worker at the last call
+ *   unsigned long* - the number of seconds each worker has not progressed
+ *
+ * Returns:
+ *   int - 1 if a worker has not progressed for STRESS_STALL seconds,
+ *     else 0
+ */
+static int stress_stalled(stress_worker* workers, long n_threads,
+	unsigned long* last, unsigned long* stalled)
+{
+	unsigned long progress;
+	long t;
+
+	sleep(1);
+
+	for (t = 0; t < n_threads; t++)
+	{
+		progress = atomic_load(&workers[t].progress);
+		if (progress == last[t] && !atomic_load(&workers[t].done))
+			stalled[t]++;
+		else
+			stalled[t] = 0;
+		last[t] = progress;
+
+		if (stalled[t] >= STRESS_STALL)
+			return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	static stress_worker workers[STRESS_MAX_THREADS];
+	unsigned long last[STRESS_MAX_THREADS] = { 0 };
+	unsigned long stalled[STRESS_MAX_THREADS] = { 0 };
+	pthread_t reader;
+	struct sigaction sa;
+	struct itimerval it;
+	sigset_t set;
+	FILE* null;
+	void* wrong;
+	unsigned long signals, iterations = 0;
+	long seconds = 10, n_threads = 4, interval = 200, t, done;
+	int opt, err;
+
+	while ((opt = getopt(argc, argv, "t:j:i:")) != -1)
+	{
+		switch (opt)
+		{
+		case 't': seconds = strtol(optarg, NULL, 0); break;
+		case 'j': n_threads = strtol(optarg, NULL, 0); break;
+		case 'i': interval = strtol(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-t seconds] [-j threads] [-i interval_us]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (n_threads < 1 || n_threads > STRESS_MAX_THREADS || interval < 1)
+	{
+		fprintf(stderr, "threads must be 1 to %d and the interval positive\n",
+			STRESS_MAX_THREADS);
+		return 2;
+	}
+
+	null = fopen("/dev/null", "w");
+	if (null == NULL || pipe(stress_pipe) != 0)
+	{
+		perror("safe_stress");
+		return 2;
+	}
+
+	// The reader and this thread don't take the signal, so that it
+	// always interrupts a worker.
+	sigemptyset(&set);
+	sigaddset(&set, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+	pthread_create(&reader, NULL, stress_read, NULL);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = stress_handler;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGALRM, &sa, NULL);
+
+	for (t = 0; t < n_threads; t++)
+	{
+		workers[t].null = null;
+		pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+		pthread_create(&workers[t].thread, NULL, stress_work, &workers[t]);
+		pthread_sigmask(SIG_BLOCK, &set, NULL);
+	}
+
+	it.it_interval.tv_sec = interval / 1000000;
+	it.it_interval.tv_usec = interval % 1000000;
+	it.it_value = it.it_interval;
+	setitimer(ITIMER_REAL, &it, NULL);
+
+	// A worker that stops making progress is stuck on a lock that was
+	// taken in the handler, and can't be joined.
+	for (t = 0; t < seconds; t++)
+	{
+		if (stress_stalled(workers, n_threads, last, stalled))
+			goto deadlock;
+	}
+
+	memset(&it, 0, sizeof(it));
+	setitimer(ITIMER_REAL, &it, NULL);
+	atomic_store(&stress_stop, 1);
+
+	do
+	{
+		if (stress_stalled(workers, n_threads, last, stalled))
+			goto deadlock;
+
+		for (done = 0, t = 0; t < n_threads; t++)
+			done += atomic_load(&workers[t].done);
+	}
+	while (done < n_threads);
+
+	for (t = 0; t < n_threads; t++)
+	{
+		pthread_join(workers[t].thread, NULL);
+		iterations += atomic_load(&workers[t].progress);
+	}
+
+	close(stress_pipe[1]);
+	pthread_join(reader, &wrong);
+
+	signals = atomic_load(&stress_signals);
+	printf("iterations=%lu\n", iterations);
+	printf("signals=%lu\n", signals);
+	printf("lines=%lu\n", stress_lines);
+	printf("failed_calls=%lu\n", atomic_load(&stress_failures));
+	printf("wrong_lines=%lu\n", (unsigned long)(uintptr_t)wrong);
+
+	err = signals == 0 || stress_lines != signals
+		|| atomic_load(&stress_failures) != 0 || wrong != NULL;
+
+	// A length that the handler can't read fails instead of misreading.
+	if (my_dprintf_safe(fileno(null), "%lc", 'x') != -1
+		|| my_dprintf_safe(fileno(null), "%ls", "x") != -1
+		|| my_dprintf_safe(fileno(null), "%Ld", 1) != -1)
+	{
+		printf("length_refused=0\n");
+		err = 1;
+	}
+
+	fclose(null);
+	close(stress_pipe[0]);
+
+	return err;
+
+deadlock:
+	printf("deadlock=1\n");
+	fflush(stdout);
+	_exit(1);
+}